@@ -8,11 +8,15 @@
 #include "discimages/CsoImageStream.h"
 #include "discimages/CueSheet.h"
 #include "discimages/IszImageStream.h"
+#include "discimages/MappedImageStream.h"
 #include "discimages/MdsDiscImage.h"
+#include "discimages/ZciImageStream.h"
 #include "StdStream.h"
 #include "StdStreamUtils.h"
 #include "StringUtils.h"
+#include "xxhash.h"
 #ifdef HAS_AMAZON_S3
+#include "s3stream/HttpRangeFetcher.h"
 #include "s3stream/S3ObjectStream.h"
 #endif
 #ifdef _WIN32
@@ -51,6 +55,18 @@ static std::unique_ptr<Framework::CStream> CreateImageStream(const fs::path& ima
 		return std::make_unique<CS3ObjectStream>(bucketName.c_str(), fullObjectPath.c_str() + objectPathPos + 1);
 #else
 		throw std::runtime_error("S3 support was disabled during build configuration.");
+#endif
+	}
+	static const auto httpImagePathPrefix = fs::path("//http/").native();
+	if(imagePathString.find(httpImagePathPrefix) == 0)
+	{
+#ifdef HAS_AMAZON_S3
+		//Plain HTTP server standing in for S3 (ex.: '//http/localhost:8000/image.iso')
+		auto url = "http://" + string_cast<std::string>(imagePathString.substr(httpImagePathPrefix.length()));
+		std::replace(url.begin(), url.end(), '\\', '/');
+		return std::make_unique<CS3ObjectStream>(std::make_unique<CHttpRangeFetcher>(url), CS3ObjectStream::GetCachePath());
+#else
+		throw std::runtime_error("S3 support was disabled during build configuration.");
 #endif
 	}
 #ifdef __ANDROID__
@@ -66,6 +82,14 @@ static std::unique_ptr<Framework::CStream> CreateImageStream(const fs::path& ima
 #elif defined(__EMSCRIPTEN__)
 	return std::make_unique<CJsDiscImageDeviceStream>();
 #else
+	try
+	{
+		return std::make_unique<CMappedImageStream>(imagePath);
+	}
+	catch(...)
+	{
+		//Not a regular file on a local fixed drive or it can't be mapped (ex.: too big for the address space), use regular file I/O
+	}
 	return std::make_unique<Framework::CStdStream>(imagePathString.c_str(), Framework::GetInputStdStreamMode<fs::path::string_type>());
 #endif
 }
@@ -130,7 +154,7 @@ static DiskUtils::OpticalMediaPtr CreateOpticalMediaFromChd(const fs::path& imag
 
 const DiskUtils::ExtensionList& DiskUtils::GetSupportedExtensions()
 {
-	static auto extensionList = ExtensionList{".iso", ".mds", ".isz", ".cso", ".cue", ".chd"};
+	static auto extensionList = ExtensionList{".iso", ".mds", ".isz", ".cso", ".cue", ".chd", ".zci"};
 	return extensionList;
 }
 
@@ -154,6 +178,10 @@ DiskUtils::OpticalMediaPtr DiskUtils::CreateOpticalMediaFromPath(const fs::path&
 	{
 		stream = std::make_shared<CCsoImageStream>(CreateImageStream(imagePath));
 	}
+	else if(!stricmp(extension.c_str(), ".zci"))
+	{
+		stream = std::make_shared<CZciImageStream>(CreateImageStream(imagePath));
+	}
 	else if(!stricmp(extension.c_str(), ".cue"))
 	{
 		return CreateOpticalMediaFromCueSheet(imagePath);
@@ -249,3 +277,18 @@ bool DiskUtils::TryGetDiskId(const fs::path& imagePath, std::string* diskIdPtr)
 		return false;
 	}
 }
+
+uint64 DiskUtils::GetImageIdentity(const fs::path& imagePath)
+{
+	std::error_code errorCode;
+	if(!fs::is_regular_file(imagePath, errorCode)) return 0;
+	auto fileSize = fs::file_size(imagePath, errorCode);
+	if(errorCode) return 0;
+	auto writeTime = fs::last_write_time(imagePath, errorCode);
+	if(errorCode) return 0;
+
+	uint64 fileInfo[2] = {static_cast<uint64>(fileSize), static_cast<uint64>(writeTime.time_since_epoch().count())};
+	const auto& pathString = imagePath.native();
+	uint64 pathHash = XXH3_64bits(pathString.data(), pathString.size() * sizeof(fs::path::value_type));
+	return XXH3_64bits_withSeed(fileInfo, sizeof(fileInfo), pathHash);
+}
@@ -18,4 +18,7 @@ namespace DiskUtils
 	SystemConfigMap ParseSystemConfigFile(Framework::CStream*);
 
 	bool TryGetDiskId(const fs::path&, std::string*);
+
+	//Hash of a local image file's path, size and modification time, 0 if it's not a local file
+	uint64 GetImageIdentity(const fs::path&);
 }
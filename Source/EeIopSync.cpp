@@ -0,0 +1,217 @@
+#include "EeIopSync.h"
+#include <cassert>
+#include <cstring>
+
+static thread_local CEeIopSync::PARTY s_currentParty = CEeIopSync::PARTY_EE;
+static thread_local unsigned int s_lockDepth = 0;
+static thread_local bool s_parkingIop = false;
+
+CEeIopSync::CLockScope::CLockScope(CEeIopSync* sync)
+    : m_sync(sync)
+{
+	if(m_sync)
+	{
+		m_sync->Lock();
+	}
+}
+
+CEeIopSync::CLockScope::~CLockScope()
+{
+	if(m_sync)
+	{
+		m_sync->Unlock();
+	}
+}
+
+CEeIopSync::CExclusiveScope::CExclusiveScope(CEeIopSync* sync)
+    : m_sync(sync)
+{
+	if(m_sync)
+	{
+		m_sync->BeginExclusive();
+	}
+}
+
+CEeIopSync::CExclusiveScope::~CExclusiveScope()
+{
+	if(m_sync)
+	{
+		m_sync->EndExclusive();
+	}
+}
+
+void CEeIopSync::SetEnabled(bool enabled)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	assert(m_lockOwner == PARTY_NONE);
+	assert(m_parkRequestCount == 0);
+	assert(!m_windowPending);
+	FlushEeWrites();
+	m_enabled = enabled;
+	m_stopping = false;
+	m_iopParked = true;
+}
+
+bool CEeIopSync::IsEnabled() const
+{
+	return m_enabled;
+}
+
+void CEeIopSync::SetCurrentThreadParty(PARTY party)
+{
+	assert(party < PARTY_COUNT);
+	s_currentParty = party;
+}
+
+void CEeIopSync::Lock()
+{
+	if(!m_enabled) return;
+	//Sections can nest, SIF calls from the EE side often end up sending a reply through the IOP side
+	if(s_lockDepth++ != 0) return;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_conditionVariable.wait(lock, [this]() { return m_lockOwner == PARTY_NONE; });
+	m_lockOwner = s_currentParty;
+	if(s_currentParty == PARTY_EE)
+	{
+		//IOP side might have written data before changing the state we're about to look at
+		FlushEeWrites();
+	}
+}
+
+void CEeIopSync::Unlock()
+{
+	if(!m_enabled) return;
+	assert(s_lockDepth != 0);
+	if(--s_lockDepth != 0) return;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	assert(m_lockOwner == s_currentParty);
+	m_lockOwner = PARTY_NONE;
+	if(s_parkingIop)
+	{
+		s_parkingIop = false;
+		m_parkRequestCount--;
+	}
+	m_conditionVariable.notify_all();
+}
+
+void CEeIopSync::BeginExclusive()
+{
+	if(!m_enabled) return;
+	if((s_currentParty == PARTY_IOP) || (s_lockDepth != 0))
+	{
+		//Parking the IOP while holding the lock could deadlock: it might be waiting for it
+		assert((s_currentParty == PARTY_IOP) || s_parkingIop);
+		Lock();
+		return;
+	}
+
+	s_lockDepth++;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	//IOP can still take the lock until it reaches a safe point, it will release it before
+	m_parkRequestCount++;
+	m_conditionVariable.wait(lock, [this]() { return (m_lockOwner == PARTY_NONE) && m_iopParked; });
+	m_lockOwner = PARTY_EE;
+	s_parkingIop = true;
+	FlushEeWrites();
+}
+
+void CEeIopSync::EndExclusive()
+{
+	Unlock();
+}
+
+void CEeIopSync::CheckPoint()
+{
+	if(m_parkRequestCount == 0) return;
+
+	assert(s_currentParty == PARTY_IOP);
+	assert(s_lockDepth == 0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_iopParked = true;
+	m_conditionVariable.notify_all();
+	m_conditionVariable.wait(lock, [this]() { return m_parkRequestCount == 0; });
+	m_iopParked = false;
+}
+
+void CEeIopSync::BeginWindow()
+{
+	assert(m_enabled);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	assert(!m_windowPending);
+	m_windowPending = true;
+	m_conditionVariable.notify_all();
+}
+
+void CEeIopSync::EndWindow()
+{
+	assert(m_enabled);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_conditionVariable.wait(lock, [this]() { return !m_windowPending; });
+	FlushEeWrites();
+}
+
+bool CEeIopSync::WaitForWindow()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_iopParked = true;
+	m_conditionVariable.notify_all();
+	m_conditionVariable.wait(lock, [this]() { return m_stopping || IsWindowReady(); });
+	//Complete the window first if there's one, the EE side is waiting for it
+	if(!IsWindowReady()) return false;
+	m_iopParked = false;
+	return true;
+}
+
+void CEeIopSync::CompleteWindow()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	assert(m_windowPending);
+	m_windowPending = false;
+	m_iopParked = true;
+	m_conditionVariable.notify_all();
+}
+
+void CEeIopSync::Stop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_stopping = true;
+	m_conditionVariable.notify_all();
+}
+
+void CEeIopSync::WriteEeMemory(void* dst, const void* src, size_t size)
+{
+	if(!m_enabled || (s_currentParty == PARTY_EE))
+	{
+		memcpy(dst, src, size);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	EE_WRITE write;
+	write.dst = dst;
+	write.dataOffset = m_eeWriteData.size();
+	write.size = size;
+	m_eeWrites.push_back(write);
+	m_eeWriteData.insert(m_eeWriteData.end(), reinterpret_cast<const uint8*>(src), reinterpret_cast<const uint8*>(src) + size);
+}
+
+void CEeIopSync::FlushEeWrites()
+{
+	//Mutex must be held, writes are applied in the order they were made
+	for(const auto& write : m_eeWrites)
+	{
+		memcpy(write.dst, m_eeWriteData.data() + write.dataOffset, write.size);
+	}
+	m_eeWrites.clear();
+	m_eeWriteData.clear();
+}
+
+bool CEeIopSync::IsWindowReady() const
+{
+	//Don't leave the safe point while the EE side is waiting for an exclusive section
+	return m_windowPending && (m_parkRequestCount == 0);
+}
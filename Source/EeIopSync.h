@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "Types.h"
+
+//Coordinates the EE and IOP when the IOP runs on its own thread.
+//Both CPUs execute in parallel inside lockstep windows started by the EE side. State shared by
+//both sides (SIF) is only touched while holding the lock. EE code that runs IOP code (SIF command
+//handlers, ioman) does it in exclusive sections: the IOP is parked at a safe point (in between
+//execution chunks or while waiting for a window) until the section ends. Being blocked on the
+//lock is not a safe point. IOP code writing to EE memory while the EE is running has its writes
+//deferred until the EE side takes the lock or ends the window. When disabled, every operation is
+//a no-op.
+class CEeIopSync
+{
+public:
+	enum PARTY
+	{
+		PARTY_EE,
+		PARTY_IOP,
+		PARTY_COUNT,
+		PARTY_NONE = PARTY_COUNT,
+	};
+
+	class CLockScope
+	{
+	public:
+		CLockScope(CEeIopSync*);
+		~CLockScope();
+
+		CLockScope(const CLockScope&) = delete;
+		CLockScope& operator=(const CLockScope&) = delete;
+
+	private:
+		CEeIopSync* m_sync = nullptr;
+	};
+
+	class CExclusiveScope
+	{
+	public:
+		CExclusiveScope(CEeIopSync*);
+		~CExclusiveScope();
+
+		CExclusiveScope(const CExclusiveScope&) = delete;
+		CExclusiveScope& operator=(const CExclusiveScope&) = delete;
+
+	private:
+		CEeIopSync* m_sync = nullptr;
+	};
+
+	void SetEnabled(bool);
+	bool IsEnabled() const;
+
+	//Threads belong to the EE side unless specified otherwise
+	static void SetCurrentThreadParty(PARTY);
+
+	void Lock();
+	void Unlock();
+
+	//Locks and parks the IOP. IOP code never runs EE code, sections started by the IOP side only lock.
+	void BeginExclusive();
+	void EndExclusive();
+
+	//IOP side, parks if the EE side is waiting to start an exclusive section
+	void CheckPoint();
+
+	//Writes to memory the EE executes from, deferred when done by the IOP side
+	void WriteEeMemory(void*, const void*, size_t);
+
+	//EE side
+	void BeginWindow();
+	void EndWindow();
+
+	//IOP side, returns false once stopped. A pending window is still executed when stopping.
+	bool WaitForWindow();
+	void CompleteWindow();
+
+	void Stop();
+
+private:
+	struct EE_WRITE
+	{
+		void* dst = nullptr;
+		size_t dataOffset = 0;
+		size_t size = 0;
+	};
+
+	bool IsWindowReady() const;
+	void FlushEeWrites();
+
+	bool m_enabled = false;
+	std::mutex m_mutex;
+	std::condition_variable m_conditionVariable;
+	std::atomic<unsigned int> m_parkRequestCount = {0};
+	PARTY m_lockOwner = PARTY_NONE;
+	bool m_iopParked = true;
+	bool m_windowPending = false;
+	bool m_stopping = false;
+	std::vector<EE_WRITE> m_eeWrites;
+	std::vector<uint8> m_eeWriteData;
+};
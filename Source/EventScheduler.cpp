@@ -0,0 +1,240 @@
+#include "EventScheduler.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+CEventScheduler::CEventScheduler()
+{
+	Reset();
+}
+
+void CEventScheduler::Reset()
+{
+	for(auto& event : m_events)
+	{
+		event.deadline = 0;
+		event.scheduled = false;
+	}
+	memset(m_slots, 0, sizeof(m_slots));
+	memset(m_slotOccupancy, 0, sizeof(m_slotOccupancy));
+	m_overflow = 0;
+	m_currentTime = 0;
+	m_currentSlot = 0;
+	m_nextEvent = NO_EVENT;
+	m_nextEventDirty = false;
+}
+
+CEventScheduler::EventId CEventScheduler::RegisterEvent(EventHandler handler)
+{
+	assert(m_eventCount < MAX_EVENTS);
+	EventId eventId = m_eventCount++;
+	m_events[eventId].handler = std::move(handler);
+	return eventId;
+}
+
+void CEventScheduler::Schedule(EventId eventId, uint32 ticks)
+{
+	assert(eventId < m_eventCount);
+	auto& event = m_events[eventId];
+	if(event.scheduled)
+	{
+		Remove(eventId);
+	}
+	event.deadline = m_currentTime + ticks;
+	Insert(eventId);
+}
+
+void CEventScheduler::Cancel(EventId eventId)
+{
+	assert(eventId < m_eventCount);
+	if(m_events[eventId].scheduled)
+	{
+		Remove(eventId);
+	}
+}
+
+bool CEventScheduler::IsScheduled(EventId eventId) const
+{
+	assert(eventId < m_eventCount);
+	return m_events[eventId].scheduled;
+}
+
+uint32 CEventScheduler::GetTicksUntil(EventId eventId) const
+{
+	assert(eventId < m_eventCount);
+	const auto& event = m_events[eventId];
+	assert(event.scheduled);
+	if(event.deadline <= m_currentTime) return 0;
+	return static_cast<uint32>(event.deadline - m_currentTime);
+}
+
+uint32 CEventScheduler::GetTicksUntilNextEvent(uint32 maxTicks) const
+{
+	auto eventId = FindNextEvent();
+	if(eventId == NO_EVENT) return maxTicks;
+	uint64 deadline = m_events[eventId].deadline;
+	if(deadline <= m_currentTime) return 0;
+	uint64 ticks = deadline - m_currentTime;
+	return (ticks < maxTicks) ? static_cast<uint32>(ticks) : maxTicks;
+}
+
+uint64 CEventScheduler::GetCurrentTime() const
+{
+	return m_currentTime;
+}
+
+void CEventScheduler::Advance(uint32 ticks)
+{
+	m_currentTime += ticks;
+
+	//Wheel doesn't move while dispatching, overdue events stay in the current slot
+	while(1)
+	{
+		auto eventId = FindNextEvent();
+		if(eventId == NO_EVENT) break;
+		auto& event = m_events[eventId];
+		if(event.deadline > m_currentTime) break;
+		Remove(eventId);
+		event.handler(static_cast<uint32>(m_currentTime - event.deadline));
+	}
+
+	uint64 slot = GetSlotIndex(m_currentTime);
+	if(slot != m_currentSlot)
+	{
+		assert(slot > m_currentSlot);
+		m_currentSlot = slot;
+		Cascade();
+	}
+}
+
+void CEventScheduler::Insert(EventId eventId)
+{
+	auto& event = m_events[eventId];
+	assert(!event.scheduled);
+	event.scheduled = true;
+	EventMask eventMask = (static_cast<EventMask>(1) << eventId);
+	if(IsInWheelRange(event.deadline))
+	{
+		uint64 slot = std::max(GetSlotIndex(event.deadline), m_currentSlot);
+		unsigned int slotPosition = static_cast<unsigned int>(slot & (SLOT_COUNT - 1));
+		m_slots[slotPosition] |= eventMask;
+		m_slotOccupancy[slotPosition / 64] |= (1ULL << (slotPosition % 64));
+	}
+	else
+	{
+		m_overflow |= eventMask;
+	}
+	if(!m_nextEventDirty && ((m_nextEvent == NO_EVENT) || (event.deadline < m_events[m_nextEvent].deadline)))
+	{
+		m_nextEvent = eventId;
+	}
+}
+
+void CEventScheduler::Remove(EventId eventId)
+{
+	auto& event = m_events[eventId];
+	assert(event.scheduled);
+	event.scheduled = false;
+	EventMask eventMask = (static_cast<EventMask>(1) << eventId);
+	if(m_overflow & eventMask)
+	{
+		m_overflow &= ~eventMask;
+	}
+	else
+	{
+		uint64 slot = std::max(GetSlotIndex(event.deadline), m_currentSlot);
+		unsigned int slotPosition = static_cast<unsigned int>(slot & (SLOT_COUNT - 1));
+		assert(m_slots[slotPosition] & eventMask);
+		m_slots[slotPosition] &= ~eventMask;
+		if(m_slots[slotPosition] == 0)
+		{
+			m_slotOccupancy[slotPosition / 64] &= ~(1ULL << (slotPosition % 64));
+		}
+	}
+	if(m_nextEvent == eventId)
+	{
+		m_nextEventDirty = true;
+	}
+}
+
+void CEventScheduler::Cascade()
+{
+	//Bring events that are now within the wheel's range out of the overflow list
+	EventMask overflow = m_overflow;
+	while(overflow != 0)
+	{
+		EventId eventId = __builtin_ctz(overflow);
+		overflow &= ~(static_cast<EventMask>(1) << eventId);
+		if(IsInWheelRange(m_events[eventId].deadline))
+		{
+			Remove(eventId);
+			Insert(eventId);
+		}
+	}
+}
+
+CEventScheduler::EventId CEventScheduler::FindNextEvent() const
+{
+	if(!m_nextEventDirty)
+	{
+		return m_nextEvent;
+	}
+
+	m_nextEventDirty = false;
+	m_nextEvent = NO_EVENT;
+
+	//Slots are ordered by time starting from the current one, first occupied slot has the earliest events
+	unsigned int startPosition = static_cast<unsigned int>(m_currentSlot & (SLOT_COUNT - 1));
+	unsigned int wordCount = SLOT_COUNT / 64;
+	unsigned int startWord = startPosition / 64;
+	for(unsigned int i = 0; i <= wordCount; i++)
+	{
+		unsigned int wordIndex = (startWord + i) % wordCount;
+		uint64 occupancy = m_slotOccupancy[wordIndex];
+		if(i == 0)
+		{
+			//Skip slots before the current one
+			occupancy &= (~0ULL << (startPosition % 64));
+		}
+		else if(i == wordCount)
+		{
+			//Wrapped around, only consider slots before the current one
+			occupancy &= ~(~0ULL << (startPosition % 64));
+		}
+		if(occupancy != 0)
+		{
+			unsigned int slotPosition = (wordIndex * 64) + __builtin_ctzll(occupancy);
+			m_nextEvent = FindEarliestEvent(m_slots[slotPosition]);
+			return m_nextEvent;
+		}
+	}
+
+	//Overflow events are always later than anything in the wheel
+	m_nextEvent = FindEarliestEvent(m_overflow);
+	return m_nextEvent;
+}
+
+CEventScheduler::EventId CEventScheduler::FindEarliestEvent(EventMask eventMask) const
+{
+	EventId result = NO_EVENT;
+	while(eventMask != 0)
+	{
+		EventId eventId = __builtin_ctz(eventMask);
+		eventMask &= ~(static_cast<EventMask>(1) << eventId);
+		if((result == NO_EVENT) || (m_events[eventId].deadline < m_events[result].deadline))
+		{
+			result = eventId;
+		}
+	}
+	return result;
+}
+
+uint64 CEventScheduler::GetSlotIndex(uint64 time)
+{
+	return time >> SLOT_TICKS_BITS;
+}
+
+bool CEventScheduler::IsInWheelRange(uint64 deadline) const
+{
+	return GetSlotIndex(deadline) < (m_currentSlot + SLOT_COUNT);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <functional>
+#include "Types.h"
+
+//Timing wheel keeping track of upcoming emulation events (in EE ticks).
+//Components register an event once and then schedule its next deadline,
+//which lets the VM run the CPUs exactly until the earliest event is due
+//instead of polling everything at fixed intervals.
+class CEventScheduler
+{
+public:
+	typedef unsigned int EventId;
+
+	//Handler receives the number of ticks by which the deadline was overshot
+	typedef std::function<void(uint32)> EventHandler;
+
+	enum
+	{
+		MAX_EVENTS = 32,
+		SLOT_TICKS_BITS = 10,
+		SLOT_COUNT_BITS = 8,
+		SLOT_COUNT = (1 << SLOT_COUNT_BITS),
+		NO_EVENT = ~0U,
+	};
+
+	CEventScheduler();
+
+	void Reset();
+
+	EventId RegisterEvent(EventHandler);
+
+	void Schedule(EventId, uint32);
+	void Cancel(EventId);
+
+	bool IsScheduled(EventId) const;
+	uint32 GetTicksUntil(EventId) const;
+	uint32 GetTicksUntilNextEvent(uint32) const;
+
+	uint64 GetCurrentTime() const;
+
+	//Moves time forward and calls handlers of events that became due, in deadline order
+	void Advance(uint32);
+
+private:
+	typedef uint32 EventMask;
+
+	struct EVENT
+	{
+		EventHandler handler;
+		uint64 deadline = 0;
+		bool scheduled = false;
+	};
+
+	static_assert((sizeof(EventMask) * 8) >= MAX_EVENTS, "EventMask is too small.");
+
+	void Insert(EventId);
+	void Remove(EventId);
+	void Cascade();
+	EventId FindNextEvent() const;
+	EventId FindEarliestEvent(EventMask) const;
+
+	static uint64 GetSlotIndex(uint64);
+	bool IsInWheelRange(uint64) const;
+
+	EVENT m_events[MAX_EVENTS];
+	unsigned int m_eventCount = 0;
+
+	EventMask m_slots[SLOT_COUNT];
+	uint64 m_slotOccupancy[SLOT_COUNT / 64];
+	EventMask m_overflow = 0;
+
+	uint64 m_currentTime = 0;
+	uint64 m_currentSlot = 0;
+	mutable EventId m_nextEvent = NO_EVENT;
+	mutable bool m_nextEventDirty = false;
+};
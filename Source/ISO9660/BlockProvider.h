@@ -20,6 +20,22 @@ namespace ISO9660
 		virtual void ReadRawBlock(uint32, void*) = 0;
 		virtual uint32 GetBlockCount() = 0;
 		virtual uint32 GetRawBlockSize() const = 0;
+
+		//Reads consecutive blocks, providers that can should do it in a single read
+		virtual void ReadBlocks(uint32 address, uint32 count, void* blocks)
+		{
+			auto output = reinterpret_cast<uint8*>(blocks);
+			for(uint32 i = 0; i < count; i++)
+			{
+				ReadBlock(address + i, output + (i * BLOCKSIZE));
+			}
+		}
+
+		//Returns a pointer to the block's data if the provider keeps the whole image in memory, nullptr otherwise
+		virtual const uint8* GetBlockData(uint32)
+		{
+			return nullptr;
+		}
 	};
 
 	class CBlockProvider2048 : public CBlockProvider
@@ -39,6 +55,12 @@ namespace ISO9660
 			m_stream->Read(block, BLOCKSIZE);
 		}
 
+		void ReadBlocks(uint32 address, uint32 count, void* blocks) override
+		{
+			m_stream->Seek(static_cast<uint64>(address + m_offset) * BLOCKSIZE, Framework::STREAM_SEEK_SET);
+			m_stream->Read(blocks, static_cast<uint64>(count) * BLOCKSIZE);
+		}
+
 		void ReadRawBlock(uint32 address, void* block) override
 		{
 			ReadBlock(address, block);
@@ -101,4 +123,52 @@ namespace ISO9660
 	};
 
 	typedef CBlockProviderCustom<0x930ULL, 0x18ULL> CBlockProviderCDROMXA;
+
+	//Exposes another provider's blocks starting at some offset (ex.: second layer of a DVD)
+	class CBlockProviderOffset : public CBlockProvider
+	{
+	public:
+		typedef std::shared_ptr<CBlockProvider> BlockProviderPtr;
+
+		CBlockProviderOffset(const BlockProviderPtr& provider, uint32 offset)
+		    : m_provider(provider)
+		    , m_offset(offset)
+		{
+		}
+
+		void ReadBlock(uint32 address, void* block) override
+		{
+			m_provider->ReadBlock(address + m_offset, block);
+		}
+
+		void ReadBlocks(uint32 address, uint32 count, void* blocks) override
+		{
+			m_provider->ReadBlocks(address + m_offset, count, blocks);
+		}
+
+		void ReadRawBlock(uint32 address, void* block) override
+		{
+			m_provider->ReadRawBlock(address + m_offset, block);
+		}
+
+		const uint8* GetBlockData(uint32 address) override
+		{
+			return m_provider->GetBlockData(address + m_offset);
+		}
+
+		uint32 GetBlockCount() override
+		{
+			uint32 blockCount = m_provider->GetBlockCount();
+			return (blockCount > m_offset) ? (blockCount - m_offset) : 0;
+		}
+
+		uint32 GetRawBlockSize() const override
+		{
+			return m_provider->GetRawBlockSize();
+		}
+
+	private:
+		BlockProviderPtr m_provider;
+		uint32 m_offset = 0;
+	};
 }
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstring>
+#include "BlockProviderMapped.h"
+
+using namespace ISO9660;
+
+CBlockProviderMapped::CBlockProviderMapped(const MappedStreamPtr& stream, uint32 internalBlockSize, uint32 blockHeaderSize)
+    : m_stream(stream)
+    , m_data(stream->GetData())
+    , m_internalBlockSize(internalBlockSize)
+    , m_blockHeaderSize(blockHeaderSize)
+{
+	assert((m_blockHeaderSize + BLOCKSIZE) <= m_internalBlockSize);
+	m_size = m_stream->GetSize();
+	m_blockCount = static_cast<uint32>(m_size / m_internalBlockSize);
+}
+
+void CBlockProviderMapped::ReadBlock(uint32 address, void* block)
+{
+	TrackAccess(address, 1);
+	CopyData((static_cast<uint64>(address) * m_internalBlockSize) + m_blockHeaderSize, BLOCKSIZE, reinterpret_cast<uint8*>(block));
+}
+
+void CBlockProviderMapped::ReadBlocks(uint32 address, uint32 count, void* blocks)
+{
+	TrackAccess(address, count);
+	auto output = reinterpret_cast<uint8*>(blocks);
+	if(m_internalBlockSize == BLOCKSIZE)
+	{
+		CopyData(static_cast<uint64>(address) * BLOCKSIZE, static_cast<uint64>(count) * BLOCKSIZE, output);
+		return;
+	}
+	for(uint32 i = 0; i < count; i++)
+	{
+		uint64 position = (static_cast<uint64>(address + i) * m_internalBlockSize) + m_blockHeaderSize;
+		CopyData(position, BLOCKSIZE, output + (i * BLOCKSIZE));
+	}
+}
+
+void CBlockProviderMapped::ReadRawBlock(uint32 address, void* block)
+{
+	CopyData(static_cast<uint64>(address) * m_internalBlockSize, m_internalBlockSize, reinterpret_cast<uint8*>(block));
+}
+
+uint32 CBlockProviderMapped::GetBlockCount()
+{
+	return m_blockCount;
+}
+
+uint32 CBlockProviderMapped::GetRawBlockSize() const
+{
+	return m_internalBlockSize;
+}
+
+const uint8* CBlockProviderMapped::GetBlockData(uint32 address)
+{
+	uint64 position = (static_cast<uint64>(address) * m_internalBlockSize) + m_blockHeaderSize;
+	if((position + BLOCKSIZE) > m_size)
+	{
+		//Block isn't entirely inside the image, let ReadBlock deal with it
+		return nullptr;
+	}
+	TrackAccess(address, 1);
+	return m_data + position;
+}
+
+void CBlockProviderMapped::CopyData(uint64 position, uint64 size, uint8* output) const
+{
+	//Stream based providers do short reads past the end of the image, copy what we have and clear the rest
+	uint64 availableSize = (position < m_size) ? std::min(size, m_size - position) : 0;
+	if(availableSize != 0)
+	{
+		memcpy(output, m_data + position, availableSize);
+	}
+	memset(output + availableSize, 0, size - availableSize);
+}
+
+void CBlockProviderMapped::TrackAccess(uint32 address, uint32 count)
+{
+	uint32 sequentialCount = (address == m_nextAddress.load(std::memory_order_relaxed)) ? (m_sequentialCount.load(std::memory_order_relaxed) + count) : 0;
+	m_sequentialCount.store(sequentialCount, std::memory_order_relaxed);
+	m_nextAddress.store(address + count, std::memory_order_relaxed);
+	if(sequentialCount < SEQUENTIAL_THRESHOLD) return;
+
+	//Keep a window of blocks ahead of the reader in flight, renewed once half of it has been consumed
+	uint32 readEnd = address + count;
+	uint32 adviseEnd = m_adviseEnd.load(std::memory_order_relaxed);
+	bool windowValid = (adviseEnd >= readEnd) && (adviseEnd <= (readEnd + ADVISE_WINDOW_BLOCK_COUNT));
+	if(windowValid && ((adviseEnd - readEnd) >= (ADVISE_WINDOW_BLOCK_COUNT / 2))) return;
+
+	uint32 adviseStart = windowValid ? adviseEnd : readEnd;
+	uint32 newAdviseEnd = std::min<uint32>(readEnd + ADVISE_WINDOW_BLOCK_COUNT, m_blockCount);
+	if(newAdviseEnd <= adviseStart) return;
+	m_adviseEnd.store(newAdviseEnd, std::memory_order_relaxed);
+
+	uint64 offset = static_cast<uint64>(adviseStart) * m_internalBlockSize;
+	uint64 size = static_cast<uint64>(newAdviseEnd - adviseStart) * m_internalBlockSize;
+	m_stream->AdviseSequential(offset, size);
+	m_stream->AdviseWillNeed(offset, size);
+}
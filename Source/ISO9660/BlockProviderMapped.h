@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include "BlockProvider.h"
+#include "../discimages/MappedImageStream.h"
+
+namespace ISO9660
+{
+	//Reads blocks straight from a memory mapped image, no system calls or stream state involved.
+	//Sequential accesses are detected to let the OS know which parts of the image we'll need next.
+	class CBlockProviderMapped : public CBlockProvider
+	{
+	public:
+		typedef std::shared_ptr<CMappedImageStream> MappedStreamPtr;
+
+		CBlockProviderMapped(const MappedStreamPtr&, uint32 internalBlockSize = BLOCKSIZE, uint32 blockHeaderSize = 0);
+
+		void ReadBlock(uint32, void*) override;
+		void ReadBlocks(uint32, uint32, void*) override;
+		void ReadRawBlock(uint32, void*) override;
+		uint32 GetBlockCount() override;
+		uint32 GetRawBlockSize() const override;
+
+		const uint8* GetBlockData(uint32) override;
+
+	private:
+		enum
+		{
+			//Number of consecutive blocks read before we consider access to be sequential
+			SEQUENTIAL_THRESHOLD = 2,
+			ADVISE_WINDOW_BLOCK_COUNT = 0x200,
+		};
+
+		void CopyData(uint64, uint64, uint8*) const;
+		void TrackAccess(uint32, uint32);
+
+		MappedStreamPtr m_stream;
+		const uint8* m_data = nullptr;
+		uint64 m_size = 0;
+		uint32 m_internalBlockSize = BLOCKSIZE;
+		uint32 m_blockHeaderSize = 0;
+		uint32 m_blockCount = 0;
+
+		//Only used for hints, concurrent readers can make these inaccurate, but that's harmless
+		std::atomic<uint32> m_nextAddress = {~0U};
+		std::atomic<uint32> m_sequentialCount = {0};
+		std::atomic<uint32> m_adviseEnd = {0};
+	};
+}
@@ -0,0 +1,68 @@
+#include <cstring>
+#include "BlockProviderReadAhead.h"
+
+using namespace ISO9660;
+
+static CReadAheadCache::PARAMS MakeCacheParams(uint32 chunkBlockCount, uint32 chunkCount, uint32 readAheadChunkCount)
+{
+	CReadAheadCache::PARAMS params;
+	params.unitsPerBlock = chunkBlockCount;
+	params.slotCount = chunkCount;
+	params.threadCount = 1;
+	params.readAheadCount = readAheadChunkCount;
+	params.threadName = "Disc Read Ahead Thread";
+	return params;
+}
+
+CBlockProviderReadAhead::CBlockProviderReadAhead(const BlockProviderPtr& provider)
+    : m_provider(provider)
+    , m_cache(MakeCacheParams(CHUNK_BLOCK_COUNT, CHUNK_COUNT, READ_AHEAD_CHUNK_COUNT),
+              [this](uint32 chunkIndex, CReadAheadCache::Block& data) { ReadChunk(chunkIndex, data); })
+{
+}
+
+CBlockProviderReadAhead::~CBlockProviderReadAhead()
+{
+}
+
+void CBlockProviderReadAhead::ReadBlock(uint32 address, void* block)
+{
+	bool cached = m_cache.Read(address, [&](CReadAheadCache::Block& data) {
+		uint32 blockOffset = address % CHUNK_BLOCK_COUNT;
+		memcpy(block, data.data() + (blockOffset * BLOCKSIZE), BLOCKSIZE);
+	});
+	if(cached)
+	{
+		return;
+	}
+
+	//Not cached or read ahead failed, read it directly to let errors reach the caller
+	std::lock_guard<std::mutex> providerLock(m_providerMutex);
+	m_provider->ReadBlock(address, block);
+}
+
+void CBlockProviderReadAhead::ReadRawBlock(uint32 address, void* block)
+{
+	std::lock_guard<std::mutex> providerLock(m_providerMutex);
+	m_provider->ReadRawBlock(address, block);
+}
+
+uint32 CBlockProviderReadAhead::GetBlockCount()
+{
+	std::lock_guard<std::mutex> providerLock(m_providerMutex);
+	return m_provider->GetBlockCount();
+}
+
+uint32 CBlockProviderReadAhead::GetRawBlockSize() const
+{
+	return m_provider->GetRawBlockSize();
+}
+
+void CBlockProviderReadAhead::ReadChunk(uint32 chunkIndex, CReadAheadCache::Block& data)
+{
+	//A chunk that goes past the end of the image will contain junk in its last blocks, but
+	//reading those directly wouldn't give anything meaningful either.
+	data.resize(CHUNK_BLOCK_COUNT * BLOCKSIZE);
+	std::lock_guard<std::mutex> providerLock(m_providerMutex);
+	m_provider->ReadBlocks(chunkIndex * CHUNK_BLOCK_COUNT, CHUNK_BLOCK_COUNT, data.data());
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <mutex>
+#include "BlockProvider.h"
+#include "../ReadAheadCache.h"
+
+namespace ISO9660
+{
+	//Wraps another provider and reads ahead of sequential accesses (ex.: CdRead, CdStRead)
+	//in large chunks on an I/O thread, later reads are then served from memory. Random
+	//accesses go straight to the wrapped provider. The wrapped provider (and its stream)
+	//must not be used by anything else once wrapped.
+	class CBlockProviderReadAhead : public CBlockProvider
+	{
+	public:
+		typedef std::shared_ptr<CBlockProvider> BlockProviderPtr;
+
+		CBlockProviderReadAhead(const BlockProviderPtr&);
+		virtual ~CBlockProviderReadAhead();
+
+		void ReadBlock(uint32, void*) override;
+		void ReadRawBlock(uint32, void*) override;
+		uint32 GetBlockCount() override;
+		uint32 GetRawBlockSize() const override;
+
+	private:
+		enum
+		{
+			CHUNK_BLOCK_COUNT = 0x80, //256KB per read
+			CHUNK_COUNT = 8,
+			READ_AHEAD_CHUNK_COUNT = 2,
+		};
+
+		void ReadChunk(uint32, CReadAheadCache::Block&);
+
+		BlockProviderPtr m_provider;
+		std::mutex m_providerMutex;
+
+		//Declared last, its thread uses the provider until it's destroyed
+		CReadAheadCache m_cache;
+	};
+}
@@ -1,4 +1,5 @@
 #include <string.h>
+#include <algorithm>
 #include "DirectoryRecord.h"
 
 using namespace ISO9660;
@@ -30,6 +31,17 @@ CDirectoryRecord::CDirectoryRecord(Framework::CStream* stream)
 	}
 }
 
+CDirectoryRecord::CDirectoryRecord(const char* name, uint32 position, uint32 dataLength, uint8 flags)
+    : m_position(position)
+    , m_dataLength(dataLength)
+    , m_flags(flags)
+{
+	size_t nameSize = std::min<size_t>(strlen(name), sizeof(m_name) - 1);
+	memcpy(m_name, name, nameSize);
+	m_name[nameSize] = 0x00;
+	m_length = static_cast<uint8>(std::min<size_t>(0x21 + nameSize, 0xFF));
+}
+
 CDirectoryRecord::~CDirectoryRecord()
 {
 }
@@ -44,6 +56,11 @@ bool CDirectoryRecord::IsDirectory() const
 	return (m_flags & 0x02) != 0;
 }
 
+uint8 CDirectoryRecord::GetFlags() const
+{
+	return m_flags;
+}
+
 const char* CDirectoryRecord::GetName() const
 {
 	return m_name;
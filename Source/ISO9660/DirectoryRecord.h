@@ -10,9 +10,11 @@ namespace ISO9660
 	public:
 		CDirectoryRecord();
 		CDirectoryRecord(Framework::CStream*);
+		CDirectoryRecord(const char*, uint32, uint32, uint8);
 		~CDirectoryRecord();
 
 		bool IsDirectory() const;
+		uint8 GetFlags() const;
 		uint8 GetLength() const;
 		const char* GetName() const;
 		uint32 GetPosition() const;
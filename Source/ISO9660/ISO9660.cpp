@@ -1,10 +1,21 @@
 #include <string.h>
 #include <limits.h>
+#include <algorithm>
+#include <cassert>
+#include <vector>
 #include "ISO9660.h"
 #include "StdStream.h"
+#include "StdStreamUtils.h"
 #include "File.h"
 #include "DirectoryRecord.h"
+#include "PathUtils.h"
+#include "ThreadUtils.h"
 #include "stricmp.h"
+#include "string_format.h"
+#include "xxhash.h"
+
+#define VOLUME_DESCRIPTOR_LBA 16
+#define MAX_PATH_TABLE_BLOCKS 0x100
 
 using namespace ISO9660;
 
@@ -17,10 +28,21 @@ CISO9660::CISO9660(const BlockProviderPtr& blockProvider)
 
 CISO9660::~CISO9660()
 {
+	m_pathIndexCancelled = true;
+	if(m_pathIndexThread.joinable())
+	{
+		m_pathIndexThread.join();
+	}
 }
 
 void CISO9660::ReadBlock(uint32 address, void* data)
 {
+	//Blocks that are already in memory can be copied directly to their destination
+	if(auto blockData = m_blockProvider->GetBlockData(address))
+	{
+		memcpy(data, blockData, CBlockProvider::BLOCKSIZE);
+		return;
+	}
 	//The buffer is needed to make sure exception handlers
 	//are properly called as some system calls (ie.: ReadFile)
 	//won't generate an exception when trying to write to
@@ -31,6 +53,16 @@ void CISO9660::ReadBlock(uint32 address, void* data)
 
 bool CISO9660::GetFileRecord(CDirectoryRecord* record, const char* filename)
 {
+	if(m_pathIndexEnabled && !m_pathIndexThread.joinable())
+	{
+		m_pathIndexThread = std::thread([this]() { PathIndexThreadProc(); });
+		Framework::ThreadUtils::SetThreadName(m_pathIndexThread, "ISO9660 Path Index Thread");
+	}
+	if(m_pathIndexReady)
+	{
+		return m_pathIndex->GetFileRecord(record, filename);
+	}
+
 	//Remove the first '/'
 	if(filename[0] == '/' || filename[0] == '\\') filename++;
 
@@ -59,13 +91,8 @@ bool CISO9660::GetFileRecord(CDirectoryRecord* record, const char* filename)
 
 bool CISO9660::GetFileRecordFromDirectory(CDirectoryRecord* record, uint32 address, const char* filename)
 {
-	CFile directory(m_blockProvider.get(), address * CBlockProvider::BLOCKSIZE);
-
-	while(1)
+	for(const auto& entry : CPathIndex::ReadDirectory(m_blockProvider.get(), address))
 	{
-		CDirectoryRecord entry(&directory);
-
-		if(entry.GetLength() == 0) break;
 		if(strnicmp(entry.GetName(), filename, strlen(filename))) continue;
 
 		(*record) = entry;
@@ -98,3 +125,79 @@ Framework::CStream* CISO9660::OpenDirectory(const char* path)
 
 	return nullptr;
 }
+
+void CISO9660::EnablePathIndex(const fs::path& cacheDirectory, uint64 imageIdentity)
+{
+	assert(!m_pathIndexThread.joinable());
+	m_pathIndexCacheDirectory = cacheDirectory;
+	m_pathIndexImageIdentity = imageIdentity;
+	m_pathIndexEnabled = true;
+}
+
+uint64 CISO9660::ComputeContentHash()
+{
+	//Volume descriptor and path table change along with the file system's layout,
+	//hashing them is much cheaper than scanning all directories
+	std::vector<uint8> data(CBlockProvider::BLOCKSIZE);
+	CFile volumeDescriptor(m_blockProvider.get(), VOLUME_DESCRIPTOR_LBA * CBlockProvider::BLOCKSIZE, CBlockProvider::BLOCKSIZE);
+	volumeDescriptor.Read(data.data(), CBlockProvider::BLOCKSIZE);
+
+	uint32 pathTableSize = 0;
+	memcpy(&pathTableSize, data.data() + 0x84, sizeof(uint32));
+	pathTableSize = std::min<uint32>(pathTableSize, MAX_PATH_TABLE_BLOCKS * CBlockProvider::BLOCKSIZE);
+	data.resize(CBlockProvider::BLOCKSIZE + pathTableSize);
+	CFile pathTable(m_blockProvider.get(), static_cast<uint64>(m_volumeDescriptor.GetLPathTableAddress()) * CBlockProvider::BLOCKSIZE, pathTableSize);
+	pathTable.Read(data.data() + CBlockProvider::BLOCKSIZE, pathTableSize);
+
+	return XXH3_64bits_withSeed(data.data(), data.size(), m_blockProvider->GetBlockCount());
+}
+
+void CISO9660::PathIndexThreadProc()
+{
+	try
+	{
+		//Content hash doesn't see files that were changed in place (ex.: patched images),
+		//the image's identity changes when that happens
+		uint64 contentHash = ComputeContentHash();
+		uint64 indexKey = XXH3_64bits_withSeed(&contentHash, sizeof(contentHash), m_pathIndexImageIdentity);
+		auto indexPath = m_pathIndexCacheDirectory / string_format("%016llx.idx", static_cast<unsigned long long>(indexKey));
+
+		std::unique_ptr<CPathIndex> pathIndex;
+		if(fs::exists(indexPath))
+		{
+			auto stream = Framework::CreateInputStdStream(indexPath.native());
+			pathIndex = CPathIndex::Load(stream, indexKey);
+		}
+
+		if(!pathIndex)
+		{
+			unsigned int rootIndex = m_pathTable.FindRoot();
+			pathIndex = CPathIndex::Build(m_blockProvider.get(), m_pathTable.GetDirectoryAddress(rootIndex), m_pathIndexCancelled);
+			if(!pathIndex) return;
+
+			try
+			{
+				//Write to a temporary file first to never leave a partial index behind
+				auto tempIndexPath = indexPath;
+				tempIndexPath.replace_extension(".tmp");
+				Framework::PathUtils::EnsurePathExists(m_pathIndexCacheDirectory);
+				{
+					auto stream = Framework::CreateOutputStdStream(tempIndexPath.native());
+					pathIndex->Save(stream, indexKey);
+				}
+				fs::rename(tempIndexPath, indexPath);
+			}
+			catch(const std::exception&)
+			{
+				//Not being able to save the index is fine, it will be built again next time
+			}
+		}
+
+		m_pathIndex = std::move(pathIndex);
+		m_pathIndexReady = true;
+	}
+	catch(const std::exception&)
+	{
+		//Lookups will keep reading directories from the disc
+	}
+}
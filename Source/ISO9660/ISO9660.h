@@ -1,10 +1,14 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <thread>
+#include "filesystem_def.h"
 #include "BlockProvider.h"
 #include "VolumeDescriptor.h"
 #include "PathTable.h"
 #include "DirectoryRecord.h"
+#include "PathIndex.h"
 
 class CISO9660
 {
@@ -20,12 +24,30 @@ public:
 	Framework::CStream* OpenDirectory(const char*);
 	bool GetFileRecord(ISO9660::CDirectoryRecord*, const char*);
 
+	//Builds an index of all paths on a background thread on the next lookup, lookups don't read
+	//directories from the disc once it's ready. The index is saved in the cache directory and
+	//reused as long as the image identity (see DiskUtils::GetImageIdentity), the volume descriptor
+	//and path table don't change. Images without an identity (0) only rely on the latter two.
+	//The block provider must support reads from multiple threads.
+	void EnablePathIndex(const fs::path&, uint64);
+
 private:
 	bool GetFileRecordFromDirectory(ISO9660::CDirectoryRecord*, uint32, const char*);
 
+	uint64 ComputeContentHash();
+	void PathIndexThreadProc();
+
 	BlockProviderPtr m_blockProvider;
 	ISO9660::CVolumeDescriptor m_volumeDescriptor;
 	ISO9660::CPathTable m_pathTable;
 
+	fs::path m_pathIndexCacheDirectory;
+	uint64 m_pathIndexImageIdentity = 0;
+	bool m_pathIndexEnabled = false;
+	std::unique_ptr<ISO9660::CPathIndex> m_pathIndex;
+	std::atomic<bool> m_pathIndexReady = {false};
+	std::atomic<bool> m_pathIndexCancelled = {false};
+	std::thread m_pathIndexThread;
+
 	uint8 m_blockBuffer[ISO9660::CBlockProvider::BLOCKSIZE];
 };
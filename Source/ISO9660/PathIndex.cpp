@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+#include "PathIndex.h"
+#include "File.h"
+#include "stricmp.h"
+
+using namespace ISO9660;
+
+#define INDEX_MAGIC 0x58444950 //'PIDX'
+#define INDEX_VERSION 1
+
+//Guards against corrupted images referencing directories in loops
+#define MAX_DIRECTORY_COUNT 0x10000
+#define MAX_DIRECTORY_SIZE 0x1000000
+
+std::unique_ptr<CPathIndex> CPathIndex::Build(CBlockProvider* blockProvider, uint32 rootAddress, const std::atomic<bool>& cancelled)
+{
+	auto result = std::make_unique<CPathIndex>();
+
+	std::vector<std::pair<std::string, uint32>> pendingDirectories;
+	std::unordered_set<uint32> visitedAddresses;
+	pendingDirectories.emplace_back(std::string(), rootAddress);
+	visitedAddresses.insert(rootAddress);
+
+	while(!pendingDirectories.empty())
+	{
+		if(cancelled) return nullptr;
+
+		auto directory = std::move(pendingDirectories.back());
+		pendingDirectories.pop_back();
+
+		EntryArray entries;
+		for(const auto& record : ReadDirectory(blockProvider, directory.second))
+		{
+			ENTRY entry;
+			entry.name = record.GetName();
+			entry.position = record.GetPosition();
+			entry.dataLength = record.GetDataLength();
+			entry.flags = record.GetFlags();
+
+			//Skip '.' and '..'
+			bool isSelfOrParent = (entry.name.size() <= 1) && ((entry.name.empty()) || (entry.name[0] == 0x01));
+			if(record.IsDirectory() && !isSelfOrParent && visitedAddresses.insert(entry.position).second)
+			{
+				if(visitedAddresses.size() > MAX_DIRECTORY_COUNT)
+				{
+					throw std::runtime_error("Too many directories.");
+				}
+				auto path = directory.first.empty() ? entry.name : (directory.first + "/" + entry.name);
+				pendingDirectories.emplace_back(ToUpper(path), entry.position);
+			}
+			entries.push_back(std::move(entry));
+		}
+		result->AddDirectory(directory.first, std::move(entries));
+	}
+
+	return result;
+}
+
+std::unique_ptr<CPathIndex> CPathIndex::Load(Framework::CStream& stream, uint64 contentHash)
+{
+	try
+	{
+		if(stream.Read32() != INDEX_MAGIC) return nullptr;
+		if(stream.Read32() != INDEX_VERSION) return nullptr;
+		uint64 storedContentHash = stream.Read64();
+		if(storedContentHash != contentHash) return nullptr;
+
+		auto readString = [&stream](uint32 length) {
+			std::string result(length, 0);
+			if(stream.Read(&result[0], length) != length)
+			{
+				throw std::runtime_error("Failed to read string.");
+			}
+			return result;
+		};
+
+		auto result = std::make_unique<CPathIndex>();
+		uint32 directoryCount = stream.Read32();
+		if(directoryCount > MAX_DIRECTORY_COUNT) return nullptr;
+		for(uint32 i = 0; i < directoryCount; i++)
+		{
+			auto path = readString(stream.Read16());
+			uint32 entryCount = stream.Read32();
+			if(entryCount > (MAX_DIRECTORY_SIZE / 0x21)) return nullptr;
+			EntryArray entries;
+			entries.reserve(entryCount);
+			for(uint32 j = 0; j < entryCount; j++)
+			{
+				ENTRY entry;
+				entry.name = readString(stream.Read8());
+				entry.position = stream.Read32();
+				entry.dataLength = stream.Read32();
+				entry.flags = stream.Read8();
+				entries.push_back(std::move(entry));
+			}
+			result->AddDirectory(path, std::move(entries));
+		}
+		return result;
+	}
+	catch(const std::exception&)
+	{
+		return nullptr;
+	}
+}
+
+void CPathIndex::Save(Framework::CStream& stream, uint64 contentHash) const
+{
+	stream.Write32(INDEX_MAGIC);
+	stream.Write32(INDEX_VERSION);
+	stream.Write64(contentHash);
+	stream.Write32(static_cast<uint32>(m_directories.size()));
+	for(const auto& directoryPair : m_directories)
+	{
+		const auto& path = directoryPair.first;
+		stream.Write16(static_cast<uint16>(path.size()));
+		stream.Write(path.data(), path.size());
+		stream.Write32(static_cast<uint32>(directoryPair.second.size()));
+		for(const auto& entry : directoryPair.second)
+		{
+			stream.Write8(static_cast<uint8>(entry.name.size()));
+			stream.Write(entry.name.data(), entry.name.size());
+			stream.Write32(entry.position);
+			stream.Write32(entry.dataLength);
+			stream.Write8(entry.flags);
+		}
+	}
+}
+
+CPathIndex::DirectoryRecordArray CPathIndex::ReadDirectory(CBlockProvider* blockProvider, uint32 address)
+{
+	DirectoryRecordArray records;
+	CFile directory(blockProvider, static_cast<uint64>(address) * CBlockProvider::BLOCKSIZE);
+	//Actual size is known once we've read the '.' record
+	uint64 directorySize = CBlockProvider::BLOCKSIZE;
+	while(1)
+	{
+		uint64 recordPosition = directory.Tell();
+		if(recordPosition >= directorySize) break;
+
+		CDirectoryRecord record(&directory);
+		if(record.GetLength() == 0)
+		{
+			//Records don't cross block boundaries, rest of the block is padding
+			uint64 nextBlockPosition = ((recordPosition / CBlockProvider::BLOCKSIZE) + 1) * CBlockProvider::BLOCKSIZE;
+			directory.Seek(nextBlockPosition, Framework::STREAM_SEEK_SET);
+			continue;
+		}
+		if(records.empty())
+		{
+			directorySize = std::min<uint64>(std::max<uint64>(record.GetDataLength(), CBlockProvider::BLOCKSIZE), MAX_DIRECTORY_SIZE);
+		}
+		records.push_back(record);
+	}
+	return records;
+}
+
+bool CPathIndex::GetFileRecord(CDirectoryRecord* record, const char* path) const
+{
+	if(path[0] == '/' || path[0] == '\\') path++;
+	auto key = ToUpper(path);
+
+	auto fileIterator = m_files.find(key);
+	if(fileIterator != std::end(m_files))
+	{
+		GetRecord(record, fileIterator->second);
+		return true;
+	}
+
+	//Not a full name (ex.: missing version number), look for the first name starting with it
+	auto separatorPosition = key.rfind('/');
+	auto directoryPath = (separatorPosition == std::string::npos) ? std::string() : key.substr(0, separatorPosition);
+	auto name = (separatorPosition == std::string::npos) ? key : key.substr(separatorPosition + 1);
+	auto directoryIterator = m_directories.find(directoryPath);
+	if(directoryIterator == std::end(m_directories)) return false;
+	for(const auto& entry : directoryIterator->second)
+	{
+		if(strnicmp(entry.name.c_str(), name.c_str(), name.size())) continue;
+		GetRecord(record, entry);
+		return true;
+	}
+	return false;
+}
+
+void CPathIndex::AddDirectory(const std::string& path, EntryArray entries)
+{
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		const auto& entry = entries[i];
+		if(entry.name.empty() || (entry.name[0] == 0x01)) continue;
+		auto name = ToUpper(entry.name);
+		//Lookups return the first entry starting with the name, which is almost always the entry itself
+		size_t matchIndex = 0;
+		for(; matchIndex < i; matchIndex++)
+		{
+			if(!strnicmp(entries[matchIndex].name.c_str(), name.c_str(), name.size())) break;
+		}
+		auto key = path.empty() ? name : (path + "/" + name);
+		m_files.emplace(std::move(key), entries[matchIndex]);
+	}
+	m_directories[path] = std::move(entries);
+}
+
+std::string CPathIndex::ToUpper(std::string value)
+{
+	for(auto& character : value)
+	{
+		character = static_cast<char>(toupper(static_cast<unsigned char>(character)));
+	}
+	return value;
+}
+
+void CPathIndex::GetRecord(CDirectoryRecord* record, const ENTRY& entry)
+{
+	(*record) = CDirectoryRecord(entry.name.c_str(), entry.position, entry.dataLength, entry.flags);
+}
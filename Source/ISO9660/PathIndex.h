@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BlockProvider.h"
+#include "DirectoryRecord.h"
+
+namespace ISO9660
+{
+	//In-memory index of every directory and file of a file system, to resolve paths without
+	//reading any directory from the disc. Lookups follow the same rules as CISO9660::GetFileRecord.
+	class CPathIndex
+	{
+	public:
+		typedef std::vector<CDirectoryRecord> DirectoryRecordArray;
+
+		//Returns null if cancelled
+		static std::unique_ptr<CPathIndex> Build(CBlockProvider*, uint32, const std::atomic<bool>&);
+		//Returns null if the stream doesn't contain a valid index for the specified content hash
+		static std::unique_ptr<CPathIndex> Load(Framework::CStream&, uint64);
+		void Save(Framework::CStream&, uint64) const;
+
+		//Reads all records of the directory at the specified block, including '.' and '..'
+		static DirectoryRecordArray ReadDirectory(CBlockProvider*, uint32);
+
+		bool GetFileRecord(CDirectoryRecord*, const char*) const;
+
+	private:
+		struct ENTRY
+		{
+			std::string name;
+			uint32 position = 0;
+			uint32 dataLength = 0;
+			uint8 flags = 0;
+		};
+		typedef std::vector<ENTRY> EntryArray;
+
+		void AddDirectory(const std::string&, EntryArray);
+		static std::string ToUpper(std::string);
+		static void GetRecord(CDirectoryRecord*, const ENTRY&);
+
+		//Keys are upper case paths, without leading separator
+		std::unordered_map<std::string, EntryArray> m_directories;
+		std::unordered_map<std::string, ENTRY> m_files;
+	};
+}
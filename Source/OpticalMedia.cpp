@@ -1,16 +1,36 @@
 #include <cassert>
 #include <cstring>
 #include "OpticalMedia.h"
+#include "ISO9660/BlockProviderMapped.h"
+#include "ISO9660/BlockProviderReadAhead.h"
 
 #define DVD_LAYER_MAX_BLOCKS 2295104
 
+static COpticalMedia::BlockProviderPtr CreateBlockProvider2048(const COpticalMedia::StreamPtr& stream)
+{
+	if(auto mappedStream = std::dynamic_pointer_cast<CMappedImageStream>(stream))
+	{
+		return std::make_shared<ISO9660::CBlockProviderMapped>(mappedStream);
+	}
+	return std::make_shared<ISO9660::CBlockProvider2048>(stream);
+}
+
+static COpticalMedia::BlockProviderPtr CreateBlockProviderCDROMXA(const COpticalMedia::StreamPtr& stream)
+{
+	if(auto mappedStream = std::dynamic_pointer_cast<CMappedImageStream>(stream))
+	{
+		return std::make_shared<ISO9660::CBlockProviderMapped>(mappedStream, 0x930, 0x18);
+	}
+	return std::make_shared<ISO9660::CBlockProviderCDROMXA>(stream);
+}
+
 std::unique_ptr<COpticalMedia> COpticalMedia::CreateAuto(StreamPtr& stream, uint32 createFlags)
 {
 	auto result = std::make_unique<COpticalMedia>();
 	//Simulate a disk with only one data track
 	try
 	{
-		auto blockProvider = std::make_shared<ISO9660::CBlockProvider2048>(stream);
+		auto blockProvider = CreateBlockProvider2048(stream);
 		result->m_fileSystem = std::make_unique<CISO9660>(blockProvider);
 		result->m_track0DataType = TRACK_DATA_TYPE_MODE1_2048;
 		result->m_track0BlockProvider = blockProvider;
@@ -18,7 +38,7 @@ std::unique_ptr<COpticalMedia> COpticalMedia::CreateAuto(StreamPtr& stream, uint
 	catch(...)
 	{
 		//Failed with block size 2048, try with CD-ROM XA
-		auto blockProvider = std::make_shared<ISO9660::CBlockProviderCDROMXA>(stream);
+		auto blockProvider = CreateBlockProviderCDROMXA(stream);
 		result->m_fileSystem = std::make_unique<CISO9660>(blockProvider);
 		result->m_track0DataType = TRACK_DATA_TYPE_MODE2_2352;
 		result->m_track0BlockProvider = blockProvider;
@@ -31,35 +51,45 @@ std::unique_ptr<COpticalMedia> COpticalMedia::CreateAuto(StreamPtr& stream, uint
 		try
 		{
 			result->CheckDualLayerDvd(stream);
-			result->SetupSecondLayer(stream);
 		}
 		catch(...)
 		{
 			//Failed to check if we got a dual layer DVD (ex.: Couldn't get stream size of physical disc)
 		}
 	}
+
+	//The stream is only accessed through the block provider from now on
+	result->SetupReadAhead();
+
+	try
+	{
+		result->SetupSecondLayer();
+	}
+	catch(...)
+	{
+		//Second layer doesn't contain a valid file system
+	}
 	return result;
 }
 
 std::unique_ptr<COpticalMedia> COpticalMedia::CreateDvd(StreamPtr& stream, bool isDualLayer, uint32 secondLayerStart)
 {
 	auto result = std::make_unique<COpticalMedia>();
-	auto blockProvider = std::make_shared<ISO9660::CBlockProvider2048>(stream);
-	result->m_fileSystem = std::make_unique<CISO9660>(blockProvider);
 	result->m_track0DataType = TRACK_DATA_TYPE_MODE1_2048;
-	result->m_track0BlockProvider = blockProvider;
+	result->m_track0BlockProvider = CreateBlockProvider2048(stream);
 	result->m_dvdIsDualLayer = isDualLayer;
 	result->m_dvdSecondLayerStart = secondLayerStart;
-	result->SetupSecondLayer(stream);
+	result->SetupReadAhead();
+	result->SetupSecondLayer();
 	return result;
 }
 
 std::unique_ptr<COpticalMedia> COpticalMedia::CreateCustomSingleTrack(BlockProviderPtr blockProvider, TRACK_DATA_TYPE trackDataType)
 {
 	auto result = std::make_unique<COpticalMedia>();
-	result->m_fileSystem = std::make_unique<CISO9660>(blockProvider);
 	result->m_track0DataType = trackDataType;
 	result->m_track0BlockProvider = blockProvider;
+	result->SetupReadAhead();
 	return result;
 }
 
@@ -97,6 +127,18 @@ uint32 COpticalMedia::GetDvdSecondLayerStart() const
 	return m_dvdSecondLayerStart - 0x10;
 }
 
+void COpticalMedia::EnablePathIndex(const fs::path& cacheDirectory, uint64 imageIdentity)
+{
+	if(m_fileSystem)
+	{
+		m_fileSystem->EnablePathIndex(cacheDirectory, imageIdentity);
+	}
+	if(m_fileSystemL1)
+	{
+		m_fileSystemL1->EnablePathIndex(cacheDirectory, imageIdentity);
+	}
+}
+
 void COpticalMedia::CheckDualLayerDvd(const StreamPtr& stream)
 {
 	//Heuristic to detect dual layer DVD disc images
@@ -146,9 +188,27 @@ void COpticalMedia::CheckDualLayerDvd(const StreamPtr& stream)
 	assert(m_dvdSecondLayerStart != 0);
 }
 
-void COpticalMedia::SetupSecondLayer(const StreamPtr& stream)
+void COpticalMedia::SetupReadAhead()
+{
+	//Mapped images are read ahead by the OS, reads never block on anything but page faults
+	if(std::dynamic_pointer_cast<ISO9660::CBlockProviderMapped>(m_track0BlockProvider))
+	{
+		if(!m_fileSystem)
+		{
+			m_fileSystem = std::make_unique<CISO9660>(m_track0BlockProvider);
+		}
+		return;
+	}
+	//Replaces the file system that might have been created with the bare provider to probe the image
+	auto blockProvider = std::make_shared<ISO9660::CBlockProviderReadAhead>(m_track0BlockProvider);
+	m_track0BlockProvider = blockProvider;
+	m_fileSystem = std::make_unique<CISO9660>(blockProvider);
+}
+
+void COpticalMedia::SetupSecondLayer()
 {
 	if(!m_dvdIsDualLayer) return;
-	auto blockProvider = std::make_shared<ISO9660::CBlockProvider2048>(stream, GetDvdSecondLayerStart());
+	//Goes through track 0's provider to share its read ahead and to make sure nothing else uses the stream concurrently
+	auto blockProvider = std::make_shared<ISO9660::CBlockProviderOffset>(m_track0BlockProvider, GetDvdSecondLayerStart());
 	m_fileSystemL1 = std::make_unique<CISO9660>(blockProvider);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Stream.h"
+#include "filesystem_def.h"
 #include "ISO9660/ISO9660.h"
 
 namespace ISO9660
@@ -44,11 +45,15 @@ public:
 	bool GetDvdIsDualLayer() const;
 	uint32 GetDvdSecondLayerStart() const;
 
+	//See CISO9660::EnablePathIndex
+	void EnablePathIndex(const fs::path&, uint64);
+
 private:
 	typedef std::unique_ptr<CISO9660> Iso9660Ptr;
 
 	void CheckDualLayerDvd(const StreamPtr&);
-	void SetupSecondLayer(const StreamPtr&);
+	void SetupReadAhead();
+	void SetupSecondLayer();
 
 	TRACK_DATA_TYPE m_track0DataType = TRACK_DATA_TYPE_MODE1_2048;
 	BlockProviderPtr m_track0BlockProvider;
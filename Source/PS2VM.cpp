@@ -2,6 +2,7 @@
 #include <exception>
 #include <memory>
 #include <climits>
+#include <algorithm>
 #include <fenv.h>
 #include "FpUtils.h"
 #include "make_unique.h"
@@ -37,6 +38,8 @@
 #define LOG_NAME ("ps2vm")
 
 #define THREAD_NAME ("PS2VM Thread")
+#define IOP_THREAD_NAME ("PS2VM IOP Thread")
+#define SPU_THREAD_NAME ("PS2VM SPU Thread")
 
 #define STATE_VM_TIMING_XML ("vm_timing.xml")
 #define STATE_VM_TIMING_VBLANK_TICKS ("vblankTicks")
@@ -94,11 +97,25 @@ CPS2VM::CPS2VM()
 	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_LIMIT_FRAMERATE, true);
 	ReloadFrameRateLimit();
 
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_PARALLEL_IOP, false);
+
+	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_PS2_TURBO_AUDIO_MODE, TURBO_AUDIO_DECIMATE);
+	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_PS2_TURBO_FRAMESKIP_COUNT, 3);
+	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_PS2_TURBO_FRAMESKIP_PERIOD, 4);
+
 	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_AUDIO_SPUBLOCKCOUNT, 100);
 	ReloadSpuBlockCountImpl();
 
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_AUDIO_SPU_RENDER_THREAD, false);
+	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_AUDIO_SPU_INTERPOLATION_MODE, Iop::CSpuBase::INTERPOLATION_LINEAR);
+	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_AUDIO_OUTPUT_SAMPLE_RATE, DEFAULT_OUTPUT_SAMPLE_RATE);
+
 	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_ARCADE_IO_SERVER_ENABLED, false);
 	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_PS2_ARCADE_IO_SERVER_PORT, 9876);
+
+	m_spuUpdateEvent = m_scheduler.RegisterEvent([this](uint32 lateTicks) { OnSpuUpdateEvent(lateTicks); });
+	m_hblankEvent = m_scheduler.RegisterEvent([this](uint32 lateTicks) { OnHBlankEvent(lateTicks); });
+	m_vblankEvent = m_scheduler.RegisterEvent([this](uint32 lateTicks) { OnVBlankEvent(lateTicks); });
 }
 
 //////////////////////////////////////////////////
@@ -235,12 +252,10 @@ void CPS2VM::ReloadFrameRateLimit()
 		hRefreshRate = m_ee->m_gs->GetCrtHSyncFrequency();
 		vRefreshRate = m_ee->m_gs->GetCrtFrameRate();
 	}
-	bool limitFrameRate = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_LIMIT_FRAMERATE);
+	bool limitFrameRate = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_LIMIT_FRAMERATE) && !m_turboModeEnabled;
 	m_frameLimiter.SetFrameRate(limitFrameRate ? vRefreshRate : 0);
 
-	//At 1x scale, IOP runs 8 times slower than EE
 	uint32 eeFreqScaled = PS2::EE_CLOCK_FREQ * m_eeFreqScaleNumerator / m_eeFreqScaleDenominator;
-	m_iopTickStep = (m_eeTickStep / 8) * m_eeFreqScaleDenominator / m_eeFreqScaleNumerator;
 
 	m_hblankTicksTotal = eeFreqScaled / hRefreshRate;
 
@@ -248,10 +263,20 @@ void CPS2VM::ReloadFrameRateLimit()
 	m_onScreenTicksTotal = frameTicks * 9 / 10;
 	m_vblankTicksTotal = frameTicks / 10;
 
-	m_spuUpdateTicksTotal = (static_cast<int64>(eeFreqScaled) << SPU_UPDATE_TICKS_PRECISION) / (static_cast<int64>(DST_SAMPLE_RATE));
+	m_spuUpdateTicksTotal = (static_cast<int64>(eeFreqScaled) << SPU_UPDATE_TICKS_PRECISION) / (static_cast<int64>(m_spuSampleRate));
 	m_spuUpdateTicksTotal *= static_cast<int64>(SAMPLES_PER_UPDATE);
 }
 
+void CPS2VM::SetTurboModeEnabled(bool enabled)
+{
+	m_mailBox.SendCall([this, enabled]() { SetTurboModeEnabledImpl(enabled); });
+}
+
+bool CPS2VM::IsTurboModeEnabled() const
+{
+	return m_turboModeEnabled;
+}
+
 CVirtualMachine::STATUS CPS2VM::GetStatus() const
 {
 	return m_nStatus;
@@ -369,6 +394,37 @@ std::future<bool> CPS2VM::LoadState(const fs::path& statePath)
 	return future;
 }
 
+void CPS2VM::StartSpuCapture()
+{
+	m_mailBox.SendCall([this]() { m_iop->StartSpuCapture(); });
+}
+
+std::future<bool> CPS2VM::StopSpuCapture(const fs::path& capturePath)
+{
+	auto promise = std::make_shared<std::promise<bool>>();
+	auto future = promise->get_future();
+	m_mailBox.SendCall(
+	    [this, promise, capturePath]() {
+		    auto capture = m_iop->StopSpuCapture();
+		    if(!capture)
+		    {
+			    promise->set_value(false);
+			    return;
+		    }
+		    try
+		    {
+			    auto captureStream = Framework::CreateOutputStdStream(capturePath.native());
+			    capture->Write(captureStream);
+			    promise->set_value(true);
+		    }
+		    catch(...)
+		    {
+			    promise->set_value(false);
+		    }
+	    });
+	return future;
+}
+
 CPS2VM::CPU_UTILISATION_INFO CPS2VM::GetCpuUtilisationInfo() const
 {
 	return m_cpuUtilisation;
@@ -473,6 +529,8 @@ void CPS2VM::CreateVM()
 	auto iopOs = dynamic_cast<CIopBios*>(m_iop->m_bios.get());
 
 	m_ee = std::make_unique<Ee::CSubSystem>(m_iop->m_ram, *iopOs);
+	m_ee->m_sif.SetEeIopSync(&m_eeIopSync);
+	m_iop->SetSpuRenderThread(&m_spuRenderThread);
 	m_OnRequestLoadExecutableConnection = m_ee->m_os->OnRequestLoadExecutable.Connect(std::bind(&CPS2VM::ReloadExecutable, this, std::placeholders::_1, std::placeholders::_2));
 	m_OnCrtModeChangeConnection = m_ee->m_os->OnCrtModeChange.Connect(std::bind(&CPS2VM::OnCrtModeChange, this));
 
@@ -487,6 +545,11 @@ void CPS2VM::ResetVM()
 	assert(m_eeRamSize <= PS2::EE_RAM_SIZE);
 	assert(m_iopRamSize <= PS2::IOP_RAM_SIZE);
 
+	m_spuRenderThread.Sync();
+
+	//IOP thread can't be running anything while its state is torn down
+	bool iopThreadStopped = StopIopThread();
+
 	m_ee->Reset(m_eeRamSize);
 	m_iop->Reset();
 
@@ -516,23 +579,30 @@ void CPS2VM::ResetVM()
 
 	CDROM0_SyncPath();
 
+	LoadSpuRenderSettings();
 	SetEeFrequencyScale(1, 1);
 
-	m_hblankTicks = m_hblankTicksTotal;
-	m_vblankTicks = m_onScreenTicksTotal;
+	m_scheduler.Reset();
+	m_scheduler.Schedule(m_hblankEvent, m_hblankTicksTotal);
+	m_scheduler.Schedule(m_vblankEvent, m_onScreenTicksTotal);
 	m_spuUpdateTicks = m_spuUpdateTicksTotal;
+	ScheduleSpuUpdate();
 	m_inVblank = false;
 
 	m_eeExecutionTicks = 0;
 	m_iopExecutionTicks = 0;
+	m_iopTickRemainder = 0;
 
 	m_currentSpuBlock = 0;
-	m_iop->m_spuCore0.SetDestinationSamplingRate(DST_SAMPLE_RATE);
-	m_iop->m_spuCore1.SetDestinationSamplingRate(DST_SAMPLE_RATE);
 
 	RegisterModulesInPadHandler();
 	m_gunListener = nullptr;
 	m_touchListener = nullptr;
+
+	if(iopThreadStopped)
+	{
+		CreateIopThread();
+	}
 }
 
 void CPS2VM::DestroyVM()
@@ -610,22 +680,28 @@ bool CPS2VM::LoadVMState(const fs::path& statePath)
 void CPS2VM::SaveVmTimingState(Framework::CZipArchiveWriter& archive)
 {
 	auto registerFile = std::make_unique<CRegisterStateFile>(STATE_VM_TIMING_XML);
-	registerFile->SetRegister32(STATE_VM_TIMING_VBLANK_TICKS, m_vblankTicks);
+	registerFile->SetRegister32(STATE_VM_TIMING_VBLANK_TICKS, m_scheduler.GetTicksUntil(m_vblankEvent));
 	registerFile->SetRegister32(STATE_VM_TIMING_IN_VBLANK, m_inVblank);
 	registerFile->SetRegister32(STATE_VM_TIMING_EE_EXECUTION_TICKS, m_eeExecutionTicks);
 	registerFile->SetRegister32(STATE_VM_TIMING_IOP_EXECUTION_TICKS, m_iopExecutionTicks);
-	registerFile->SetRegister64(STATE_VM_TIMING_SPU_UPDATE_TICKS, m_spuUpdateTicks);
+	registerFile->SetRegister64(STATE_VM_TIMING_SPU_UPDATE_TICKS, (static_cast<int64>(m_scheduler.GetTicksUntil(m_spuUpdateEvent)) << SPU_UPDATE_TICKS_PRECISION) + m_spuUpdateTicks);
 	archive.InsertFile(std::move(registerFile));
 }
 
 void CPS2VM::LoadVmTimingState(Framework::CZipArchiveReader& archive)
 {
 	CRegisterStateFile registerFile(*archive.BeginReadFile(STATE_VM_TIMING_XML));
-	m_vblankTicks = registerFile.GetRegister32(STATE_VM_TIMING_VBLANK_TICKS);
+	int32 vblankTicks = registerFile.GetRegister32(STATE_VM_TIMING_VBLANK_TICKS);
 	m_inVblank = registerFile.GetRegister32(STATE_VM_TIMING_IN_VBLANK) != 0;
 	m_eeExecutionTicks = registerFile.GetRegister32(STATE_VM_TIMING_EE_EXECUTION_TICKS);
 	m_iopExecutionTicks = registerFile.GetRegister32(STATE_VM_TIMING_IOP_EXECUTION_TICKS);
 	m_spuUpdateTicks = registerFile.GetRegister64(STATE_VM_TIMING_SPU_UPDATE_TICKS);
+
+	m_scheduler.Reset();
+	m_scheduler.Schedule(m_hblankEvent, m_hblankTicksTotal);
+	m_scheduler.Schedule(m_vblankEvent, std::max<int32>(vblankTicks, 0));
+	ScheduleSpuUpdate();
+	m_iopTickRemainder = 0;
 }
 
 void CPS2VM::PauseImpl()
@@ -660,6 +736,7 @@ void CPS2VM::CreateGsHandlerImpl(const CGSHandler::FactoryFunction& factoryFunct
 	m_ee->m_gs->SendGSCall([this]() {
 		static_cast<CEeExecutor*>(m_ee->m_EE.m_executor.get())->AttachExceptionHandlerToThread();
 	});
+	UpdateGsFrameSkip();
 	if(gs)
 	{
 		m_ee->m_gs->Copy(gs);
@@ -691,12 +768,14 @@ void CPS2VM::DestroyPadHandlerImpl()
 
 void CPS2VM::CreateSoundHandlerImpl(const CSoundHandler::FactoryFunction& factoryFunction)
 {
+	m_spuRenderThread.Sync();
 	m_soundHandler = factoryFunction();
 }
 
 void CPS2VM::ReloadSpuBlockCountImpl()
 {
 	ValidateThreadContext();
+	m_spuRenderThread.Sync();
 	m_currentSpuBlock = 0;
 	auto spuBlockCount = CAppConfig::GetInstance().GetPreferenceInteger(PREF_AUDIO_SPUBLOCKCOUNT);
 	assert(spuBlockCount <= MAX_BLOCK_COUNT);
@@ -704,19 +783,91 @@ void CPS2VM::ReloadSpuBlockCountImpl()
 	m_spuBlockCount = spuBlockCount;
 }
 
+void CPS2VM::LoadSpuRenderSettings()
+{
+	//Only read when the VM is reset, changing these requires a restart
+	auto outputSampleRate = CAppConfig::GetInstance().GetPreferenceInteger(PREF_AUDIO_OUTPUT_SAMPLE_RATE);
+	m_outputSampleRate = std::clamp<int>(outputSampleRate, MIN_OUTPUT_SAMPLE_RATE, MAX_OUTPUT_SAMPLE_RATE);
+	//Higher rates are reached by resampling the final mix
+	m_spuSampleRate = std::min<uint32>(m_outputSampleRate, MAX_SPU_SAMPLE_RATE);
+	m_outputResampler.Reset();
+	m_outputResampler.SetSamplingRates(m_spuSampleRate, m_outputSampleRate);
+
+	m_iop->m_spuCore0.SetDestinationSamplingRate(m_spuSampleRate);
+	m_iop->m_spuCore1.SetDestinationSamplingRate(m_spuSampleRate);
+	UpdateSpuQualitySettings();
+}
+
+void CPS2VM::UpdateSpuQualitySettings()
+{
+	//Turbo mode audio is either muted or choppy, use the cheapest settings
+	auto interpolationMode = m_turboModeEnabled ? Iop::CSpuBase::INTERPOLATION_LINEAR : static_cast<Iop::CSpuBase::INTERPOLATION_MODE>(CAppConfig::GetInstance().GetPreferenceInteger(PREF_AUDIO_SPU_INTERPOLATION_MODE));
+	m_iop->m_spuCore0.SetInterpolationMode(interpolationMode);
+	m_iop->m_spuCore1.SetInterpolationMode(interpolationMode);
+	m_iop->m_spuCore0.SetReverbEnabled(!m_turboModeEnabled);
+	m_iop->m_spuCore1.SetReverbEnabled(!m_turboModeEnabled);
+}
+
+void CPS2VM::SetTurboModeEnabledImpl(bool enabled)
+{
+	if(m_turboModeEnabled == enabled) return;
+	m_spuRenderThread.Sync();
+	m_turboModeEnabled = enabled;
+	if(enabled)
+	{
+		m_turboAudioMode = static_cast<TURBO_AUDIO_MODE>(CAppConfig::GetInstance().GetPreferenceInteger(PREF_PS2_TURBO_AUDIO_MODE));
+		m_turboAudioStartTime = std::chrono::steady_clock::now();
+		m_turboAudioFrameCount = 0;
+	}
+	UpdateSpuQualitySettings();
+	UpdateGsFrameSkip();
+	ReloadFrameRateLimit();
+}
+
+void CPS2VM::UpdateGsFrameSkip()
+{
+	if(!m_ee->m_gs) return;
+	if(m_turboModeEnabled)
+	{
+		auto skipCount = CAppConfig::GetInstance().GetPreferenceInteger(PREF_PS2_TURBO_FRAMESKIP_COUNT);
+		auto period = CAppConfig::GetInstance().GetPreferenceInteger(PREF_PS2_TURBO_FRAMESKIP_PERIOD);
+		period = std::max(period, 0);
+		skipCount = std::clamp(skipCount, 0, period);
+		m_ee->m_gs->SetFrameSkip(skipCount, period);
+	}
+	else
+	{
+		m_ee->m_gs->SetFrameSkip(0, 0);
+	}
+}
+
+bool CPS2VM::CanWriteTurboAudio(unsigned int sampleCount)
+{
+	if(!m_turboModeEnabled) return true;
+	if(m_turboAudioMode == TURBO_AUDIO_MUTE) return false;
+	//Let blocks through as long as we're not ahead of what the host has had time to play
+	auto elapsedTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_turboAudioStartTime);
+	uint64 elapsedFrameCount = static_cast<uint64>(elapsedTime.count()) * m_spuSampleRate / 1000000;
+	if(m_turboAudioFrameCount > elapsedFrameCount) return false;
+	m_turboAudioFrameCount += sampleCount / 2;
+	return true;
+}
+
 void CPS2VM::DestroySoundHandlerImpl()
 {
 	if(m_soundHandler == nullptr) return;
+	m_spuRenderThread.Sync();
 	delete m_soundHandler;
 	m_soundHandler = nullptr;
 }
 
-void CPS2VM::UpdateEe()
+int CPS2VM::UpdateEe()
 {
 #ifdef PROFILE
 	CProfilerZone profilerZone(m_eeProfilerZone);
 #endif
 
+	int totalExecuted = 0;
 	while(m_eeExecutionTicks > 0)
 	{
 		int executed = m_ee->ExecuteCpu(m_singleStepEe ? 1 : m_eeExecutionTicks);
@@ -731,16 +882,15 @@ void CPS2VM::UpdateEe()
 		m_ee->m_vpu1->Execute(m_singleStepVu1 ? 1 : executed);
 
 		m_eeExecutionTicks -= executed;
-		m_spuUpdateTicks -= (static_cast<int64>(executed) << SPU_UPDATE_TICKS_PRECISION);
 		m_ee->CountTicks(executed);
-		m_hblankTicks -= executed;
-		m_vblankTicks -= executed;
+		totalExecuted += executed;
 
 #ifdef DEBUGGER_INCLUDED
 		if(m_singleStepEe || m_singleStepVu0 || m_singleStepVu1) break;
 		if(m_ee->m_EE.m_executor->MustBreak()) break;
 #endif
 	}
+	return totalExecuted;
 }
 
 void CPS2VM::UpdateIop()
@@ -749,18 +899,24 @@ void CPS2VM::UpdateIop()
 	CProfilerZone profilerZone(m_iopProfilerZone);
 #endif
 
+	ExecuteIop();
+}
+
+void CPS2VM::ExecuteIop()
+{
 	while(m_iopExecutionTicks > 0)
 	{
 		int executed = m_iop->ExecuteCpu(m_singleStepIop ? 1 : m_iopExecutionTicks);
 		if(m_iop->IsCpuIdle())
 		{
-			m_cpuUtilisation.iopIdleTicks += (m_iopExecutionTicks - executed);
+			m_iopCpuUtilisation.iopIdleTicks += (m_iopExecutionTicks - executed);
 			executed = m_iopExecutionTicks;
 		}
-		m_cpuUtilisation.iopTotalTicks += executed;
+		m_iopCpuUtilisation.iopTotalTicks += executed;
 
 		m_iopExecutionTicks -= executed;
 		m_iop->CountTicks(executed);
+		m_eeIopSync.CheckPoint();
 
 #ifdef DEBUGGER_INCLUDED
 		if(m_singleStepIop) break;
@@ -775,6 +931,12 @@ void CPS2VM::UpdateSpu()
 	CProfilerZone profilerZone(m_spuProfilerZone);
 #endif
 
+	//Runs right away if the render thread isn't enabled
+	m_spuRenderThread.QueueJob([this]() { RenderSpu(); });
+}
+
+void CPS2VM::RenderSpu()
+{
 	unsigned int blockOffset = (BLOCK_SIZE * m_currentSpuBlock);
 	int16* samplesSpu0 = m_samples + blockOffset;
 
@@ -795,17 +957,99 @@ void CPS2VM::UpdateSpu()
 	}
 
 	m_currentSpuBlock++;
-	if(m_currentSpuBlock == m_spuBlockCount)
+	//Pull based handlers do their own buffering, don't hold blocks back
+	bool flush = (m_currentSpuBlock == m_spuBlockCount) || (m_soundHandler && m_soundHandler->IsPullBased());
+	if(flush)
 	{
-		if(m_soundHandler)
+		unsigned int sampleCount = BLOCK_SIZE * m_currentSpuBlock;
+		if(m_soundHandler && CanWriteTurboAudio(sampleCount))
 		{
 			m_soundHandler->RecycleBuffers();
-			m_soundHandler->Write(m_samples, BLOCK_SIZE * m_spuBlockCount, DST_SAMPLE_RATE);
+			if(m_outputSampleRate == m_spuSampleRate)
+			{
+				m_soundHandler->Write(m_samples, sampleCount, m_outputSampleRate);
+			}
+			else
+			{
+				m_outputSamples.clear();
+				m_outputResampler.Process(m_outputSamples, m_samples, sampleCount);
+				m_soundHandler->Write(m_outputSamples.data(), static_cast<unsigned int>(m_outputSamples.size()), m_outputSampleRate);
+			}
 		}
 		m_currentSpuBlock = 0;
 	}
 }
 
+void CPS2VM::ScheduleSpuUpdate()
+{
+	//Scheduler works with whole ticks, fractional part is carried over to the next update
+	int64 ticks = std::max<int64>((m_spuUpdateTicks + (1LL << SPU_UPDATE_TICKS_PRECISION) - 1) >> SPU_UPDATE_TICKS_PRECISION, 0);
+	m_spuUpdateTicks -= (ticks << SPU_UPDATE_TICKS_PRECISION);
+	m_scheduler.Schedule(m_spuUpdateEvent, static_cast<uint32>(ticks));
+}
+
+void CPS2VM::OnSpuUpdateEvent(uint32 lateTicks)
+{
+	UpdateSpu();
+	m_spuUpdateTicks -= (static_cast<int64>(lateTicks) << SPU_UPDATE_TICKS_PRECISION);
+	m_spuUpdateTicks += m_spuUpdateTicksTotal;
+	ScheduleSpuUpdate();
+}
+
+void CPS2VM::OnHBlankEvent(uint32 lateTicks)
+{
+	m_scheduler.Schedule(m_hblankEvent, m_hblankTicksTotal - std::min(lateTicks, m_hblankTicksTotal));
+	if(m_ee->m_gs)
+	{
+		m_ee->m_gs->SetHBlank();
+	}
+}
+
+void CPS2VM::OnVBlankEvent(uint32 lateTicks)
+{
+	m_inVblank = !m_inVblank;
+	if(m_inVblank)
+	{
+		m_scheduler.Schedule(m_vblankEvent, m_vblankTicksTotal - std::min(lateTicks, m_vblankTicksTotal));
+		m_ee->NotifyVBlankStart();
+		m_iop->NotifyVBlankStart();
+
+		if(m_ee->m_gs != NULL)
+		{
+#ifdef PROFILE
+			CProfilerZone profilerZone(m_gsSyncProfilerZone);
+#endif
+			m_ee->m_gs->SetVBlank();
+		}
+
+		if(m_pad != NULL)
+		{
+			m_pad->Update(m_ee->m_ram);
+		}
+#ifdef PROFILE
+		//Finish up profile
+		CProfiler::GetInstance().CountCurrentZone();
+#endif
+		OnNewFrame();
+#ifdef PROFILE
+		CProfiler::GetInstance().Reset();
+#endif
+		m_cpuUtilisation = CPU_UTILISATION_INFO();
+	}
+	else
+	{
+		m_scheduler.Schedule(m_vblankEvent, m_onScreenTicksTotal - std::min(lateTicks, m_onScreenTicksTotal));
+		m_ee->NotifyVBlankEnd();
+		m_iop->NotifyVBlankEnd();
+		if(m_ee->m_gs != NULL)
+		{
+			m_ee->m_gs->ResetVBlank();
+		}
+		m_frameLimiter.EndFrame();
+		m_frameLimiter.BeginFrame();
+	}
+}
+
 void CPS2VM::CDROM0_SyncPath()
 {
 	//TODO: Check if there's an m_cdrom0 already
@@ -819,6 +1063,7 @@ void CPS2VM::CDROM0_SyncPath()
 		try
 		{
 			m_cdrom0 = DiskUtils::CreateOpticalMediaFromPath(path);
+			m_cdrom0->EnablePathIndex(CAppConfig::GetInstance().GetBasePath() / fs::path("discindex/"), DiskUtils::GetImageIdentity(path));
 			SetIopOpticalMedia(m_cdrom0.get());
 		}
 		catch(const std::exception& Exception)
@@ -862,9 +1107,13 @@ void CPS2VM::RegisterModulesInPadHandler()
 
 void CPS2VM::ReloadExecutable(const char* executablePath, const CPS2OS::ArgumentList& arguments)
 {
+	//Requested by the EE while the IOP might be running on its own thread, let it complete
+	//its window and keep it stopped until the new executable is loaded
+	bool iopThreadStopped = StopIopThread();
 	{
 		//SPU RAM is not cleared by a LoadExecPS2 operation, we must keep its contents
 		//Deus Ex uses SPU RAM to keep game state in between executable reloads
+		m_iop->SyncSpu();
 		auto savedSpuRam = std::vector<uint8>(PS2::SPU_RAM_SIZE);
 		memcpy(savedSpuRam.data(), m_iop->m_spuRam, PS2::SPU_RAM_SIZE);
 		ResetVM();
@@ -879,6 +1128,10 @@ void CPS2VM::ReloadExecutable(const char* executablePath, const CPS2OS::Argument
 	{
 		AfterExecutableReloaded(this);
 	}
+	if(iopThreadStopped)
+	{
+		CreateIopThread();
+	}
 }
 
 void CPS2VM::OnCrtModeChange()
@@ -900,6 +1153,8 @@ void CPS2VM::EmuThread()
 	CProfilerZone profilerZone(m_otherProfilerZone);
 #endif
 	static_cast<CEeExecutor*>(m_ee->m_EE.m_executor.get())->AddExceptionHandler();
+	StartIopThread();
+	StartSpuRenderThread();
 	m_frameLimiter.BeginFrame();
 	while(1)
 	{
@@ -914,74 +1169,38 @@ void CPS2VM::EmuThread()
 		}
 		if(m_nStatus == RUNNING)
 		{
-			if(m_spuUpdateTicks <= 0)
+			//Run until the next scheduled event, EE peripherals can shorten the time slice
+			//if they are about to raise an interrupt
+			uint32 maxSliceTicks = std::min<uint32>(m_eeTickStep, m_ee->GetTicksUntilNextEvent());
+			uint32 sliceTicks = m_scheduler.GetTicksUntilNextEvent(std::max<uint32>(maxSliceTicks, 1));
+			int executedTicks = 0;
+			if(sliceTicks != 0)
 			{
-				UpdateSpu();
-				m_spuUpdateTicks += m_spuUpdateTicksTotal;
-			}
+				//At 1x scale, IOP runs 8 times slower than EE
+				uint64 iopTicks = (static_cast<uint64>(sliceTicks) * m_eeFreqScaleDenominator) + m_iopTickRemainder;
+				uint32 iopTicksDivisor = 8 * m_eeFreqScaleNumerator;
+				m_iopTickRemainder = static_cast<uint32>(iopTicks % iopTicksDivisor);
 
-			{
-				if(m_hblankTicks <= 0)
+				m_eeExecutionTicks += sliceTicks;
+				m_iopExecutionTicks += static_cast<int>(iopTicks / iopTicksDivisor);
+
+				if(m_eeIopSync.IsEnabled())
 				{
-					m_hblankTicks += m_hblankTicksTotal;
-					if(m_ee->m_gs)
-					{
-						m_ee->m_gs->SetHBlank();
-					}
+					//IOP runs its share of the time slice in parallel
+					m_eeIopSync.BeginWindow();
+					executedTicks = UpdateEe();
+					m_eeIopSync.EndWindow();
 				}
-
-				//Check vblank stuff
-				if(m_vblankTicks <= 0)
+				else
 				{
-					m_inVblank = !m_inVblank;
-					if(m_inVblank)
-					{
-						m_vblankTicks += m_vblankTicksTotal;
-						m_ee->NotifyVBlankStart();
-						m_iop->NotifyVBlankStart();
-
-						if(m_ee->m_gs != NULL)
-						{
-#ifdef PROFILE
-							CProfilerZone profilerZone(m_gsSyncProfilerZone);
-#endif
-							m_ee->m_gs->SetVBlank();
-						}
-
-						if(m_pad != NULL)
-						{
-							m_pad->Update(m_ee->m_ram);
-						}
-#ifdef PROFILE
-						//Finish up profile
-						CProfiler::GetInstance().CountCurrentZone();
-#endif
-						OnNewFrame();
-#ifdef PROFILE
-						CProfiler::GetInstance().Reset();
-#endif
-						m_cpuUtilisation = CPU_UTILISATION_INFO();
-					}
-					else
-					{
-						m_vblankTicks += m_onScreenTicksTotal;
-						m_ee->NotifyVBlankEnd();
-						m_iop->NotifyVBlankEnd();
-						if(m_ee->m_gs != NULL)
-						{
-							m_ee->m_gs->ResetVBlank();
-						}
-						m_frameLimiter.EndFrame();
-						m_frameLimiter.BeginFrame();
-					}
+					executedTicks = UpdateEe();
+					UpdateIop();
 				}
-
-				m_eeExecutionTicks += m_eeTickStep;
-				m_iopExecutionTicks += m_iopTickStep;
-
-				UpdateEe();
-				UpdateIop();
+				m_cpuUtilisation.iopTotalTicks += m_iopCpuUtilisation.iopTotalTicks;
+				m_cpuUtilisation.iopIdleTicks += m_iopCpuUtilisation.iopIdleTicks;
+				m_iopCpuUtilisation = CPU_UTILISATION_INFO();
 			}
+			m_scheduler.Advance(std::max<int>(executedTicks, 0));
 #ifdef DEBUGGER_INCLUDED
 			if(
 			    m_ee->m_EE.m_executor->MustBreak() ||
@@ -1000,8 +1219,80 @@ void CPS2VM::EmuThread()
 #endif
 		}
 	}
+	StopSpuRenderThread();
+	StopIopThread();
 	static_cast<CEeExecutor*>(m_ee->m_EE.m_executor.get())->RemoveExceptionHandler();
 #ifdef __ANDROID__
 	Framework::CJavaVM::DetachCurrentThread();
 #endif
 }
+
+void CPS2VM::StartIopThread()
+{
+	//Only read when the emulation thread starts, changing it requires a restart
+	if(!CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_PARALLEL_IOP)) return;
+	CreateIopThread();
+}
+
+void CPS2VM::CreateIopThread()
+{
+	assert(!m_iopThread.joinable());
+	m_eeIopSync.SetEnabled(true);
+	m_iopThread = std::thread([&]() { IopThread(); });
+	Framework::ThreadUtils::SetThreadName(m_iopThread, IOP_THREAD_NAME);
+}
+
+bool CPS2VM::StopIopThread()
+{
+	if(!m_iopThread.joinable()) return false;
+	//Thread completes the window it's been given, if any, before exiting
+	m_eeIopSync.Stop();
+	m_iopThread.join();
+	m_eeIopSync.SetEnabled(false);
+	return true;
+}
+
+void CPS2VM::IopThread()
+{
+	CEeIopSync::SetCurrentThreadParty(CEeIopSync::PARTY_IOP);
+	fesetround(FE_TOWARDZERO);
+	FpUtils::SetDenormalHandlingMode();
+#ifdef __ANDROID__
+	JNIEnv* env = nullptr;
+	Framework::CJavaVM::AttachCurrentThread(&env, IOP_THREAD_NAME);
+#endif
+	while(m_eeIopSync.WaitForWindow())
+	{
+		ExecuteIop();
+		m_eeIopSync.CompleteWindow();
+	}
+#ifdef __ANDROID__
+	Framework::CJavaVM::DetachCurrentThread();
+#endif
+}
+
+void CPS2VM::StartSpuRenderThread()
+{
+	//Only read when the emulation thread starts, changing it requires a restart
+	if(!CAppConfig::GetInstance().GetPreferenceBoolean(PREF_AUDIO_SPU_RENDER_THREAD)) return;
+	m_spuRenderThread.Start(
+	    SPU_THREAD_NAME,
+	    []() {
+		    fesetround(FE_TOWARDZERO);
+		    FpUtils::SetDenormalHandlingMode();
+#ifdef __ANDROID__
+		    JNIEnv* env = nullptr;
+		    Framework::CJavaVM::AttachCurrentThread(&env, SPU_THREAD_NAME);
+#endif
+	    },
+	    []() {
+#ifdef __ANDROID__
+		    Framework::CJavaVM::DetachCurrentThread();
+#endif
+	    });
+}
+
+void CPS2VM::StopSpuRenderThread()
+{
+	m_spuRenderThread.Stop();
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <thread>
 #include <future>
 #include "filesystem_def.h"
@@ -12,8 +14,12 @@
 #include "VirtualMachine.h"
 #include "ee/Ee_SubSystem.h"
 #include "iop/Iop_SubSystem.h"
+#include "iop/Iop_SpuResampler.h"
 #include "../tools/PsfPlayer/Source/SoundHandler.h"
 #include "FrameLimiter.h"
+#include "EventScheduler.h"
+#include "EeIopSync.h"
+#include "SpuRenderThread.h"
 #include "Profiler.h"
 
 class CPS2VM : public CVirtualMachine
@@ -34,6 +40,14 @@ public:
 	typedef Framework::CSignal<void()> NewFrameEvent;
 	typedef std::function<void(CPS2VM*)> ExecutableReloadedHandler;
 
+	enum TURBO_AUDIO_MODE
+	{
+		//SPU keeps running, games rely on its timing, but nothing reaches the sound handler
+		TURBO_AUDIO_MUTE,
+		//Only as much audio as can be played in real time is kept, the rest is dropped
+		TURBO_AUDIO_DECIMATE,
+	};
+
 	CPS2VM();
 	virtual ~CPS2VM() = default;
 
@@ -71,12 +85,20 @@ public:
 	void SetEeFrequencyScale(uint32, uint32);
 	void ReloadFrameRateLimit();
 
+	//Runs as fast as emulation allows: no frame limit, fewer frames presented and cheaper audio that doesn't flood the sound handler
+	void SetTurboModeEnabled(bool);
+	bool IsTurboModeEnabled() const;
+
 	static fs::path GetStateDirectoryPath();
 	fs::path GenerateStatePath(unsigned int) const;
 
 	std::future<bool> SaveState(const fs::path&);
 	std::future<bool> LoadState(const fs::path&);
 
+	//Records SPU2 activity, the capture is written when stopped (see tools/SpuTest for replaying it)
+	void StartSpuCapture();
+	std::future<bool> StopSpuCapture(const fs::path&);
+
 	CPU_UTILISATION_INFO GetCpuUtilisationInfo() const;
 
 #ifdef DEBUGGER_INCLUDED
@@ -143,10 +165,23 @@ private:
 	void DestroySoundHandlerImpl();
 
 	void ReloadSpuBlockCountImpl();
+	void LoadSpuRenderSettings();
+	void UpdateSpuQualitySettings();
 
-	void UpdateEe();
+	void SetTurboModeEnabledImpl(bool);
+	void UpdateGsFrameSkip();
+	bool CanWriteTurboAudio(unsigned int);
+
+	int UpdateEe();
 	void UpdateIop();
+	void ExecuteIop();
 	void UpdateSpu();
+	void RenderSpu();
+
+	void ScheduleSpuUpdate();
+	void OnSpuUpdateEvent(uint32);
+	void OnHBlankEvent(uint32);
+	void OnVBlankEvent(uint32);
 
 	void SetIopOpticalMedia(COpticalMedia*);
 
@@ -154,7 +189,19 @@ private:
 
 	void EmuThread();
 
+	void StartIopThread();
+	void CreateIopThread();
+	//Returns true if the thread was running
+	bool StopIopThread();
+	void IopThread();
+
+	void StartSpuRenderThread();
+	void StopSpuRenderThread();
+
 	std::thread m_thread;
+	std::thread m_iopThread;
+	CEeIopSync m_eeIopSync;
+	CSpuRenderThread m_spuRenderThread;
 	STATUS m_nStatus = PAUSED;
 	bool m_nEnd = false;
 
@@ -165,18 +212,24 @@ private:
 	uint32 m_hblankTicksTotal = 0;
 	uint32 m_onScreenTicksTotal = 0;
 	uint32 m_vblankTicksTotal = 0;
-	int m_hblankTicks = 0;
-	int m_vblankTicks = 0;
 	bool m_inVblank = false;
 	int64 m_spuUpdateTicks = 0;
 	int64 m_spuUpdateTicksTotal = 0;
 	int m_eeExecutionTicks = 0;
 	int m_iopExecutionTicks = 0;
-	static const int m_eeTickStep = 4800;
-	int m_iopTickStep = 0;
+	uint32 m_iopTickRemainder = 0;
+	//Maximum time slice, bounds how far EE and IOP can drift apart. IOP events (timers, CDVD, SIF DMA)
+	//aren't scheduled, they're only noticed when the IOP gets to run.
+	static constexpr uint32 m_eeTickStep = 4800;
+	CEventScheduler m_scheduler;
+	CEventScheduler::EventId m_spuUpdateEvent = 0;
+	CEventScheduler::EventId m_hblankEvent = 0;
+	CEventScheduler::EventId m_vblankEvent = 0;
 	CFrameLimiter m_frameLimiter;
 
 	CPU_UTILISATION_INFO m_cpuUtilisation;
+	//Only touched by the thread running the IOP, merged into m_cpuUtilisation after every time slice
+	CPU_UTILISATION_INFO m_iopCpuUtilisation;
 
 	bool m_singleStepEe = false;
 	bool m_singleStepIop = false;
@@ -186,7 +239,11 @@ private:
 	//SPU update parameters
 	enum
 	{
-		DST_SAMPLE_RATE = 44100,
+		DEFAULT_OUTPUT_SAMPLE_RATE = 44100,
+		MIN_OUTPUT_SAMPLE_RATE = 22050,
+		MAX_OUTPUT_SAMPLE_RATE = 192000,
+		//Envelopes and reverb are tied to the rate the SPU renders at, it can't go above its native rate
+		MAX_SPU_SAMPLE_RATE = 48000,
 		SAMPLES_PER_UPDATE = 45, //44100 / 45 -> 980 SPU updates per second
 		SPU_UPDATE_TICKS_PRECISION = 32,
 		BLOCK_SIZE = SAMPLES_PER_UPDATE * 2,
@@ -196,8 +253,17 @@ private:
 	int16 m_samples[BLOCK_SIZE * MAX_BLOCK_COUNT];
 	int m_currentSpuBlock = 0;
 	int m_spuBlockCount = 0;
+	uint32 m_spuSampleRate = DEFAULT_OUTPUT_SAMPLE_RATE;
+	uint32 m_outputSampleRate = DEFAULT_OUTPUT_SAMPLE_RATE;
+	Iop::CSpuResampler m_outputResampler;
+	std::vector<int16> m_outputSamples;
 	CSoundHandler* m_soundHandler = nullptr;
 
+	std::atomic<bool> m_turboModeEnabled = {false};
+	TURBO_AUDIO_MODE m_turboAudioMode = TURBO_AUDIO_DECIMATE;
+	std::chrono::steady_clock::time_point m_turboAudioStartTime;
+	uint64 m_turboAudioFrameCount = 0;
+
 	CScreenPositionListener* m_gunListener = nullptr;
 	CScreenPositionListener* m_touchListener = nullptr;
 
@@ -13,7 +13,14 @@
 #define PREF_PS2_ARCADE_IO_SERVER_PORT ("ps2.arcade.ioserver.port")
 
 #define PREF_PS2_LIMIT_FRAMERATE ("ps2.limitframerate")
+#define PREF_PS2_PARALLEL_IOP ("ps2.paralleliop")
+#define PREF_PS2_TURBO_AUDIO_MODE ("ps2.turbo.audiomode")
+#define PREF_PS2_TURBO_FRAMESKIP_COUNT ("ps2.turbo.frameskip.count")
+#define PREF_PS2_TURBO_FRAMESKIP_PERIOD ("ps2.turbo.frameskip.period")
 
 #define PREF_AUDIO_SPUBLOCKCOUNT ("audio.spublockcount")
+#define PREF_AUDIO_SPU_RENDER_THREAD ("audio.spurenderthread")
+#define PREF_AUDIO_SPU_INTERPOLATION_MODE ("audio.spuinterpolationmode")
+#define PREF_AUDIO_OUTPUT_SAMPLE_RATE ("audio.outputsamplerate")
 
 #define PREF_SYSTEM_LANGUAGE ("system.language")
@@ -13,6 +13,7 @@ CProfiler::ZoneHandle CProfiler::RegisterZone(const char* name)
 	auto newZone = ZONE();
 	newZone.name = name;
 	newZone.totalTime = 0;
+	newZone.hitCount = 0;
 	m_zones.push_back(newZone);
 	return static_cast<CProfiler::ZoneHandle>(m_zones.size() - 1);
 #else
@@ -60,6 +61,13 @@ void CProfiler::ExitZone()
 	m_zoneStack.pop();
 }
 
+void CProfiler::CountZoneHit(ZoneHandle zoneHandle)
+{
+	assert(std::this_thread::get_id() == m_workThreadId);
+	assert(m_zones.size() > zoneHandle);
+	m_zones[zoneHandle].hitCount++;
+}
+
 CProfiler::ZoneArray CProfiler::GetStats() const
 {
 	assert(std::this_thread::get_id() == m_workThreadId);
@@ -72,6 +80,7 @@ void CProfiler::Reset()
 	for(auto& zone : m_zones)
 	{
 		zone.totalTime = 0;
+		zone.hitCount = 0;
 	}
 }
 
@@ -17,6 +17,7 @@ public:
 	{
 		std::string name;
 		uint64 totalTime = 0;
+		uint64 hitCount = 0;
 	};
 
 	typedef std::vector<ZONE> ZoneArray;
@@ -31,6 +32,9 @@ public:
 	void EnterZone(ZoneHandle);
 	void ExitZone();
 
+	//For zones that track events rather than time
+	void CountZoneHit(ZoneHandle);
+
 	ZoneArray GetStats() const;
 	void Reset();
 
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include "ReadAheadCache.h"
+#include "ThreadUtils.h"
+
+CReadAheadCache::CReadAheadCache(const PARAMS& params, FetchFunction fetchFunction, FilterFunction filterFunction)
+    : m_params(params)
+    , m_fetchFunction(std::move(fetchFunction))
+    , m_filterFunction(std::move(filterFunction))
+    , m_slots(params.slotCount)
+{
+}
+
+CReadAheadCache::~CReadAheadCache()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_threadDone = true;
+	}
+	m_requestCondition.notify_all();
+	for(auto& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+bool CReadAheadCache::Read(uint32 position, const ReadFunction& readFunction, bool release)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	bool sequential = IsSequentialAccess(position);
+	uint32 blockIndex = position / m_params.unitsPerBlock;
+
+	auto slot = FindSlot(blockIndex);
+	if(slot && (slot->state == SLOT_STATE_PENDING))
+	{
+		//Already requested by read ahead, make sure it's fetched next if it's still waiting
+		auto requestIterator = std::find(m_requests.begin(), m_requests.end(), slot);
+		if(requestIterator != m_requests.end())
+		{
+			m_requests.erase(requestIterator);
+			m_requests.push_front(slot);
+		}
+	}
+	if(!slot && sequential && ShouldFetch(blockIndex))
+	{
+		slot = RequestBlock(blockIndex, true);
+	}
+	if(slot)
+	{
+		//Mark as used first to make sure it doesn't get replaced by the blocks requested below
+		slot->lastUse = ++m_useCounter;
+	}
+	if(sequential)
+	{
+		for(uint32 i = 1; i <= m_params.readAheadCount; i++)
+		{
+			uint32 nextBlockIndex = blockIndex + i;
+			if(FindSlot(nextBlockIndex) || !ShouldFetch(nextBlockIndex)) continue;
+			RequestBlock(nextBlockIndex, false);
+		}
+	}
+	if(!slot)
+	{
+		return false;
+	}
+
+	m_slotReadyCondition.wait(lock, [&]() { return (slot->state != SLOT_STATE_PENDING) || (slot->blockIndex != blockIndex); });
+	if((slot->state != SLOT_STATE_READY) || (slot->blockIndex != blockIndex))
+	{
+		return false;
+	}
+
+	readFunction(slot->data);
+	if(release)
+	{
+		//Make sure the slot is reused before any slot holding blocks that were fetched ahead
+		slot->state = SLOT_STATE_EMPTY;
+		slot->lastUse = 0;
+	}
+	return true;
+}
+
+bool CReadAheadCache::IsSequentialAccess(uint32 position)
+{
+	m_sequentialCount = (position == m_nextPosition) ? (m_sequentialCount + 1) : 0;
+	m_nextPosition = position + 1;
+	return (m_sequentialCount >= SEQUENTIAL_THRESHOLD);
+}
+
+bool CReadAheadCache::ShouldFetch(uint32 blockIndex) const
+{
+	return !m_filterFunction || m_filterFunction(blockIndex);
+}
+
+CReadAheadCache::SLOT* CReadAheadCache::FindSlot(uint32 blockIndex)
+{
+	for(auto& slot : m_slots)
+	{
+		if((slot.state != SLOT_STATE_EMPTY) && (slot.blockIndex == blockIndex))
+		{
+			return &slot;
+		}
+	}
+	return nullptr;
+}
+
+CReadAheadCache::SLOT* CReadAheadCache::RequestBlock(uint32 blockIndex, bool urgent)
+{
+	//Replace the least recently used slot that isn't being fetched
+	SLOT* slot = nullptr;
+	for(auto& candidate : m_slots)
+	{
+		if(candidate.state == SLOT_STATE_PENDING) continue;
+		if(!slot || (candidate.lastUse < slot->lastUse))
+		{
+			slot = &candidate;
+		}
+	}
+	if(!slot)
+	{
+		//Worker threads are lagging behind, don't queue any more requests
+		return nullptr;
+	}
+
+	slot->blockIndex = blockIndex;
+	slot->state = SLOT_STATE_PENDING;
+	slot->lastUse = ++m_useCounter;
+	if(urgent)
+	{
+		m_requests.push_front(slot);
+	}
+	else
+	{
+		m_requests.push_back(slot);
+	}
+
+	if(m_threads.empty())
+	{
+		for(uint32 i = 0; i < m_params.threadCount; i++)
+		{
+			m_threads.emplace_back([this]() { ThreadProc(); });
+			Framework::ThreadUtils::SetThreadName(m_threads.back(), m_params.threadName);
+		}
+	}
+	m_requestCondition.notify_one();
+
+	return slot;
+}
+
+void CReadAheadCache::ThreadProc()
+{
+	while(1)
+	{
+		SLOT* slot = nullptr;
+		uint32 blockIndex = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_requestCondition.wait(lock, [this]() { return m_threadDone || !m_requests.empty(); });
+			if(m_threadDone) break;
+			slot = m_requests.front();
+			blockIndex = slot->blockIndex;
+			m_requests.pop_front();
+		}
+
+		//Pending slots are never replaced, we're the only ones touching its data until it's ready
+		bool succeeded = true;
+		try
+		{
+			m_fetchFunction(blockIndex, slot->data);
+		}
+		catch(...)
+		{
+			succeeded = false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			slot->state = succeeded ? SLOT_STATE_READY : SLOT_STATE_FAILED;
+		}
+		m_slotReadyCondition.notify_all();
+	}
+}
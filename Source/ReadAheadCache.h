@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Types.h"
+
+//Keeps a few blocks of a slow medium in memory. Blocks are fetched by worker threads,
+//sequential accesses are detected and blocks following them are fetched ahead of time.
+//Least recently used blocks are replaced first, blocks being fetched are never replaced.
+class CReadAheadCache
+{
+public:
+	typedef std::vector<uint8> Block;
+	//Called on a worker thread, throws if the block couldn't be fetched
+	typedef std::function<void(uint32, Block&)> FetchFunction;
+	//Returns false for blocks that shouldn't be fetched (ex.: past the end or available elsewhere)
+	typedef std::function<bool(uint32)> FilterFunction;
+	//Called with the block's data while the cache is locked
+	typedef std::function<void(Block&)> ReadFunction;
+
+	struct PARAMS
+	{
+		//Positions are in units (ex.: sectors), sequential accesses are detected on those
+		uint32 unitsPerBlock = 1;
+		uint32 slotCount = 8;
+		uint32 threadCount = 1;
+		uint32 readAheadCount = 2;
+		const char* threadName = "Read Ahead Thread";
+	};
+
+	CReadAheadCache(const PARAMS&, FetchFunction, FilterFunction = FilterFunction());
+	virtual ~CReadAheadCache();
+
+	CReadAheadCache(const CReadAheadCache&) = delete;
+	CReadAheadCache& operator=(const CReadAheadCache&) = delete;
+
+	//Gives the block containing the position if it's in memory or once it's fetched. Returns false if
+	//it isn't (random access or fetch failed), the caller must read it by itself then.
+	//If release is set, the block is dropped once read.
+	bool Read(uint32, const ReadFunction&, bool release = false);
+
+private:
+	enum
+	{
+		//Number of consecutive units read before we consider access to be sequential
+		SEQUENTIAL_THRESHOLD = 2,
+	};
+
+	enum SLOT_STATE
+	{
+		SLOT_STATE_EMPTY,
+		SLOT_STATE_PENDING,
+		SLOT_STATE_READY,
+		SLOT_STATE_FAILED,
+	};
+
+	struct SLOT
+	{
+		uint32 blockIndex = 0;
+		SLOT_STATE state = SLOT_STATE_EMPTY;
+		uint64 lastUse = 0;
+		Block data;
+	};
+
+	bool IsSequentialAccess(uint32);
+	bool ShouldFetch(uint32) const;
+	SLOT* FindSlot(uint32);
+	SLOT* RequestBlock(uint32, bool);
+	void ThreadProc();
+
+	PARAMS m_params;
+	FetchFunction m_fetchFunction;
+	FilterFunction m_filterFunction;
+
+	std::mutex m_mutex;
+	std::condition_variable m_requestCondition;
+	std::condition_variable m_slotReadyCondition;
+	std::vector<SLOT> m_slots;
+	std::deque<SLOT*> m_requests;
+	uint32 m_nextPosition = ~0U;
+	uint32 m_sequentialCount = 0;
+	uint64 m_useCounter = 0;
+	bool m_threadDone = false;
+	std::vector<std::thread> m_threads;
+};
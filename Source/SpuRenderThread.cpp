@@ -0,0 +1,86 @@
+#include "SpuRenderThread.h"
+#include <cassert>
+#include "ThreadUtils.h"
+
+CSpuRenderThread::~CSpuRenderThread()
+{
+	Stop();
+}
+
+void CSpuRenderThread::Start(const char* threadName, ThreadEventHandler threadStartHandler, ThreadEventHandler threadEndHandler)
+{
+	assert(!m_thread.joinable());
+	m_stopping = false;
+	m_thread = std::thread([this, threadStartHandler, threadEndHandler]() { ThreadProc(threadStartHandler, threadEndHandler); });
+	Framework::ThreadUtils::SetThreadName(m_thread, threadName);
+}
+
+void CSpuRenderThread::Stop()
+{
+	if(!m_thread.joinable()) return;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_stopping = true;
+		m_conditionVariable.notify_all();
+	}
+	m_thread.join();
+	assert(!m_busy);
+}
+
+bool CSpuRenderThread::IsRunning() const
+{
+	return m_thread.joinable();
+}
+
+void CSpuRenderThread::QueueJob(Job job)
+{
+	if(!IsRunning())
+	{
+		job();
+		return;
+	}
+	Sync();
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_job = std::move(job);
+	m_busy = true;
+	m_conditionVariable.notify_all();
+}
+
+void CSpuRenderThread::Sync()
+{
+	if(!m_busy.load(std::memory_order_acquire)) return;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_conditionVariable.wait(lock, [&]() { return !m_busy; });
+}
+
+void CSpuRenderThread::ThreadProc(ThreadEventHandler threadStartHandler, ThreadEventHandler threadEndHandler)
+{
+	if(threadStartHandler)
+	{
+		threadStartHandler();
+	}
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while(1)
+	{
+		//Pending job is always completed before stopping
+		m_conditionVariable.wait(lock, [&]() { return m_busy || m_stopping; });
+		if(m_busy)
+		{
+			auto job = std::move(m_job);
+			lock.unlock();
+			job();
+			lock.lock();
+			m_busy.store(false, std::memory_order_release);
+			m_conditionVariable.notify_all();
+		}
+		else if(m_stopping)
+		{
+			break;
+		}
+	}
+	lock.unlock();
+	if(threadEndHandler)
+	{
+		threadEndHandler();
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+//Runs SPU rendering jobs on a dedicated thread, one job at a time.
+//Emulated SPU state belongs to the running job until it completes: anything that
+//touches it from the emulation side needs to call Sync first. When the thread isn't
+//running, jobs are executed right away by the caller.
+class CSpuRenderThread
+{
+public:
+	typedef std::function<void()> Job;
+	typedef std::function<void()> ThreadEventHandler;
+
+	virtual ~CSpuRenderThread();
+
+	//Handlers are called on the render thread when it starts and before it exits
+	void Start(const char*, ThreadEventHandler = ThreadEventHandler(), ThreadEventHandler = ThreadEventHandler());
+	void Stop();
+	bool IsRunning() const;
+
+	//Waits for the previous job to complete before queueing this one
+	void QueueJob(Job);
+
+	//Waits for the current job to complete
+	void Sync();
+
+private:
+	void ThreadProc(ThreadEventHandler, ThreadEventHandler);
+
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_conditionVariable;
+	Job m_job;
+	std::atomic<bool> m_busy = {false};
+	bool m_stopping = false;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Types.h"
+
+//Common interface of the audio file encoders, samples are interleaved 16-bit PCM.
+class CAudioFileWriter
+{
+public:
+	virtual ~CAudioFileWriter() = default;
+
+	virtual void Write(const int16*, unsigned int) = 0;
+};
@@ -0,0 +1,75 @@
+#include "AudioLatencyController.h"
+#include <algorithm>
+#include <cassert>
+
+void CAudioLatencyController::SetSampleRate(uint32 sampleRate)
+{
+	assert(sampleRate != 0);
+	m_sampleRate = sampleRate;
+	Reset();
+}
+
+void CAudioLatencyController::SetLimits(uint32 minFrameCount, uint32 maxFrameCount)
+{
+	assert(minFrameCount <= maxFrameCount);
+	m_minFrameCount = minFrameCount;
+	m_maxFrameCount = maxFrameCount;
+	m_customLimits = true;
+	Reset();
+}
+
+void CAudioLatencyController::Reset()
+{
+	if(!m_customLimits)
+	{
+		m_minFrameCount = MillisecondsToFrames(DEFAULT_MIN_LATENCY_MS);
+		m_maxFrameCount = MillisecondsToFrames(DEFAULT_MAX_LATENCY_MS);
+	}
+	m_targetFrameCount = std::clamp(MillisecondsToFrames(INITIAL_LATENCY_MS), m_minFrameCount, m_maxFrameCount);
+	m_stableFrameCount = 0;
+}
+
+void CAudioLatencyController::Update(uint32 frameCount, uint32 underrunCount)
+{
+	if(underrunCount != 0)
+	{
+		//Grow by half for every underrun, host is probably struggling to keep up
+		uint32 targetFrameCount = m_targetFrameCount;
+		for(uint32 i = 0; (i < underrunCount) && (targetFrameCount < m_maxFrameCount); i++)
+		{
+			targetFrameCount += std::max<uint32>(targetFrameCount / 2, 1);
+		}
+		m_targetFrameCount = std::min(targetFrameCount, m_maxFrameCount);
+		m_stableFrameCount = 0;
+		return;
+	}
+
+	m_stableFrameCount += frameCount;
+	uint32 stablePeriod = MillisecondsToFrames(STABLE_PERIOD_MS);
+	if(m_stableFrameCount >= stablePeriod)
+	{
+		m_stableFrameCount -= stablePeriod;
+		uint32 decreaseStep = MillisecondsToFrames(DECREASE_STEP_MS);
+		m_targetFrameCount = std::max(m_targetFrameCount - std::min(m_targetFrameCount, decreaseStep), m_minFrameCount);
+	}
+}
+
+uint32 CAudioLatencyController::GetTargetFrameCount() const
+{
+	return m_targetFrameCount;
+}
+
+uint32 CAudioLatencyController::GetMinFrameCount() const
+{
+	return m_minFrameCount;
+}
+
+uint32 CAudioLatencyController::GetMaxFrameCount() const
+{
+	return m_maxFrameCount;
+}
+
+uint32 CAudioLatencyController::MillisecondsToFrames(uint32 milliseconds) const
+{
+	return static_cast<uint32>((static_cast<uint64>(m_sampleRate) * milliseconds) / 1000);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Types.h"
+
+//Picks how many frames should be buffered ahead of the host's audio callback.
+//Target grows quickly when underruns happen and slowly shrinks back while playback is stable.
+class CAudioLatencyController
+{
+public:
+	void SetSampleRate(uint32);
+	void SetLimits(uint32, uint32);
+	void Reset();
+
+	//Reports how many frames went by and how many underruns happened since the last update
+	void Update(uint32, uint32);
+
+	uint32 GetTargetFrameCount() const;
+	uint32 GetMinFrameCount() const;
+	uint32 GetMaxFrameCount() const;
+
+private:
+	enum
+	{
+		DEFAULT_MIN_LATENCY_MS = 20,
+		DEFAULT_MAX_LATENCY_MS = 250,
+		INITIAL_LATENCY_MS = 60,
+		//Time without underruns before trying a lower latency
+		STABLE_PERIOD_MS = 5000,
+		//Latency removed after each stable period
+		DECREASE_STEP_MS = 5,
+	};
+
+	uint32 MillisecondsToFrames(uint32) const;
+
+	uint32 m_sampleRate = 44100;
+	uint32 m_minFrameCount = 0;
+	uint32 m_maxFrameCount = 0;
+	uint32 m_targetFrameCount = 0;
+	uint32 m_stableFrameCount = 0;
+	bool m_customLimits = false;
+};
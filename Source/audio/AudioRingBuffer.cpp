@@ -0,0 +1,74 @@
+#include "AudioRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+CAudioRingBuffer::CAudioRingBuffer(unsigned int frameCount)
+{
+	SetCapacity(frameCount);
+}
+
+void CAudioRingBuffer::SetCapacity(unsigned int frameCount)
+{
+	unsigned int capacity = 1;
+	while(capacity < frameCount)
+	{
+		capacity <<= 1;
+	}
+	m_samples.assign(capacity * CHANNEL_COUNT, 0);
+	m_frameMask = capacity - 1;
+	Clear();
+}
+
+void CAudioRingBuffer::Clear()
+{
+	m_readPosition = 0;
+	m_writePosition = 0;
+}
+
+unsigned int CAudioRingBuffer::GetCapacity() const
+{
+	return m_frameMask + 1;
+}
+
+unsigned int CAudioRingBuffer::GetReadableFrameCount() const
+{
+	return m_writePosition.load(std::memory_order_acquire) - m_readPosition.load(std::memory_order_acquire);
+}
+
+unsigned int CAudioRingBuffer::GetWritableFrameCount() const
+{
+	return GetCapacity() - GetReadableFrameCount();
+}
+
+unsigned int CAudioRingBuffer::Write(const int16* samples, unsigned int frameCount)
+{
+	uint32 writePosition = m_writePosition.load(std::memory_order_relaxed);
+	uint32 readPosition = m_readPosition.load(std::memory_order_acquire);
+	frameCount = std::min<unsigned int>(frameCount, GetCapacity() - (writePosition - readPosition));
+	if(frameCount == 0) return 0;
+
+	//Copy in at most two parts, the second one starts at the beginning of the ring
+	unsigned int frameIndex = writePosition & m_frameMask;
+	unsigned int firstFrameCount = std::min<unsigned int>(frameCount, GetCapacity() - frameIndex);
+	memcpy(m_samples.data() + (frameIndex * CHANNEL_COUNT), samples, firstFrameCount * CHANNEL_COUNT * sizeof(int16));
+	memcpy(m_samples.data(), samples + (firstFrameCount * CHANNEL_COUNT), (frameCount - firstFrameCount) * CHANNEL_COUNT * sizeof(int16));
+
+	m_writePosition.store(writePosition + frameCount, std::memory_order_release);
+	return frameCount;
+}
+
+unsigned int CAudioRingBuffer::Read(int16* samples, unsigned int frameCount)
+{
+	uint32 readPosition = m_readPosition.load(std::memory_order_relaxed);
+	uint32 writePosition = m_writePosition.load(std::memory_order_acquire);
+	frameCount = std::min<unsigned int>(frameCount, writePosition - readPosition);
+	if(frameCount == 0) return 0;
+
+	unsigned int frameIndex = readPosition & m_frameMask;
+	unsigned int firstFrameCount = std::min<unsigned int>(frameCount, GetCapacity() - frameIndex);
+	memcpy(samples, m_samples.data() + (frameIndex * CHANNEL_COUNT), firstFrameCount * CHANNEL_COUNT * sizeof(int16));
+	memcpy(samples + (firstFrameCount * CHANNEL_COUNT), m_samples.data(), (frameCount - firstFrameCount) * CHANNEL_COUNT * sizeof(int16));
+
+	m_readPosition.store(readPosition + frameCount, std::memory_order_release);
+	return frameCount;
+}
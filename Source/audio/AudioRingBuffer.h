@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "Types.h"
+
+//Lock-free ring of interleaved stereo frames, safe with one producer thread and one consumer thread.
+class CAudioRingBuffer
+{
+public:
+	enum
+	{
+		CHANNEL_COUNT = 2,
+	};
+
+	//Capacity is rounded up to a power of two
+	CAudioRingBuffer(unsigned int = 0);
+
+	//Not thread safe, neither side must be active
+	void SetCapacity(unsigned int);
+	void Clear();
+
+	unsigned int GetCapacity() const;
+	unsigned int GetReadableFrameCount() const;
+	unsigned int GetWritableFrameCount() const;
+
+	//Producer side, returns the number of frames written
+	unsigned int Write(const int16*, unsigned int);
+
+	//Consumer side, returns the number of frames read
+	unsigned int Read(int16*, unsigned int);
+
+private:
+	std::vector<int16> m_samples;
+	uint32 m_frameMask = 0;
+	//Free running frame counters, only their difference matters
+	std::atomic<uint32> m_readPosition = {0};
+	std::atomic<uint32> m_writePosition = {0};
+};
@@ -0,0 +1,473 @@
+#include "FlacFileWriter.h"
+#include <algorithm>
+#include <cassert>
+
+class CFlacFileWriter::CBitWriter
+{
+public:
+	CBitWriter(std::vector<uint8>& buffer)
+	    : m_buffer(buffer)
+	{
+		m_buffer.clear();
+	}
+
+	void WriteBits(uint32 value, unsigned int bitCount)
+	{
+		assert(bitCount <= 32);
+		uint64 mask = (1ULL << bitCount) - 1;
+		m_accumulator = (m_accumulator << bitCount) | (value & mask);
+		m_bitCount += bitCount;
+		while(m_bitCount >= 8)
+		{
+			m_bitCount -= 8;
+			m_buffer.push_back(static_cast<uint8>(m_accumulator >> m_bitCount));
+		}
+	}
+
+	void WriteSigned(int32 value, unsigned int bitCount)
+	{
+		WriteBits(static_cast<uint32>(value), bitCount);
+	}
+
+	//Zeros followed by a one
+	void WriteUnary(uint32 zeroCount)
+	{
+		while(zeroCount >= 32)
+		{
+			WriteBits(0, 32);
+			zeroCount -= 32;
+		}
+		WriteBits(1, zeroCount + 1);
+	}
+
+	void AlignToByte()
+	{
+		if(m_bitCount != 0)
+		{
+			WriteBits(0, 8 - m_bitCount);
+		}
+	}
+
+private:
+	std::vector<uint8>& m_buffer;
+	uint64 m_accumulator = 0;
+	unsigned int m_bitCount = 0;
+};
+
+static uint8 ComputeCrc8(const uint8* data, size_t size)
+{
+	//Polynomial x^8 + x^2 + x + 1
+	uint8 crc = 0;
+	for(size_t i = 0; i < size; i++)
+	{
+		crc ^= data[i];
+		for(unsigned int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x80) ? static_cast<uint8>((crc << 1) ^ 0x07) : static_cast<uint8>(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static uint16 ComputeCrc16(const uint8* data, size_t size)
+{
+	//Polynomial x^16 + x^15 + x^2 + 1
+	uint16 crc = 0;
+	for(size_t i = 0; i < size; i++)
+	{
+		crc ^= static_cast<uint16>(data[i] << 8);
+		for(unsigned int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? static_cast<uint16>((crc << 1) ^ 0x8005) : static_cast<uint16>(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static uint32 ZigZag(int32 value)
+{
+	return (static_cast<uint32>(value) << 1) ^ static_cast<uint32>(value >> 31);
+}
+
+static void ComputeFixedResidual(int32* residual, const int32* samples, unsigned int sampleCount, unsigned int order)
+{
+	for(unsigned int i = order; i < sampleCount; i++)
+	{
+		const int32* s = samples + i;
+		int32 prediction = 0;
+		switch(order)
+		{
+		case 1:
+			prediction = s[-1];
+			break;
+		case 2:
+			prediction = (2 * s[-1]) - s[-2];
+			break;
+		case 3:
+			prediction = (3 * s[-1]) - (3 * s[-2]) + s[-3];
+			break;
+		case 4:
+			prediction = (4 * s[-1]) - (6 * s[-2]) + (4 * s[-3]) - s[-4];
+			break;
+		}
+		residual[i - order] = s[0] - prediction;
+	}
+}
+
+CFlacFileWriter::CFlacFileWriter(StreamPtr stream, uint32 sampleRate, uint16 channelCount)
+    : m_stream(std::move(stream))
+    , m_sampleRate(sampleRate)
+    , m_channelCount(channelCount)
+{
+	assert(m_stream);
+	assert((m_channelCount != 0) && (m_channelCount <= MAX_CHANNEL_COUNT));
+	for(unsigned int i = 0; i < m_channelCount; i++)
+	{
+		m_blockSamples[i].resize(BLOCK_SIZE);
+	}
+	for(auto& decorrelated : m_decorrelated)
+	{
+		decorrelated.resize(BLOCK_SIZE);
+	}
+	m_residual.resize(BLOCK_SIZE);
+
+	static const uint8 g_marker[4] = {'f', 'L', 'a', 'C'};
+	m_stream->Write(g_marker, sizeof(g_marker));
+	//Only metadata block, STREAMINFO
+	static const uint8 g_blockHeader[4] = {0x80, 0x00, 0x00, STREAMINFO_SIZE};
+	m_stream->Write(g_blockHeader, sizeof(g_blockHeader));
+	WriteStreamInfo();
+}
+
+CFlacFileWriter::~CFlacFileWriter()
+{
+	EncodeBlock();
+	m_stream->Seek(STREAMINFO_OFFSET, Framework::STREAM_SEEK_SET);
+	WriteStreamInfo();
+	m_stream->Seek(0, Framework::STREAM_SEEK_END);
+}
+
+void CFlacFileWriter::Write(const int16* samples, unsigned int sampleCount)
+{
+	assert((sampleCount % m_channelCount) == 0);
+	unsigned int frameCount = sampleCount / m_channelCount;
+	while(frameCount != 0)
+	{
+		unsigned int copyCount = std::min<unsigned int>(frameCount, BLOCK_SIZE - m_blockFrameCount);
+		for(unsigned int i = 0; i < copyCount; i++)
+		{
+			for(unsigned int channel = 0; channel < m_channelCount; channel++)
+			{
+				m_blockSamples[channel][m_blockFrameCount + i] = *(samples++);
+			}
+		}
+		m_blockFrameCount += copyCount;
+		frameCount -= copyCount;
+		if(m_blockFrameCount == BLOCK_SIZE)
+		{
+			EncodeBlock();
+		}
+	}
+}
+
+uint32 CFlacFileWriter::GetSampleRate() const
+{
+	return m_sampleRate;
+}
+
+uint64 CFlacFileWriter::GetFrameCount() const
+{
+	return m_frameCount + m_blockFrameCount;
+}
+
+void CFlacFileWriter::WriteStreamInfo()
+{
+	std::vector<uint8> streamInfo;
+	CBitWriter writer(streamInfo);
+	writer.WriteBits(BLOCK_SIZE, 16);
+	writer.WriteBits(BLOCK_SIZE, 16);
+	writer.WriteBits(m_minFrameSize, 24);
+	writer.WriteBits(m_maxFrameSize, 24);
+	writer.WriteBits(m_sampleRate, 20);
+	writer.WriteBits(m_channelCount - 1, 3);
+	writer.WriteBits(16 - 1, 5);
+	writer.WriteBits(static_cast<uint32>(m_frameCount >> 32), 4);
+	writer.WriteBits(static_cast<uint32>(m_frameCount), 32);
+	//MD5 signature isn't computed, all zeros means it's unknown
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		writer.WriteBits(0, 32);
+	}
+	assert(streamInfo.size() == STREAMINFO_SIZE);
+	m_stream->Write(streamInfo.data(), streamInfo.size());
+}
+
+void CFlacFileWriter::EncodeBlock()
+{
+	unsigned int frameCount = m_blockFrameCount;
+	if(frameCount == 0) return;
+
+	SUBFRAME_PLAN plans[MAX_CHANNEL_COUNT];
+	const int32* channelSamples[MAX_CHANNEL_COUNT] = {};
+	unsigned int channelAssignment = m_channelCount - 1;
+	for(unsigned int channel = 0; channel < m_channelCount; channel++)
+	{
+		channelSamples[channel] = m_blockSamples[channel].data();
+		plans[channel] = PlanSubframe(channelSamples[channel], frameCount, 16);
+	}
+
+	if(m_channelCount == 2)
+	{
+		//Try coding the difference between channels, side needs an extra bit
+		const int32* left = m_blockSamples[0].data();
+		const int32* right = m_blockSamples[1].data();
+		int32* mid = m_decorrelated[0].data();
+		int32* side = m_decorrelated[1].data();
+		for(unsigned int i = 0; i < frameCount; i++)
+		{
+			mid[i] = (left[i] + right[i]) >> 1;
+			side[i] = left[i] - right[i];
+		}
+		auto midPlan = PlanSubframe(mid, frameCount, 16);
+		auto sidePlan = PlanSubframe(side, frameCount, 17);
+
+		uint64 independentBitCount = plans[0].bitCount + plans[1].bitCount;
+		uint64 leftSideBitCount = plans[0].bitCount + sidePlan.bitCount;
+		uint64 rightSideBitCount = sidePlan.bitCount + plans[1].bitCount;
+		uint64 midSideBitCount = midPlan.bitCount + sidePlan.bitCount;
+		uint64 bestBitCount = std::min({independentBitCount, leftSideBitCount, rightSideBitCount, midSideBitCount});
+		if(bestBitCount == midSideBitCount)
+		{
+			channelAssignment = CHANNEL_ASSIGNMENT_MID_SIDE;
+			plans[0] = midPlan;
+			plans[1] = sidePlan;
+			channelSamples[0] = mid;
+			channelSamples[1] = side;
+		}
+		else if(bestBitCount == leftSideBitCount)
+		{
+			channelAssignment = CHANNEL_ASSIGNMENT_LEFT_SIDE;
+			plans[1] = sidePlan;
+			channelSamples[1] = side;
+		}
+		else if(bestBitCount == rightSideBitCount)
+		{
+			channelAssignment = CHANNEL_ASSIGNMENT_RIGHT_SIDE;
+			plans[0] = sidePlan;
+			channelSamples[0] = side;
+		}
+	}
+
+	CBitWriter writer(m_frameBuffer);
+
+	//Frame header
+	writer.WriteBits(0x3FFE, 14); //Sync code
+	writer.WriteBits(0, 1);
+	writer.WriteBits(0, 1); //Fixed block size, header has the frame number
+	writer.WriteBits(7, 4); //Block size - 1 follows as a 16-bit value
+	writer.WriteBits(0, 4); //Sample rate from stream info
+	writer.WriteBits(channelAssignment, 4);
+	writer.WriteBits(4, 3); //16 bits per sample
+	writer.WriteBits(0, 1);
+	{
+		//Frame number uses the same variable length encoding as UTF-8
+		uint32 frameNumber = m_frameNumber;
+		if(frameNumber < 0x80)
+		{
+			writer.WriteBits(frameNumber, 8);
+		}
+		else
+		{
+			unsigned int extraByteCount = 1;
+			while((extraByteCount < 5) && (frameNumber >= (1U << (6 + (5 * extraByteCount)))))
+			{
+				extraByteCount++;
+			}
+			uint32 leadBits = (0xFF00 >> (extraByteCount + 1)) & 0xFF;
+			writer.WriteBits(leadBits | (frameNumber >> (6 * extraByteCount)), 8);
+			for(unsigned int i = extraByteCount; i != 0; i--)
+			{
+				writer.WriteBits(0x80 | ((frameNumber >> (6 * (i - 1))) & 0x3F), 8);
+			}
+		}
+	}
+	writer.WriteBits(frameCount - 1, 16);
+	writer.WriteBits(ComputeCrc8(m_frameBuffer.data(), m_frameBuffer.size()), 8);
+
+	for(unsigned int channel = 0; channel < m_channelCount; channel++)
+	{
+		WriteSubframe(writer, plans[channel], channelSamples[channel], frameCount);
+	}
+
+	writer.AlignToByte();
+	writer.WriteBits(ComputeCrc16(m_frameBuffer.data(), m_frameBuffer.size()), 16);
+
+	m_stream->Write(m_frameBuffer.data(), m_frameBuffer.size());
+
+	uint32 frameSize = static_cast<uint32>(m_frameBuffer.size());
+	m_minFrameSize = (m_minFrameSize == 0) ? frameSize : std::min(m_minFrameSize, frameSize);
+	m_maxFrameSize = std::max(m_maxFrameSize, frameSize);
+	m_frameNumber++;
+	m_frameCount += frameCount;
+	m_blockFrameCount = 0;
+}
+
+CFlacFileWriter::SUBFRAME_PLAN CFlacFileWriter::PlanSubframe(const int32* samples, unsigned int sampleCount, unsigned int bitsPerSample)
+{
+	//Subframe header is 8 bits
+	SUBFRAME_PLAN bestPlan;
+	bestPlan.bitsPerSample = bitsPerSample;
+
+	if(std::all_of(samples, samples + sampleCount, [&](int32 sample) { return sample == samples[0]; }))
+	{
+		bestPlan.type = SUBFRAME_CONSTANT;
+		bestPlan.bitCount = 8 + bitsPerSample;
+		return bestPlan;
+	}
+
+	bestPlan.type = SUBFRAME_VERBATIM;
+	bestPlan.bitCount = 8 + (static_cast<uint64>(sampleCount) * bitsPerSample);
+
+	unsigned int maxOrder = std::min<unsigned int>(MAX_FIXED_ORDER, sampleCount - 1);
+	for(unsigned int order = 0; order <= maxOrder; order++)
+	{
+		SUBFRAME_PLAN plan;
+		plan.type = SUBFRAME_FIXED;
+		plan.bitsPerSample = bitsPerSample;
+		plan.order = order;
+		ComputeFixedResidual(m_residual.data(), samples, sampleCount, order);
+		PlanResidual(plan, m_residual.data(), sampleCount);
+		plan.bitCount += 8 + (order * bitsPerSample);
+		if(plan.bitCount < bestPlan.bitCount)
+		{
+			bestPlan = plan;
+		}
+	}
+
+	return bestPlan;
+}
+
+void CFlacFileWriter::PlanResidual(SUBFRAME_PLAN& plan, const int32* residual, unsigned int sampleCount)
+{
+	unsigned int order = plan.order;
+
+	//Partitions need to split the block evenly and the first one has to hold more than the warm-up samples
+	unsigned int maxPartitionOrder = 0;
+	while(
+	    (maxPartitionOrder < MAX_PARTITION_ORDER) &&
+	    ((sampleCount % (2U << maxPartitionOrder)) == 0) &&
+	    ((sampleCount >> (maxPartitionOrder + 1)) > order))
+	{
+		maxPartitionOrder++;
+	}
+
+	uint64 partitionSums[1 << MAX_PARTITION_ORDER] = {};
+	{
+		unsigned int partitionSize = sampleCount >> maxPartitionOrder;
+		const int32* value = residual;
+		for(unsigned int partition = 0; partition < (1U << maxPartitionOrder); partition++)
+		{
+			unsigned int count = (partition == 0) ? (partitionSize - order) : partitionSize;
+			uint64 sum = 0;
+			for(unsigned int i = 0; i < count; i++)
+			{
+				sum += ZigZag(*(value++));
+			}
+			partitionSums[partition] = sum;
+		}
+	}
+
+	//Going from the finest partitioning to a single partition, merging sums along the way
+	uint64 bestBitCount = UINT64_MAX;
+	for(int partitionOrder = maxPartitionOrder; partitionOrder >= 0; partitionOrder--)
+	{
+		unsigned int partitionCount = 1U << partitionOrder;
+		unsigned int partitionSize = sampleCount >> partitionOrder;
+		if(partitionOrder != static_cast<int>(maxPartitionOrder))
+		{
+			for(unsigned int partition = 0; partition < partitionCount; partition++)
+			{
+				partitionSums[partition] = partitionSums[(partition * 2) + 0] + partitionSums[(partition * 2) + 1];
+			}
+		}
+
+		//Coding method and partition order
+		uint64 bitCount = 2 + 4;
+		uint8 riceParams[1 << MAX_PARTITION_ORDER];
+		for(unsigned int partition = 0; partition < partitionCount; partition++)
+		{
+			uint64 count = (partition == 0) ? (partitionSize - order) : partitionSize;
+			//Estimated size of a partition coded with parameter k: (k + 1) bits per value plus the unary parts
+			uint64 bestPartitionBitCount = UINT64_MAX;
+			for(unsigned int k = 0; k <= MAX_RICE_PARAM; k++)
+			{
+				uint64 partitionBitCount = (count * (k + 1)) + (partitionSums[partition] >> k);
+				if(partitionBitCount < bestPartitionBitCount)
+				{
+					bestPartitionBitCount = partitionBitCount;
+					riceParams[partition] = k;
+				}
+			}
+			bitCount += 4 + bestPartitionBitCount;
+		}
+
+		if(bitCount < bestBitCount)
+		{
+			bestBitCount = bitCount;
+			plan.partitionOrder = partitionOrder;
+			std::copy(riceParams, riceParams + partitionCount, plan.riceParams);
+		}
+	}
+
+	plan.bitCount = bestBitCount;
+}
+
+void CFlacFileWriter::WriteSubframe(CBitWriter& writer, const SUBFRAME_PLAN& plan, const int32* samples, unsigned int sampleCount)
+{
+	writer.WriteBits(0, 1);
+	switch(plan.type)
+	{
+	case SUBFRAME_CONSTANT:
+		writer.WriteBits(0x00, 6);
+		writer.WriteBits(0, 1);
+		writer.WriteSigned(samples[0], plan.bitsPerSample);
+		break;
+	case SUBFRAME_VERBATIM:
+		writer.WriteBits(0x01, 6);
+		writer.WriteBits(0, 1);
+		for(unsigned int i = 0; i < sampleCount; i++)
+		{
+			writer.WriteSigned(samples[i], plan.bitsPerSample);
+		}
+		break;
+	case SUBFRAME_FIXED:
+	{
+		writer.WriteBits(0x08 | plan.order, 6);
+		writer.WriteBits(0, 1);
+		for(unsigned int i = 0; i < plan.order; i++)
+		{
+			writer.WriteSigned(samples[i], plan.bitsPerSample);
+		}
+
+		ComputeFixedResidual(m_residual.data(), samples, sampleCount, plan.order);
+		writer.WriteBits(0, 2); //Rice coding with 4-bit parameters
+		writer.WriteBits(plan.partitionOrder, 4);
+		unsigned int partitionCount = 1U << plan.partitionOrder;
+		unsigned int partitionSize = sampleCount >> plan.partitionOrder;
+		const int32* value = m_residual.data();
+		for(unsigned int partition = 0; partition < partitionCount; partition++)
+		{
+			unsigned int k = plan.riceParams[partition];
+			unsigned int count = (partition == 0) ? (partitionSize - plan.order) : partitionSize;
+			writer.WriteBits(k, 4);
+			for(unsigned int i = 0; i < count; i++)
+			{
+				uint32 zigZagValue = ZigZag(*(value++));
+				writer.WriteUnary(zigZagValue >> k);
+				writer.WriteBits(zigZagValue, k);
+			}
+		}
+	}
+	break;
+	}
+}
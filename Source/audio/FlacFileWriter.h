@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Stream.h"
+#include "Types.h"
+#include "AudioFileWriter.h"
+
+//Encodes 16-bit PCM samples to a FLAC stream. Frames use fixed predictors and Rice coded residuals,
+//which gets most of the compression FLAC can offer at a small fraction of the cost of LPC analysis.
+//Stream info (total sample count, frame sizes) is fixed up when the writer is destroyed.
+class CFlacFileWriter : public CAudioFileWriter
+{
+public:
+	typedef std::unique_ptr<Framework::CStream> StreamPtr;
+
+	enum
+	{
+		BLOCK_SIZE = 4096,
+		MAX_CHANNEL_COUNT = 8,
+	};
+
+	CFlacFileWriter(StreamPtr, uint32, uint16);
+	virtual ~CFlacFileWriter();
+
+	CFlacFileWriter(const CFlacFileWriter&) = delete;
+	CFlacFileWriter& operator=(const CFlacFileWriter&) = delete;
+
+	void Write(const int16*, unsigned int) override;
+
+	uint32 GetSampleRate() const;
+	uint64 GetFrameCount() const;
+
+private:
+	enum
+	{
+		MAX_FIXED_ORDER = 4,
+		MAX_PARTITION_ORDER = 8,
+		MAX_RICE_PARAM = 14,
+		STREAMINFO_OFFSET = 8,
+		STREAMINFO_SIZE = 34,
+	};
+
+	enum SUBFRAME_TYPE
+	{
+		SUBFRAME_CONSTANT,
+		SUBFRAME_VERBATIM,
+		SUBFRAME_FIXED,
+	};
+
+	enum CHANNEL_ASSIGNMENT
+	{
+		//Values below are for stereo only, independent channels use channel count - 1
+		CHANNEL_ASSIGNMENT_LEFT_SIDE = 8,
+		CHANNEL_ASSIGNMENT_RIGHT_SIDE = 9,
+		CHANNEL_ASSIGNMENT_MID_SIDE = 10,
+	};
+
+	struct SUBFRAME_PLAN
+	{
+		SUBFRAME_TYPE type = SUBFRAME_VERBATIM;
+		unsigned int bitsPerSample = 16;
+		unsigned int order = 0;
+		unsigned int partitionOrder = 0;
+		uint8 riceParams[1 << MAX_PARTITION_ORDER] = {};
+		uint64 bitCount = 0;
+	};
+
+	class CBitWriter;
+
+	void WriteStreamInfo();
+	void EncodeBlock();
+	SUBFRAME_PLAN PlanSubframe(const int32*, unsigned int, unsigned int);
+	void PlanResidual(SUBFRAME_PLAN&, const int32*, unsigned int);
+	void WriteSubframe(CBitWriter&, const SUBFRAME_PLAN&, const int32*, unsigned int);
+
+	StreamPtr m_stream;
+	uint32 m_sampleRate = 0;
+	uint16 m_channelCount = 0;
+	uint64 m_frameCount = 0;
+	uint32 m_frameNumber = 0;
+	uint32 m_minFrameSize = 0;
+	uint32 m_maxFrameSize = 0;
+
+	//Samples of the block being filled, one array per channel
+	std::vector<int32> m_blockSamples[MAX_CHANNEL_COUNT];
+	unsigned int m_blockFrameCount = 0;
+
+	//Scratch buffers reused from block to block
+	std::vector<int32> m_decorrelated[2];
+	std::vector<int32> m_residual;
+	std::vector<uint8> m_frameBuffer;
+};
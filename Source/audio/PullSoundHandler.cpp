@@ -0,0 +1,157 @@
+#include "PullSoundHandler.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+CPullSoundHandler::CPullSoundHandler()
+    : m_ring(RING_FRAME_COUNT)
+{
+	SetSampleRate(44100);
+}
+
+void CPullSoundHandler::Reset()
+{
+	//Ring is cleared by the host side on its next pull
+	m_resetPending = true;
+	m_timeStretcher.Reset();
+	m_latencyController.Reset();
+	m_targetFrameCount = m_latencyController.GetTargetFrameCount();
+}
+
+void CPullSoundHandler::Write(int16* samples, unsigned int sampleCount, unsigned int sampleRate)
+{
+	assert((sampleCount % CAudioRingBuffer::CHANNEL_COUNT) == 0);
+	if(sampleRate != m_sampleRate)
+	{
+		SetSampleRate(sampleRate);
+	}
+
+	unsigned int frameCount = sampleCount / CAudioRingBuffer::CHANNEL_COUNT;
+
+	uint32 underrunCount = m_underrunCount;
+	m_latencyController.Update(frameCount, underrunCount - m_lastUnderrunCount);
+	m_lastUnderrunCount = underrunCount;
+	m_targetFrameCount = m_latencyController.GetTargetFrameCount();
+
+	if(m_timeStretchEnabled)
+	{
+		UpdateTempo();
+		m_stretchedSamples.clear();
+		m_timeStretcher.Process(m_stretchedSamples, samples, frameCount);
+		samples = m_stretchedSamples.data();
+		frameCount = static_cast<unsigned int>(m_stretchedSamples.size() / CAudioRingBuffer::CHANNEL_COUNT);
+	}
+
+	//Don't let latency grow forever if the emulator runs faster than the host consumes
+	uint32 maxBufferedFrameCount = m_latencyController.GetMaxFrameCount() * 2;
+	uint32 bufferedFrameCount = m_ring.GetReadableFrameCount();
+	uint32 acceptedFrameCount = (bufferedFrameCount < maxBufferedFrameCount) ? std::min<uint32>(frameCount, maxBufferedFrameCount - bufferedFrameCount) : 0;
+	uint32 writtenFrameCount = m_ring.Write(samples, acceptedFrameCount);
+	m_droppedFrameCount += frameCount - writtenFrameCount;
+}
+
+bool CPullSoundHandler::HasFreeBuffers()
+{
+	//Lets frontends that pace themselves on this stop once the target is reached
+	return m_ring.GetReadableFrameCount() < m_targetFrameCount;
+}
+
+void CPullSoundHandler::RecycleBuffers()
+{
+}
+
+bool CPullSoundHandler::IsPullBased() const
+{
+	return true;
+}
+
+void CPullSoundHandler::Pull(int16* samples, unsigned int frameCount)
+{
+	if(m_resetPending.exchange(false))
+	{
+		//Drop everything that was written before the reset
+		int16 discard[0x100 * CAudioRingBuffer::CHANNEL_COUNT];
+		while(m_ring.Read(discard, 0x100) != 0)
+		{
+		}
+		m_primed = false;
+	}
+
+	unsigned int readFrameCount = 0;
+	if(!m_primed)
+	{
+		//Wait for enough audio to be buffered before starting, starting right away would underrun again
+		if(m_ring.GetReadableFrameCount() >= std::max<uint32>(m_targetFrameCount, frameCount))
+		{
+			m_primed = true;
+		}
+	}
+
+	if(m_primed)
+	{
+		readFrameCount = m_ring.Read(samples, frameCount);
+		if(readFrameCount != frameCount)
+		{
+			m_underrunCount++;
+			m_primed = false;
+		}
+	}
+
+	memset(samples + (readFrameCount * CAudioRingBuffer::CHANNEL_COUNT), 0, (frameCount - readFrameCount) * CAudioRingBuffer::CHANNEL_COUNT * sizeof(int16));
+}
+
+void CPullSoundHandler::SetTimeStretchEnabled(bool timeStretchEnabled)
+{
+	if(m_timeStretchEnabled == timeStretchEnabled) return;
+	m_timeStretchEnabled = timeStretchEnabled;
+	m_timeStretcher.Reset();
+	m_timeStretcher.SetTempo(1);
+}
+
+void CPullSoundHandler::SetLatencyLimits(uint32 minFrameCount, uint32 maxFrameCount)
+{
+	m_latencyController.SetLimits(minFrameCount, maxFrameCount);
+	m_targetFrameCount = m_latencyController.GetTargetFrameCount();
+}
+
+uint32 CPullSoundHandler::GetSampleRate() const
+{
+	return m_sampleRate;
+}
+
+uint32 CPullSoundHandler::GetTargetLatencyFrameCount() const
+{
+	return m_targetFrameCount;
+}
+
+uint32 CPullSoundHandler::GetBufferedFrameCount() const
+{
+	return m_ring.GetReadableFrameCount();
+}
+
+uint32 CPullSoundHandler::GetUnderrunCount() const
+{
+	return m_underrunCount;
+}
+
+uint32 CPullSoundHandler::GetDroppedFrameCount() const
+{
+	return m_droppedFrameCount;
+}
+
+void CPullSoundHandler::SetSampleRate(uint32 sampleRate)
+{
+	m_sampleRate = sampleRate;
+	m_latencyController.SetSampleRate(sampleRate);
+	m_timeStretcher.SetSampleRate(sampleRate);
+	m_targetFrameCount = m_latencyController.GetTargetFrameCount();
+}
+
+void CPullSoundHandler::UpdateTempo()
+{
+	//Speed up a bit when too much audio is buffered, slow down when the ring is running dry
+	float targetFrameCount = static_cast<float>(std::max<uint32>(m_targetFrameCount, 1));
+	float error = (static_cast<float>(m_ring.GetReadableFrameCount()) - targetFrameCount) / targetFrameCount;
+	float adjustment = std::clamp(error * (STRETCH_GAIN_PERCENT / 100.0f), -MAX_STRETCH_PERCENT / 100.0f, MAX_STRETCH_PERCENT / 100.0f);
+	m_timeStretcher.SetTempo(1.0f + adjustment);
+}
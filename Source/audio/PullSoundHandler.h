@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "../../tools/PsfPlayer/Source/SoundHandler.h"
+#include "AudioLatencyController.h"
+#include "AudioRingBuffer.h"
+#include "TimeStretcher.h"
+
+//Sound handler for hosts that request audio from their own callback.
+//Emulation writes into a lock-free ring that the host callback drains with Pull. How much audio is
+//kept in the ring adapts to the underruns seen by the host. When time stretching is enabled, the
+//emulated audio is sped up or slowed down slightly to keep the ring close to that target instead
+//of dropping samples or letting it run dry.
+class CPullSoundHandler : public CSoundHandler
+{
+public:
+	CPullSoundHandler();
+
+	void Reset() override;
+	void Write(int16*, unsigned int, unsigned int) override;
+	bool HasFreeBuffers() override;
+	void RecycleBuffers() override;
+	bool IsPullBased() const override;
+
+	//Host side, always fills the whole buffer, silence is used when not enough frames are available
+	void Pull(int16*, unsigned int);
+
+	//Emulation side
+	void SetTimeStretchEnabled(bool);
+	void SetLatencyLimits(uint32, uint32);
+
+	uint32 GetSampleRate() const;
+	uint32 GetTargetLatencyFrameCount() const;
+	uint32 GetBufferedFrameCount() const;
+	uint32 GetUnderrunCount() const;
+	uint32 GetDroppedFrameCount() const;
+
+private:
+	enum
+	{
+		//Enough for the largest latency at high output rates plus what a frontend writes in one go
+		RING_FRAME_COUNT = 0x20000,
+		//Tempo change when the ring is off target by the whole target
+		STRETCH_GAIN_PERCENT = 5,
+		MAX_STRETCH_PERCENT = 5,
+	};
+
+	void SetSampleRate(uint32);
+	void UpdateTempo();
+
+	CAudioRingBuffer m_ring;
+	CAudioLatencyController m_latencyController;
+	CTimeStretcher m_timeStretcher;
+	std::vector<int16> m_stretchedSamples;
+	bool m_timeStretchEnabled = false;
+	uint32 m_droppedFrameCount = 0;
+	uint32 m_lastUnderrunCount = 0;
+
+	//Shared with the host callback
+	std::atomic<uint32> m_sampleRate = {0};
+	std::atomic<uint32> m_targetFrameCount = {0};
+	std::atomic<uint32> m_underrunCount = {0};
+	std::atomic<bool> m_resetPending = {false};
+
+	//Host side, playback waits for the ring to reach its target before starting
+	bool m_primed = false;
+};
@@ -0,0 +1,129 @@
+#include "SH_Capture.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include "StdStream.h"
+#include "StdStreamUtils.h"
+#include "FlacFileWriter.h"
+#include "WaveFileWriter.h"
+
+CSH_Capture::CSH_Capture(CSoundHandler* inner, const fs::path& outputPath)
+    : m_inner(inner)
+    , m_format(GetFormatFromPath(outputPath))
+    , m_ring(RING_FRAME_COUNT)
+{
+	//Open the file right away to report errors to whoever creates the handler
+	m_outputStream = std::make_unique<Framework::CStdStream>(Framework::CreateOutputStdStream(outputPath.native()));
+	m_drainSamples.resize(DRAIN_FRAME_COUNT * CAudioRingBuffer::CHANNEL_COUNT);
+	m_thread = std::thread([this]() { ThreadProc(); });
+}
+
+CSH_Capture::~CSH_Capture()
+{
+	m_stopping = true;
+	m_thread.join();
+}
+
+CSoundHandler::FactoryFunction CSH_Capture::GetFactoryFunction(const FactoryFunction& innerFactory, const fs::path& outputPath)
+{
+	return [innerFactory, outputPath]() {
+		CSoundHandler* inner = innerFactory ? innerFactory() : nullptr;
+		return new CSH_Capture(inner, outputPath);
+	};
+}
+
+CSH_Capture::FORMAT CSH_Capture::GetFormatFromPath(const fs::path& path)
+{
+	auto extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	return (extension == ".flac") ? FORMAT_FLAC : FORMAT_WAVE;
+}
+
+void CSH_Capture::Reset()
+{
+	//Capture is continuous, only the inner handler's buffers are flushed
+	if(m_inner)
+	{
+		m_inner->Reset();
+	}
+}
+
+void CSH_Capture::Write(int16* samples, unsigned int sampleCount, unsigned int sampleRate)
+{
+	assert((sampleCount % CAudioRingBuffer::CHANNEL_COUNT) == 0);
+	uint32 expectedSampleRate = 0;
+	m_sampleRate.compare_exchange_strong(expectedSampleRate, sampleRate);
+
+	unsigned int frameCount = sampleCount / CAudioRingBuffer::CHANNEL_COUNT;
+	unsigned int writtenFrameCount = m_ring.Write(samples, frameCount);
+	if(writtenFrameCount != frameCount)
+	{
+		m_droppedFrameCount += frameCount - writtenFrameCount;
+	}
+
+	if(m_inner)
+	{
+		m_inner->Write(samples, sampleCount, sampleRate);
+	}
+}
+
+bool CSH_Capture::HasFreeBuffers()
+{
+	return m_inner ? m_inner->HasFreeBuffers() : true;
+}
+
+void CSH_Capture::RecycleBuffers()
+{
+	if(m_inner)
+	{
+		m_inner->RecycleBuffers();
+	}
+}
+
+bool CSH_Capture::IsPullBased() const
+{
+	//Without an inner handler, nothing needs batching
+	return m_inner ? m_inner->IsPullBased() : true;
+}
+
+uint64 CSH_Capture::GetDroppedFrameCount() const
+{
+	return m_droppedFrameCount;
+}
+
+void CSH_Capture::ThreadProc()
+{
+	while(!m_stopping)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_PERIOD_MS));
+		Drain();
+	}
+	//Producer is gone at this point, pick up what's left and finish the file
+	Drain();
+	m_writer.reset();
+	m_outputStream.reset();
+}
+
+void CSH_Capture::Drain()
+{
+	while(true)
+	{
+		unsigned int frameCount = m_ring.Read(m_drainSamples.data(), DRAIN_FRAME_COUNT);
+		if(frameCount == 0) break;
+		if(!m_writer)
+		{
+			uint32 sampleRate = m_sampleRate;
+			switch(m_format)
+			{
+			case FORMAT_FLAC:
+				m_writer = std::make_unique<CFlacFileWriter>(std::move(m_outputStream), sampleRate, CAudioRingBuffer::CHANNEL_COUNT);
+				break;
+			default:
+				m_writer = std::make_unique<CWaveFileWriter>(std::move(m_outputStream), sampleRate, CAudioRingBuffer::CHANNEL_COUNT);
+				break;
+			}
+		}
+		m_writer->Write(m_drainSamples.data(), frameCount * CAudioRingBuffer::CHANNEL_COUNT);
+	}
+}
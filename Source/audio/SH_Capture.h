@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "filesystem_def.h"
+#include "Stream.h"
+#include "../../tools/PsfPlayer/Source/SoundHandler.h"
+#include "AudioFileWriter.h"
+#include "AudioRingBuffer.h"
+
+//Sound handler decorator that records everything written to it while forwarding to another handler.
+//Writes only copy samples to a ring, a separate thread encodes them to a WAVE or FLAC file (picked from the extension).
+//If encoding can't keep up, samples that don't fit are dropped from the file rather than stalling the caller.
+class CSH_Capture : public CSoundHandler
+{
+public:
+	enum FORMAT
+	{
+		FORMAT_WAVE,
+		FORMAT_FLAC,
+	};
+
+	//Takes ownership of the inner handler, which can be null for headless captures
+	CSH_Capture(CSoundHandler*, const fs::path&);
+	virtual ~CSH_Capture();
+
+	static FactoryFunction GetFactoryFunction(const FactoryFunction&, const fs::path&);
+	static FORMAT GetFormatFromPath(const fs::path&);
+
+	void Reset() override;
+	void Write(int16*, unsigned int, unsigned int) override;
+	bool HasFreeBuffers() override;
+	void RecycleBuffers() override;
+	bool IsPullBased() const override;
+
+	uint64 GetDroppedFrameCount() const;
+
+private:
+	enum
+	{
+		//About 5 seconds at 48KHz
+		RING_FRAME_COUNT = 0x40000,
+		DRAIN_PERIOD_MS = 20,
+		DRAIN_FRAME_COUNT = 0x1000,
+	};
+
+	void ThreadProc();
+	void Drain();
+
+	std::unique_ptr<CSoundHandler> m_inner;
+	FORMAT m_format = FORMAT_WAVE;
+	std::unique_ptr<Framework::CStream> m_outputStream;
+	//File's sample rate is the one used when audio is first written
+	std::unique_ptr<CAudioFileWriter> m_writer;
+	std::vector<int16> m_drainSamples;
+
+	CAudioRingBuffer m_ring;
+	std::atomic<uint32> m_sampleRate = {0};
+	std::atomic<uint64> m_droppedFrameCount = {0};
+	std::thread m_thread;
+	std::atomic<bool> m_stopping = {false};
+};
@@ -0,0 +1,72 @@
+#include "SH_WaveFile.h"
+#include <chrono>
+#include <vector>
+#include "StdStream.h"
+#include "StdStreamUtils.h"
+
+CSH_WaveFile::CSH_WaveFile(const fs::path& outputPath)
+    : m_outputPath(outputPath)
+{
+	m_thread = std::thread([this]() { ThreadProc(); });
+}
+
+CSH_WaveFile::~CSH_WaveFile()
+{
+	m_stopping = true;
+	m_thread.join();
+}
+
+CSoundHandler::FactoryFunction CSH_WaveFile::GetFactoryFunction(const fs::path& outputPath)
+{
+	return [outputPath]() { return new CSH_WaveFile(outputPath); };
+}
+
+void CSH_WaveFile::Write(int16* samples, unsigned int sampleCount, unsigned int sampleRate)
+{
+	CPullSoundHandler::Write(samples, sampleCount, sampleRate);
+	m_started = true;
+}
+
+void CSH_WaveFile::ThreadProc()
+{
+	std::vector<int16> samples;
+	auto nextPullTime = std::chrono::steady_clock::now();
+	uint64 pulledFrameCount = 0;
+	uint64 elapsedMs = 0;
+	uint32 sampleRate = GetSampleRate();
+	while(!m_stopping)
+	{
+		nextPullTime += std::chrono::milliseconds(PULL_PERIOD_MS);
+		std::this_thread::sleep_until(nextPullTime);
+
+		if(!m_started)
+		{
+			nextPullTime = std::chrono::steady_clock::now();
+			continue;
+		}
+
+		if(GetSampleRate() != sampleRate)
+		{
+			sampleRate = GetSampleRate();
+			pulledFrameCount = 0;
+			elapsedMs = 0;
+		}
+
+		//Keep track of the total to avoid accumulating rounding errors
+		elapsedMs += PULL_PERIOD_MS;
+		uint64 frameCount = ((elapsedMs * sampleRate) / 1000) - pulledFrameCount;
+		pulledFrameCount += frameCount;
+
+		samples.resize(frameCount * CAudioRingBuffer::CHANNEL_COUNT);
+		Pull(samples.data(), static_cast<unsigned int>(frameCount));
+
+		if(m_outputPath.empty()) continue;
+		if(!m_writer)
+		{
+			auto stream = std::make_unique<Framework::CStdStream>(Framework::CreateOutputStdStream(m_outputPath.native()));
+			m_writer = std::make_unique<CWaveFileWriter>(std::move(stream), sampleRate, CAudioRingBuffer::CHANNEL_COUNT);
+		}
+		m_writer->Write(samples.data(), static_cast<unsigned int>(samples.size()));
+	}
+	m_writer.reset();
+}
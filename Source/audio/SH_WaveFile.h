@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "filesystem_def.h"
+#include "PullSoundHandler.h"
+#include "WaveFileWriter.h"
+
+//Headless sound handler: a thread plays the part of the host's audio callback and pulls audio in real time.
+//Pulled audio goes to a WAVE file if a path is given and is discarded otherwise.
+class CSH_WaveFile : public CPullSoundHandler
+{
+public:
+	CSH_WaveFile(const fs::path& = fs::path());
+	virtual ~CSH_WaveFile();
+
+	static FactoryFunction GetFactoryFunction(const fs::path& = fs::path());
+
+	void Write(int16*, unsigned int, unsigned int) override;
+
+private:
+	enum
+	{
+		PULL_PERIOD_MS = 10,
+	};
+
+	void ThreadProc();
+
+	fs::path m_outputPath;
+	//File's sample rate is the one used when audio is first pulled
+	std::unique_ptr<CWaveFileWriter> m_writer;
+	std::thread m_thread;
+	std::atomic<bool> m_stopping = {false};
+	//Pulling starts with the first write, the file then gets the emulator's sample rate
+	std::atomic<bool> m_started = {false};
+};
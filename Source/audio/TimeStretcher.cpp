@@ -0,0 +1,151 @@
+#include "TimeStretcher.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+CTimeStretcher::CTimeStretcher()
+{
+	SetSampleRate(44100);
+}
+
+void CTimeStretcher::SetSampleRate(uint32 sampleRate)
+{
+	assert(sampleRate != 0);
+	m_sequenceFrameCount = (sampleRate * SEQUENCE_MS) / 1000;
+	m_overlapFrameCount = (sampleRate * OVERLAP_MS) / 1000;
+	m_seekFrameCount = (sampleRate * SEEK_WINDOW_MS) / 1000;
+	assert(m_sequenceFrameCount >= (m_overlapFrameCount * 2));
+	Reset();
+}
+
+void CTimeStretcher::SetTempo(float tempo)
+{
+	m_tempo = std::clamp(tempo, 0.5f, 2.0f);
+}
+
+float CTimeStretcher::GetTempo() const
+{
+	return m_tempo;
+}
+
+void CTimeStretcher::Reset()
+{
+	m_input.clear();
+	m_overlap.clear();
+	m_hasOverlap = false;
+	m_skipFraction = 0;
+}
+
+void CTimeStretcher::Process(std::vector<int16>& output, const int16* samples, unsigned int frameCount)
+{
+	m_input.insert(m_input.end(), samples, samples + (frameCount * CHANNEL_COUNT));
+
+	//Each sequence outputs (sequence - overlap) frames and consumes tempo times that
+	double nominalSkip = m_tempo * static_cast<double>(m_sequenceFrameCount - m_overlapFrameCount);
+	unsigned int requiredFrameCount = std::max<unsigned int>(static_cast<unsigned int>(std::ceil(nominalSkip)) + m_overlapFrameCount, m_sequenceFrameCount) + m_seekFrameCount;
+
+	size_t inputFrameCount = m_input.size() / CHANNEL_COUNT;
+	size_t inputPosition = 0;
+	while((inputFrameCount - inputPosition) >= requiredFrameCount)
+	{
+		const int16* window = m_input.data() + (inputPosition * CHANNEL_COUNT);
+		unsigned int sequenceOffset = m_hasOverlap ? FindBestOverlapPosition(window) : 0;
+		const int16* sequence = window + (sequenceOffset * CHANNEL_COUNT);
+
+		if(m_hasOverlap)
+		{
+			OverlapAdd(output, sequence);
+		}
+		else
+		{
+			output.insert(output.end(), sequence, sequence + (m_overlapFrameCount * CHANNEL_COUNT));
+		}
+
+		//Middle of the sequence goes out as is, its end will be crossfaded with the next one
+		unsigned int overlapStart = m_sequenceFrameCount - m_overlapFrameCount;
+		output.insert(output.end(), sequence + (m_overlapFrameCount * CHANNEL_COUNT), sequence + (overlapStart * CHANNEL_COUNT));
+		m_overlap.assign(sequence + (overlapStart * CHANNEL_COUNT), sequence + (m_sequenceFrameCount * CHANNEL_COUNT));
+		m_hasOverlap = true;
+
+		m_skipFraction += nominalSkip;
+		unsigned int skip = static_cast<unsigned int>(m_skipFraction);
+		m_skipFraction -= skip;
+		inputPosition += skip;
+	}
+
+	m_input.erase(m_input.begin(), m_input.begin() + (inputPosition * CHANNEL_COUNT));
+}
+
+unsigned int CTimeStretcher::GetBufferedFrameCount() const
+{
+	return static_cast<unsigned int>(m_input.size() / CHANNEL_COUNT);
+}
+
+unsigned int CTimeStretcher::FindBestOverlapPosition(const int16* window)
+{
+	m_overlapMono.resize(m_overlapFrameCount);
+	for(unsigned int i = 0; i < m_overlapFrameCount; i++)
+	{
+		m_overlapMono[i] = m_overlap[(i * CHANNEL_COUNT) + 0] + m_overlap[(i * CHANNEL_COUNT) + 1];
+	}
+
+	unsigned int windowFrameCount = m_seekFrameCount + m_overlapFrameCount;
+	m_windowMono.resize(windowFrameCount);
+	for(unsigned int i = 0; i < windowFrameCount; i++)
+	{
+		m_windowMono[i] = window[(i * CHANNEL_COUNT) + 0] + window[(i * CHANNEL_COUNT) + 1];
+	}
+
+	auto search = [&](unsigned int start, unsigned int end, unsigned int step, unsigned int bestPosition) {
+		double bestScore = -INFINITY;
+		for(unsigned int position = start; position < end; position += step)
+		{
+			//Correlation normalized by the candidate's energy, the overlap's energy is the same for everyone
+			int64 energy = 0;
+			for(unsigned int i = 0; i < m_overlapFrameCount; i++)
+			{
+				int64 value = m_windowMono[position + i];
+				energy += value * value;
+			}
+			double score = static_cast<double>(GetCorrelation(position)) / std::sqrt(static_cast<double>(energy) + 1.0);
+			if(score > bestScore)
+			{
+				bestScore = score;
+				bestPosition = position;
+			}
+		}
+		return bestPosition;
+	};
+
+	unsigned int coarsePosition = search(0, m_seekFrameCount, SEEK_COARSE_STEP, 0);
+	unsigned int refineStart = coarsePosition - std::min<unsigned int>(coarsePosition, SEEK_COARSE_STEP - 1);
+	unsigned int refineEnd = std::min<unsigned int>(coarsePosition + SEEK_COARSE_STEP, m_seekFrameCount);
+	return search(refineStart, refineEnd, 1, coarsePosition);
+}
+
+int64 CTimeStretcher::GetCorrelation(unsigned int position) const
+{
+	int64 correlation = 0;
+	const int32* candidate = m_windowMono.data() + position;
+	for(unsigned int i = 0; i < m_overlapFrameCount; i++)
+	{
+		correlation += static_cast<int64>(m_overlapMono[i]) * candidate[i];
+	}
+	return correlation;
+}
+
+void CTimeStretcher::OverlapAdd(std::vector<int16>& output, const int16* sequence) const
+{
+	//Linear crossfade from the end of the previous sequence to the start of the new one
+	int32 overlapFrameCount = m_overlapFrameCount;
+	for(int32 i = 0; i < overlapFrameCount; i++)
+	{
+		for(unsigned int channel = 0; channel < CHANNEL_COUNT; channel++)
+		{
+			int32 previous = m_overlap[(i * CHANNEL_COUNT) + channel];
+			int32 next = sequence[(i * CHANNEL_COUNT) + channel];
+			int32 value = ((previous * (overlapFrameCount - i)) + (next * i)) / overlapFrameCount;
+			output.push_back(static_cast<int16>(value));
+		}
+	}
+}
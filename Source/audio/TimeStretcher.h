@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "Types.h"
+
+//WSOLA (waveform similarity overlap-add) time stretcher for interleaved stereo frames.
+//Changes the playback speed without changing the pitch: the input is cut in overlapping
+//sequences and each sequence is aligned with the end of the previous one where both
+//waveforms are the most similar before being crossfaded.
+class CTimeStretcher
+{
+public:
+	enum
+	{
+		CHANNEL_COUNT = 2,
+	};
+
+	CTimeStretcher();
+
+	void SetSampleRate(uint32);
+
+	//Input duration over output duration, higher values play faster
+	void SetTempo(float);
+	float GetTempo() const;
+
+	void Reset();
+
+	//Appends stretched frames to the output, some input is kept until enough is available
+	void Process(std::vector<int16>&, const int16*, unsigned int);
+
+	unsigned int GetBufferedFrameCount() const;
+
+private:
+	enum
+	{
+		SEQUENCE_MS = 40,
+		OVERLAP_MS = 8,
+		SEEK_WINDOW_MS = 15,
+		//Seeking is done on a coarse grid first and refined around the best match
+		SEEK_COARSE_STEP = 4,
+	};
+
+	unsigned int FindBestOverlapPosition(const int16*);
+	int64 GetCorrelation(unsigned int) const;
+	void OverlapAdd(std::vector<int16>&, const int16*) const;
+
+	unsigned int m_sequenceFrameCount = 0;
+	unsigned int m_overlapFrameCount = 0;
+	unsigned int m_seekFrameCount = 0;
+	float m_tempo = 1;
+	double m_skipFraction = 0;
+
+	std::vector<int16> m_input;
+	std::vector<int16> m_overlap;
+	bool m_hasOverlap = false;
+
+	//Mono versions of the overlap and of the current seek window used for the similarity search
+	std::vector<int32> m_overlapMono;
+	std::vector<int32> m_windowMono;
+};
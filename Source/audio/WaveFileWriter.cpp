@@ -0,0 +1,67 @@
+#include "WaveFileWriter.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+CWaveFileWriter::CWaveFileWriter(StreamPtr stream, uint32 sampleRate, uint16 channelCount)
+    : m_stream(std::move(stream))
+    , m_sampleRate(sampleRate)
+    , m_channelCount(channelCount)
+{
+	assert(m_stream);
+	assert(m_channelCount != 0);
+	WriteHeader();
+}
+
+CWaveFileWriter::~CWaveFileWriter()
+{
+	UpdateSizes();
+}
+
+void CWaveFileWriter::Write(const int16* samples, unsigned int sampleCount)
+{
+	assert((sampleCount % m_channelCount) == 0);
+	//WAVE files are little endian, like every platform we run on
+	uint32 size = sampleCount * sizeof(int16);
+	m_stream->Write(samples, size);
+	m_dataSize += size;
+}
+
+uint32 CWaveFileWriter::GetSampleRate() const
+{
+	return m_sampleRate;
+}
+
+uint64 CWaveFileWriter::GetFrameCount() const
+{
+	return m_dataSize / (sizeof(int16) * m_channelCount);
+}
+
+void CWaveFileWriter::WriteHeader()
+{
+	uint16 blockAlign = m_channelCount * sizeof(int16);
+	m_stream->Write32(0x46464952); //'RIFF'
+	m_stream->Write32(0);
+	m_stream->Write32(0x45564157); //'WAVE'
+	m_stream->Write32(0x20746D66); //'fmt '
+	m_stream->Write32(16);
+	m_stream->Write16(1); //PCM
+	m_stream->Write16(m_channelCount);
+	m_stream->Write32(m_sampleRate);
+	m_stream->Write32(m_sampleRate * blockAlign);
+	m_stream->Write16(blockAlign);
+	m_stream->Write16(16);
+	m_stream->Write32(0x61746164); //'data'
+	m_stream->Write32(0);
+}
+
+void CWaveFileWriter::UpdateSizes()
+{
+	//Sizes are 32-bit, files over 4GB get truncated sizes
+	uint32 dataSize = static_cast<uint32>(std::min<uint64>(m_dataSize, UINT32_MAX - HEADER_SIZE));
+	m_stream->Seek(RIFF_SIZE_OFFSET, Framework::STREAM_SEEK_SET);
+	m_stream->Write32(dataSize + HEADER_SIZE - 8);
+	m_stream->Seek(DATA_SIZE_OFFSET, Framework::STREAM_SEEK_SET);
+	m_stream->Write32(dataSize);
+	m_stream->Seek(0, Framework::STREAM_SEEK_END);
+}
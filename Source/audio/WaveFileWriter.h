@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include "Stream.h"
+#include "Types.h"
+#include "AudioFileWriter.h"
+
+//Writes 16-bit PCM samples to a RIFF WAVE stream. Sizes in the header are fixed up when the writer is destroyed.
+class CWaveFileWriter : public CAudioFileWriter
+{
+public:
+	typedef std::unique_ptr<Framework::CStream> StreamPtr;
+
+	CWaveFileWriter(StreamPtr, uint32, uint16);
+	virtual ~CWaveFileWriter();
+
+	CWaveFileWriter(const CWaveFileWriter&) = delete;
+	CWaveFileWriter& operator=(const CWaveFileWriter&) = delete;
+
+	void Write(const int16*, unsigned int) override;
+
+	uint32 GetSampleRate() const;
+	uint64 GetFrameCount() const;
+
+private:
+	enum
+	{
+		HEADER_SIZE = 44,
+		RIFF_SIZE_OFFSET = 4,
+		DATA_SIZE_OFFSET = 40,
+	};
+
+	void WriteHeader();
+	void UpdateSizes();
+
+	StreamPtr m_stream;
+	uint32 m_sampleRate = 0;
+	uint16 m_channelCount = 0;
+	uint64 m_dataSize = 0;
+};
@@ -1,16 +1,19 @@
 #include "ChdImageStream.h"
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <cassert>
 #include <stdexcept>
 #include "maybe_unused.h"
 #include <libchdr/chd.h>
 #include "ChdStreamSupport.h"
+#include "ThreadUtils.h"
 
 //Should probably take a shared_ptr instead of raw
 CChdImageStream::CChdImageStream(std::unique_ptr<Framework::CStream> baseStream)
     : m_baseStream(std::move(baseStream))
 {
-	m_file = ChdStreamSupport::CreateFileFromStream(m_baseStream.get());
+	m_file = ChdStreamSupport::CreateFileFromStream(m_baseStream.get(), m_baseStreamMutex);
 	chd_error result = chd_open_core_file(m_file, CHD_OPEN_READ, nullptr, &m_chd);
 	if(result != CHDERR_NONE)
 	{
@@ -20,11 +23,14 @@ CChdImageStream::CChdImageStream(std::unique_ptr<Framework::CStream> baseStream)
 	m_unitCount = header->unitcount;
 	m_unitSize = header->unitbytes;
 	m_hunkSize = header->hunkbytes;
-	m_hunkBuffer.resize(m_hunkSize);
+	m_hunkCount = header->hunkcount;
+	SetReadAheadHunkCount(std::max<uint32>(DEFAULT_READ_AHEAD_SIZE / m_hunkSize, 1));
+	SetCacheSize(DEFAULT_CACHE_SIZE_MB);
 }
 
 CChdImageStream::~CChdImageStream()
 {
+	StopWorkers();
 	chd_close(m_chd);
 }
 
@@ -33,6 +39,28 @@ uint32 CChdImageStream::GetUnitSize() const
 	return m_unitSize;
 }
 
+void CChdImageStream::SetCacheSize(uint32 megabytes)
+{
+	std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+	uint64 cacheSize = static_cast<uint64>(megabytes) * 0x100000;
+	//Always keep enough room for the hunks being read ahead and the one being read
+	m_maxCachedHunkCount = std::max<uint32>(static_cast<uint32>(cacheSize / m_hunkSize), m_readAheadHunkCount + 2);
+	EvictHunks();
+}
+
+void CChdImageStream::SetReadAheadHunkCount(uint32 readAheadHunkCount)
+{
+	std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+	m_readAheadHunkCount = readAheadHunkCount;
+	m_maxCachedHunkCount = std::max<uint32>(m_maxCachedHunkCount, m_readAheadHunkCount + 2);
+}
+
+CChdImageStream::CACHE_STATS CChdImageStream::GetCacheStats()
+{
+	std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+	return m_stats;
+}
+
 void CChdImageStream::Seek(int64 position, Framework::STREAM_SEEK_DIRECTION origin)
 {
 	switch(origin)
@@ -61,17 +89,22 @@ bool CChdImageStream::IsEOF()
 
 uint64 CChdImageStream::Read(void* buffer, uint64 size)
 {
-	uint32 hunkPosition = m_position % m_hunkSize;
-	assert((hunkPosition + size) <= m_hunkSize);
-	uint32 hunkIdx = m_position / m_hunkSize;
-	if(hunkIdx != m_hunkBufferIdx)
+	uint64 totalSize = GetTotalSize();
+	if(m_position >= totalSize) return 0;
+	size = std::min<uint64>(size, totalSize - m_position);
+
+	auto dest = reinterpret_cast<uint8*>(buffer);
+	uint64 remaining = size;
+	while(remaining != 0)
 	{
-		FRAMEWORK_MAYBE_UNUSED chd_error error = chd_read(m_chd, hunkIdx, m_hunkBuffer.data());
-		assert(error == CHDERR_NONE);
-		m_hunkBufferIdx = hunkIdx;
+		uint32 hunkIdx = static_cast<uint32>(m_position / m_hunkSize);
+		uint32 hunkPosition = static_cast<uint32>(m_position % m_hunkSize);
+		uint32 sizeToRead = static_cast<uint32>(std::min<uint64>(remaining, m_hunkSize - hunkPosition));
+		ReadFromHunk(hunkIdx, hunkPosition, dest, sizeToRead);
+		m_position += sizeToRead;
+		dest += sizeToRead;
+		remaining -= sizeToRead;
 	}
-	memcpy(buffer, m_hunkBuffer.data() + hunkPosition, size);
-	m_position += size;
 	return size;
 }
 
@@ -84,3 +117,181 @@ uint64 CChdImageStream::GetTotalSize() const
 {
 	return m_unitCount * static_cast<uint64>(m_unitSize);
 }
+
+void CChdImageStream::ReadFromHunk(uint32 hunkIdx, uint32 hunkPosition, uint8* dest, uint32 size)
+{
+	std::unique_lock<std::mutex> cacheLock(m_cacheMutex);
+
+	bool sequential = (hunkIdx == m_lastHunkIdx) || (hunkIdx == (m_lastHunkIdx + 1));
+	m_lastHunkIdx = hunkIdx;
+
+	auto hunkIterator = m_hunkMap.find(hunkIdx);
+	if(hunkIterator != std::end(m_hunkMap))
+	{
+		//Only we remove hunks from the cache and pending ones are never removed, iterator stays valid while we wait
+		auto hunk = hunkIterator->second;
+		m_hunks.splice(std::begin(m_hunks), m_hunks, hunk);
+		m_hunkReadyCondition.wait(cacheLock, [hunk]() { return hunk->state != HUNK_STATE_PENDING; });
+		if(hunk->state == HUNK_STATE_READY)
+		{
+			m_stats.hitCount++;
+			if(hunk->readAhead)
+			{
+				m_stats.readAheadHitCount++;
+				hunk->readAhead = false;
+			}
+			memcpy(dest, hunk->data.data() + hunkPosition, size);
+			if(sequential)
+			{
+				ScheduleReadAhead(hunkIdx);
+			}
+			return;
+		}
+		//Worker failed to decompress it, try again here
+		m_hunks.erase(hunk);
+		m_hunkMap.erase(hunkIdx);
+	}
+
+	m_stats.missCount++;
+	cacheLock.unlock();
+
+	std::vector<uint8> data;
+	FRAMEWORK_MAYBE_UNUSED bool decompressed = DecompressHunk(m_chd, hunkIdx, data);
+	assert(decompressed);
+	memcpy(dest, data.data() + hunkPosition, size);
+
+	cacheLock.lock();
+
+	HUNK hunk;
+	hunk.index = hunkIdx;
+	hunk.state = HUNK_STATE_READY;
+	hunk.data = std::move(data);
+	m_hunks.push_front(std::move(hunk));
+	m_hunkMap[hunkIdx] = std::begin(m_hunks);
+
+	if(sequential)
+	{
+		ScheduleReadAhead(hunkIdx);
+	}
+	EvictHunks();
+}
+
+bool CChdImageStream::DecompressHunk(chd_file* chd, uint32 hunkIdx, std::vector<uint8>& data)
+{
+	data.resize(m_hunkSize);
+	auto startTime = std::chrono::steady_clock::now();
+	chd_error error = chd_read(chd, hunkIdx, data.data());
+	auto decompressionTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime);
+	{
+		std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+		m_stats.decompressedHunkCount++;
+		m_stats.decompressionTimeUs += decompressionTime.count();
+	}
+	return (error == CHDERR_NONE);
+}
+
+void CChdImageStream::ScheduleReadAhead(uint32 hunkIdx)
+{
+	bool requested = false;
+	for(uint32 i = 1; i <= m_readAheadHunkCount; i++)
+	{
+		uint32 readAheadHunkIdx = hunkIdx + i;
+		if(readAheadHunkIdx >= m_hunkCount) break;
+		if(m_hunkMap.find(readAheadHunkIdx) != std::end(m_hunkMap)) continue;
+
+		HUNK hunk;
+		hunk.index = readAheadHunkIdx;
+		hunk.state = HUNK_STATE_PENDING;
+		hunk.readAhead = true;
+		m_hunks.push_front(std::move(hunk));
+		m_hunkMap[readAheadHunkIdx] = std::begin(m_hunks);
+		m_requests.push_back(readAheadHunkIdx);
+		requested = true;
+	}
+	if(!requested) return;
+	if(m_workers.empty())
+	{
+		StartWorkers();
+	}
+	m_requestCondition.notify_all();
+	EvictHunks();
+}
+
+void CChdImageStream::EvictHunks()
+{
+	auto hunkIterator = std::end(m_hunks);
+	while((m_hunks.size() > m_maxCachedHunkCount) && (hunkIterator != std::begin(m_hunks)))
+	{
+		hunkIterator--;
+		if(hunkIterator->state == HUNK_STATE_PENDING) continue;
+		m_hunkMap.erase(hunkIterator->index);
+		hunkIterator = m_hunks.erase(hunkIterator);
+	}
+}
+
+void CChdImageStream::StartWorkers()
+{
+	//Each worker opens its own CHD handle, decompression state can't be shared between threads
+	uint32 workerCount = std::clamp<uint32>(std::thread::hardware_concurrency() / 2, 1, MAX_WORKER_COUNT);
+	for(uint32 i = 0; i < workerCount; i++)
+	{
+		m_workers.emplace_back([this]() { WorkerProc(); });
+		Framework::ThreadUtils::SetThreadName(m_workers.back(), "CHD Decompression Thread");
+	}
+}
+
+void CChdImageStream::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+		m_workersDone = true;
+	}
+	m_requestCondition.notify_all();
+	for(auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+void CChdImageStream::WorkerProc()
+{
+	chd_file* chd = nullptr;
+	auto file = ChdStreamSupport::CreateFileFromStream(m_baseStream.get(), m_baseStreamMutex);
+	if(chd_open_core_file(file, CHD_OPEN_READ, nullptr, &chd) != CHDERR_NONE)
+	{
+		//Keep going, hunks we're given will be marked as failed and decompressed by the reader
+		chd = nullptr;
+	}
+
+	while(1)
+	{
+		uint32 hunkIdx = 0;
+		{
+			std::unique_lock<std::mutex> cacheLock(m_cacheMutex);
+			m_requestCondition.wait(cacheLock, [this]() { return m_workersDone || !m_requests.empty(); });
+			if(m_workersDone) break;
+			hunkIdx = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		std::vector<uint8> data;
+		bool succeeded = chd && DecompressHunk(chd, hunkIdx, data);
+
+		{
+			std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+			auto hunkIterator = m_hunkMap.find(hunkIdx);
+			assert(hunkIterator != std::end(m_hunkMap));
+			auto hunk = hunkIterator->second;
+			assert(hunk->state == HUNK_STATE_PENDING);
+			hunk->state = succeeded ? HUNK_STATE_READY : HUNK_STATE_FAILED;
+			hunk->data = std::move(data);
+		}
+		m_hunkReadyCondition.notify_all();
+	}
+
+	if(chd)
+	{
+		chd_close(chd);
+	}
+}
@@ -1,20 +1,49 @@
 #pragma once
 
 #include "Stream.h"
-#include <vector>
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 typedef struct _chd_file chd_file;
 typedef struct chd_core_file core_file;
 
+//Decompressed hunks are kept in a LRU cache. When reading sequentially, worker threads
+//(each with its own CHD handle on the base stream) decompress the next hunks ahead of time.
 class CChdImageStream : public Framework::CStream
 {
 public:
+	struct CACHE_STATS
+	{
+		uint64 hitCount = 0;
+		uint64 missCount = 0;
+		//Hits on hunks that were requested by read ahead (included in hitCount)
+		uint64 readAheadHitCount = 0;
+		uint64 decompressedHunkCount = 0;
+		uint64 decompressionTimeUs = 0;
+	};
+
+	enum
+	{
+		DEFAULT_CACHE_SIZE_MB = 16,
+		DEFAULT_READ_AHEAD_SIZE = 0x40000,
+		MAX_WORKER_COUNT = 4,
+	};
+
 	CChdImageStream(std::unique_ptr<Framework::CStream> baseStream);
 	virtual ~CChdImageStream();
 
 	uint32 GetUnitSize() const;
 
+	void SetCacheSize(uint32);
+	void SetReadAheadHunkCount(uint32);
+	CACHE_STATS GetCacheStats();
+
 	virtual void Seek(int64 pos, Framework::STREAM_SEEK_DIRECTION whence) override;
 	virtual uint64 Tell() override;
 	virtual bool IsEOF() override;
@@ -25,12 +54,53 @@ protected:
 	uint64 GetTotalSize() const;
 
 	std::unique_ptr<Framework::CStream> m_baseStream;
+	std::mutex m_baseStreamMutex;
 	core_file* m_file = nullptr;
 	chd_file* m_chd = nullptr;
 	uint64 m_unitCount = 0;
 	uint32 m_unitSize = 0;
 	uint32 m_hunkSize = 0;
+	uint32 m_hunkCount = 0;
 	uint64 m_position = 0;
-	std::vector<uint8> m_hunkBuffer;
-	uint32 m_hunkBufferIdx = ~0U;
+
+private:
+	enum HUNK_STATE
+	{
+		HUNK_STATE_PENDING,
+		HUNK_STATE_READY,
+		HUNK_STATE_FAILED,
+	};
+
+	struct HUNK
+	{
+		uint32 index = 0;
+		HUNK_STATE state = HUNK_STATE_PENDING;
+		bool readAhead = false;
+		std::vector<uint8> data;
+	};
+
+	//Most recently used hunks are at the front
+	typedef std::list<HUNK> HunkList;
+
+	void ReadFromHunk(uint32, uint32, uint8*, uint32);
+	bool DecompressHunk(chd_file*, uint32, std::vector<uint8>&);
+	void ScheduleReadAhead(uint32);
+	void EvictHunks();
+	void StartWorkers();
+	void StopWorkers();
+	void WorkerProc();
+
+	std::mutex m_cacheMutex;
+	std::condition_variable m_requestCondition;
+	std::condition_variable m_hunkReadyCondition;
+	HunkList m_hunks;
+	std::unordered_map<uint32, HunkList::iterator> m_hunkMap;
+	std::deque<uint32> m_requests;
+	uint32 m_maxCachedHunkCount = 0;
+	uint32 m_readAheadHunkCount = 0;
+	uint32 m_lastHunkIdx = ~0U;
+	CACHE_STATS m_stats;
+
+	std::vector<std::thread> m_workers;
+	bool m_workersDone = false;
 };
@@ -3,39 +3,66 @@
 #include <libchdr/chd.h>
 #include "Stream.h"
 
+struct STREAM_FILE
+{
+	Framework::CStream* stream = nullptr;
+	std::mutex* streamMutex = nullptr;
+	uint64 position = 0;
+};
+
 static size_t stream_core_fread(void* buffer, size_t elemSize, size_t elemCount, core_file* file)
 {
 	assert(elemSize == 1);
-	auto stream = reinterpret_cast<Framework::CStream*>(file->argp);
-	return stream->Read(buffer, elemSize * elemCount);
+	auto streamFile = reinterpret_cast<STREAM_FILE*>(file->argp);
+	std::lock_guard<std::mutex> streamLock(*streamFile->streamMutex);
+	streamFile->stream->Seek(streamFile->position, Framework::STREAM_SEEK_SET);
+	auto result = streamFile->stream->Read(buffer, elemSize * elemCount);
+	streamFile->position += result;
+	return result;
 }
 
 static int stream_core_fseek(core_file* file, INT64 position, int whence)
 {
-	auto stream = reinterpret_cast<Framework::CStream*>(file->argp);
-	stream->Seek(position, static_cast<Framework::STREAM_SEEK_DIRECTION>(whence));
+	auto streamFile = reinterpret_cast<STREAM_FILE*>(file->argp);
+	switch(static_cast<Framework::STREAM_SEEK_DIRECTION>(whence))
+	{
+	case Framework::STREAM_SEEK_SET:
+		streamFile->position = position;
+		break;
+	case Framework::STREAM_SEEK_CUR:
+		streamFile->position += position;
+		break;
+	case Framework::STREAM_SEEK_END:
+	{
+		std::lock_guard<std::mutex> streamLock(*streamFile->streamMutex);
+		streamFile->position = streamFile->stream->GetLength() + position;
+	}
+	break;
+	}
 	return 0;
 }
 
 static UINT64 stream_core_fsize(core_file* file)
 {
-	auto stream = reinterpret_cast<Framework::CStream*>(file->argp);
-	auto currPos = stream->Tell();
-	auto size = stream->GetLength();
-	stream->Seek(currPos, Framework::STREAM_SEEK_SET);
-	return size;
+	auto streamFile = reinterpret_cast<STREAM_FILE*>(file->argp);
+	std::lock_guard<std::mutex> streamLock(*streamFile->streamMutex);
+	return streamFile->stream->GetLength();
 }
 
 static int stream_core_fclose(core_file* file)
 {
+	delete reinterpret_cast<STREAM_FILE*>(file->argp);
 	delete file;
 	return 0;
 }
 
-core_file* ChdStreamSupport::CreateFileFromStream(Framework::CStream* stream)
+core_file* ChdStreamSupport::CreateFileFromStream(Framework::CStream* stream, std::mutex& streamMutex)
 {
+	auto streamFile = new STREAM_FILE;
+	streamFile->stream = stream;
+	streamFile->streamMutex = &streamMutex;
 	auto file = new core_file;
-	file->argp = stream;
+	file->argp = streamFile;
 	file->fread = &stream_core_fread;
 	file->fseek = &stream_core_fseek;
 	file->fsize = &stream_core_fsize;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 namespace Framework
 {
 	class CStream;
@@ -8,5 +10,7 @@ typedef struct chd_core_file core_file;
 
 namespace ChdStreamSupport
 {
-	core_file* CreateFileFromStream(Framework::CStream*);
+	//Many files can be created on the same stream, each one keeps its own position
+	//and accesses to the stream are serialized with the mutex
+	core_file* CreateFileFromStream(Framework::CStream*, std::mutex&);
 }
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include "CsoImageStream.h"
 #include "zstd_zlibwrapper.h"
+#include "ThreadUtils.h"
 
 typedef uint32 uint32_le;
 typedef uint64 uint64_le;
@@ -23,9 +24,11 @@ struct CsoHeader
 
 CCsoImageStream::CCsoImageStream(std::unique_ptr<CStream> baseStream)
     : m_baseStream(std::move(baseStream))
+    , m_readBufferSize(0)
     , m_readBuffer(nullptr)
     , m_zlibBuffer(nullptr)
     , m_index(nullptr)
+    , m_frameCount(0)
     , m_position(0)
 {
 	if(!m_baseStream)
@@ -35,10 +38,12 @@ CCsoImageStream::CCsoImageStream(std::unique_ptr<CStream> baseStream)
 
 	ReadFileHeader();
 	InitializeBuffers();
+	SetReadAheadFrameCount(std::max<uint32>(DEFAULT_READ_AHEAD_SIZE / m_frameSize, 1));
 }
 
 CCsoImageStream::~CCsoImageStream()
 {
+	StopReadAheadThread();
 	delete[] m_readBuffer;
 	delete[] m_zlibBuffer;
 	delete[] m_index;
@@ -89,16 +94,10 @@ void CCsoImageStream::InitializeBuffers()
 	uint32 numFrames = static_cast<uint32>((m_totalSize + m_frameSize - 1) / m_frameSize);
 
 	// We might read a bit of alignment too, so be prepared.
-	if(m_frameSize + (1 << m_indexShift) < CSO_READ_BUFFER_SIZE)
-	{
-		m_readBuffer = new uint8[CSO_READ_BUFFER_SIZE];
-	}
-	else
-	{
-		m_readBuffer = new uint8[m_frameSize + (1 << m_indexShift)];
-	}
+	m_readBufferSize = std::max<uint32>(m_frameSize + (1 << m_indexShift), CSO_READ_BUFFER_SIZE);
+	m_readBuffer = new uint8[m_readBufferSize];
 	m_zlibBuffer = new uint8[m_frameSize + (1 << m_indexShift)];
-	m_zlibBufferFrame = numFrames;
+	m_frameCount = numFrames;
 
 	const uint32 indexSize = numFrames + 1;
 	m_index = new uint32[indexSize];
@@ -108,6 +107,21 @@ void CCsoImageStream::InitializeBuffers()
 	}
 }
 
+void CCsoImageStream::SetFrameCacheSize(uint32 frameCount)
+{
+	std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+	//Always keep enough room for the frames being read ahead and the one being read
+	m_maxCachedFrameCount = std::max<uint32>(frameCount, m_readAheadFrameCount + 2);
+	EvictFrames();
+}
+
+void CCsoImageStream::SetReadAheadFrameCount(uint32 frameCount)
+{
+	std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+	m_readAheadFrameCount = frameCount;
+	m_maxCachedFrameCount = std::max<uint32>(m_maxCachedFrameCount, m_readAheadFrameCount + 2);
+}
+
 void CCsoImageStream::Seek(int64 position, Framework::STREAM_SEEK_DIRECTION origin)
 {
 	switch(origin)
@@ -168,7 +182,7 @@ uint32 CCsoImageStream::ReadFromNextFrame(uint8* dest, uint64 maxBytes)
 	const uint32 frame = static_cast<uint32>(m_position >> m_frameShift);
 	const uint32 offset = static_cast<uint32>(m_position - (frame << m_frameShift));
 	// This is how many bytes we will actually be reading from this frame.
-	const uint32 bytes = static_cast<uint32>(std::min(maxBytes, static_cast<uint64>(m_frameSize - offset)));
+	const uint32 bytes = static_cast<uint32>(std::min({maxBytes, static_cast<uint64>(m_frameSize - offset), GetTotalSize() - m_position}));
 
 	// Grab the index data for the frame we're about to read.
 	const bool compressed = (m_index[frame + 0] & 0x80000000) == 0;
@@ -177,7 +191,40 @@ uint32 CCsoImageStream::ReadFromNextFrame(uint8* dest, uint64 maxBytes)
 
 	// Calculate where the compressed payload is (if compressed.)
 	const uint64 frameRawPos = static_cast<uint64>(index0) << m_indexShift;
-	const uint64 frameRawSize = (index1 - index0) << m_indexShift;
+	const uint64 frameRawSize = static_cast<uint64>(index1 - index0) << m_indexShift;
+
+	{
+		std::unique_lock<std::mutex> cacheLock(m_cacheMutex);
+
+		bool sequential = (frame == m_lastFrame) || (frame == (m_lastFrame + 1));
+		m_lastFrame = frame;
+
+		auto frameIterator = m_frameMap.find(frame);
+		if(frameIterator != std::end(m_frameMap))
+		{
+			//Only we remove frames from the cache and pending ones are never removed, iterator stays valid while we wait
+			auto cachedFrame = frameIterator->second;
+			m_frames.splice(std::begin(m_frames), m_frames, cachedFrame);
+			m_frameReadyCondition.wait(cacheLock, [cachedFrame]() { return cachedFrame->state != FRAME_STATE_PENDING; });
+			if(cachedFrame->state == FRAME_STATE_READY)
+			{
+				memcpy(dest, cachedFrame->data.data() + offset, bytes);
+				if(sequential)
+				{
+					ScheduleReadAhead(frame);
+				}
+				return bytes;
+			}
+			//Read ahead failed, try again here
+			m_frames.erase(cachedFrame);
+			m_frameMap.erase(frame);
+		}
+
+		if(sequential)
+		{
+			ScheduleReadAhead(frame);
+		}
+	}
 
 	if(!compressed)
 	{
@@ -189,23 +236,18 @@ uint32 CCsoImageStream::ReadFromNextFrame(uint8* dest, uint64 maxBytes)
 	}
 	else
 	{
-		// We don't need to decompress if we already did this same frame last time.
-		if(m_zlibBufferFrame != frame)
-		{
-			// This might be less bytes than frameRawSize in case of padding on the last frame.
-			// This is because the index positions must be aligned.
-			const uint64 readRawBytes = ReadBaseAt(frameRawPos, m_readBuffer, frameRawSize);
-			DecompressFrame(frame, readRawBytes);
-		}
-
-		// Now we just copy the offset data from the cache.
+		// This might be less bytes than frameRawSize in case of padding on the last frame.
+		// This is because the index positions must be aligned.
+		const uint64 readRawBytes = ReadBaseAt(frameRawPos, m_readBuffer, frameRawSize);
+		DecompressFrame(m_readBuffer, readRawBytes, m_zlibBuffer);
 		memcpy(dest, m_zlibBuffer + offset, bytes);
+		CacheFrame(frame, m_zlibBuffer);
 	}
 
 	return bytes;
 }
 
-void CCsoImageStream::DecompressFrame(uint32 frame, uint64 readBufferSize)
+void CCsoImageStream::DecompressFrame(const uint8* src, uint64 srcSize, uint8* dest)
 {
 	z_stream z;
 	z.zalloc = Z_NULL;
@@ -216,9 +258,9 @@ void CCsoImageStream::DecompressFrame(uint32 frame, uint64 readBufferSize)
 		throw std::runtime_error("Unable to initialize zlib for CSO decompression.");
 	}
 
-	z.next_in = m_readBuffer;
-	z.avail_in = static_cast<uint32>(readBufferSize);
-	z.next_out = m_zlibBuffer;
+	z.next_in = const_cast<uint8*>(src);
+	z.avail_in = static_cast<uint32>(srcSize);
+	z.next_out = dest;
 	z.avail_out = m_frameSize;
 
 	int status = inflate(&z, Z_FINISH);
@@ -228,13 +270,174 @@ void CCsoImageStream::DecompressFrame(uint32 frame, uint64 readBufferSize)
 		throw std::runtime_error("Unable to decompress CSO frame using zlib.");
 	}
 	inflateEnd(&z);
-
-	// Our buffer now contains this frame.
-	m_zlibBufferFrame = frame;
 }
 
 uint64 CCsoImageStream::ReadBaseAt(uint64 pos, uint8* dest, uint64 bytes)
 {
+	std::lock_guard<std::mutex> baseStreamLock(m_baseStreamMutex);
 	m_baseStream->Seek(pos, Framework::STREAM_SEEK_SET);
 	return m_baseStream->Read(dest, bytes);
 }
+
+uint64 CCsoImageStream::GetFrameRawPosition(uint32 frame) const
+{
+	return static_cast<uint64>(m_index[frame] & 0x7FFFFFFF) << m_indexShift;
+}
+
+void CCsoImageStream::CacheFrame(uint32 frame, const uint8* data)
+{
+	std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+	assert(m_frameMap.find(frame) == std::end(m_frameMap));
+
+	FRAME cachedFrame;
+	cachedFrame.index = frame;
+	cachedFrame.state = FRAME_STATE_READY;
+	cachedFrame.data.assign(data, data + m_frameSize);
+	m_frames.push_front(std::move(cachedFrame));
+	m_frameMap[frame] = std::begin(m_frames);
+	EvictFrames();
+}
+
+void CCsoImageStream::ScheduleReadAhead(uint32 frame)
+{
+	//Skip what's already there or coming
+	uint32 endFrame = std::min<uint32>(frame + 1 + m_readAheadFrameCount, m_frameCount);
+	uint32 firstFrame = frame + 1;
+	while((firstFrame < endFrame) && (m_frameMap.find(firstFrame) != std::end(m_frameMap)))
+	{
+		firstFrame++;
+	}
+	if(firstFrame >= endFrame) return;
+
+	//Wait until we're half way through what was read ahead to get bigger batches
+	if((firstFrame - (frame + 1)) > (m_readAheadFrameCount / 2)) return;
+
+	//Frames are stored one after the other, read as many as we can fit in one go
+	uint32 frameCount = 1;
+	while(
+	    ((firstFrame + frameCount) < endFrame) &&
+	    (m_frameMap.find(firstFrame + frameCount) == std::end(m_frameMap)) &&
+	    ((GetFrameRawPosition(firstFrame + frameCount + 1) - GetFrameRawPosition(firstFrame)) <= m_readBufferSize))
+	{
+		frameCount++;
+	}
+
+	for(uint32 i = 0; i < frameCount; i++)
+	{
+		FRAME pendingFrame;
+		pendingFrame.index = firstFrame + i;
+		pendingFrame.state = FRAME_STATE_PENDING;
+		m_frames.push_front(std::move(pendingFrame));
+		m_frameMap[firstFrame + i] = std::begin(m_frames);
+	}
+
+	READ_AHEAD_REQUEST request;
+	request.firstFrame = firstFrame;
+	request.frameCount = frameCount;
+	m_requests.push_back(request);
+
+	if(!m_readAheadThread.joinable())
+	{
+		m_readAheadThread = std::thread([this]() { ReadAheadThreadProc(); });
+		Framework::ThreadUtils::SetThreadName(m_readAheadThread, "CSO Read Ahead Thread");
+	}
+	m_requestCondition.notify_one();
+	EvictFrames();
+}
+
+void CCsoImageStream::EvictFrames()
+{
+	auto frameIterator = std::end(m_frames);
+	while((m_frames.size() > m_maxCachedFrameCount) && (frameIterator != std::begin(m_frames)))
+	{
+		frameIterator--;
+		if(frameIterator->state == FRAME_STATE_PENDING) continue;
+		m_frameMap.erase(frameIterator->index);
+		frameIterator = m_frames.erase(frameIterator);
+	}
+}
+
+void CCsoImageStream::StopReadAheadThread()
+{
+	{
+		std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+		m_readAheadThreadDone = true;
+	}
+	m_requestCondition.notify_one();
+	if(m_readAheadThread.joinable())
+	{
+		m_readAheadThread.join();
+	}
+}
+
+void CCsoImageStream::ReadAheadThreadProc()
+{
+	std::vector<uint8> readBuffer(m_readBufferSize);
+
+	while(1)
+	{
+		READ_AHEAD_REQUEST request;
+		{
+			std::unique_lock<std::mutex> cacheLock(m_cacheMutex);
+			m_requestCondition.wait(cacheLock, [this]() { return m_readAheadThreadDone || !m_requests.empty(); });
+			if(m_readAheadThreadDone) break;
+			request = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		uint64 batchRawPos = GetFrameRawPosition(request.firstFrame);
+		uint64 batchRawSize = GetFrameRawPosition(request.firstFrame + request.frameCount) - batchRawPos;
+		uint64 readRawBytes = 0;
+		try
+		{
+			readRawBytes = ReadBaseAt(batchRawPos, readBuffer.data(), std::min<uint64>(batchRawSize, readBuffer.size()));
+		}
+		catch(...)
+		{
+		}
+
+		std::vector<std::vector<uint8>> frameData(request.frameCount);
+		for(uint32 i = 0; i < request.frameCount; i++)
+		{
+			uint32 frame = request.firstFrame + i;
+			uint64 frameRawOffset = GetFrameRawPosition(frame) - batchRawPos;
+			uint64 frameRawSize = GetFrameRawPosition(frame + 1) - GetFrameRawPosition(frame);
+			if(frameRawOffset >= readRawBytes) continue;
+			// Last frame might be smaller because of padding.
+			frameRawSize = std::min<uint64>(frameRawSize, readRawBytes - frameRawOffset);
+
+			auto& data = frameData[i];
+			data.resize(m_frameSize);
+			try
+			{
+				const bool compressed = (m_index[frame] & 0x80000000) == 0;
+				if(compressed)
+				{
+					DecompressFrame(readBuffer.data() + frameRawOffset, frameRawSize, data.data());
+				}
+				else
+				{
+					memcpy(data.data(), readBuffer.data() + frameRawOffset, std::min<uint64>(frameRawSize, m_frameSize));
+				}
+			}
+			catch(...)
+			{
+				data.clear();
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+			for(uint32 i = 0; i < request.frameCount; i++)
+			{
+				auto frameIterator = m_frameMap.find(request.firstFrame + i);
+				assert(frameIterator != std::end(m_frameMap));
+				auto cachedFrame = frameIterator->second;
+				assert(cachedFrame->state == FRAME_STATE_PENDING);
+				cachedFrame->state = frameData[i].empty() ? FRAME_STATE_FAILED : FRAME_STATE_READY;
+				cachedFrame->data = std::move(frameData[i]);
+			}
+		}
+		m_frameReadyCondition.notify_all();
+	}
+}
@@ -1,15 +1,33 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include "Types.h"
 #include "Stream.h"
 
+//Decompressed frames are kept in a LRU cache. When reading sequentially, the following frames
+//are read in batches and decompressed on a worker thread ahead of time.
 class CCsoImageStream : public Framework::CStream
 {
 public:
+	enum
+	{
+		DEFAULT_FRAME_CACHE_SIZE = 256,
+		DEFAULT_READ_AHEAD_SIZE = 0x40000,
+	};
+
 	CCsoImageStream(std::unique_ptr<Framework::CStream> baseStream);
 	virtual ~CCsoImageStream();
 
+	void SetFrameCacheSize(uint32);
+	void SetReadAheadFrameCount(uint32);
+
 	virtual void Seek(int64 pos, Framework::STREAM_SEEK_DIRECTION whence) override;
 	virtual uint64 Tell() override;
 	virtual bool IsEOF() override;
@@ -17,21 +35,66 @@ public:
 	virtual uint64 Write(const void* src, uint64 bytes) override;
 
 private:
+	enum FRAME_STATE
+	{
+		FRAME_STATE_PENDING,
+		FRAME_STATE_READY,
+		FRAME_STATE_FAILED,
+	};
+
+	struct FRAME
+	{
+		uint32 index = 0;
+		FRAME_STATE state = FRAME_STATE_PENDING;
+		std::vector<uint8> data;
+	};
+
+	struct READ_AHEAD_REQUEST
+	{
+		uint32 firstFrame = 0;
+		uint32 frameCount = 0;
+	};
+
+	//Most recently used frames are at the front
+	typedef std::list<FRAME> FrameList;
+
 	void ReadFileHeader();
 	void InitializeBuffers();
 	uint64 GetTotalSize() const;
 	uint32 ReadFromNextFrame(uint8* dest, uint64 maxBytes);
 	uint64 ReadBaseAt(uint64 pos, uint8* dest, uint64 bytes);
-	void DecompressFrame(uint32 frame, uint64 readBufferSize);
+	void DecompressFrame(const uint8* src, uint64 srcSize, uint8* dest);
+	uint64 GetFrameRawPosition(uint32) const;
+
+	void CacheFrame(uint32, const uint8*);
+	void ScheduleReadAhead(uint32);
+	void EvictFrames();
+	void StopReadAheadThread();
+	void ReadAheadThreadProc();
 
 	std::unique_ptr<Framework::CStream> m_baseStream;
+	std::mutex m_baseStreamMutex;
 	uint32 m_frameSize;
 	uint8 m_frameShift;
 	uint8 m_indexShift;
+	uint32 m_readBufferSize;
 	uint8* m_readBuffer;
 	uint8* m_zlibBuffer;
-	uint32 m_zlibBufferFrame;
 	uint32* m_index;
+	uint32 m_frameCount;
 	uint64 m_totalSize;
 	uint64 m_position;
+
+	std::mutex m_cacheMutex;
+	std::condition_variable m_requestCondition;
+	std::condition_variable m_frameReadyCondition;
+	FrameList m_frames;
+	std::unordered_map<uint32, FrameList::iterator> m_frameMap;
+	std::deque<READ_AHEAD_REQUEST> m_requests;
+	uint32 m_maxCachedFrameCount = DEFAULT_FRAME_CACHE_SIZE;
+	uint32 m_readAheadFrameCount = 0;
+	uint32 m_lastFrame = ~0U;
+
+	std::thread m_readAheadThread;
+	bool m_readAheadThreadDone = false;
 };
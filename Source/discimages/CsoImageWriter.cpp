@@ -0,0 +1,72 @@
+#include "CsoImageWriter.h"
+#include <stdexcept>
+#include <vector>
+#include "zstd_zlibwrapper.h"
+
+void WriteCsoImage(Framework::CStream& output, Framework::CStream& input, uint32 frameSize, uint8 indexShift)
+{
+	uint64 totalSize = input.GetLength();
+	uint32 frameCount = static_cast<uint32>((totalSize + frameSize - 1) / frameSize);
+	uint32 alignment = (1 << indexShift);
+
+	//Header, same layout as CsoHeader in CsoImageStream.cpp
+	output.Write("CISO", 4);
+	output.Write32(0x18);
+	output.Write64(totalSize);
+	output.Write32(frameSize);
+	output.Write8(1);
+	output.Write8(indexShift);
+	output.Write16(0);
+
+	std::vector<uint32> index(frameCount + 1);
+	uint64 indexPosition = output.Tell();
+	output.Write(index.data(), index.size() * sizeof(uint32));
+
+	std::vector<uint8> frame(frameSize);
+	std::vector<uint8> compressedFrame(compressBound(frameSize));
+	input.Seek(0, Framework::STREAM_SEEK_SET);
+	for(uint32 i = 0; i < frameCount; i++)
+	{
+		//Frames need to start on an aligned position
+		while(output.Tell() % alignment)
+		{
+			output.Write8(0);
+		}
+		index[i] = static_cast<uint32>(output.Tell() >> indexShift);
+
+		std::fill(frame.begin(), frame.end(), 0);
+		input.Read(frame.data(), frameSize);
+
+		z_stream z = {};
+		if(deflateInit2(&z, Z_BEST_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			throw std::runtime_error("Failed to initialize deflate.");
+		}
+		z.next_in = frame.data();
+		z.avail_in = frameSize;
+		z.next_out = compressedFrame.data();
+		z.avail_out = static_cast<uInt>(compressedFrame.size());
+		int result = deflate(&z, Z_FINISH);
+		uint32 compressedSize = static_cast<uint32>(z.total_out);
+		deflateEnd(&z);
+
+		if((result == Z_STREAM_END) && ((compressedSize + alignment) < frameSize))
+		{
+			output.Write(compressedFrame.data(), compressedSize);
+		}
+		else
+		{
+			index[i] |= 0x80000000;
+			output.Write(frame.data(), frameSize);
+		}
+	}
+	while(output.Tell() % alignment)
+	{
+		output.Write8(0);
+	}
+	index[frameCount] = static_cast<uint32>(output.Tell() >> indexShift);
+
+	output.Seek(indexPosition, Framework::STREAM_SEEK_SET);
+	output.Write(index.data(), index.size() * sizeof(uint32));
+	output.Seek(0, Framework::STREAM_SEEK_END);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "Types.h"
+#include "Stream.h"
+
+//Writes a CSOv1 image, frames that don't compress well are stored uncompressed
+void WriteCsoImage(Framework::CStream& output, Framework::CStream& input, uint32 frameSize = 0x800, uint8 indexShift = 0);
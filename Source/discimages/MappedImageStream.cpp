@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <fstream>
+#include <string>
+#include "MappedImageStream.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__APPLE__)
+#include <sys/mount.h>
+#elif defined(__linux__)
+#include <sys/sysmacros.h>
+#include <sys/vfs.h>
+#endif
+#endif
+
+#ifdef _WIN32
+
+static bool IsFixedStorageFile(const fs::path& path)
+{
+	auto rootPath = fs::absolute(path).root_path();
+	if(rootPath.native().compare(0, 2, L"\\\\") == 0)
+	{
+		//UNC path
+		return false;
+	}
+	//Excludes network shares, optical drives and removable drives (ex.: USB flash drives)
+	return GetDriveTypeW(rootPath.c_str()) == DRIVE_FIXED;
+}
+
+#else
+
+#if defined(__linux__)
+
+static bool IsFixedBlockDevice(dev_t device)
+{
+	if(major(device) == 0)
+	{
+		//Not backed by a single block device (ex.: tmpfs, btrfs)
+		return true;
+	}
+	std::error_code errorCode;
+	auto devicePath = fs::canonical(fs::path("/sys/dev/block") / (std::to_string(major(device)) + ":" + std::to_string(minor(device))), errorCode);
+	if(errorCode) return false;
+	//USB and SD card disks often don't report themselves as removable
+	const auto& devicePathString = devicePath.native();
+	if((devicePathString.find("/usb") != std::string::npos) || (devicePathString.find("/mmc") != std::string::npos))
+	{
+		return false;
+	}
+	auto diskPath = fs::exists(devicePath / "partition", errorCode) ? devicePath.parent_path() : devicePath;
+	std::ifstream removableStream(diskPath / "removable");
+	char removable = 0;
+	if(!removableStream.get(removable)) return false;
+	return removable == '0';
+}
+
+#endif
+
+static bool IsFixedStorageFile(int fd)
+{
+#if defined(__APPLE__)
+	struct statfs s;
+	if(fstatfs(fd, &s) != 0) return false;
+	if((s.f_flags & MNT_LOCAL) == 0) return false;
+#ifdef MNT_REMOVABLE
+	if((s.f_flags & MNT_REMOVABLE) != 0) return false;
+#endif
+	//External drives and disc images are mounted there
+	return strncmp(s.f_mntonname, "/Volumes/", 9) != 0;
+#elif defined(__linux__)
+	struct statfs s;
+	if(fstatfs(fd, &s) != 0) return false;
+	switch(static_cast<uint32>(s.f_type))
+	{
+	case 0x6969:     //NFS
+	case 0x517B:     //SMB
+	case 0xFF534D42: //CIFS
+	case 0xFE534D42: //SMB2
+	case 0x65735546: //FUSE (sshfs, etc.)
+	case 0x00C36400: //Ceph
+	case 0x01021997: //9P
+	case 0x9660:     //ISO9660
+	case 0x15013346: //UDF
+		return false;
+	default:
+		break;
+	}
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) != 0) return false;
+	return IsFixedBlockDevice(fileStat.st_dev);
+#else
+	return false;
+#endif
+}
+
+#endif
+
+CMappedImageStream::CMappedImageStream(const fs::path& path)
+{
+#ifdef _WIN32
+	if(!IsFixedStorageFile(path))
+	{
+		throw std::runtime_error("Image file is not on a local fixed drive.");
+	}
+	m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if(m_file == INVALID_HANDLE_VALUE)
+	{
+		m_file = nullptr;
+		throw std::runtime_error("Failed to open image file.");
+	}
+	try
+	{
+		LARGE_INTEGER fileSize = {};
+		if(!GetFileSizeEx(m_file, &fileSize) || (fileSize.QuadPart == 0))
+		{
+			throw std::runtime_error("Failed to get image file size.");
+		}
+		if(static_cast<uint64>(fileSize.QuadPart) > SIZE_MAX)
+		{
+			throw std::runtime_error("Image file is too big to be mapped.");
+		}
+		m_size = fileSize.QuadPart;
+		m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(!m_mapping)
+		{
+			throw std::runtime_error("Failed to create image file mapping.");
+		}
+		m_data = reinterpret_cast<const uint8*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if(!m_data)
+		{
+			throw std::runtime_error("Failed to map image file.");
+		}
+	}
+	catch(...)
+	{
+		if(m_mapping) CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		throw;
+	}
+	SYSTEM_INFO systemInfo = {};
+	GetSystemInfo(&systemInfo);
+	m_pageSize = systemInfo.dwPageSize;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		throw std::runtime_error("Failed to open image file.");
+	}
+	void* data = MAP_FAILED;
+	try
+	{
+		if(!IsFixedStorageFile(fd))
+		{
+			throw std::runtime_error("Image file is not on a local fixed drive.");
+		}
+		struct stat s;
+		if((fstat(fd, &s) != 0) || !S_ISREG(s.st_mode) || (s.st_size == 0))
+		{
+			throw std::runtime_error("Image file is not a regular file.");
+		}
+		if(static_cast<uint64>(s.st_size) > SIZE_MAX)
+		{
+			throw std::runtime_error("Image file is too big to be mapped.");
+		}
+		m_size = s.st_size;
+		data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+		if(data == MAP_FAILED)
+		{
+			throw std::runtime_error("Failed to map image file.");
+		}
+	}
+	catch(...)
+	{
+		close(fd);
+		throw;
+	}
+	//The mapping keeps a reference to the file
+	close(fd);
+	m_data = reinterpret_cast<const uint8*>(data);
+	m_pageSize = sysconf(_SC_PAGESIZE);
+#endif
+}
+
+CMappedImageStream::~CMappedImageStream()
+{
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_mapping);
+	CloseHandle(m_file);
+#else
+	munmap(const_cast<uint8*>(m_data), m_size);
+#endif
+}
+
+const uint8* CMappedImageStream::GetData() const
+{
+	return m_data;
+}
+
+uint64 CMappedImageStream::GetSize() const
+{
+	return m_size;
+}
+
+void CMappedImageStream::AdviseSequential(uint64 offset, uint64 size)
+{
+#ifndef _WIN32
+	if(offset >= m_size) return;
+	uint64 begin = offset & ~(m_pageSize - 1);
+	uint64 end = std::min(offset + size, m_size);
+	madvise(const_cast<uint8*>(m_data) + begin, end - begin, MADV_SEQUENTIAL);
+#endif
+}
+
+void CMappedImageStream::AdviseWillNeed(uint64 offset, uint64 size)
+{
+	//No equivalent on Windows, the cache manager already reads ahead of page faults
+#ifndef _WIN32
+	if(offset >= m_size) return;
+	uint64 begin = offset & ~(m_pageSize - 1);
+	uint64 end = std::min(offset + size, m_size);
+	madvise(const_cast<uint8*>(m_data) + begin, end - begin, MADV_WILLNEED);
+#endif
+}
+
+void CMappedImageStream::Seek(int64 position, Framework::STREAM_SEEK_DIRECTION origin)
+{
+	switch(origin)
+	{
+	case Framework::STREAM_SEEK_CUR:
+		m_position += position;
+		break;
+	case Framework::STREAM_SEEK_SET:
+		m_position = position;
+		break;
+	case Framework::STREAM_SEEK_END:
+		m_position = m_size + position;
+		break;
+	}
+}
+
+uint64 CMappedImageStream::Tell()
+{
+	return m_position;
+}
+
+uint64 CMappedImageStream::Read(void* buffer, uint64 size)
+{
+	if(m_position >= m_size) return 0;
+	size = std::min(size, m_size - m_position);
+	memcpy(buffer, m_data + m_position, size);
+	m_position += size;
+	return size;
+}
+
+uint64 CMappedImageStream::Write(const void*, uint64)
+{
+	throw std::runtime_error("Not supported.");
+}
+
+bool CMappedImageStream::IsEOF()
+{
+	return (m_position >= m_size);
+}
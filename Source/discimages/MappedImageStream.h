@@ -0,0 +1,39 @@
+#pragma once
+
+#include "filesystem_def.h"
+#include "Types.h"
+#include "Stream.h"
+
+//Maps a whole local image file in memory. Block providers use the mapping directly
+//(see ISO9660::CBlockProviderMapped) and other users go through the regular stream interface.
+//Throws if the file isn't a regular file on a local fixed drive: I/O errors on a mapping (ex.: network
+//share going away, removable media being ejected) can't be recovered from.
+class CMappedImageStream : public Framework::CStream
+{
+public:
+	CMappedImageStream(const fs::path&);
+	virtual ~CMappedImageStream();
+
+	const uint8* GetData() const;
+	uint64 GetSize() const;
+
+	//Hints for the OS, ranges don't need to be aligned to pages
+	void AdviseSequential(uint64, uint64);
+	void AdviseWillNeed(uint64, uint64);
+
+	void Seek(int64, Framework::STREAM_SEEK_DIRECTION) override;
+	uint64 Tell() override;
+	uint64 Read(void*, uint64) override;
+	uint64 Write(const void*, uint64) override;
+	bool IsEOF() override;
+
+private:
+	const uint8* m_data = nullptr;
+	uint64 m_size = 0;
+	uint64 m_position = 0;
+	uint64 m_pageSize = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+};
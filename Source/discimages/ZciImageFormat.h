@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Types.h"
+
+//ZCI (zstd chunked image) layout:
+//- Header
+//- Optional zstd dictionary, shared by all chunks
+//- Chunks, each holding 'chunkSize' bytes of the image (except the last one) as a zstd frame, or
+//  stored as is when it doesn't compress
+//- Index, 'chunkCount + 1' little endian uint64 chunk offsets. The last entry is the end of the
+//  chunk data. Chunks stored uncompressed have ZCI_INDEX_STORED_FLAG set in their entry.
+//- Footer, at the very end of the file to allow images to be written in one pass
+
+#define ZCI_HEADER_MAGIC "ZCI\x1A"
+#define ZCI_FOOTER_MAGIC "ZCIF"
+#define ZCI_VERSION 1
+
+static const uint64 ZCI_INDEX_STORED_FLAG = (1ULL << 63);
+
+#pragma pack(push, 1)
+struct ZCI_HEADER
+{
+	char magic[4];
+	uint32 version;
+	uint32 headerSize;
+	uint32 chunkSize;
+};
+static_assert(sizeof(ZCI_HEADER) == 0x10, "ZCI_HEADER size must be 16 bytes.");
+
+struct ZCI_FOOTER
+{
+	uint64 uncompressedSize;
+	uint64 indexOffset;
+	uint64 dictionaryOffset;
+	uint32 dictionarySize;
+	uint32 chunkCount;
+	uint32 reserved;
+	char magic[4];
+};
+static_assert(sizeof(ZCI_FOOTER) == 0x28, "ZCI_FOOTER size must be 40 bytes.");
+#pragma pack(pop)
@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <zstd.h>
+#include "ZciImageStream.h"
+#include "ZciImageFormat.h"
+
+//Chunks bigger than this are most likely the result of a corrupted header
+#define ZCI_MAX_CHUNK_SIZE (0x1000000)
+
+CZciImageStream::CZciImageStream(std::unique_ptr<Framework::CStream> baseStream)
+    : m_baseStream(std::move(baseStream))
+{
+	if(!m_baseStream)
+	{
+		throw std::runtime_error("Null base stream supplied.");
+	}
+
+	ReadHeaderAndFooter();
+	ReadIndex();
+
+	m_decompressContext = ZSTD_createDCtx();
+	if(!m_decompressContext)
+	{
+		throw std::runtime_error("Failed to create zstd decompression context.");
+	}
+
+	try
+	{
+		ReadDictionary();
+	}
+	catch(...)
+	{
+		ZSTD_freeDCtx(m_decompressContext);
+		throw;
+	}
+
+	m_chunkBuffer.resize(m_chunkSize);
+	m_compressedBuffer.resize(ZSTD_compressBound(m_chunkSize));
+}
+
+CZciImageStream::~CZciImageStream()
+{
+	ZSTD_freeDDict(m_dictionary);
+	ZSTD_freeDCtx(m_decompressContext);
+}
+
+uint32 CZciImageStream::GetChunkSize() const
+{
+	return m_chunkSize;
+}
+
+void CZciImageStream::ReadHeaderAndFooter()
+{
+	uint64 fileSize = m_baseStream->GetLength();
+	if(fileSize < (sizeof(ZCI_HEADER) + sizeof(ZCI_FOOTER)))
+	{
+		throw std::runtime_error("File is too small to be a ZCI image.");
+	}
+
+	ZCI_HEADER header = {};
+	ReadBaseAt(0, &header, sizeof(ZCI_HEADER));
+	if(memcmp(header.magic, ZCI_HEADER_MAGIC, sizeof(header.magic)))
+	{
+		throw std::runtime_error("Not a valid ZCI image.");
+	}
+	if(header.version != ZCI_VERSION)
+	{
+		throw std::runtime_error("Unsupported ZCI image version.");
+	}
+	if((header.chunkSize == 0) || (header.chunkSize > ZCI_MAX_CHUNK_SIZE))
+	{
+		throw std::runtime_error("Invalid ZCI chunk size.");
+	}
+	m_chunkSize = header.chunkSize;
+
+	ZCI_FOOTER footer = {};
+	ReadBaseAt(fileSize - sizeof(ZCI_FOOTER), &footer, sizeof(ZCI_FOOTER));
+	if(memcmp(footer.magic, ZCI_FOOTER_MAGIC, sizeof(footer.magic)))
+	{
+		throw std::runtime_error("Invalid ZCI footer, image might be truncated.");
+	}
+	uint64 expectedChunkCount = (footer.uncompressedSize + m_chunkSize - 1) / m_chunkSize;
+	uint64 indexSize = (static_cast<uint64>(footer.chunkCount) + 1) * sizeof(uint64);
+	if(
+	    (footer.chunkCount != expectedChunkCount) ||
+	    (footer.indexOffset > fileSize) ||
+	    (indexSize > (fileSize - footer.indexOffset)) ||
+	    (footer.dictionaryOffset > fileSize) ||
+	    (footer.dictionarySize > (fileSize - footer.dictionaryOffset)))
+	{
+		throw std::runtime_error("Invalid ZCI footer.");
+	}
+	m_totalSize = footer.uncompressedSize;
+	m_chunkCount = footer.chunkCount;
+	m_indexOffset = footer.indexOffset;
+	m_dictionaryOffset = footer.dictionaryOffset;
+	m_dictionarySize = footer.dictionarySize;
+}
+
+void CZciImageStream::ReadIndex()
+{
+	m_index.resize(m_chunkCount + 1);
+	ReadBaseAt(m_indexOffset, m_index.data(), m_index.size() * sizeof(uint64));
+
+	uint64 compressedSizeBound = ZSTD_compressBound(m_chunkSize);
+	for(uint32 i = 0; i < m_chunkCount; i++)
+	{
+		uint64 chunkStart = m_index[i] & ~ZCI_INDEX_STORED_FLAG;
+		uint64 chunkEnd = m_index[i + 1] & ~ZCI_INDEX_STORED_FLAG;
+		if((chunkEnd < chunkStart) || (chunkEnd > m_indexOffset) || ((chunkEnd - chunkStart) > compressedSizeBound))
+		{
+			throw std::runtime_error("Invalid ZCI index.");
+		}
+	}
+}
+
+void CZciImageStream::ReadDictionary()
+{
+	if(m_dictionarySize == 0) return;
+	std::vector<uint8> dictionary(m_dictionarySize);
+	ReadBaseAt(m_dictionaryOffset, dictionary.data(), dictionary.size());
+	m_dictionary = ZSTD_createDDict(dictionary.data(), dictionary.size());
+	if(!m_dictionary)
+	{
+		throw std::runtime_error("Failed to load ZCI dictionary.");
+	}
+}
+
+void CZciImageStream::ReadBaseAt(uint64 position, void* buffer, uint64 size)
+{
+	m_baseStream->Seek(position, Framework::STREAM_SEEK_SET);
+	if(m_baseStream->Read(buffer, size) != size)
+	{
+		throw std::runtime_error("Failed to read from ZCI image.");
+	}
+}
+
+void CZciImageStream::LoadChunk(uint32 chunkIndex)
+{
+	if(chunkIndex == m_chunkBufferIndex) return;
+	assert(chunkIndex < m_chunkCount);
+
+	//Make sure we don't use a partially overwritten chunk if something goes wrong
+	m_chunkBufferIndex = ~0U;
+
+	uint64 chunkStart = m_index[chunkIndex] & ~ZCI_INDEX_STORED_FLAG;
+	uint64 chunkEnd = m_index[chunkIndex + 1] & ~ZCI_INDEX_STORED_FLAG;
+	uint64 chunkPosition = static_cast<uint64>(chunkIndex) * m_chunkSize;
+	uint64 chunkSize = std::min<uint64>(m_chunkSize, m_totalSize - chunkPosition);
+	uint64 compressedSize = chunkEnd - chunkStart;
+
+	if(m_index[chunkIndex] & ZCI_INDEX_STORED_FLAG)
+	{
+		if(compressedSize != chunkSize)
+		{
+			throw std::runtime_error("Invalid ZCI stored chunk size.");
+		}
+		ReadBaseAt(chunkStart, m_chunkBuffer.data(), chunkSize);
+	}
+	else
+	{
+		ReadBaseAt(chunkStart, m_compressedBuffer.data(), compressedSize);
+		size_t result = m_dictionary ? ZSTD_decompress_usingDDict(m_decompressContext, m_chunkBuffer.data(), chunkSize, m_compressedBuffer.data(), compressedSize, m_dictionary)
+		                             : ZSTD_decompressDCtx(m_decompressContext, m_chunkBuffer.data(), chunkSize, m_compressedBuffer.data(), compressedSize);
+		if(ZSTD_isError(result) || (result != chunkSize))
+		{
+			throw std::runtime_error("Failed to decompress ZCI chunk.");
+		}
+	}
+
+	m_chunkBufferIndex = chunkIndex;
+}
+
+void CZciImageStream::Seek(int64 position, Framework::STREAM_SEEK_DIRECTION origin)
+{
+	switch(origin)
+	{
+	case Framework::STREAM_SEEK_CUR:
+		m_position += position;
+		break;
+	case Framework::STREAM_SEEK_SET:
+		m_position = position;
+		break;
+	case Framework::STREAM_SEEK_END:
+		m_position = m_totalSize + position;
+		break;
+	}
+}
+
+uint64 CZciImageStream::Tell()
+{
+	return m_position;
+}
+
+bool CZciImageStream::IsEOF()
+{
+	return (m_position >= m_totalSize);
+}
+
+uint64 CZciImageStream::Read(void* buffer, uint64 size)
+{
+	auto output = reinterpret_cast<uint8*>(buffer);
+	uint64 totalRead = 0;
+	while((size != 0) && (m_position < m_totalSize))
+	{
+		uint32 chunkIndex = static_cast<uint32>(m_position / m_chunkSize);
+		uint32 chunkOffset = static_cast<uint32>(m_position % m_chunkSize);
+		LoadChunk(chunkIndex);
+		uint64 chunkSize = std::min<uint64>(m_chunkSize, m_totalSize - (static_cast<uint64>(chunkIndex) * m_chunkSize));
+		uint64 copySize = std::min<uint64>(size, chunkSize - chunkOffset);
+		memcpy(output, m_chunkBuffer.data() + chunkOffset, copySize);
+		output += copySize;
+		size -= copySize;
+		m_position += copySize;
+		totalRead += copySize;
+	}
+	return totalRead;
+}
+
+uint64 CZciImageStream::Write(const void*, uint64)
+{
+	throw std::runtime_error("Writing is not supported.");
+}
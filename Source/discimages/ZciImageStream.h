@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Types.h"
+#include "Stream.h"
+
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+typedef struct ZSTD_DDict_s ZSTD_DDict;
+
+//Reads ZCI images (see ZciImageFormat.h). Chunks are small enough to be decompressed on
+//demand, the last decompressed chunk is kept around for sequential reads.
+class CZciImageStream : public Framework::CStream
+{
+public:
+	CZciImageStream(std::unique_ptr<Framework::CStream>);
+	virtual ~CZciImageStream();
+
+	uint32 GetChunkSize() const;
+
+	void Seek(int64, Framework::STREAM_SEEK_DIRECTION) override;
+	uint64 Tell() override;
+	bool IsEOF() override;
+	uint64 Read(void*, uint64) override;
+	uint64 Write(const void*, uint64) override;
+
+private:
+	void ReadHeaderAndFooter();
+	void ReadIndex();
+	void ReadDictionary();
+	void ReadBaseAt(uint64, void*, uint64);
+	void LoadChunk(uint32);
+
+	std::unique_ptr<Framework::CStream> m_baseStream;
+	uint32 m_chunkSize = 0;
+	uint32 m_chunkCount = 0;
+	uint64 m_totalSize = 0;
+	uint64 m_indexOffset = 0;
+	uint64 m_dictionaryOffset = 0;
+	uint32 m_dictionarySize = 0;
+	uint64 m_position = 0;
+
+	std::vector<uint64> m_index;
+	std::vector<uint8> m_compressedBuffer;
+	std::vector<uint8> m_chunkBuffer;
+	uint32 m_chunkBufferIndex = ~0U;
+
+	ZSTD_DCtx* m_decompressContext = nullptr;
+	ZSTD_DDict* m_dictionary = nullptr;
+};
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <zstd.h>
+#include "ZciImageWriter.h"
+#include "ZciImageFormat.h"
+
+//Chunks handed to each thread per batch, keeps threads busy without buffering too much of the image
+#define CHUNKS_PER_THREAD (16)
+
+CZciImageWriter::CZciImageWriter(Framework::CStream& output, const OPTIONS& options)
+    : m_output(output)
+    , m_options(options)
+{
+	if((m_options.chunkSize < 0x800) || (m_options.chunkSize > 0x1000000) || (m_options.chunkSize % 0x800))
+	{
+		throw std::runtime_error("ZCI chunk size must be a multiple of 2048 bytes, up to 16MB.");
+	}
+	if(m_options.threadCount == 0)
+	{
+		m_options.threadCount = std::max<unsigned int>(std::thread::hardware_concurrency(), 1);
+	}
+
+	m_chunks.resize(m_options.threadCount * CHUNKS_PER_THREAD);
+	m_batchData.resize(static_cast<size_t>(m_chunks.size()) * m_options.chunkSize);
+
+	ZCI_HEADER header = {};
+	memcpy(header.magic, ZCI_HEADER_MAGIC, sizeof(header.magic));
+	header.version = ZCI_VERSION;
+	header.headerSize = sizeof(ZCI_HEADER);
+	header.chunkSize = m_options.chunkSize;
+	m_output.Write(&header, sizeof(ZCI_HEADER));
+	m_outputPosition = sizeof(ZCI_HEADER);
+
+	m_dictionaryOffset = m_outputPosition;
+	m_output.Write(m_options.dictionary.data(), m_options.dictionary.size());
+	m_outputPosition += m_options.dictionary.size();
+
+	CreateContexts();
+}
+
+CZciImageWriter::~CZciImageWriter()
+{
+	FreeContexts();
+}
+
+void CZciImageWriter::CreateContexts()
+{
+	try
+	{
+		for(unsigned int i = 0; i < m_options.threadCount; i++)
+		{
+			auto context = ZSTD_createCCtx();
+			if(!context)
+			{
+				throw std::runtime_error("Failed to create zstd compression context.");
+			}
+			m_compressContexts.push_back(context);
+		}
+		if(!m_options.dictionary.empty())
+		{
+			m_dictionary = ZSTD_createCDict(m_options.dictionary.data(), m_options.dictionary.size(), m_options.compressionLevel);
+			if(!m_dictionary)
+			{
+				throw std::runtime_error("Failed to load zstd dictionary.");
+			}
+		}
+	}
+	catch(...)
+	{
+		FreeContexts();
+		throw;
+	}
+}
+
+void CZciImageWriter::FreeContexts()
+{
+	for(auto context : m_compressContexts)
+	{
+		ZSTD_freeCCtx(context);
+	}
+	m_compressContexts.clear();
+	ZSTD_freeCDict(m_dictionary);
+	m_dictionary = nullptr;
+}
+
+void CZciImageWriter::Write(const void* buffer, uint64 size)
+{
+	assert(!m_finished);
+	auto input = reinterpret_cast<const uint8*>(buffer);
+	uint64 batchPosition = m_uncompressedSize % m_batchData.size();
+	while(size != 0)
+	{
+		uint64 copySize = std::min<uint64>(size, m_batchData.size() - batchPosition);
+		memcpy(m_batchData.data() + batchPosition, input, copySize);
+		input += copySize;
+		size -= copySize;
+		batchPosition += copySize;
+		m_uncompressedSize += copySize;
+		if(batchPosition == m_batchData.size())
+		{
+			FlushChunks();
+			batchPosition = 0;
+		}
+	}
+}
+
+void CZciImageWriter::Finish()
+{
+	assert(!m_finished);
+	FlushChunks();
+
+	uint64 indexOffset = m_outputPosition;
+	m_index.push_back(indexOffset);
+	m_output.Write(m_index.data(), m_index.size() * sizeof(uint64));
+	m_outputPosition += m_index.size() * sizeof(uint64);
+
+	ZCI_FOOTER footer = {};
+	footer.uncompressedSize = m_uncompressedSize;
+	footer.indexOffset = indexOffset;
+	footer.dictionaryOffset = m_dictionaryOffset;
+	footer.dictionarySize = static_cast<uint32>(m_options.dictionary.size());
+	footer.chunkCount = static_cast<uint32>(m_index.size() - 1);
+	memcpy(footer.magic, ZCI_FOOTER_MAGIC, sizeof(footer.magic));
+	m_output.Write(&footer, sizeof(ZCI_FOOTER));
+	m_outputPosition += sizeof(ZCI_FOOTER);
+
+	m_finished = true;
+}
+
+uint64 CZciImageWriter::GetCompressedSize() const
+{
+	return m_outputPosition;
+}
+
+void CZciImageWriter::FlushChunks()
+{
+	//Everything that was written since the last flush, only the image's last chunk can be partial
+	uint64 batchSize = m_uncompressedSize - (static_cast<uint64>(m_index.size()) * m_options.chunkSize);
+	if(batchSize == 0) return;
+	assert(batchSize <= m_batchData.size());
+	uint32 chunkCount = static_cast<uint32>((batchSize + m_options.chunkSize - 1) / m_options.chunkSize);
+
+	std::atomic<uint32> nextChunk = {0};
+	auto compressChunks = [&](ZSTD_CCtx* context) {
+		while(1)
+		{
+			uint32 chunkIndex = nextChunk++;
+			if(chunkIndex >= chunkCount) break;
+			uint64 chunkOffset = static_cast<uint64>(chunkIndex) * m_options.chunkSize;
+			uint32 chunkSize = static_cast<uint32>(std::min<uint64>(m_options.chunkSize, batchSize - chunkOffset));
+			CompressChunk(context, m_chunks[chunkIndex], m_batchData.data() + chunkOffset, chunkSize);
+		}
+	};
+	std::vector<std::thread> threads;
+	unsigned int threadCount = std::min<unsigned int>(m_options.threadCount, chunkCount);
+	for(unsigned int i = 1; i < threadCount; i++)
+	{
+		threads.emplace_back(compressChunks, m_compressContexts[i]);
+	}
+	compressChunks(m_compressContexts[0]);
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	for(uint32 i = 0; i < chunkCount; i++)
+	{
+		const auto& chunk = m_chunks[i];
+		if(chunk.compressedSize == 0)
+		{
+			throw std::runtime_error("Failed to compress ZCI chunk.");
+		}
+		m_index.push_back(m_outputPosition | (chunk.stored ? ZCI_INDEX_STORED_FLAG : 0));
+		const uint8* chunkData = chunk.stored ? (m_batchData.data() + (static_cast<uint64>(i) * m_options.chunkSize)) : chunk.data.data();
+		m_output.Write(chunkData, chunk.compressedSize);
+		m_outputPosition += chunk.compressedSize;
+	}
+}
+
+void CZciImageWriter::CompressChunk(ZSTD_CCtx* context, CHUNK& chunk, const uint8* data, uint32 size)
+{
+	chunk.data.resize(ZSTD_compressBound(size));
+	size_t result = m_dictionary ? ZSTD_compress_usingCDict(context, chunk.data.data(), chunk.data.size(), data, size, m_dictionary)
+	                             : ZSTD_compressCCtx(context, chunk.data.data(), chunk.data.size(), data, size, m_options.compressionLevel);
+	if(ZSTD_isError(result))
+	{
+		chunk.compressedSize = 0;
+		return;
+	}
+	//Store chunks that don't compress as is, they're faster to read that way
+	chunk.stored = (result >= size);
+	chunk.compressedSize = chunk.stored ? size : result;
+}
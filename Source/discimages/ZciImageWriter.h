@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include "Types.h"
+#include "Stream.h"
+
+typedef struct ZSTD_CCtx_s ZSTD_CCtx;
+typedef struct ZSTD_CDict_s ZSTD_CDict;
+
+//Writes ZCI images (see ZciImageFormat.h) in a single pass, chunks are compressed in parallel.
+class CZciImageWriter
+{
+public:
+	enum
+	{
+		DEFAULT_CHUNK_SIZE = 0x10000,
+		DEFAULT_COMPRESSION_LEVEL = 19,
+	};
+
+	struct OPTIONS
+	{
+		uint32 chunkSize = DEFAULT_CHUNK_SIZE;
+		int compressionLevel = DEFAULT_COMPRESSION_LEVEL;
+		//0 to use as many threads as there are cores
+		unsigned int threadCount = 0;
+		//Optional, made with 'zstd --train' on similar images
+		std::vector<uint8> dictionary;
+	};
+
+	CZciImageWriter(Framework::CStream&, const OPTIONS&);
+	~CZciImageWriter();
+
+	void Write(const void*, uint64);
+	//Writes the index and footer, nothing can be written after this
+	void Finish();
+
+	uint64 GetCompressedSize() const;
+
+private:
+	struct CHUNK
+	{
+		std::vector<uint8> data;
+		size_t compressedSize = 0;
+		bool stored = false;
+	};
+
+	void CreateContexts();
+	void FreeContexts();
+	void FlushChunks();
+	void CompressChunk(ZSTD_CCtx*, CHUNK&, const uint8*, uint32);
+
+	Framework::CStream& m_output;
+	OPTIONS m_options;
+	std::vector<uint8> m_batchData;
+	std::vector<CHUNK> m_chunks;
+	std::vector<ZSTD_CCtx*> m_compressContexts;
+	ZSTD_CDict* m_dictionary = nullptr;
+
+	std::vector<uint64> m_index;
+	uint64 m_uncompressedSize = 0;
+	uint64 m_outputPosition = 0;
+	uint64 m_dictionaryOffset = 0;
+	bool m_finished = false;
+};
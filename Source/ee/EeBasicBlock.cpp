@@ -27,39 +27,35 @@ void CEeBasicBlock::CompileEpilog(CMipsJitter* jitter, bool loopsOnItself)
 		jitter->FP_SetRoundingMode(DEFAULT_FP_ROUNDING_MODE);
 	}
 
-	if(m_isIdleLoopBlock || IsCodeIdleLoopBlock())
+	if(m_isIdleLoopBlock)
 	{
 		jitter->PushCst(MIPS_EXCEPTION_IDLE);
 		jitter->PullRel(offsetof(CMIPS, m_State.nHasException));
 	}
+	else if(IsCodeIdleLoopBlock())
+	{
+		//Only idle if we're about to run the loop again, the loop exiting means the condition was met
+		jitter->PushRel(offsetof(CMIPS, m_State.nDelayedJumpAddr));
+		jitter->PushCst(m_begin);
+		jitter->BeginIf(Jitter::CONDITION_EQ);
+		{
+			jitter->PushCst(MIPS_EXCEPTION_IDLE);
+			jitter->PullRel(offsetof(CMIPS, m_State.nHasException));
+		}
+		jitter->EndIf();
+	}
 
 	CBasicBlock::CompileEpilog(jitter, loopsOnItself);
 }
 
 bool CEeBasicBlock::IsCodeIdleLoopBlock() const
 {
-	enum OP
-	{
-		OP_BEQ = 0x04,
-		OP_BNE = 0x05,
-		OP_SLTIU = 0x0B,
-		OP_ANDI = 0x0C,
-		OP_XORI = 0x0E,
-		OP_LUI = 0x0F,
-		OP_LQ = 0x1E,
-		OP_LW = 0x23,
-		OP_LBU = 0x24,
-	};
-
-	enum
-	{
-		OP_SPECIAL_SLT = 0x2A,
-		OP_SPECIAL_SLTU = 0x2B,
-	};
-
 	uint32 endInstructionAddress = m_end - 4;
 	uint32 endInstruction = m_context.m_pMemoryMap->GetWord(endInstructionAddress);
 
+	uint32 instructionCount = ((m_end - m_begin) / 4) + 1;
+	if(instructionCount > MAX_IDLE_LOOP_INSTRUCTIONS) return false;
+
 	//We need a branch at the end of the block
 	auto branchType = m_context.m_pArch->IsInstructionBranch(&m_context, endInstructionAddress, endInstruction);
 	if(branchType != MIPS_BRANCH_NORMAL) return false;
@@ -69,91 +65,214 @@ bool CEeBasicBlock::IsCodeIdleLoopBlock() const
 	if(branchTarget == MIPS_INVALID_PC) return false;
 	if(branchTarget != m_begin) return false;
 
-	uint32 compareRs = 0;
-	uint32 compareRt = 0;
+	uint32 defState = 0; //Set of registers written within this block
+	uint32 useState = 0; //Set of registers read before being written within this block
 
-	//Check what kind of branching instruction we have.
+	//The loop is idle if every iteration computes the same thing: no side effects and
+	//no dependency on a value computed by a previous iteration. Only memory (RAM or
+	//hardware registers) can then make it exit.
+	for(uint32 address = m_begin; address <= m_end; address += 4)
 	{
-		uint32 op = (endInstruction >> 26) & 0x3F;
-		uint32 rt = (endInstruction >> 16) & 0x1F;
-		uint32 rs = (endInstruction >> 21) & 0x1F;
+		uint32 inst = m_context.m_pMemoryMap->GetWord(address);
 
-		//We want a BEQ or BNE
-		if((op != OP_BEQ) && (op != OP_BNE)) return false;
+		uint32 newDef = 0;
+		uint32 newUse = 0;
+
+		bool isPure = (address == endInstructionAddress) ? GetBranchRegisterUsage(inst, newUse) : GetPureInstructionRegisterUsage(inst, newUse, newDef);
+		if(!isPure) return false;
+
+		//R0 is never modified
+		newUse &= ~1;
+		newDef &= ~1;
 
-		compareRs = rs;
-		compareRt = rt;
+		//Remove uses from defs within this block
+		newUse &= ~defState;
+
+		useState |= newUse;
+		defState |= newDef;
 	}
 
-	uint32 defState = 0; //Set of completely new definitions of registers within this block
-	uint32 useState = 0; //Set of previous state usage within this block
+	//Bail if we define any state that was carried from a previous iteration
+	return (useState & defState) == 0;
+}
 
-	//Check all instructions inside to see if we can prove it's waiting for some kind of flag
-	for(uint32 address = m_begin; address <= m_end; address += 4)
+bool CEeBasicBlock::GetBranchRegisterUsage(uint32 inst, uint32& use)
+{
+	enum OP
 	{
-		//Don't check branch instruction as we've checked it already
-		if(address == endInstructionAddress) continue;
+		OP_REGIMM = 0x01,
+		OP_BEQ = 0x04,
+		OP_BNE = 0x05,
+		OP_BLEZ = 0x06,
+		OP_BGTZ = 0x07,
+		OP_BEQL = 0x14,
+		OP_BNEL = 0x15,
+		OP_BLEZL = 0x16,
+		OP_BGTZL = 0x17,
+	};
 
-		uint32 inst = m_context.m_pMemoryMap->GetWord(address);
-		if(inst == 0) continue;
-		uint32 special = inst & 0x3F;
-		uint32 rd = (inst >> 11) & 0x1F;
-		uint32 rt = (inst >> 16) & 0x1F;
-		uint32 rs = (inst >> 21) & 0x1F;
-		uint32 op = (inst >> 26) & 0x3F;
+	enum
+	{
+		OP_REGIMM_BLTZ = 0x00,
+		OP_REGIMM_BGEZ = 0x01,
+		OP_REGIMM_BLTZL = 0x02,
+		OP_REGIMM_BGEZL = 0x03,
+	};
 
-		uint32 newDef = 0;
-		uint32 newUse = 0;
+	uint32 rt = (inst >> 16) & 0x1F;
+	uint32 rs = (inst >> 21) & 0x1F;
+	uint32 op = (inst >> 26) & 0x3F;
 
-		switch(op)
+	switch(op)
+	{
+	case OP_BEQ:
+	case OP_BNE:
+	case OP_BEQL:
+	case OP_BNEL:
+		use = (1 << rs) | (1 << rt);
+		return true;
+	case OP_BLEZ:
+	case OP_BGTZ:
+	case OP_BLEZL:
+	case OP_BGTZL:
+		use = (1 << rs);
+		return true;
+	case OP_REGIMM:
+		switch(rt)
 		{
-		case 0x00:
-			switch(special)
-			{
-			case OP_SPECIAL_SLT:
-			case OP_SPECIAL_SLTU:
-				newUse = (1 << rs) | (1 << rt);
-				newDef = (1 << rd);
-				break;
-			default:
-				//We don't know what this does, let's not take a chance
-				return false;
-			}
-			break;
-		case OP_LUI:
-			newDef = (1 << rt);
-			break;
-		case OP_LW:
-		case OP_LQ:
-		case OP_LBU:
-		case OP_SLTIU:
-		case OP_XORI:
-			newUse = (1 << rs);
-			newDef = (1 << rt);
-			break;
+		case OP_REGIMM_BLTZ:
+		case OP_REGIMM_BGEZ:
+		case OP_REGIMM_BLTZL:
+		case OP_REGIMM_BGEZL:
+			use = (1 << rs);
+			return true;
 		default:
-			//We don't know what this does, let's not take a chance
-			return false;
-		}
-
-		//Bail if this defines any state that we previously used
-		if(useState & newDef)
-		{
+			//Linking branches and traps
 			return false;
 		}
+	default:
+		//COP branches depend on state we don't track
+		return false;
+	}
+}
 
-		//Remove uses from defs within this block
-		newUse &= ~defState;
+bool CEeBasicBlock::GetPureInstructionRegisterUsage(uint32 inst, uint32& use, uint32& def)
+{
+	enum OP
+	{
+		OP_SPECIAL = 0x00,
+		OP_ADDIU = 0x09,
+		OP_SLTI = 0x0A,
+		OP_SLTIU = 0x0B,
+		OP_ANDI = 0x0C,
+		OP_ORI = 0x0D,
+		OP_XORI = 0x0E,
+		OP_LUI = 0x0F,
+		OP_DADDIU = 0x19,
+		OP_LQ = 0x1E,
+		OP_LB = 0x20,
+		OP_LH = 0x21,
+		OP_LW = 0x23,
+		OP_LBU = 0x24,
+		OP_LHU = 0x25,
+		OP_LWU = 0x27,
+		OP_LD = 0x37,
+	};
 
-		defState |= newDef;
-		useState |= newUse;
-	}
+	enum
+	{
+		OP_SPECIAL_SLL = 0x00,
+		OP_SPECIAL_SRL = 0x02,
+		OP_SPECIAL_SRA = 0x03,
+		OP_SPECIAL_SLLV = 0x04,
+		OP_SPECIAL_SRLV = 0x06,
+		OP_SPECIAL_SRAV = 0x07,
+		OP_SPECIAL_ADDU = 0x21,
+		OP_SPECIAL_SUBU = 0x23,
+		OP_SPECIAL_AND = 0x24,
+		OP_SPECIAL_OR = 0x25,
+		OP_SPECIAL_XOR = 0x26,
+		OP_SPECIAL_NOR = 0x27,
+		OP_SPECIAL_SLT = 0x2A,
+		OP_SPECIAL_SLTU = 0x2B,
+		OP_SPECIAL_DADDU = 0x2D,
+		OP_SPECIAL_DSUBU = 0x2F,
+		OP_SPECIAL_DSLL = 0x38,
+		OP_SPECIAL_DSRL = 0x3A,
+		OP_SPECIAL_DSRA = 0x3B,
+		OP_SPECIAL_DSLL32 = 0x3C,
+		OP_SPECIAL_DSRL32 = 0x3E,
+		OP_SPECIAL_DSRA32 = 0x3F,
+	};
 
-	//Just make sure that we've at least defined our comparision register
-	FRAMEWORK_MAYBE_UNUSED bool compareRsDefined = defState & (1 << compareRs);
-	FRAMEWORK_MAYBE_UNUSED bool compareRtDefined = defState & (1 << compareRt);
+	if(inst == 0) return true;
 
-	assert(compareRsDefined || compareRtDefined);
+	uint32 special = inst & 0x3F;
+	uint32 rd = (inst >> 11) & 0x1F;
+	uint32 rt = (inst >> 16) & 0x1F;
+	uint32 rs = (inst >> 21) & 0x1F;
+	uint32 op = (inst >> 26) & 0x3F;
 
-	return true;
+	switch(op)
+	{
+	case OP_SPECIAL:
+		switch(special)
+		{
+		case OP_SPECIAL_SLL:
+		case OP_SPECIAL_SRL:
+		case OP_SPECIAL_SRA:
+		case OP_SPECIAL_DSLL:
+		case OP_SPECIAL_DSRL:
+		case OP_SPECIAL_DSRA:
+		case OP_SPECIAL_DSLL32:
+		case OP_SPECIAL_DSRL32:
+		case OP_SPECIAL_DSRA32:
+			use = (1 << rt);
+			def = (1 << rd);
+			return true;
+		case OP_SPECIAL_SLLV:
+		case OP_SPECIAL_SRLV:
+		case OP_SPECIAL_SRAV:
+		case OP_SPECIAL_ADDU:
+		case OP_SPECIAL_SUBU:
+		case OP_SPECIAL_AND:
+		case OP_SPECIAL_OR:
+		case OP_SPECIAL_XOR:
+		case OP_SPECIAL_NOR:
+		case OP_SPECIAL_SLT:
+		case OP_SPECIAL_SLTU:
+		case OP_SPECIAL_DADDU:
+		case OP_SPECIAL_DSUBU:
+			use = (1 << rs) | (1 << rt);
+			def = (1 << rd);
+			return true;
+		default:
+			//We don't know what this does, let's not take a chance
+			return false;
+		}
+	case OP_LUI:
+		def = (1 << rt);
+		return true;
+	case OP_ADDIU:
+	case OP_SLTI:
+	case OP_SLTIU:
+	case OP_ANDI:
+	case OP_ORI:
+	case OP_XORI:
+	case OP_DADDIU:
+	case OP_LQ:
+	case OP_LB:
+	case OP_LH:
+	case OP_LW:
+	case OP_LBU:
+	case OP_LHU:
+	case OP_LWU:
+	case OP_LD:
+		use = (1 << rs);
+		def = (1 << rt);
+		return true;
+	default:
+		//We don't know what this does, let's not take a chance
+		return false;
+	}
 }
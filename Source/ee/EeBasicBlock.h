@@ -16,6 +16,13 @@ protected:
 
 private:
 	bool IsCodeIdleLoopBlock() const;
+	static bool GetBranchRegisterUsage(uint32, uint32&);
+	static bool GetPureInstructionRegisterUsage(uint32, uint32&, uint32&);
+
+	enum
+	{
+		MAX_IDLE_LOOP_INSTRUCTIONS = 32,
+	};
 
 	static constexpr auto DEFAULT_FP_ROUNDING_MODE = Jitter::CJitter::ROUND_TRUNCATE;
 	Jitter::CJitter::ROUNDINGMODE m_fpRoundingMode = DEFAULT_FP_ROUNDING_MODE;
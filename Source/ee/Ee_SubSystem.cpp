@@ -9,6 +9,9 @@
 #include "../iop/IopBios.h"
 #include "Vif.h"
 #include "placeholder_def.h"
+#ifdef PROFILE
+#include "string_format.h"
+#endif
 
 using namespace Ee;
 
@@ -226,6 +229,9 @@ void CSubSystem::Reset(uint32 ramSize)
 	m_intc.Reset();
 	m_timer.Reset();
 
+	m_pendingTimerTicks = 0;
+	UpdateTimerDeadline();
+
 	m_os->Initialize(ramSize);
 	m_os->GetLibMc2().Reset();
 	FillFakeIopRam();
@@ -273,6 +279,9 @@ int CSubSystem::ExecuteCpu(int quota)
 			break;
 		case MIPS_EXCEPTION_IDLE:
 		{
+#ifdef PROFILE
+			CountIdleLoopHit(m_EE.m_State.nPC);
+#endif
 			m_isIdle = true;
 			m_EE.m_State.nHasException = MIPS_EXCEPTION_NONE;
 		}
@@ -299,6 +308,23 @@ int CSubSystem::ExecuteCpu(int quota)
 	return executed;
 }
 
+#ifdef PROFILE
+
+void CSubSystem::CountIdleLoopHit(uint32 address)
+{
+	//Each idle loop gets its own zone, its hit count tells how many times we skipped ahead because of it
+	auto zoneIterator = m_idleLoopProfilerZones.find(address);
+	if(zoneIterator == std::end(m_idleLoopProfilerZones))
+	{
+		auto zoneName = string_format("EE Idle Loop 0x%08X", address);
+		auto zoneHandle = CProfiler::GetInstance().RegisterZone(zoneName.c_str());
+		zoneIterator = m_idleLoopProfilerZones.emplace(address, zoneHandle).first;
+	}
+	CProfiler::GetInstance().CountZoneHit(zoneIterator->second);
+}
+
+#endif
+
 bool CSubSystem::IsCpuIdle() const
 {
 	return m_os->IsIdle() || m_isIdle;
@@ -329,7 +355,11 @@ void CSubSystem::CountTicks(int ticks)
 		}
 	}
 	m_EE.m_State.nCOP0[CCOP_SCU::COUNT] += ticks;
-	m_timer.Count(ticks);
+	m_pendingTimerTicks += ticks;
+	if(m_pendingTimerTicks >= m_ticksUntilTimerFlag)
+	{
+		SyncTimers();
+	}
 	if(m_EE.m_State.cop0_pccr & 0x80000000)
 	{
 		auto pccr = make_convertible<CCOP_SCU::PCCR>(m_EE.m_State.cop0_pccr);
@@ -347,9 +377,21 @@ void CSubSystem::CountTicks(int ticks)
 	CheckPendingInterrupts();
 }
 
+//Earliest deadline known by peripherals, used to end CPU time slices right when an interrupt is due
+uint32 CSubSystem::GetTicksUntilNextEvent()
+{
+	SyncTimers();
+	uint32 result = m_timer.GetTicksUntilNextInterrupt();
+	result = std::min(result, m_vpu0->GetVif().GetTicksUntilNextInterrupt());
+	result = std::min(result, m_vpu1->GetVif().GetTicksUntilNextInterrupt());
+	return result;
+}
+
 void CSubSystem::NotifyVBlankStart()
 {
+	SyncTimers();
 	m_timer.NotifyVBlankStart();
+	UpdateTimerDeadline();
 	m_intc.AssertLine(CINTC::INTC_LINE_VBLANK_START);
 	m_os->GetLibMc2().NotifyVBlankStart();
 	if(m_os->CheckVBlankFlag())
@@ -362,12 +404,15 @@ void CSubSystem::NotifyVBlankStart()
 
 void CSubSystem::NotifyVBlankEnd()
 {
+	SyncTimers();
 	m_timer.NotifyVBlankEnd();
+	UpdateTimerDeadline();
 	m_intc.AssertLine(CINTC::INTC_LINE_VBLANK_END);
 }
 
 void CSubSystem::SaveState(Framework::CZipArchiveWriter& archive)
 {
+	SyncTimers();
 	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_EE, &m_EE.m_State, sizeof(MIPSSTATE)));
 	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_VU0, &m_VU0.m_State, sizeof(MIPSSTATE)));
 	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_VU1, &m_VU1.m_State, sizeof(MIPSSTATE)));
@@ -411,6 +456,8 @@ void CSubSystem::LoadState(Framework::CZipArchiveReader& archive)
 	m_vpu0->LoadState(archive);
 	m_vpu1->LoadState(archive);
 	m_timer.LoadState(archive);
+	m_pendingTimerTicks = 0;
+	UpdateTimerDeadline();
 	m_gif.LoadState(archive);
 	m_ipu.LoadState(archive);
 	m_os->GetLibMc2().LoadState(archive);
@@ -430,6 +477,7 @@ uint32 CSubSystem::IOPortReadHandler(uint32 nAddress)
 	uint32 nReturn = 0;
 	if(nAddress >= 0x10000000 && nAddress <= 0x1000183F)
 	{
+		SyncTimers();
 		nReturn = m_timer.GetRegister(nAddress);
 	}
 	else if(nAddress >= 0x10002000 && nAddress <= 0x1000203F)
@@ -510,7 +558,9 @@ uint32 CSubSystem::IOPortWriteHandler(uint32 nAddress, uint32 nData)
 {
 	if(nAddress >= 0x10000000 && nAddress <= 0x1000183F)
 	{
+		SyncTimers();
 		m_timer.SetRegister(nAddress, nData);
+		UpdateTimerDeadline();
 	}
 	else if(nAddress >= 0x10002000 && nAddress <= 0x1000203F)
 	{
@@ -797,6 +847,22 @@ void CSubSystem::ExecuteIpu()
 	}
 }
 
+void CSubSystem::SyncTimers()
+{
+	//Counting in one go gives the same result as counting every chunk as long as we don't go past a flag
+	if(m_pendingTimerTicks != 0)
+	{
+		m_timer.Count(m_pendingTimerTicks);
+		m_pendingTimerTicks = 0;
+	}
+	UpdateTimerDeadline();
+}
+
+void CSubSystem::UpdateTimerDeadline()
+{
+	m_ticksUntilTimerFlag = m_timer.GetTicksUntilNextFlag();
+}
+
 void CSubSystem::CheckPendingInterrupts()
 {
 	if(!m_EE.m_State.nHasException)
@@ -19,6 +19,11 @@
 
 #include "signal/Signal.h"
 
+#ifdef PROFILE
+#include <unordered_map>
+#include "../Profiler.h"
+#endif
+
 namespace Ee
 {
 	class CSubSystem
@@ -31,6 +36,7 @@ namespace Ee
 		int ExecuteCpu(int);
 		bool IsCpuIdle() const;
 		void CountTicks(int);
+		uint32 GetTicksUntilNextEvent();
 
 		void NotifyVBlankStart();
 		void NotifyVBlankEnd();
@@ -108,6 +114,9 @@ namespace Ee
 
 		void ExecuteIpu();
 
+		void SyncTimers();
+		void UpdateTimerDeadline();
+
 		void CheckPendingInterrupts();
 
 		void FlushInstructionCache();
@@ -115,9 +124,19 @@ namespace Ee
 		void LoadBIOS();
 		void FillFakeIopRam();
 
+#ifdef PROFILE
+		void CountIdleLoopHit(uint32);
+
+		std::unordered_map<uint32, CProfiler::ZoneHandle> m_idleLoopProfilerZones;
+#endif
+
 		StatusRegisterCheckerMap m_statusRegisterCheckers;
 		bool m_isIdle = false;
 
+		//Timers are only brought up to date when they're accessed or about to set a flag
+		uint32 m_pendingTimerTicks = 0;
+		uint32 m_ticksUntilTimerFlag = 0;
+
 		CMA_VU m_MAVU0;
 		CMA_VU m_MAVU1;
 		CMA_EE m_EEArch;
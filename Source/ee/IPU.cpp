@@ -12,13 +12,12 @@
 #include "IPU_MacroblockTypeBTable.h"
 #include "IPU_MotionCodeTable.h"
 #include "IPU_DmVectorTable.h"
+#include "IPU_Kernels.h"
 #include "mpeg2/DcSizeLuminanceTable.h"
 #include "mpeg2/DcSizeChrominanceTable.h"
 #include "mpeg2/DctCoefficientTable0.h"
 #include "mpeg2/DctCoefficientTable1.h"
 #include "mpeg2/CodedBlockPatternTable.h"
-#include "mpeg2/QuantiserScaleTable.h"
-#include "mpeg2/InverseScanTable.h"
 #include "idct/TrivialC.h"
 #include "idct/IEEE1180.h"
 #include "../Log.h"
@@ -416,6 +415,41 @@ void CIPU::FlushOUTFIFOData()
 	m_OUT_FIFO.Flush();
 }
 
+CIPU::DCT_DECODE_STATUS CIPU::DecodeDctBlock(int16* block, uint32& consumedBits, const uint8* data, uint32 size, uint32 firstWriteSize,
+                                             bool mbi, bool isMpeg1CoeffVLCTable, bool isMpeg2)
+{
+	assert(size <= CINFIFO::BUFFERSIZE);
+	assert(firstWriteSize <= size);
+	auto status = DCT_DECODE_STATUS_DONE;
+	CINFIFO fifo;
+	fifo.Reset();
+	fifo.Write(const_cast<uint8*>(data), firstWriteSize);
+	uint32 writtenSize = firstWriteSize;
+	int16 dcPredictor[3] = {};
+	CBDECCommand_ReadDct readDctCommand;
+	readDctCommand.Initialize(&fifo, block, 0, dcPredictor, mbi, isMpeg1CoeffVLCTable, isMpeg2);
+	try
+	{
+		while(!readDctCommand.Execute())
+		{
+			if(writtenSize == size)
+			{
+				status = DCT_DECODE_STATUS_NEEDMOREDATA;
+				break;
+			}
+			fifo.Write(const_cast<uint8*>(data) + writtenSize, size - writtenSize);
+			writtenSize = size;
+		}
+	}
+	catch(...)
+	{
+		status = DCT_DECODE_STATUS_ERROR;
+	}
+	//FIFO discards bytes as they are consumed
+	consumedBits = ((writtenSize - fifo.GetSize()) * 8) + fifo.GetBitIndex();
+	return status;
+}
+
 void CIPU::InitializeCommand(uint32 value)
 {
 	unsigned int cmd = (value >> 28);
@@ -536,123 +570,6 @@ bool CIPU::GetIsZigZagScan()
 	return (m_IPU_CTRL & 0x00100000) == 0;
 }
 
-void CIPU::DequantiseBlock(int16* pBlock, uint8 nMBI, uint8 nQSC, bool isLinearQScale, uint32 dcPrecision, uint8* intraIq, uint8* nonIntraIq)
-{
-	int16 nQuantScale;
-
-	if(isLinearQScale)
-	{
-		nQuantScale = (int16)CQuantiserScaleTable::m_nTable0[nQSC];
-	}
-	else
-	{
-		nQuantScale = (int16)CQuantiserScaleTable::m_nTable1[nQSC];
-	}
-
-	if(nMBI == 1)
-	{
-		int16 nIntraDcMult = 0;
-
-		switch(dcPrecision)
-		{
-		case 0:
-			nIntraDcMult = 8;
-			break;
-		case 1:
-			nIntraDcMult = 4;
-			break;
-		case 2:
-			nIntraDcMult = 2;
-			break;
-		}
-
-		pBlock[0] = nIntraDcMult * pBlock[0];
-
-		for(unsigned int i = 1; i < 64; i++)
-		{
-			int16 nSign = 0;
-
-			if(pBlock[i] == 0)
-			{
-				nSign = 0;
-			}
-			else
-			{
-				nSign = (pBlock[i] > 0) ? 0x0001 : 0xFFFF;
-			}
-
-			pBlock[i] = (pBlock[i] * static_cast<int16>(intraIq[i]) * nQuantScale * 2) / 32;
-
-			if(nSign != 0)
-			{
-				if((pBlock[i] & 1) == 0)
-				{
-					pBlock[i] = (pBlock[i] - nSign) | 1;
-				}
-			}
-		}
-	}
-	else
-	{
-		for(unsigned int i = 0; i < 64; i++)
-		{
-			int16 nSign = 0;
-
-			if(pBlock[i] == 0)
-			{
-				nSign = 0;
-			}
-			else
-			{
-				nSign = (pBlock[i] > 0) ? 0x0001 : 0xFFFF;
-			}
-
-			pBlock[i] = (((pBlock[i] * 2) + nSign) * static_cast<int16>(nonIntraIq[i]) * nQuantScale) / 32;
-
-			if(nSign != 0)
-			{
-				if((pBlock[i] & 1) == 0)
-				{
-					pBlock[i] = (pBlock[i] - nSign) | 1;
-				}
-			}
-		}
-	}
-
-	//Saturate
-	int16 nSum = 0;
-
-	for(unsigned int i = 0; i < 64; i++)
-	{
-		if(pBlock[i] > 2047)
-		{
-			pBlock[i] = 2047;
-		}
-		if(pBlock[i] < -2048)
-		{
-			pBlock[i] = -2048;
-		}
-		nSum += pBlock[i];
-	}
-
-	if(nSum & 1)
-	{
-	}
-}
-
-void CIPU::InverseScan(int16* pBlock, bool isZigZag)
-{
-	int16 nTemp[0x40];
-
-	memcpy(nTemp, pBlock, sizeof(int16) * 0x40);
-	unsigned int* pTable = isZigZag ? CInverseScanTable::m_nTable0 : CInverseScanTable::m_nTable1;
-
-	for(unsigned int i = 0; i < 64; i++)
-	{
-		pBlock[i] = nTemp[pTable[i]];
-	}
-}
-
 uint32 CIPU::GetBusyBit(bool condition) const
 {
 	return condition ? 0x80000000 : 0x00000000;
@@ -969,6 +886,20 @@ unsigned int CIPU::CINFIFO::GetAvailableBits() const
 	return std::max<int32>((m_size * 8) - m_bitPosition, 0);
 }
 
+unsigned int CIPU::CINFIFO::PeekReservoir(uint64& result)
+{
+	//Returns the bits following the current position, left aligned
+	if(m_lookupBitsDirty)
+	{
+		SyncLookupBits();
+		m_lookupBitsDirty = false;
+	}
+
+	unsigned int shift = m_bitPosition % 32;
+	result = m_lookupBits << shift;
+	return std::min<unsigned int>(64 - shift, GetAvailableBits());
+}
+
 void CIPU::CINFIFO::Reset()
 {
 	m_bitPosition = 0;
@@ -1404,9 +1335,8 @@ bool CIPU::CBDECCommand::Execute()
 			BLOCKENTRY& blockInfo(m_blocks[m_currentBlockIndex]);
 			int16 blockTemp[0x40];
 
-			DequantiseBlock(blockInfo.block, (m_command.mbi != 0), m_command.qsc,
-			                m_context.isLinearQScale, m_context.dcPrecision, m_context.intraIq, m_context.nonIntraIq);
-			InverseScan(blockInfo.block, m_context.isZigZag);
+			Kernels::DequantiseInverseScan(blockInfo.block, (m_command.mbi != 0), m_command.qsc, m_context.isLinearQScale,
+			                               m_context.dcPrecision, m_context.intraIq, m_context.nonIntraIq, m_context.isZigZag);
 
 			memcpy(blockTemp, blockInfo.block, sizeof(int16) * 0x40);
 
@@ -1485,7 +1415,8 @@ void CIPU::CBDECCommand_ReadDct::Initialize(CINFIFO* fifo, int16* block, unsigne
 	m_blockIndex = 0;
 	m_dcDiff = 0;
 
-	if(m_mbi && !m_isMpeg1CoeffVLCTable)
+	bool useTable1 = m_mbi && !m_isMpeg1CoeffVLCTable;
+	if(useTable1)
 	{
 		m_coeffTable = &CDctCoefficientTable1::GetInstance();
 	}
@@ -1493,6 +1424,7 @@ void CIPU::CBDECCommand_ReadDct::Initialize(CINFIFO* fifo, int16* block, unsigne
 	{
 		m_coeffTable = &CDctCoefficientTable0::GetInstance();
 	}
+	m_coeffLookup = &CDctCoefficientLookup::GetInstance(useTable1, m_isMpeg2);
 }
 
 bool CIPU::CBDECCommand_ReadDct::Execute()
@@ -1536,6 +1468,18 @@ bool CIPU::CBDECCommand_ReadDct::Execute()
 		break;
 		case STATE_CHECKEOB:
 		{
+			if(m_blockIndex != 0)
+			{
+				//Resolve as many codes as possible through the lookup table,
+				//falls back to symbol by symbol decoding when it can't
+				if(m_coeffLookup->TryDecodeBlock(*m_IN_FIFO, m_block, m_blockIndex))
+				{
+#ifdef _DECODE_LOGGING
+					CLog::GetInstance().Print(DECODE_LOG_NAME, "\r\n");
+#endif
+					return true;
+				}
+			}
 			bool isEob = false;
 			if(m_coeffTable->TryIsEndOfBlock(m_IN_FIFO, isEob) != CVLCTable::DECODE_STATUS_SUCCESS)
 			{
@@ -1879,11 +1823,6 @@ bool CIPU::CSETVQCommand::Execute()
 //CSC command implementation
 /////////////////////////////////////////////
 
-CIPU::CCSCCommand::CCSCCommand()
-{
-	GenerateCbCrMap();
-}
-
 void CIPU::CCSCCommand::Initialize(CINFIFO* input, COUTFIFO* output, uint32 commandCode, uint16 TH0, uint16 TH1)
 {
 	m_command <<= commandCode;
@@ -1939,80 +1878,20 @@ bool CIPU::CCSCCommand::Execute()
 		break;
 		case STATE_CONVERTBLOCK:
 		{
-			uint32 nPixel[0x100];
-
-			uint8* pY = m_block;
-			uint8* nBlockCb = m_block + 0x100;
-			uint8* nBlockCr = m_block + 0x140;
-
-			uint32* pPixel = nPixel;
-			unsigned int* pCbCrMap = m_nCbCrMap;
-
-			uint16 alphaTh0 = (m_TH0 & 0x1FF);
-			uint16 alphaTh1 = (m_TH1 & 0x1FF);
-
-			for(unsigned int i = 0; i < 16; i++)
-			{
-				for(unsigned int j = 0; j < 16; j++)
-				{
-					float nY = pY[j];
-					float nCb = nBlockCb[pCbCrMap[j]];
-					float nCr = nBlockCr[pCbCrMap[j]];
-
-					float nR = nY + 1.402f * (nCr - 128);
-					float nG = nY - 0.34414f * (nCb - 128) - 0.71414f * (nCr - 128);
-					float nB = nY + 1.772f * (nCb - 128);
-
-					nR = std::clamp(nR, 0.f, 255.f);
-					nG = std::clamp(nG, 0.f, 255.f);
-					nB = std::clamp(nB, 0.f, 255.f);
-
-					uint8 a = 0;
-					uint8 r = static_cast<uint8>(nR);
-					uint8 g = static_cast<uint8>(nG);
-					uint8 b = static_cast<uint8>(nB);
-
-					if(r < alphaTh0 && g < alphaTh0 && b < alphaTh0)
-					{
-						a = 0;
-					}
-					else if(r < alphaTh1 && g < alphaTh1 && b < alphaTh1)
-					{
-						a = 0x40;
-					}
-					else
-					{
-						a = 0x80;
-					}
-
-					pPixel[j] = (a << 24) | (b << 16) | (g << 8) | (r << 0);
-				}
-
-				pY += 0x10;
-				pCbCrMap += 0x10;
-				pPixel += 0x10;
-			}
+			uint32 nPixel[Kernels::MACROBLOCK_PIXELS];
+			Kernels::ConvertYCbCrToRgb32(nPixel, m_block, m_TH0, m_TH1);
 
 			if(m_command.ofm == 1)
 			{
 				//RGBA16 output
-				uint16 cvtPixels[0x100];
-				for(uint32 i = 0; i < 0x100; i++)
-				{
-					uint32 pixel = nPixel[i];
-					uint16 result = 0;
-					result |= ((pixel & 0x000000F8) >> (0 + 3)) << 0;
-					result |= ((pixel & 0x0000F800) >> (8 + 3)) << 5;
-					result |= ((pixel & 0x00F80000) >> (16 + 3)) << 10;
-					result |= ((pixel & 0x80000000) >> 31) << 15;
-					cvtPixels[i] = result;
-				}
-				m_OUT_FIFO->Write(cvtPixels, sizeof(uint16) * 0x100);
+				uint16 cvtPixels[Kernels::MACROBLOCK_PIXELS];
+				Kernels::ConvertRgb32ToRgb16(cvtPixels, nPixel, m_command.dte != 0);
+				m_OUT_FIFO->Write(cvtPixels, sizeof(cvtPixels));
 			}
 			else
 			{
 				//RGBA32 output
-				m_OUT_FIFO->Write(nPixel, sizeof(uint32) * 0x100);
+				m_OUT_FIFO->Write(nPixel, sizeof(nPixel));
 			}
 
 			m_mbCount--;
@@ -2036,24 +1915,6 @@ bool CIPU::CCSCCommand::Execute()
 	}
 }
 
-void CIPU::CCSCCommand::GenerateCbCrMap()
-{
-	unsigned int* pCbCrMap = m_nCbCrMap;
-	for(unsigned int i = 0; i < 0x40; i += 0x8)
-	{
-		for(unsigned int j = 0; j < 0x10; j += 2)
-		{
-			pCbCrMap[j + 0x00] = (j / 2) + i;
-			pCbCrMap[j + 0x01] = (j / 2) + i;
-
-			pCbCrMap[j + 0x10] = (j / 2) + i;
-			pCbCrMap[j + 0x11] = (j / 2) + i;
-		}
-
-		pCbCrMap += 0x20;
-	}
-}
-
 /////////////////////////////////////////////
 //SETTH command implementation
 /////////////////////////////////////////////
@@ -9,6 +9,7 @@
 #include "mpeg2/VLCTable.h"
 #include "mpeg2/DctCoefficientTable.h"
 #include "../MailBox.h"
+#include "IPU_DctCoefficientLookup.h"
 #include "Convertible.h"
 #include "zip/ZipArchiveWriter.h"
 #include "zip/ZipArchiveReader.h"
@@ -50,6 +51,18 @@ public:
 	bool HasPendingOUTFIFOData() const;
 	void FlushOUTFIFOData();
 
+	enum DCT_DECODE_STATUS
+	{
+		DCT_DECODE_STATUS_DONE,
+		DCT_DECODE_STATUS_NEEDMOREDATA,
+		DCT_DECODE_STATUS_ERROR,
+	};
+
+	//Used by tests: decodes a block's coefficients from data written to an input FIFO, the same way BDEC does.
+	//Only the first bytes are written at first, the rest is written when the decoder runs out of data.
+	static DCT_DECODE_STATUS DecodeDctBlock(int16* block, uint32& consumedBits, const uint8* data, uint32 size, uint32 firstWriteSize,
+	                                        bool mbi, bool isMpeg1CoeffVLCTable, bool isMpeg2);
+
 private:
 	enum IPU_CTRL_BITS
 	{
@@ -173,6 +186,7 @@ private:
 		void SetBitPosition(unsigned int);
 		unsigned int GetSize() const;
 		unsigned int GetAvailableBits() const;
+		unsigned int PeekReservoir(uint64&);
 
 		void Reset();
 		void SaveState(const char*, Framework::CZipArchiveWriter&);
@@ -330,6 +344,7 @@ private:
 		bool m_isMpeg2 = true;
 		unsigned int m_blockIndex = 0;
 		MPEG2::CDctCoefficientTable* m_coeffTable = nullptr;
+		const IPU::CDctCoefficientLookup* m_coeffLookup = nullptr;
 		int16* m_dcPredictor = nullptr;
 		int16 m_dcDiff = 0;
 		CBDECCommand_ReadDcDiff m_readDcDiffCommand;
@@ -464,8 +479,6 @@ private:
 			BLOCK_SIZE = 0x180,
 		};
 
-		CCSCCommand();
-
 		void Initialize(CINFIFO*, COUTFIFO*, uint32, uint16, uint16);
 		bool Execute() override;
 
@@ -479,8 +492,6 @@ private:
 			STATE_DONE,
 		};
 
-		void GenerateCbCrMap();
-
 		STATE m_state = STATE_DONE;
 		CMD_CSC m_command = make_convertible<CMD_CSC>(0);
 
@@ -492,8 +503,6 @@ private:
 		unsigned int m_currentIndex = 0;
 		unsigned int m_mbCount = 0;
 
-		unsigned int m_nCbCrMap[0x100];
-
 		uint8 m_block[BLOCK_SIZE];
 	};
 
@@ -522,9 +531,6 @@ private:
 	bool GetIsZigZagScan();
 	bool GetIsMPEG1CoeffVLCTable();
 
-	static void DequantiseBlock(int16*, uint8, uint8, bool isLinearQScale, uint32 dcPrecision, uint8* intraIq, uint8* nonIntraIq);
-	static void InverseScan(int16*, bool isZigZag);
-
 	uint32 GetBusyBit(bool) const;
 	FIFO_STATE GetFifoState() const;
 
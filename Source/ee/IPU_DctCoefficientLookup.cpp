@@ -0,0 +1,125 @@
+#include "IPU_DctCoefficientLookup.h"
+#include <cassert>
+#include "mpeg2/DctCoefficientTable0.h"
+#include "mpeg2/DctCoefficientTable1.h"
+
+using namespace IPU;
+using namespace MPEG2;
+
+//Bit stream only made of a lookup index. Reading past the index is reported as
+//missing data, so codes that depend on bits outside of it are never put in the table.
+class CLookupIndexBitStream : public Framework::CBitStream
+{
+public:
+	CLookupIndexBitStream(uint32 index)
+	    : m_index(index)
+	{
+	}
+
+	void Advance(uint8 bits) override
+	{
+		if((m_position + bits) > CDctCoefficientLookup::LOOKUP_BITS)
+		{
+			throw CBitStreamException();
+		}
+		m_position += bits;
+	}
+
+	uint8 GetBitIndex() const override
+	{
+		return m_position;
+	}
+
+	bool TryPeekBits_LSBF(uint8, uint32&) override
+	{
+		//Shouldn't be used
+		return false;
+	}
+
+	bool TryPeekBits_MSBF(uint8 size, uint32& result) override
+	{
+		assert(size != 0);
+		if((m_position + size) > CDctCoefficientLookup::LOOKUP_BITS)
+		{
+			return false;
+		}
+		uint32 shift = CDctCoefficientLookup::LOOKUP_BITS - m_position - size;
+		result = (m_index >> shift) & ((1 << size) - 1);
+		return true;
+	}
+
+	uint32 GetPosition() const
+	{
+		return m_position;
+	}
+
+private:
+	uint32 m_index = 0;
+	uint32 m_position = 0;
+};
+
+CDctCoefficientLookup::CDctCoefficientLookup(CDctCoefficientTable& table, bool isMpeg2)
+{
+	for(uint32 index = 0; index < ENTRY_COUNT; index++)
+	{
+		auto& entry = m_entries[index];
+		CLookupIndexBitStream stream(index);
+		try
+		{
+			while(1)
+			{
+				bool isEob = false;
+				if(table.TryIsEndOfBlock(&stream, isEob) != CVLCTable::DECODE_STATUS_SUCCESS)
+				{
+					break;
+				}
+				if(isEob)
+				{
+					if(table.TrySkipEndOfBlock(&stream) != CVLCTable::DECODE_STATUS_SUCCESS)
+					{
+						break;
+					}
+					entry.isEndOfBlock = true;
+					entry.length = static_cast<uint8>(stream.GetPosition());
+					break;
+				}
+				if(entry.symbolCount == MAX_SYMBOLS)
+				{
+					break;
+				}
+				RUNLEVELPAIR runLevelPair;
+				if(table.TryGetRunLevelPair(&stream, &runLevelPair, isMpeg2) != CVLCTable::DECODE_STATUS_SUCCESS)
+				{
+					break;
+				}
+				auto& symbol = entry.symbols[entry.symbolCount];
+				symbol.run = static_cast<uint8>(runLevelPair.run);
+				symbol.level = static_cast<int16>(runLevelPair.level);
+				entry.symbolCount++;
+				entry.length = static_cast<uint8>(stream.GetPosition());
+			}
+		}
+		catch(const Framework::CBitStream::CBitStreamException&)
+		{
+		}
+		catch(const CVLCTable::CVLCTableException&)
+		{
+		}
+	}
+}
+
+const CDctCoefficientLookup& CDctCoefficientLookup::GetInstance(bool useTable1, bool isMpeg2)
+{
+	static const CDctCoefficientLookup table0Mpeg1Lookup(CDctCoefficientTable0::GetInstance(), false);
+	static const CDctCoefficientLookup table0Mpeg2Lookup(CDctCoefficientTable0::GetInstance(), true);
+	static const CDctCoefficientLookup table1Mpeg1Lookup(CDctCoefficientTable1::GetInstance(), false);
+	static const CDctCoefficientLookup table1Mpeg2Lookup(CDctCoefficientTable1::GetInstance(), true);
+	if(useTable1)
+	{
+		return isMpeg2 ? table1Mpeg2Lookup : table1Mpeg1Lookup;
+	}
+	else
+	{
+		return isMpeg2 ? table0Mpeg2Lookup : table0Mpeg1Lookup;
+	}
+}
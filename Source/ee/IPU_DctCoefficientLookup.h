@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Types.h"
+#include "mpeg2/DctCoefficientTable.h"
+
+namespace IPU
+{
+	//Multi-symbol lookup table for DCT coefficients. Each entry resolves all the
+	//short codes (run/level pairs and end of block) fully contained in LOOKUP_BITS
+	//bits, letting the decoder advance the bit stream once for several symbols.
+	//Entries are generated by probing the regular VLC decoder, so both always agree.
+	class CDctCoefficientLookup
+	{
+	public:
+		enum
+		{
+			LOOKUP_BITS = 10,
+			ENTRY_COUNT = (1 << LOOKUP_BITS),
+			MAX_SYMBOLS = 4,
+		};
+
+		CDctCoefficientLookup(MPEG2::CDctCoefficientTable&, bool);
+
+		static const CDctCoefficientLookup& GetInstance(bool useTable1, bool isMpeg2);
+
+		//Decodes AC coefficients until end of block or until a code can't be resolved
+		//through the lookup table (escape codes, long codes or not enough bits available).
+		//Stream needs to provide bits left aligned in a 64-bit word through PeekReservoir.
+		//Returns true if the end of block code was consumed.
+		template <typename StreamType>
+		bool TryDecodeBlock(StreamType& stream, int16* block, unsigned int& blockIndex) const
+		{
+			while(1)
+			{
+				uint64 bits = 0;
+				unsigned int availableBits = stream.PeekReservoir(bits);
+				const auto& entry = m_entries[bits >> (64 - LOOKUP_BITS)];
+				if((entry.length == 0) || (entry.length > availableBits))
+				{
+					return false;
+				}
+
+				//Let the regular decoder deal with (and report) out of range coefficients
+				unsigned int endIndex = blockIndex;
+				for(unsigned int i = 0; i < entry.symbolCount; i++)
+				{
+					endIndex += entry.symbols[i].run;
+					if(endIndex >= 0x40)
+					{
+						return false;
+					}
+					endIndex++;
+				}
+
+				for(unsigned int i = 0; i < entry.symbolCount; i++)
+				{
+					const auto& symbol = entry.symbols[i];
+					blockIndex += symbol.run;
+					block[blockIndex] = symbol.level;
+					blockIndex++;
+				}
+
+				stream.Advance(entry.length);
+
+				if(entry.isEndOfBlock)
+				{
+					return true;
+				}
+			}
+		}
+
+	private:
+		struct SYMBOL
+		{
+			int16 level = 0;
+			uint8 run = 0;
+		};
+
+		struct ENTRY
+		{
+			uint8 length = 0;
+			uint8 symbolCount = 0;
+			bool isEndOfBlock = false;
+			SYMBOL symbols[MAX_SYMBOLS];
+		};
+
+		ENTRY m_entries[ENTRY_COUNT];
+	};
+}
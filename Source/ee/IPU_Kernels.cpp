@@ -0,0 +1,568 @@
+#include "IPU_Kernels.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "SimdDefs.h"
+#include "mpeg2/QuantiserScaleTable.h"
+#include "mpeg2/InverseScanTable.h"
+
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+#include <emmintrin.h>
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace IPU;
+using namespace MPEG2;
+
+// clang-format off
+static const int16 g_ditherMatrix[4][4] =
+{
+	{ -4,  0, -3,  1 },
+	{  2, -2,  3, -1 },
+	{ -3,  1, -4,  0 },
+	{  3, -1,  2, -2 },
+};
+// clang-format on
+
+static int16 GetQuantiserScale(uint8 qsc, bool isLinearQScale)
+{
+	return isLinearQScale ? static_cast<int16>(CQuantiserScaleTable::m_nTable0[qsc]) : static_cast<int16>(CQuantiserScaleTable::m_nTable1[qsc]);
+}
+
+static int16 GetIntraDcMultiplier(uint32 dcPrecision)
+{
+	switch(dcPrecision)
+	{
+	case 0:
+		return 8;
+	case 1:
+		return 4;
+	case 2:
+		return 2;
+	default:
+		return 0;
+	}
+}
+
+static int16 SaturateCoefficient(int16 value)
+{
+	return std::clamp<int16>(value, -2048, 2047);
+}
+
+static void InverseScan(int16* block, const int16* source, bool isZigZag)
+{
+	unsigned int* table = isZigZag ? CInverseScanTable::m_nTable0 : CInverseScanTable::m_nTable1;
+	for(unsigned int i = 0; i < 0x40; i++)
+	{
+		block[i] = source[table[i]];
+	}
+}
+
+void Kernels::DequantiseInverseScan_Generic(int16* block, bool isIntra, uint8 qsc, bool isLinearQScale, uint32 dcPrecision,
+                                            const uint8* intraIq, const uint8* nonIntraIq, bool isZigZag)
+{
+	int16 quantScale = GetQuantiserScale(qsc, isLinearQScale);
+	int16 temp[0x40];
+
+	if(isIntra)
+	{
+		temp[0] = GetIntraDcMultiplier(dcPrecision) * block[0];
+
+		for(unsigned int i = 1; i < 0x40; i++)
+		{
+			int16 coeff = block[i];
+			int16 sign = (coeff == 0) ? 0 : ((coeff > 0) ? 1 : -1);
+			int16 value = (coeff * static_cast<int16>(intraIq[i]) * quantScale * 2) / 32;
+			if((sign != 0) && ((value & 1) == 0))
+			{
+				value = (value - sign) | 1;
+			}
+			temp[i] = value;
+		}
+	}
+	else
+	{
+		for(unsigned int i = 0; i < 0x40; i++)
+		{
+			int16 coeff = block[i];
+			int16 sign = (coeff == 0) ? 0 : ((coeff > 0) ? 1 : -1);
+			int16 value = (((coeff * 2) + sign) * static_cast<int16>(nonIntraIq[i]) * quantScale) / 32;
+			if((sign != 0) && ((value & 1) == 0))
+			{
+				value = (value - sign) | 1;
+			}
+			temp[i] = value;
+		}
+	}
+
+	for(unsigned int i = 0; i < 0x40; i++)
+	{
+		temp[i] = SaturateCoefficient(temp[i]);
+	}
+
+	InverseScan(block, temp, isZigZag);
+}
+
+void Kernels::ConvertYCbCrToRgb32_Generic(uint32* dst, const uint8* block, uint16 th0, uint16 th1)
+{
+	const uint8* blockY = block;
+	const uint8* blockCb = block + 0x100;
+	const uint8* blockCr = block + 0x140;
+
+	uint16 alphaTh0 = (th0 & 0x1FF);
+	uint16 alphaTh1 = (th1 & 0x1FF);
+
+	for(unsigned int i = 0; i < 16; i++)
+	{
+		for(unsigned int j = 0; j < 16; j++)
+		{
+			unsigned int cbCrIndex = ((i / 2) * 8) + (j / 2);
+
+			float nY = blockY[j];
+			float nCb = blockCb[cbCrIndex];
+			float nCr = blockCr[cbCrIndex];
+
+			float nR = nY + 1.402f * (nCr - 128);
+			float nG = nY - 0.34414f * (nCb - 128) - 0.71414f * (nCr - 128);
+			float nB = nY + 1.772f * (nCb - 128);
+
+			nR = std::clamp(nR, 0.f, 255.f);
+			nG = std::clamp(nG, 0.f, 255.f);
+			nB = std::clamp(nB, 0.f, 255.f);
+
+			uint8 a = 0;
+			uint8 r = static_cast<uint8>(nR);
+			uint8 g = static_cast<uint8>(nG);
+			uint8 b = static_cast<uint8>(nB);
+
+			if(r < alphaTh0 && g < alphaTh0 && b < alphaTh0)
+			{
+				a = 0;
+			}
+			else if(r < alphaTh1 && g < alphaTh1 && b < alphaTh1)
+			{
+				a = 0x40;
+			}
+			else
+			{
+				a = 0x80;
+			}
+
+			dst[j] = (a << 24) | (b << 16) | (g << 8) | (r << 0);
+		}
+
+		blockY += 0x10;
+		dst += 0x10;
+	}
+}
+
+void Kernels::ConvertRgb32ToRgb16_Generic(uint16* dst, const uint32* src, bool dither)
+{
+	for(uint32 i = 0; i < MACROBLOCK_PIXELS; i++)
+	{
+		uint32 pixel = src[i];
+		int16 r = static_cast<int16>((pixel >> 0) & 0xFF);
+		int16 g = static_cast<int16>((pixel >> 8) & 0xFF);
+		int16 b = static_cast<int16>((pixel >> 16) & 0xFF);
+		if(dither)
+		{
+			int16 ditherValue = g_ditherMatrix[(i / 16) & 3][i & 3];
+			r = std::clamp<int16>(r + ditherValue, 0, 255);
+			g = std::clamp<int16>(g + ditherValue, 0, 255);
+			b = std::clamp<int16>(b + ditherValue, 0, 255);
+		}
+		uint16 result = 0;
+		result |= (r >> 3) << 0;
+		result |= (g >> 3) << 5;
+		result |= (b >> 3) << 10;
+		result |= ((pixel & 0x80000000) >> 31) << 15;
+		dst[i] = result;
+	}
+}
+
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+
+void Kernels::DequantiseInverseScan(int16* block, bool isIntra, uint8 qsc, bool isLinearQScale, uint32 dcPrecision,
+                                    const uint8* intraIq, const uint8* nonIntraIq, bool isZigZag)
+{
+	int16 quantScale = GetQuantiserScale(qsc, isLinearQScale);
+	const uint8* iq = isIntra ? intraIq : nonIntraIq;
+	int16 dcValue = block[0];
+
+	alignas(16) int16 temp[0x40];
+
+	__m128i zero = _mm_setzero_si128();
+	__m128i one = _mm_set1_epi16(1);
+	__m128i quantScaleVector = _mm_set1_epi16(quantScale);
+	__m128i satMin = _mm_set1_epi16(-2048);
+	__m128i satMax = _mm_set1_epi16(2047);
+
+	for(unsigned int i = 0; i < 0x40; i += 8)
+	{
+		__m128i coeff = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+
+		//Multiplier is IQ * QS (* 2 for intra blocks) and always fits in 16 unsigned bits
+		__m128i mult = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(iq + i)), zero);
+		mult = _mm_mullo_epi16(mult, quantScaleVector);
+		if(isIntra)
+		{
+			mult = _mm_slli_epi16(mult, 1);
+		}
+
+		__m128i isNeg = _mm_cmpgt_epi16(zero, coeff);
+		__m128i isPos = _mm_cmpgt_epi16(coeff, zero);
+		__m128i isNonZero = _mm_or_si128(isNeg, isPos);
+		__m128i sign = _mm_sub_epi16(isNeg, isPos);
+
+		//Work on magnitudes to get division truncation towards zero
+		__m128i magnitude = _mm_sub_epi16(_mm_xor_si128(coeff, isNeg), isNeg);
+		__m128i productLo = _mm_mullo_epi16(magnitude, mult);
+		__m128i productHi = _mm_mulhi_epu16(magnitude, mult);
+		__m128i product0 = _mm_unpacklo_epi16(productLo, productHi);
+		__m128i product1 = _mm_unpackhi_epi16(productLo, productHi);
+
+		if(!isIntra)
+		{
+			//((2 * |c|) + 1) * m = (2 * |c| * m) + m
+			__m128i addend = _mm_and_si128(mult, isNonZero);
+			product0 = _mm_add_epi32(_mm_slli_epi32(product0, 1), _mm_unpacklo_epi16(addend, zero));
+			product1 = _mm_add_epi32(_mm_slli_epi32(product1, 1), _mm_unpackhi_epi16(addend, zero));
+		}
+
+		product0 = _mm_srli_epi32(product0, 5);
+		product1 = _mm_srli_epi32(product1, 5);
+
+		//Keep lower 16 bits of each result (same wrap around as the generic path)
+		product0 = _mm_srai_epi32(_mm_slli_epi32(product0, 16), 16);
+		product1 = _mm_srai_epi32(_mm_slli_epi32(product1, 16), 16);
+		__m128i value = _mm_packs_epi32(product0, product1);
+		value = _mm_sub_epi16(_mm_xor_si128(value, isNeg), isNeg);
+
+		//Make sure non zero values are odd
+		__m128i isEven = _mm_cmpeq_epi16(_mm_and_si128(value, one), zero);
+		__m128i oddValue = _mm_or_si128(_mm_sub_epi16(value, sign), one);
+		__m128i oddMask = _mm_and_si128(isEven, isNonZero);
+		value = _mm_or_si128(_mm_and_si128(oddMask, oddValue), _mm_andnot_si128(oddMask, value));
+
+		value = _mm_max_epi16(value, satMin);
+		value = _mm_min_epi16(value, satMax);
+
+		_mm_store_si128(reinterpret_cast<__m128i*>(temp + i), value);
+	}
+
+	if(isIntra)
+	{
+		temp[0] = SaturateCoefficient(GetIntraDcMultiplier(dcPrecision) * dcValue);
+	}
+
+	InverseScan(block, temp, isZigZag);
+}
+
+void Kernels::ConvertYCbCrToRgb32(uint32* dst, const uint8* block, uint16 th0, uint16 th1)
+{
+	const uint8* blockY = block;
+	const uint8* blockCb = block + 0x100;
+	const uint8* blockCr = block + 0x140;
+
+	__m128i zero = _mm_setzero_si128();
+	__m128 bias = _mm_set1_ps(128.f);
+	__m128 rCrFactor = _mm_set1_ps(1.402f);
+	__m128 gCbFactor = _mm_set1_ps(0.34414f);
+	__m128 gCrFactor = _mm_set1_ps(0.71414f);
+	__m128 bCbFactor = _mm_set1_ps(1.772f);
+	__m128 clampMin = _mm_setzero_ps();
+	__m128 clampMax = _mm_set1_ps(255.f);
+	__m128i alphaTh0 = _mm_set1_epi32(th0 & 0x1FF);
+	__m128i alphaTh1 = _mm_set1_epi32(th1 & 0x1FF);
+	__m128i alphaHalf = _mm_set1_epi32(0x40);
+	__m128i alphaFull = _mm_set1_epi32(0x80);
+
+	for(unsigned int i = 0; i < 16; i++)
+	{
+		__m128i rowY = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blockY));
+		__m128i rowCb = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(blockCb + ((i / 2) * 8)));
+		__m128i rowCr = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(blockCr + ((i / 2) * 8)));
+
+		//Each chroma sample covers two horizontal pixels
+		rowCb = _mm_unpacklo_epi8(rowCb, rowCb);
+		rowCr = _mm_unpacklo_epi8(rowCr, rowCr);
+
+		__m128i y16[2] = {_mm_unpacklo_epi8(rowY, zero), _mm_unpackhi_epi8(rowY, zero)};
+		__m128i cb16[2] = {_mm_unpacklo_epi8(rowCb, zero), _mm_unpackhi_epi8(rowCb, zero)};
+		__m128i cr16[2] = {_mm_unpacklo_epi8(rowCr, zero), _mm_unpackhi_epi8(rowCr, zero)};
+
+		for(unsigned int j = 0; j < 4; j++)
+		{
+			__m128i y32 = (j & 1) ? _mm_unpackhi_epi16(y16[j / 2], zero) : _mm_unpacklo_epi16(y16[j / 2], zero);
+			__m128i cb32 = (j & 1) ? _mm_unpackhi_epi16(cb16[j / 2], zero) : _mm_unpacklo_epi16(cb16[j / 2], zero);
+			__m128i cr32 = (j & 1) ? _mm_unpackhi_epi16(cr16[j / 2], zero) : _mm_unpacklo_epi16(cr16[j / 2], zero);
+
+			__m128 y = _mm_cvtepi32_ps(y32);
+			__m128 cb = _mm_sub_ps(_mm_cvtepi32_ps(cb32), bias);
+			__m128 cr = _mm_sub_ps(_mm_cvtepi32_ps(cr32), bias);
+
+			//Same operation order as the generic path to get identical rounding
+			__m128 r = _mm_add_ps(y, _mm_mul_ps(rCrFactor, cr));
+			__m128 g = _mm_sub_ps(_mm_sub_ps(y, _mm_mul_ps(gCbFactor, cb)), _mm_mul_ps(gCrFactor, cr));
+			__m128 b = _mm_add_ps(y, _mm_mul_ps(bCbFactor, cb));
+
+			__m128i ri = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(r, clampMin), clampMax));
+			__m128i gi = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(g, clampMin), clampMax));
+			__m128i bi = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(b, clampMin), clampMax));
+
+			__m128i belowTh0 = _mm_and_si128(_mm_and_si128(_mm_cmplt_epi32(ri, alphaTh0), _mm_cmplt_epi32(gi, alphaTh0)), _mm_cmplt_epi32(bi, alphaTh0));
+			__m128i belowTh1 = _mm_and_si128(_mm_and_si128(_mm_cmplt_epi32(ri, alphaTh1), _mm_cmplt_epi32(gi, alphaTh1)), _mm_cmplt_epi32(bi, alphaTh1));
+			__m128i alpha = _mm_or_si128(_mm_and_si128(belowTh1, alphaHalf), _mm_andnot_si128(belowTh1, alphaFull));
+			alpha = _mm_andnot_si128(belowTh0, alpha);
+
+			__m128i pixel = _mm_or_si128(
+			    _mm_or_si128(_mm_slli_epi32(alpha, 24), _mm_slli_epi32(bi, 16)),
+			    _mm_or_si128(_mm_slli_epi32(gi, 8), ri));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (j * 4)), pixel);
+		}
+
+		blockY += 0x10;
+		dst += 0x10;
+	}
+}
+
+void Kernels::ConvertRgb32ToRgb16(uint16* dst, const uint32* src, bool dither)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i channelMask = _mm_set1_epi32(0xFF);
+	__m128i channelMax = _mm_set1_epi16(255);
+
+	for(uint32 i = 0; i < MACROBLOCK_PIXELS; i += 8)
+	{
+		__m128i pixel0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 0));
+		__m128i pixel1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+
+		__m128i r = _mm_packs_epi32(_mm_and_si128(pixel0, channelMask), _mm_and_si128(pixel1, channelMask));
+		__m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(pixel0, 8), channelMask), _mm_and_si128(_mm_srli_epi32(pixel1, 8), channelMask));
+		__m128i b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(pixel0, 16), channelMask), _mm_and_si128(_mm_srli_epi32(pixel1, 16), channelMask));
+		__m128i a = _mm_packs_epi32(_mm_srli_epi32(pixel0, 31), _mm_srli_epi32(pixel1, 31));
+
+		if(dither)
+		{
+			const int16* ditherRow = g_ditherMatrix[(i / 16) & 3];
+			__m128i ditherValue = _mm_setr_epi16(ditherRow[0], ditherRow[1], ditherRow[2], ditherRow[3],
+			                                     ditherRow[0], ditherRow[1], ditherRow[2], ditherRow[3]);
+			r = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(r, ditherValue), zero), channelMax);
+			g = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(g, ditherValue), zero), channelMax);
+			b = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(b, ditherValue), zero), channelMax);
+		}
+
+		__m128i result = _mm_or_si128(
+		    _mm_or_si128(_mm_srli_epi16(r, 3), _mm_slli_epi16(_mm_srli_epi16(g, 3), 5)),
+		    _mm_or_si128(_mm_slli_epi16(_mm_srli_epi16(b, 3), 10), _mm_slli_epi16(a, 15)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+	}
+}
+
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+
+void Kernels::DequantiseInverseScan(int16* block, bool isIntra, uint8 qsc, bool isLinearQScale, uint32 dcPrecision,
+                                    const uint8* intraIq, const uint8* nonIntraIq, bool isZigZag)
+{
+	int16 quantScale = GetQuantiserScale(qsc, isLinearQScale);
+	const uint8* iq = isIntra ? intraIq : nonIntraIq;
+	int16 dcValue = block[0];
+
+	alignas(16) int16 temp[0x40];
+
+	int16x8_t zero = vdupq_n_s16(0);
+	int16x8_t one = vdupq_n_s16(1);
+	uint16x8_t quantScaleVector = vdupq_n_u16(static_cast<uint16>(quantScale));
+	int16x8_t satMin = vdupq_n_s16(-2048);
+	int16x8_t satMax = vdupq_n_s16(2047);
+
+	for(unsigned int i = 0; i < 0x40; i += 8)
+	{
+		int16x8_t coeff = vld1q_s16(block + i);
+
+		//Multiplier is IQ * QS (* 2 for intra blocks) and always fits in 16 unsigned bits
+		uint16x8_t mult = vmulq_u16(vmovl_u8(vld1_u8(iq + i)), quantScaleVector);
+		if(isIntra)
+		{
+			mult = vshlq_n_u16(mult, 1);
+		}
+
+		int16x8_t isNeg = vreinterpretq_s16_u16(vcltq_s16(coeff, zero));
+		int16x8_t isPos = vreinterpretq_s16_u16(vcgtq_s16(coeff, zero));
+		uint16x8_t isNonZero = vtstq_s16(coeff, coeff);
+		int16x8_t sign = vsubq_s16(isNeg, isPos);
+
+		//Work on magnitudes to get division truncation towards zero
+		uint16x8_t magnitude = vreinterpretq_u16_s16(vsubq_s16(veorq_s16(coeff, isNeg), isNeg));
+		uint32x4_t product0 = vmull_u16(vget_low_u16(magnitude), vget_low_u16(mult));
+		uint32x4_t product1 = vmull_u16(vget_high_u16(magnitude), vget_high_u16(mult));
+
+		if(!isIntra)
+		{
+			//((2 * |c|) + 1) * m = (2 * |c| * m) + m
+			uint16x8_t addend = vandq_u16(mult, isNonZero);
+			product0 = vaddq_u32(vshlq_n_u32(product0, 1), vmovl_u16(vget_low_u16(addend)));
+			product1 = vaddq_u32(vshlq_n_u32(product1, 1), vmovl_u16(vget_high_u16(addend)));
+		}
+
+		product0 = vshrq_n_u32(product0, 5);
+		product1 = vshrq_n_u32(product1, 5);
+
+		//Narrowing keeps lower 16 bits of each result (same wrap around as the generic path)
+		int16x8_t value = vreinterpretq_s16_u16(vcombine_u16(vmovn_u32(product0), vmovn_u32(product1)));
+		value = vsubq_s16(veorq_s16(value, isNeg), isNeg);
+
+		//Make sure non zero values are odd
+		uint16x8_t isEven = vceqq_s16(vandq_s16(value, one), zero);
+		int16x8_t oddValue = vorrq_s16(vsubq_s16(value, sign), one);
+		value = vbslq_s16(vandq_u16(isEven, isNonZero), oddValue, value);
+
+		value = vmaxq_s16(value, satMin);
+		value = vminq_s16(value, satMax);
+
+		vst1q_s16(temp + i, value);
+	}
+
+	if(isIntra)
+	{
+		temp[0] = SaturateCoefficient(GetIntraDcMultiplier(dcPrecision) * dcValue);
+	}
+
+	InverseScan(block, temp, isZigZag);
+}
+
+void Kernels::ConvertYCbCrToRgb32(uint32* dst, const uint8* block, uint16 th0, uint16 th1)
+{
+	const uint8* blockY = block;
+	const uint8* blockCb = block + 0x100;
+	const uint8* blockCr = block + 0x140;
+
+	float32x4_t bias = vdupq_n_f32(128.f);
+	float32x4_t rCrFactor = vdupq_n_f32(1.402f);
+	float32x4_t gCbFactor = vdupq_n_f32(0.34414f);
+	float32x4_t gCrFactor = vdupq_n_f32(0.71414f);
+	float32x4_t bCbFactor = vdupq_n_f32(1.772f);
+	float32x4_t clampMin = vdupq_n_f32(0.f);
+	float32x4_t clampMax = vdupq_n_f32(255.f);
+	uint32x4_t alphaTh0 = vdupq_n_u32(th0 & 0x1FF);
+	uint32x4_t alphaTh1 = vdupq_n_u32(th1 & 0x1FF);
+	uint32x4_t alphaHalf = vdupq_n_u32(0x40);
+	uint32x4_t alphaFull = vdupq_n_u32(0x80);
+	uint32x4_t alphaNone = vdupq_n_u32(0);
+
+	for(unsigned int i = 0; i < 16; i++)
+	{
+		uint8x16_t rowY = vld1q_u8(blockY);
+		uint8x8_t rowCb = vld1_u8(blockCb + ((i / 2) * 8));
+		uint8x8_t rowCr = vld1_u8(blockCr + ((i / 2) * 8));
+
+		//Each chroma sample covers two horizontal pixels
+		uint8x8x2_t cbPairs = vzip_u8(rowCb, rowCb);
+		uint8x8x2_t crPairs = vzip_u8(rowCr, rowCr);
+
+		uint16x8_t y16[2] = {vmovl_u8(vget_low_u8(rowY)), vmovl_u8(vget_high_u8(rowY))};
+		uint16x8_t cb16[2] = {vmovl_u8(cbPairs.val[0]), vmovl_u8(cbPairs.val[1])};
+		uint16x8_t cr16[2] = {vmovl_u8(crPairs.val[0]), vmovl_u8(crPairs.val[1])};
+
+		for(unsigned int j = 0; j < 4; j++)
+		{
+			uint32x4_t y32 = (j & 1) ? vmovl_u16(vget_high_u16(y16[j / 2])) : vmovl_u16(vget_low_u16(y16[j / 2]));
+			uint32x4_t cb32 = (j & 1) ? vmovl_u16(vget_high_u16(cb16[j / 2])) : vmovl_u16(vget_low_u16(cb16[j / 2]));
+			uint32x4_t cr32 = (j & 1) ? vmovl_u16(vget_high_u16(cr16[j / 2])) : vmovl_u16(vget_low_u16(cr16[j / 2]));
+
+			float32x4_t y = vcvtq_f32_u32(y32);
+			float32x4_t cb = vsubq_f32(vcvtq_f32_u32(cb32), bias);
+			float32x4_t cr = vsubq_f32(vcvtq_f32_u32(cr32), bias);
+
+			//Same operation order as the generic path to get identical rounding (no fused multiply-add)
+			float32x4_t r = vaddq_f32(y, vmulq_f32(rCrFactor, cr));
+			float32x4_t g = vsubq_f32(vsubq_f32(y, vmulq_f32(gCbFactor, cb)), vmulq_f32(gCrFactor, cr));
+			float32x4_t b = vaddq_f32(y, vmulq_f32(bCbFactor, cb));
+
+			uint32x4_t ri = vcvtq_u32_f32(vminq_f32(vmaxq_f32(r, clampMin), clampMax));
+			uint32x4_t gi = vcvtq_u32_f32(vminq_f32(vmaxq_f32(g, clampMin), clampMax));
+			uint32x4_t bi = vcvtq_u32_f32(vminq_f32(vmaxq_f32(b, clampMin), clampMax));
+
+			uint32x4_t belowTh0 = vandq_u32(vandq_u32(vcltq_u32(ri, alphaTh0), vcltq_u32(gi, alphaTh0)), vcltq_u32(bi, alphaTh0));
+			uint32x4_t belowTh1 = vandq_u32(vandq_u32(vcltq_u32(ri, alphaTh1), vcltq_u32(gi, alphaTh1)), vcltq_u32(bi, alphaTh1));
+			uint32x4_t alpha = vbslq_u32(belowTh0, alphaNone, vbslq_u32(belowTh1, alphaHalf, alphaFull));
+
+			uint32x4_t pixel = vorrq_u32(
+			    vorrq_u32(vshlq_n_u32(alpha, 24), vshlq_n_u32(bi, 16)),
+			    vorrq_u32(vshlq_n_u32(gi, 8), ri));
+			vst1q_u32(dst + (j * 4), pixel);
+		}
+
+		blockY += 0x10;
+		dst += 0x10;
+	}
+}
+
+void Kernels::ConvertRgb32ToRgb16(uint16* dst, const uint32* src, bool dither)
+{
+	int16x8_t zero = vdupq_n_s16(0);
+	int16x8_t channelMax = vdupq_n_s16(255);
+
+	for(uint32 i = 0; i < MACROBLOCK_PIXELS; i += 16)
+	{
+		//Deinterleave 16 pixels into R, G, B and A planes
+		uint8x16x4_t pixels = vld4q_u8(reinterpret_cast<const uint8*>(src + i));
+
+		for(unsigned int half = 0; half < 2; half++)
+		{
+			int16x8_t r, g, b;
+			uint16x8_t a;
+			if(half == 0)
+			{
+				r = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(pixels.val[0])));
+				g = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(pixels.val[1])));
+				b = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(pixels.val[2])));
+				a = vmovl_u8(vget_low_u8(pixels.val[3]));
+			}
+			else
+			{
+				r = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(pixels.val[0])));
+				g = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(pixels.val[1])));
+				b = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(pixels.val[2])));
+				a = vmovl_u8(vget_high_u8(pixels.val[3]));
+			}
+
+			if(dither)
+			{
+				const int16* ditherRow = g_ditherMatrix[(i / 16) & 3];
+				int16x4_t ditherHalf = vld1_s16(ditherRow);
+				int16x8_t ditherValue = vcombine_s16(ditherHalf, ditherHalf);
+				r = vminq_s16(vmaxq_s16(vaddq_s16(r, ditherValue), zero), channelMax);
+				g = vminq_s16(vmaxq_s16(vaddq_s16(g, ditherValue), zero), channelMax);
+				b = vminq_s16(vmaxq_s16(vaddq_s16(b, ditherValue), zero), channelMax);
+			}
+
+			uint16x8_t result = vshrq_n_u16(vreinterpretq_u16_s16(r), 3);
+			result = vorrq_u16(result, vshlq_n_u16(vshrq_n_u16(vreinterpretq_u16_s16(g), 3), 5));
+			result = vorrq_u16(result, vshlq_n_u16(vshrq_n_u16(vreinterpretq_u16_s16(b), 3), 10));
+			result = vorrq_u16(result, vshlq_n_u16(vshrq_n_u16(a, 7), 15));
+			vst1q_u16(dst + i + (half * 8), result);
+		}
+	}
+}
+
+#else
+
+void Kernels::DequantiseInverseScan(int16* block, bool isIntra, uint8 qsc, bool isLinearQScale, uint32 dcPrecision,
+                                    const uint8* intraIq, const uint8* nonIntraIq, bool isZigZag)
+{
+	DequantiseInverseScan_Generic(block, isIntra, qsc, isLinearQScale, dcPrecision, intraIq, nonIntraIq, isZigZag);
+}
+
+void Kernels::ConvertYCbCrToRgb32(uint32* dst, const uint8* block, uint16 th0, uint16 th1)
+{
+	ConvertYCbCrToRgb32_Generic(dst, block, th0, th1);
+}
+
+void Kernels::ConvertRgb32ToRgb16(uint16* dst, const uint32* src, bool dither)
+{
+	ConvertRgb32ToRgb16_Generic(dst, src, dither);
+}
+
+#endif
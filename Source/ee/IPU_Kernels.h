@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Types.h"
+
+namespace IPU
+{
+	namespace Kernels
+	{
+		enum
+		{
+			MACROBLOCK_PIXELS = 0x100,
+		};
+
+		//Dequantises a block of coefficients (in scan order) and reorders them in raster order.
+		//Output is bit-exact with the generic implementation regardless of the selected path.
+		void DequantiseInverseScan(int16* block, bool isIntra, uint8 qsc, bool isLinearQScale, uint32 dcPrecision,
+		                           const uint8* intraIq, const uint8* nonIntraIq, bool isZigZag);
+		void DequantiseInverseScan_Generic(int16* block, bool isIntra, uint8 qsc, bool isLinearQScale, uint32 dcPrecision,
+		                                   const uint8* intraIq, const uint8* nonIntraIq, bool isZigZag);
+
+		//Converts a RAW8 macroblock (256 Y, 64 Cb, 64 Cr) to 256 RGBA32 pixels.
+		void ConvertYCbCrToRgb32(uint32* dst, const uint8* block, uint16 th0, uint16 th1);
+		void ConvertYCbCrToRgb32_Generic(uint32* dst, const uint8* block, uint16 th0, uint16 th1);
+
+		//Converts 256 RGBA32 pixels to RGBA16, optionally applying the IPU's 4x4 ordered dither.
+		void ConvertRgb32ToRgb16(uint16* dst, const uint32* src, bool dither);
+		void ConvertRgb32ToRgb16_Generic(uint16* dst, const uint32* src, bool dither);
+	}
+}
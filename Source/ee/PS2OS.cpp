@@ -3224,6 +3224,7 @@ void CPS2OS::sc_Deci2Call()
 					assert(sendInfo->size >= 0x0C);
 					if(sendInfo->size >= 0x0C)
 					{
+						CEeIopSync::CExclusiveScope exclusiveScope(m_sif.GetEeIopSync());
 						m_iopBios.GetIoman()->Write(Iop::CIoman::FID_STDOUT, sendInfo->size - 0xC, sendInfo->data);
 					}
 					buffer->status0 = 0;
@@ -3259,6 +3260,7 @@ void CPS2OS::sc_Deci2Call()
 		{
 			uint32 stringAddr = *reinterpret_cast<uint32*>(GetStructPtr(param));
 			uint8* string = &m_ram[stringAddr];
+			CEeIopSync::CExclusiveScope exclusiveScope(m_sif.GetEeIopSync());
 			m_iopBios.GetIoman()->Write(1, static_cast<uint32>(strlen(reinterpret_cast<char*>(string))), string);
 		}
 		break;
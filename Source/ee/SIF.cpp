@@ -89,14 +89,44 @@ void CSIF::Reset()
 	DeleteModules();
 }
 
+void CSIF::SetEeIopSync(CEeIopSync* eeIopSync)
+{
+	m_eeIopSync = eeIopSync;
+}
+
+CEeIopSync* CSIF::GetEeIopSync() const
+{
+	return m_eeIopSync;
+}
+
+void CSIF::WriteEeRam(uint32 address, const void* data, uint32 size)
+{
+	uint8* dst = m_eeRam + (address & (PS2::EE_RAM_SIZE - 1));
+	if(m_eeIopSync)
+	{
+		m_eeIopSync->WriteEeMemory(dst, data, size);
+	}
+	else
+	{
+		memcpy(dst, data, size);
+	}
+}
+
+//Entry points used by both the EE and IOP sides hold the sync lock when both CPUs
+//run in parallel. Entry points running IOP code from the EE side park the IOP as well.
+
 void CSIF::SetDmaBuffer(uint32 bufferAddress, uint32 size)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	m_dmaBufferAddress = bufferAddress;
 	m_dmaBufferSize = size;
 }
 
 void CSIF::SetCmdBuffer(uint32 bufferAddress, uint32 size)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	m_cmdBufferAddress = bufferAddress;
 	m_cmdBufferSize = size;
 	m_nSUBADDR = bufferAddress;
@@ -104,6 +134,8 @@ void CSIF::SetCmdBuffer(uint32 bufferAddress, uint32 size)
 
 void CSIF::RegisterModule(uint32 moduleId, CSifModule* module)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	m_modules[moduleId] = module;
 
 	auto replyIterator(m_bindReplies.find(moduleId));
@@ -138,11 +170,15 @@ void CSIF::CheckPendingBindRequests(uint32 ticks)
 
 bool CSIF::IsModuleRegistered(uint32 moduleId) const
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	return m_modules.find(moduleId) != std::end(m_modules);
 }
 
 void CSIF::UnregisterModule(uint32 moduleId)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	m_modules.erase(moduleId);
 }
 
@@ -153,11 +189,16 @@ void CSIF::DeleteModules()
 
 uint32 CSIF::ReceiveDMA5(uint32 srcAddress, uint32 size, uint32 unused, bool isTagIncluded)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	return size;
 }
 
 uint32 CSIF::ReceiveDMA6(uint32 nSrcAddr, uint32 nSize, uint32 nDstAddr, bool isTagIncluded)
 {
+	//Commands are handled by IOP modules
+	CEeIopSync::CExclusiveScope exclusiveScope(m_eeIopSync);
+
 	assert(!isTagIncluded);
 
 	//Humm, this is kinda odd, but it ors the address with 0x20000000
@@ -244,11 +285,15 @@ uint32 CSIF::ReceiveDMA6(uint32 nSrcAddr, uint32 nSize, uint32 nDstAddr, bool is
 
 void CSIF::SendPacket(const void* packet, uint32 size)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	SendPacketToAddress(packet, size, m_nEERecvAddr);
 }
 
 void CSIF::SendPacketToAddress(const void* packet, uint32 size, uint32 dstAddr)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	m_packetQueue.insert(m_packetQueue.end(),
 	                     reinterpret_cast<const uint8*>(&size),
 	                     reinterpret_cast<const uint8*>(&size) + 4);
@@ -262,6 +307,8 @@ void CSIF::SendPacketToAddress(const void* packet, uint32 size, uint32 dstAddr)
 
 void CSIF::CountTicks(uint32 ticks)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	CheckPendingBindRequests(ticks);
 
 	if(m_packetProcessed && !m_packetQueue.empty())
@@ -277,6 +324,8 @@ void CSIF::CountTicks(uint32 ticks)
 
 void CSIF::MarkPacketProcessed()
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	assert(m_packetProcessed == false);
 	m_packetProcessed = true;
 }
@@ -634,7 +683,7 @@ void CSIF::Cmd_GetOtherData(const SIFCMDHEADER* hdr)
 	uint32 dstPtr = otherData->dstPtr & (PS2::EE_RAM_SIZE - 1);
 	uint32 srcPtr = otherData->srcPtr & (PS2::IOP_RAM_SIZE - 1);
 
-	memcpy(m_eeRam + dstPtr, m_iopRam + srcPtr, otherData->size);
+	WriteEeRam(dstPtr, m_iopRam + srcPtr, otherData->size);
 
 	{
 		SIFRPCREQUESTEND rend;
@@ -655,6 +704,8 @@ void CSIF::Cmd_GetOtherData(const SIFCMDHEADER* hdr)
 
 void CSIF::SendCallReply(uint32 serverId, const void* returnData)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	CLog::GetInstance().Print(LOG_NAME, "Processing call reply from serverId: 0x%08X\r\n", serverId);
 
 	auto replyIterator(m_callReplies.find(serverId));
@@ -669,7 +720,7 @@ void CSIF::SendCallReply(uint32 serverId, const void* returnData)
 		//Size needs to be a multiple of 4
 		assert((requestInfo.call.recvSize & 0x03) == 0);
 		uint32 dstSize = (requestInfo.call.recvSize + 0x03) & ~0x03;
-		memcpy(m_eeRam + dstPtr, returnData, dstSize);
+		WriteEeRam(dstPtr, returnData, dstSize);
 	}
 	SendPacket(&requestInfo.reply, sizeof(SIFRPCREQUESTEND));
 	m_callReplies.erase(replyIterator);
@@ -677,11 +728,15 @@ void CSIF::SendCallReply(uint32 serverId, const void* returnData)
 
 void CSIF::SetModuleResetHandler(const ModuleResetHandler& moduleResetHandler)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	m_moduleResetHandler = moduleResetHandler;
 }
 
 void CSIF::SetCustomCommandHandler(const CustomCommandHandler& customCommandHandler)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	m_customCommandHandler = customCommandHandler;
 }
 
@@ -691,6 +746,8 @@ void CSIF::SetCustomCommandHandler(const CustomCommandHandler& customCommandHand
 
 uint32 CSIF::GetRegister(uint32 nRegister)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	switch(nRegister)
 	{
 	case 0x00000001:
@@ -720,6 +777,8 @@ uint32 CSIF::GetRegister(uint32 nRegister)
 
 void CSIF::SetRegister(uint32 nRegister, uint32 nValue)
 {
+	CEeIopSync::CLockScope lockScope(m_eeIopSync);
+
 	switch(nRegister)
 	{
 	case 0x00000001:
@@ -4,6 +4,7 @@
 #include <vector>
 #include "../SifDefs.h"
 #include "../SifModule.h"
+#include "../EeIopSync.h"
 #include "DMAC.h"
 #include "zip/ZipArchiveWriter.h"
 #include "zip/ZipArchiveReader.h"
@@ -20,6 +21,9 @@ public:
 
 	void Reset();
 
+	void SetEeIopSync(CEeIopSync*);
+	CEeIopSync* GetEeIopSync() const;
+
 	void CountTicks(uint32);
 	void MarkPacketProcessed();
 
@@ -40,6 +44,9 @@ public:
 
 	void SendDMA(const void*, uint32, uint32);
 
+	//Must be used by code that writes to EE RAM and can run on the IOP side
+	void WriteEeRam(uint32, const void*, uint32);
+
 	uint32 GetRegister(uint32);
 	void SetRegister(uint32, uint32);
 
@@ -90,6 +97,7 @@ private:
 	void Cmd_GetOtherData(const SIFCMDHEADER*);
 
 	CDMAC& m_dmac;
+	CEeIopSync* m_eeIopSync = nullptr;
 	uint8* m_eeRam;
 	uint8* m_iopRam;
 	uint32 m_dmaBufferAddress = 0;
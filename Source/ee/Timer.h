@@ -56,6 +56,9 @@ public:
 	void Reset();
 
 	void Count(unsigned int);
+	uint32 GetTicksUntilNextInterrupt() const;
+	//Counting past this could skip a compare or overflow flag
+	uint32 GetTicksUntilNextFlag() const;
 
 	uint32 GetRegister(uint32);
 	void SetRegister(uint32, uint32);
@@ -87,6 +90,9 @@ private:
 		uint32 clockRemain;
 	};
 
+	uint32 GetTicksUntilNextTarget(bool) const;
+	uint32 GetTimerDivider(const TIMER&) const;
+
 	TIMER m_timer[MAX_TIMER];
 	CINTC& m_intc;
 	CGSHandler*& m_gs;
@@ -264,6 +264,12 @@ void CVif::CountTicks(uint32 ticks)
 	}
 }
 
+uint32 CVif::GetTicksUntilNextInterrupt() const
+{
+	if(m_interruptDelayTicks == 0) return ~0U;
+	return std::max<int32>(m_interruptDelayTicks, 0);
+}
+
 void CVif::SaveState(Framework::CZipArchiveWriter& archive)
 {
 	{
@@ -73,6 +73,7 @@ public:
 	uint32 GetRegister(uint32);
 	void SetRegister(uint32, uint32);
 	void CountTicks(uint32);
+	uint32 GetTicksUntilNextInterrupt() const;
 	virtual void SaveState(Framework::CZipArchiveWriter&);
 	virtual void LoadState(Framework::CZipArchiveReader&);
 
@@ -391,6 +391,14 @@ void CGSHandler::SetDrawEnabled(bool drawEnabled)
 	m_drawEnabled = drawEnabled;
 }
 
+void CGSHandler::SetFrameSkip(uint32 skipCount, uint32 period)
+{
+	assert(skipCount <= period);
+	m_frameSkipCount = std::min(skipCount, period);
+	m_frameSkipPeriod = period;
+	m_frameSkipPosition = 0;
+}
+
 void CGSHandler::SetHBlank()
 {
 	std::lock_guard registerMutexLock(m_registerMutex);
@@ -402,7 +410,17 @@ void CGSHandler::SetVBlank()
 {
 	{
 		Finish();
-		Flip();
+		bool skipFrame = false;
+		if(m_frameSkipPeriod != 0)
+		{
+			skipFrame = (m_frameSkipPosition < m_frameSkipCount);
+			m_frameSkipPosition = (m_frameSkipPosition + 1) % m_frameSkipPeriod;
+		}
+		//Skipped frames stay dirty and will be presented by the next flip
+		if(!skipFrame)
+		{
+			Flip();
+		}
 	}
 
 	std::lock_guard registerMutexLock(m_registerMutex);
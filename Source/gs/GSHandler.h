@@ -840,6 +840,9 @@ public:
 	bool GetDrawEnabled() const;
 	void SetDrawEnabled(bool);
 
+	//Skips presenting the first N frames of every M (N, M), frames are still drawn. (0, 0) presents all frames.
+	void SetFrameSkip(uint32, uint32);
+
 	void WritePrivRegister(uint32, uint32);
 	uint32 ReadPrivRegister(uint32);
 
@@ -1131,6 +1134,9 @@ protected:
 	FrameDumpCallback m_frameDumpCallback;
 	bool m_regsDirty = false;
 	bool m_drawEnabled = true;
+	uint32 m_frameSkipCount = 0;
+	uint32 m_frameSkipPeriod = 0;
+	uint32 m_frameSkipPosition = 0;
 	CINTC* m_intc = nullptr;
 	bool m_gsThreaded = true;
 	bool m_flipped = false;
@@ -73,20 +73,18 @@ void CCdvdfsv::CountTicks(uint32 ticks, CSifMan* sifMan)
 
 		static const uint32 sectorSize = 0x800;
 
-		uint8* eeRam = nullptr;
-		if(auto sifManPs2 = dynamic_cast<CSifManPs2*>(sifMan))
-		{
-			eeRam = sifManPs2->GetEeRam();
-		}
+		auto sifManPs2 = dynamic_cast<CSifManPs2*>(sifMan);
+		uint8 sectorBuffer[sectorSize];
 
 		if(m_pendingCommand == COMMAND_READ)
 		{
-			if(m_opticalMedia != nullptr)
+			if((m_opticalMedia != nullptr) && sifManPs2)
 			{
 				auto fileSystem = m_opticalMedia->GetFileSystem();
 				for(unsigned int i = 0; i < m_pendingReadCount; i++)
 				{
-					fileSystem->ReadBlock(m_pendingReadSector + i, eeRam + (m_pendingReadAddr + (i * sectorSize)));
+					fileSystem->ReadBlock(m_pendingReadSector + i, sectorBuffer);
+					sifManPs2->WriteEeRam(m_pendingReadAddr + (i * sectorSize), sectorBuffer, sectorSize);
 				}
 			}
 		}
@@ -103,12 +101,13 @@ void CCdvdfsv::CountTicks(uint32 ticks, CSifMan* sifMan)
 		}
 		else if(m_pendingCommand == COMMAND_STREAM_READ)
 		{
-			if(m_opticalMedia != nullptr)
+			if((m_opticalMedia != nullptr) && sifManPs2)
 			{
 				auto fileSystem = m_opticalMedia->GetFileSystem();
 				for(unsigned int i = 0; i < m_pendingReadCount; i++)
 				{
-					fileSystem->ReadBlock(m_streamPos, eeRam + (m_pendingReadAddr + (i * sectorSize)));
+					fileSystem->ReadBlock(m_streamPos, sectorBuffer);
+					sifManPs2->WriteEeRam(m_pendingReadAddr + (i * sectorSize), sectorBuffer, sectorSize);
 					m_streamPos++;
 				}
 			}
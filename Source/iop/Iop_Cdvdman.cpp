@@ -1,4 +1,5 @@
 #include <cstring>
+#include "ThreadUtils.h"
 #include "../Log.h"
 #include "../states/RegisterStateFile.h"
 #include "../Ps2Const.h"
@@ -14,6 +15,9 @@
 #define STATE_DISCCHANGED ("DiscChanged")
 #define STATE_PENDING_COMMAND ("PendingCommand")
 #define STATE_PENDING_COMMAND_DELAY ("PendingCommandDelay")
+#define STATE_PENDING_READ_SECTOR ("PendingReadSector")
+#define STATE_PENDING_READ_SECTOR_COUNT ("PendingReadSectorCount")
+#define STATE_PENDING_READ_BUFFER ("PendingReadBuffer")
 
 #define FUNCTION_CDINIT "CdInit"
 #define FUNCTION_CDSTANDBY "CdStandby"
@@ -54,6 +58,19 @@ CCdvdman::CCdvdman(CIopBios& bios, uint8* ram)
 {
 }
 
+CCdvdman::~CCdvdman()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_hostReadMutex);
+		m_hostReadThreadDone = true;
+	}
+	m_hostReadRequestCondition.notify_one();
+	if(m_hostReadThread.joinable())
+	{
+		m_hostReadThread.join();
+	}
+}
+
 void CCdvdman::LoadState(Framework::CZipArchiveReader& archive)
 {
 	CRegisterStateFile registerFile(*archive.BeginReadFile(STATE_FILENAME));
@@ -62,6 +79,17 @@ void CCdvdman::LoadState(Framework::CZipArchiveReader& archive)
 	m_discChanged = registerFile.GetRegister32(STATE_DISCCHANGED);
 	m_pendingCommand = static_cast<COMMAND>(registerFile.GetRegister32(STATE_PENDING_COMMAND));
 	m_pendingCommandDelay = registerFile.GetRegister32(STATE_PENDING_COMMAND_DELAY);
+
+	//Data of a read that was pending isn't in the state, read it again
+	uint32 pendingReadSector = registerFile.GetRegister32(STATE_PENDING_READ_SECTOR);
+	uint32 pendingReadSectorCount = registerFile.GetRegister32(STATE_PENDING_READ_SECTOR_COUNT);
+	m_pendingReadBufferPtr = registerFile.GetRegister32(STATE_PENDING_READ_BUFFER);
+	m_pendingRead.reset();
+	m_streamRead.reset();
+	if(m_opticalMedia && (m_pendingCommand == COMMAND_READ) && (pendingReadSectorCount != 0))
+	{
+		m_pendingRead = IssueHostRead(pendingReadSector, pendingReadSectorCount);
+	}
 }
 
 void CCdvdman::SaveState(Framework::CZipArchiveWriter& archive) const
@@ -72,6 +100,9 @@ void CCdvdman::SaveState(Framework::CZipArchiveWriter& archive) const
 	registerFile->SetRegister32(STATE_DISCCHANGED, m_discChanged);
 	registerFile->SetRegister32(STATE_PENDING_COMMAND, m_pendingCommand);
 	registerFile->SetRegister32(STATE_PENDING_COMMAND_DELAY, m_pendingCommandDelay);
+	registerFile->SetRegister32(STATE_PENDING_READ_SECTOR, m_pendingRead ? m_pendingRead->sector : 0);
+	registerFile->SetRegister32(STATE_PENDING_READ_SECTOR_COUNT, m_pendingRead ? m_pendingRead->sectorCount : 0);
+	registerFile->SetRegister32(STATE_PENDING_READ_BUFFER, m_pendingReadBufferPtr);
 	archive.InsertFile(std::move(registerFile));
 }
 
@@ -404,6 +435,11 @@ void CCdvdman::CountTicks(uint32 ticks)
 		m_pendingCommandDelay = std::max<int32>(0, m_pendingCommandDelay - ticks);
 		if(m_pendingCommandDelay == 0)
 		{
+			//Command only completes once its data has arrived, if the host is slower than the emulated drive
+			if((m_pendingCommand == COMMAND_READ) && !CompletePendingRead())
+			{
+				return;
+			}
 			switch(m_pendingCommand)
 			{
 			case COMMAND_READ:
@@ -431,6 +467,9 @@ void CCdvdman::CountTicks(uint32 ticks)
 
 void CCdvdman::SetOpticalMedia(COpticalMedia* opticalMedia)
 {
+	//Host reads use the current media's block provider, make sure they're done with it
+	CancelHostReads();
+	m_streamRead.reset();
 	m_opticalMedia = opticalMedia;
 }
 
@@ -470,16 +509,11 @@ uint32 CCdvdman::CdRead(uint32 startSector, uint32 sectorCount, uint32 bufferPtr
 		//Does that make sure it's 2048 byte mode?
 		assert(mode[2] == 0);
 	}
-	if(m_opticalMedia && (bufferPtr != 0))
+	if(m_opticalMedia && (bufferPtr != 0) && (sectorCount != 0))
 	{
-		uint8* buffer = &m_ram[bufferPtr & (PS2::IOP_RAM_SIZE - 1)];
-		static const uint32 sectorSize = 2048;
-		auto fileSystem = m_opticalMedia->GetFileSystem();
-		for(unsigned int i = 0; i < sectorCount; i++)
-		{
-			fileSystem->ReadBlock(startSector + i, buffer);
-			buffer += sectorSize;
-		}
+		//Host read overlaps with the emulated delay, data is copied to RAM when the command completes
+		m_pendingRead = IssueHostRead(startSector, sectorCount);
+		m_pendingReadBufferPtr = bufferPtr;
 	}
 	m_pendingCommand = COMMAND_READ;
 	m_pendingCommandDelay = COMMAND_READ_BASE_DELAY + (sectorCount * COMMAND_READ_SECTOR_DELAY);
@@ -625,11 +659,32 @@ uint32 CCdvdman::CdStRead(uint32 sectors, uint32 bufPtr, uint32 mode, uint32 err
 {
 	CLog::GetInstance().Print(LOG_NAME, FUNCTION_CDSTREAD "(sectors = %d, bufPtr = 0x%08X, mode = %d, errPtr = 0x%08X);\r\n",
 	                          sectors, bufPtr, mode, errPtr);
-	auto fileSystem = m_opticalMedia->GetFileSystem();
-	for(unsigned int i = 0; i < sectors; i++)
+	static const uint32 sectorSize = 2048;
+	bool prefetched = false;
+	if(m_streamRead && (m_streamRead->sector == m_streamPos) && (m_streamRead->sectorCount >= sectors))
+	{
+		WaitHostRead(m_streamRead);
+		if(!m_streamRead->exception && (m_streamRead->data.size() >= (sectors * sectorSize)))
+		{
+			memcpy(m_ram + bufPtr, m_streamRead->data.data(), sectors * sectorSize);
+			prefetched = true;
+		}
+	}
+	m_streamRead.reset();
+	if(!prefetched)
 	{
-		fileSystem->ReadBlock(m_streamPos, m_ram + (bufPtr + (i * 0x800)));
-		m_streamPos++;
+		//Not prefetched or prefetch failed, read directly to let errors reach the caller
+		auto fileSystem = m_opticalMedia->GetFileSystem();
+		for(unsigned int i = 0; i < sectors; i++)
+		{
+			fileSystem->ReadBlock(m_streamPos + i, m_ram + (bufPtr + (i * sectorSize)));
+		}
+	}
+	m_streamPos += sectors;
+	//Games usually keep streaming the same amount of sectors, get the next ones while these are processed
+	if(sectors != 0)
+	{
+		m_streamRead = IssueHostRead(m_streamPos, sectors);
 	}
 	if(errPtr != 0)
 	{
@@ -729,3 +784,107 @@ uint32 CCdvdman::CdLayerSearchFile(uint32 fileInfoPtr, uint32 namePtr, uint32 la
 	uint32 result = CdLayerSearchFileDirect(m_opticalMedia, fileInfo, name, layer);
 	return result;
 }
+
+CCdvdman::HostReadPtr CCdvdman::IssueHostRead(uint32 sector, uint32 sectorCount)
+{
+	assert(m_opticalMedia);
+	auto hostRead = std::make_shared<HOST_READ>();
+	hostRead->blockProvider = m_opticalMedia->GetTrackBlockProvider(0);
+	hostRead->sector = sector;
+	hostRead->sectorCount = sectorCount;
+
+	{
+		std::lock_guard<std::mutex> lock(m_hostReadMutex);
+		m_hostReadRequests.push_back(hostRead);
+		if(!m_hostReadThread.joinable())
+		{
+			m_hostReadThread = std::thread([this]() { HostReadThreadProc(); });
+			Framework::ThreadUtils::SetThreadName(m_hostReadThread, "Cdvdman Host Read Thread");
+		}
+	}
+	m_hostReadRequestCondition.notify_one();
+
+	return hostRead;
+}
+
+bool CCdvdman::IsHostReadCompleted(const HostReadPtr& hostRead)
+{
+	std::lock_guard<std::mutex> lock(m_hostReadMutex);
+	return hostRead->completed;
+}
+
+void CCdvdman::WaitHostRead(const HostReadPtr& hostRead)
+{
+	std::unique_lock<std::mutex> lock(m_hostReadMutex);
+	m_hostReadCompleteCondition.wait(lock, [&]() { return hostRead->completed; });
+}
+
+void CCdvdman::CancelHostReads()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_hostReadMutex);
+		//Cancelled reads complete without any data
+		for(auto& hostRead : m_hostReadRequests)
+		{
+			hostRead->completed = true;
+		}
+		m_hostReadRequests.clear();
+		m_hostReadCompleteCondition.wait(lock, [this]() { return !m_hostReadBusy; });
+	}
+	m_hostReadCompleteCondition.notify_all();
+}
+
+void CCdvdman::HostReadThreadProc()
+{
+	while(1)
+	{
+		HostReadPtr hostRead;
+
+		{
+			std::unique_lock<std::mutex> lock(m_hostReadMutex);
+			m_hostReadRequestCondition.wait(lock, [this]() { return m_hostReadThreadDone || !m_hostReadRequests.empty(); });
+			if(m_hostReadThreadDone) break;
+			hostRead = m_hostReadRequests.front();
+			m_hostReadRequests.pop_front();
+			m_hostReadBusy = true;
+		}
+
+		//Nobody touches the read's data until it's marked as completed
+		try
+		{
+			hostRead->data.resize(hostRead->sectorCount * ISO9660::CBlockProvider::BLOCKSIZE);
+			hostRead->blockProvider->ReadBlocks(hostRead->sector, hostRead->sectorCount, hostRead->data.data());
+		}
+		catch(...)
+		{
+			hostRead->exception = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_hostReadMutex);
+			hostRead->completed = true;
+			m_hostReadBusy = false;
+		}
+		m_hostReadCompleteCondition.notify_all();
+	}
+}
+
+bool CCdvdman::CompletePendingRead()
+{
+	if(!m_pendingRead) return true;
+	if(!IsHostReadCompleted(m_pendingRead)) return false;
+
+	auto hostRead = std::move(m_pendingRead);
+	m_pendingRead.reset();
+	if(hostRead->exception)
+	{
+		std::rethrow_exception(hostRead->exception);
+	}
+	//Cancelled reads don't have any data
+	if(!hostRead->data.empty())
+	{
+		uint8* buffer = &m_ram[m_pendingReadBufferPtr & (PS2::IOP_RAM_SIZE - 1)];
+		memcpy(buffer, hostRead->data.data(), hostRead->data.size());
+	}
+	return true;
+}
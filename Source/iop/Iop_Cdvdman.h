@@ -1,5 +1,11 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "Iop_Module.h"
 #include "../OpticalMedia.h"
 #include "zip/ZipArchiveWriter.h"
@@ -43,7 +49,7 @@ namespace Iop
 		};
 
 		CCdvdman(CIopBios&, uint8*);
-		virtual ~CCdvdman() = default;
+		virtual ~CCdvdman();
 
 		virtual std::string GetId() const override;
 		virtual std::string GetFunctionName(unsigned int) const override;
@@ -107,6 +113,25 @@ namespace Iop
 		uint32 CdReadDvdDualInfo(uint32, uint32);
 		uint32 CdLayerSearchFile(uint32, uint32, uint32);
 
+		//Sectors read from the disc image on the host read thread
+		struct HOST_READ
+		{
+			ISO9660::CBlockProvider* blockProvider = nullptr;
+			uint32 sector = 0;
+			uint32 sectorCount = 0;
+			std::vector<uint8> data;
+			std::exception_ptr exception;
+			bool completed = false;
+		};
+		typedef std::shared_ptr<HOST_READ> HostReadPtr;
+
+		HostReadPtr IssueHostRead(uint32, uint32);
+		bool IsHostReadCompleted(const HostReadPtr&);
+		void WaitHostRead(const HostReadPtr&);
+		void CancelHostReads();
+		void HostReadThreadProc();
+		bool CompletePendingRead();
+
 		CIopBios& m_bios;
 		COpticalMedia* m_opticalMedia = nullptr;
 		uint8* m_ram = nullptr;
@@ -118,6 +143,18 @@ namespace Iop
 		uint32 m_streamBufferSize = 0;
 		COMMAND m_pendingCommand = COMMAND_NONE;
 		int32 m_pendingCommandDelay = 0;
+
+		HostReadPtr m_pendingRead;
+		uint32 m_pendingReadBufferPtr = 0;
+		HostReadPtr m_streamRead;
+
+		std::mutex m_hostReadMutex;
+		std::condition_variable m_hostReadRequestCondition;
+		std::condition_variable m_hostReadCompleteCondition;
+		std::deque<HostReadPtr> m_hostReadRequests;
+		bool m_hostReadBusy = false;
+		bool m_hostReadThreadDone = false;
+		std::thread m_hostReadThread;
 	};
 
 	typedef std::shared_ptr<CCdvdman> CdvdmanPtr;
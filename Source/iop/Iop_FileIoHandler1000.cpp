@@ -177,7 +177,7 @@ void CFileIoHandler1000::LaunchSeekRequest(uint32* args, uint32 argsSize, uint32
 	m_bios.TriggerCallback(m_trampolineAddr, args[0], args[1], args[2]);
 }
 
-std::pair<bool, int32> CFileIoHandler1000::FinishReadRequest(MODULEDATA* moduleData, uint8* eeRam, int32 result)
+std::pair<bool, int32> CFileIoHandler1000::FinishReadRequest(MODULEDATA* moduleData, CSifManPs2* sifManPs2, int32 result)
 {
 	bool done = false;
 	if(result < 0)
@@ -193,7 +193,7 @@ std::pair<bool, int32> CFileIoHandler1000::FinishReadRequest(MODULEDATA* moduleD
 	}
 	else
 	{
-		memcpy(eeRam + moduleData->eeBufferAddr, moduleData->buffer, result);
+		sifManPs2->WriteEeRam(moduleData->eeBufferAddr, moduleData->buffer, result);
 		moduleData->bytesProcessed += result;
 		moduleData->eeBufferAddr += result;
 		moduleData->size -= result;
@@ -241,11 +241,8 @@ void CFileIoHandler1000::FinishRequest(CMIPS& context)
 	int32 result = context.m_State.nGPR[CMIPS::A0].nV0;
 	auto moduleData = reinterpret_cast<MODULEDATA*>(m_iopRam + m_moduleDataAddr);
 
-	uint8* eeRam = nullptr;
-	if(auto sifManPs2 = dynamic_cast<CSifManPs2*>(&m_sifMan))
-	{
-		eeRam = sifManPs2->GetEeRam();
-	}
+	auto sifManPs2 = dynamic_cast<CSifManPs2*>(&m_sifMan);
+	assert(sifManPs2);
 
 	bool done = false;
 	switch(moduleData->method)
@@ -256,7 +253,7 @@ void CFileIoHandler1000::FinishRequest(CMIPS& context)
 		done = true;
 		break;
 	case METHOD_ID_READ:
-		std::tie(done, result) = FinishReadRequest(moduleData, eeRam, result);
+		std::tie(done, result) = FinishReadRequest(moduleData, sifManPs2, result);
 		break;
 	default:
 		break;
@@ -264,7 +261,7 @@ void CFileIoHandler1000::FinishRequest(CMIPS& context)
 
 	if(done)
 	{
-		*reinterpret_cast<uint32*>(eeRam + moduleData->resultAddr) = result;
+		sifManPs2->WriteEeRam(moduleData->resultAddr, &result, sizeof(int32));
 		m_sifMan.SendCallReply(CFileIo::SIF_MODULE_ID, nullptr);
 		context.m_State.nGPR[CMIPS::V0].nV0 = 0;
 	}
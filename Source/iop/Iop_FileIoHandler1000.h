@@ -4,6 +4,8 @@
 
 namespace Iop
 {
+	class CSifManPs2;
+
 	class CFileIoHandler1000 : public CFileIo::CHandler
 	{
 	public:
@@ -43,7 +45,7 @@ namespace Iop
 		void LaunchReadRequest(uint32*, uint32, uint32*, uint32, uint8*);
 		void LaunchSeekRequest(uint32*, uint32, uint32*, uint32, uint8*);
 
-		std::pair<bool, int32> FinishReadRequest(MODULEDATA*, uint8*, int32);
+		std::pair<bool, int32> FinishReadRequest(MODULEDATA*, CSifManPs2*, int32);
 
 		void ExecuteRequest(CMIPS&);
 		void FinishRequest(CMIPS&);
@@ -132,16 +132,11 @@ void CFileIoHandler2200::SaveState(Framework::CZipArchiveWriter& archive) const
 	}
 }
 
-void CFileIoHandler2200::ProcessCommands(CSifMan* sifMan)
+void CFileIoHandler2200::ProcessCommands(CSifMan*)
 {
 	if(m_pendingReply.valid)
 	{
-		uint8* eeRam = nullptr;
-		if(auto sifManPs2 = dynamic_cast<CSifManPs2*>(sifMan))
-		{
-			eeRam = sifManPs2->GetEeRam();
-		}
-		SendPendingReply(eeRam);
+		SendPendingReply();
 	}
 }
 
@@ -177,7 +172,7 @@ uint32 CFileIoHandler2200::InvokeClose(uint32* args, uint32 argsSize, uint32* re
 	if(m_pendingReply.valid && (m_pendingReply.fileId == command->fd))
 	{
 		assert((fileMode & Ioman::CDevice::OPEN_FLAG_NOWAIT) != 0);
-		SendPendingReply(ram);
+		SendPendingReply();
 		assert(!m_pendingReply.valid);
 		m_pendingReply.SetReply(reply);
 		m_pendingReply.fileId = command->fd;
@@ -215,7 +210,7 @@ uint32 CFileIoHandler2200::InvokeRead(uint32* args, uint32 argsSize, uint32* ret
 	//This can happen in Star Wars: Clone Wars when loading a specific level.
 	if(m_pendingReply.valid && (m_pendingReply.fileId != command->fd))
 	{
-		SendPendingReply(ram);
+		SendPendingReply();
 		assert(!m_pendingReply.valid);
 	}
 
@@ -525,12 +520,14 @@ void CFileIoHandler2200::PrepareGenericReply(uint8* ram, const COMMANDHEADER& he
 	}
 }
 
-void CFileIoHandler2200::SendPendingReply(uint8* ram)
+void CFileIoHandler2200::SendPendingReply()
 {
-	//Send response
+	//Send response, this can happen on the IOP side when the reply was held until a read completed
 	if(m_resultPtr[0] != 0)
 	{
-		memcpy(ram + m_resultPtr[0], m_pendingReply.buffer.data(), m_pendingReply.replySize);
+		auto sifManPs2 = dynamic_cast<CSifManPs2*>(&m_sifMan);
+		assert(sifManPs2);
+		sifManPs2->WriteEeRam(m_resultPtr[0], m_pendingReply.buffer.data(), m_pendingReply.replySize);
 	}
 	SendSifReply();
 	m_pendingReply.valid = false;
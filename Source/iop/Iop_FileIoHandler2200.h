@@ -310,7 +310,7 @@ namespace Iop
 
 		void CopyHeader(REPLYHEADER&, const COMMANDHEADER&);
 		void PrepareGenericReply(uint8*, const COMMANDHEADER&, COMMANDID, uint32);
-		void SendPendingReply(uint8*);
+		void SendPendingReply();
 		void SendSifReply();
 
 		CSifMan& m_sifMan;
@@ -1073,8 +1073,7 @@ void CMcServ::ProceedReadFast(CMIPS& context)
 
 	if(auto sifManPs2 = dynamic_cast<CSifManPs2*>(&m_sifMan))
 	{
-		auto eeRam = sifManPs2->GetEeRam();
-		memcpy(eeRam + moduleData->readFastBufferAddress, cluster, readSize);
+		sifManPs2->WriteEeRam(moduleData->readFastBufferAddress, cluster, readSize);
 	}
 
 	reinterpret_cast<uint32*>(moduleData->rpcBuffer)[3] = readSize;
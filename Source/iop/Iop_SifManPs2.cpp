@@ -48,6 +48,8 @@ void CSifManPs2::SendCallReply(uint32 serverId, const void* returnData)
 
 void CSifManPs2::GetOtherData(uint32 dst, uint32 src, uint32 size)
 {
+	CEeIopSync::CLockScope lockScope(m_sif.GetEeIopSync());
+
 	uint8* srcPtr = m_eeRam + (src & (PS2::EE_RAM_SIZE - 1));
 	uint8* dstPtr = m_iopRam + dst;
 	memcpy(dstPtr, srcPtr, size);
@@ -71,6 +73,8 @@ void CSifManPs2::ExecuteSifDma(uint32 structAddr, uint32 count)
 		return;
 	}
 
+	CEeIopSync::CLockScope lockScope(m_sif.GetEeIopSync());
+
 	auto dmaRegs = reinterpret_cast<const SIFDMAREG*>(m_iopRam + structAddr);
 	for(unsigned int i = 0; i < count; i++)
 	{
@@ -84,8 +88,7 @@ void CSifManPs2::ExecuteSifDma(uint32 structAddr, uint32 count)
 		}
 		else
 		{
-			uint8* dst = m_eeRam + dstAddr;
-			memcpy(dst, src, dmaReg.size);
+			m_sif.WriteEeRam(dstAddr, src, dmaReg.size);
 		}
 	}
 }
@@ -94,3 +97,8 @@ uint8* CSifManPs2::GetEeRam() const
 {
 	return m_eeRam;
 }
+
+void CSifManPs2::WriteEeRam(uint32 address, const void* data, uint32 size)
+{
+	m_sif.WriteEeRam(address, data, size);
+}
@@ -24,6 +24,8 @@ namespace Iop
 		void ExecuteSifDma(uint32, uint32) override;
 
 		uint8* GetEeRam() const;
+		//Modules writing to EE RAM from code running on the IOP side must go through this
+		void WriteEeRam(uint32, const void*, uint32);
 
 	private:
 		CSIF& m_sif;
@@ -1,6 +1,7 @@
 #include <assert.h>
 #include "make_unique.h"
 #include "Iop_Spu2.h"
+#include "Iop_SpuCapture.h"
 #include "../Log.h"
 #include "placeholder_def.h"
 
@@ -41,13 +42,27 @@ CCore* CSpu2::GetCore(unsigned int coreId)
 	return m_core[coreId].get();
 }
 
+void CSpu2::SetCapture(CSpuCapture* capture)
+{
+	m_capture = capture;
+}
+
 uint32 CSpu2::ReadRegister(uint32 address)
 {
+	//Some reads have side effects (ie.: clearing IRQ flags), they need to be replayed too
+	if(m_capture)
+	{
+		m_capture->RecordRegisterRead(address);
+	}
 	return ProcessRegisterAccess(m_readDispatchInfo, address, 0);
 }
 
 uint32 CSpu2::WriteRegister(uint32 address, uint32 value)
 {
+	if(m_capture)
+	{
+		m_capture->RecordRegisterWrite(address, value);
+	}
 	return ProcessRegisterAccess(m_writeDispatchInfo, address, value);
 }
 
@@ -21,6 +21,9 @@ namespace Iop
 		void Reset();
 		Spu2::CCore* GetCore(unsigned int);
 
+		//Records register accesses, needs to be set on both cores too to get a complete capture
+		void SetCapture(CSpuCapture*);
+
 		enum
 		{
 			C_IRQINFO = 0x1F9007C2
@@ -56,6 +59,7 @@ namespace Iop
 		REGISTER_DISPATCH_INFO m_readDispatchInfo;
 		REGISTER_DISPATCH_INFO m_writeDispatchInfo;
 		CorePtr m_core[CORE_NUM];
+		CSpuCapture* m_capture = nullptr;
 	};
 }
 
@@ -4,16 +4,25 @@
 #include <climits>
 #include <algorithm>
 #include "string_format.h"
+#include "SimdDefs.h"
 #include "../Log.h"
 #include "../states/RegisterStateCollectionFile.h"
 #include "../states/RegisterStateUtils.h"
 #include "../states/RegisterStateFile.h"
 #include "Iop_SpuBase.h"
+#include "Iop_SpuCapture.h"
+
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+#include <emmintrin.h>
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+#include <arm_neon.h>
+#endif
 
 using namespace Iop;
 
 #define INIT_SAMPLE_RATE (44100)
-#define PITCH_BASE (0x1000)
+#define PITCH_BASE_BITS (12)
+#define PITCH_BASE (1 << PITCH_BASE_BITS)
 #define TIME_SCALE (0x1000)
 #define RESET_IRQ_ADDR (~0U)
 #define LOG_NAME ("iop_spubase")
@@ -204,6 +213,8 @@ void CSpuBase::Reset()
 	m_reverbWorkAddrStart = 0;
 	m_reverbWorkAddrEnd = 0x80000;
 	m_baseSamplingRate = INIT_SAMPLE_RATE;
+	//Readers lose their destination sampling rate when they're reset
+	m_destinationSamplingRate = 0;
 
 	memset(m_channel, 0, sizeof(m_channel));
 	memset(m_reverb, 0, sizeof(m_reverb));
@@ -325,11 +336,21 @@ bool CSpuBase::IsEnabled() const
 void CSpuBase::SetVolumeAdjust(float volumeAdjust)
 {
 	m_volumeAdjust = volumeAdjust;
+	if(m_capture)
+	{
+		uint32 volumeAdjustBits = 0;
+		memcpy(&volumeAdjustBits, &volumeAdjust, sizeof(volumeAdjustBits));
+		m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_VOLUME_ADJUST, volumeAdjustBits);
+	}
 }
 
 void CSpuBase::SetReverbEnabled(bool enabled)
 {
 	m_reverbEnabled = enabled;
+	if(m_capture)
+	{
+		m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_REVERB_ENABLED, enabled ? 1 : 0);
+	}
 }
 
 uint16 CSpuBase::GetControl() const
@@ -351,15 +372,52 @@ void CSpuBase::SetBaseSamplingRate(uint32 samplingRate)
 {
 	m_baseSamplingRate = samplingRate;
 	m_blockReader.SetBaseSamplingRate(samplingRate);
+	if(m_capture)
+	{
+		m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_BASE_SAMPLING_RATE, samplingRate);
+	}
 }
 
 void CSpuBase::SetDestinationSamplingRate(uint32 samplingRate)
 {
+	m_destinationSamplingRate = samplingRate;
 	m_blockReader.SetDestinationSamplingRate(samplingRate);
 	for(auto& reader : m_reader)
 	{
 		reader.SetDestinationSamplingRate(samplingRate);
 	}
+	if(m_capture)
+	{
+		m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_DESTINATION_SAMPLING_RATE, samplingRate);
+	}
+}
+
+void CSpuBase::SetInterpolationMode(INTERPOLATION_MODE interpolationMode)
+{
+	m_interpolationMode = interpolationMode;
+	for(auto& reader : m_reader)
+	{
+		reader.SetInterpolationMode(interpolationMode);
+	}
+	if(m_capture)
+	{
+		m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_INTERPOLATION_MODE, interpolationMode);
+	}
+}
+
+void CSpuBase::SetCapture(CSpuCapture* capture)
+{
+	m_capture = capture;
+	if(!m_capture) return;
+	//Settings aren't part of the saved state, record them so the capture can be replayed with the same output
+	uint32 volumeAdjustBits = 0;
+	memcpy(&volumeAdjustBits, &m_volumeAdjust, sizeof(volumeAdjustBits));
+	//Destination sampling rate goes first, the block reader can't take a base sampling rate without it
+	m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_DESTINATION_SAMPLING_RATE, m_destinationSamplingRate);
+	m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_BASE_SAMPLING_RATE, m_baseSamplingRate);
+	m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_INTERPOLATION_MODE, m_interpolationMode);
+	m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_VOLUME_ADJUST, volumeAdjustBits);
+	m_capture->RecordSetting(m_spuNumber, CSpuCapture::SETTING_REVERB_ENABLED, m_reverbEnabled ? 1 : 0);
 }
 
 bool CSpuBase::GetIrqPending() const
@@ -552,6 +610,17 @@ void CSpuBase::SetReverbCurrentAddress(uint32 address)
 }
 
 uint32 CSpuBase::ReceiveDma(uint8* buffer, uint32 blockSize, uint32 blockAmount, uint32 direction)
+{
+	uint32 blocksReceived = ReceiveDmaImpl(buffer, blockSize, blockAmount, direction);
+	if(m_capture && (blocksReceived != 0))
+	{
+		//Only what was consumed is recorded, replaying it will consume the same amount
+		m_capture->RecordDma(m_spuNumber, buffer, blockSize, blocksReceived);
+	}
+	return blocksReceived;
+}
+
+uint32 CSpuBase::ReceiveDmaImpl(uint8* buffer, uint32 blockSize, uint32 blockAmount, uint32 direction)
 {
 #ifdef _DEBUG
 	CLog::GetInstance().Print(LOG_NAME, "Receiving DMA transfer to 0x%08X. Size = 0x%08X bytes.\r\n",
@@ -583,10 +652,10 @@ uint32 CSpuBase::ReceiveDma(uint8* buffer, uint32 blockSize, uint32 blockAmount,
 		blockAmount = std::min<uint32>(blockAmount, 0x100);
 		assert((m_ctrl & CONTROL_DMA) == CONTROL_DMA_WRITE);
 		unsigned int blocksTransfered = 0;
-		m_sampleCache->ClearRange(m_transferAddr, blockSize * blockAmount);
 		for(unsigned int i = 0; i < blockAmount; i++)
 		{
 			uint32 copySize = std::min<uint32>(m_ramSize - m_transferAddr, blockSize);
+			m_sampleCache->ClearRange(m_transferAddr, copySize);
 			memcpy(m_ram + m_transferAddr, buffer, copySize);
 			m_transferAddr += blockSize;
 			m_transferAddr &= m_ramSize - 1;
@@ -693,6 +762,11 @@ void CSpuBase::MixSamples(int32 inputSample, int32 volumeLevel, int16* output)
 
 void CSpuBase::Render(int16* samples, unsigned int sampleCount)
 {
+	if(m_capture)
+	{
+		m_capture->RecordRender(m_spuNumber, sampleCount);
+	}
+
 	bool updateReverb = m_reverbEnabled && (m_ctrl & CONTROL_REVERB) && (m_reverbWorkAddrStart < m_reverbWorkAddrEnd);
 	bool irqEnabled = (m_ctrl & CONTROL_IRQ);
 
@@ -701,66 +775,62 @@ void CSpuBase::Render(int16* samples, unsigned int sampleCount)
 	unsigned int ticks = sampleCount / 2;
 	memset(samples, 0, sizeof(int16) * sampleCount);
 
-	for(unsigned int j = 0; j < ticks; j++)
+	//IRQs hit by voices are only reported once all ticks are rendered, rendering by block doesn't change that
+	for(unsigned int blockStart = 0; blockStart < ticks;)
 	{
-		int16 reverbSample[2] = {};
-		//Update channels
-		for(unsigned int i = 0; i < 24; i++)
+		unsigned int blockTicks = std::min<unsigned int>(ticks - blockStart, RENDER_BLOCK_TICKS);
+		if(updateReverb && CanChannelsReadReverbWorkArea())
 		{
-			auto& channel(m_channel[i]);
-			auto& reader(m_reader[i]);
-			if(channel.status == KEY_ON)
-			{
-				reader.SetParamsRead(channel.address, channel.repeat);
-				reader.ClearEndFlag();
-				channel.status = ATTACK;
-				channel.adsrVolume = 0;
-			}
-			else
-			{
-				if(reader.IsDone())
-				{
-					channel.status = STOPPED;
-					channel.adsrVolume = 0;
-					reader.ClearIsDone();
-				}
-				if(reader.DidChangeRepeat() && !channel.repeatSet)
-				{
-					channel.repeat = reader.GetRepeat();
-					reader.ClearDidChangeRepeat();
-				}
-				//Update repeat in case it has been changed externally (needed for FFX)
-				reader.SetRepeat(channel.repeat);
-			}
-
-			int32 readSample = reader.GetSample();
-			channel.current = reader.GetCurrent();
+			//Voices need to see what reverb wrote on the previous tick, go back to rendering tick by tick
+			blockTicks = 1;
+		}
+		RenderBlock(samples + (blockStart * 2), blockTicks, updateReverb, irqEnabled);
+		blockStart += blockTicks;
+	}
 
-			UpdateAdsr(channel);
-			channel.volumeLeftAbs = ComputeChannelVolume(channel.volumeLeft, channel.volumeLeftAbs);
-			channel.volumeRightAbs = ComputeChannelVolume(channel.volumeRight, channel.volumeRightAbs);
+	if(irqEnabled && m_irqWatcher->HasPendingIrq(m_spuNumber))
+	{
+		m_irqPending = true;
+	}
+	m_irqWatcher->ClearIrqPending(m_spuNumber);
 
-			if(readSample == 0) continue;
+	if(m_volumeAdjust != 1.0f)
+	{
+		for(int i = 0; i < sampleCount; i++)
+		{
+			float adjustedSample = static_cast<float>(samplesBase[i]) * m_volumeAdjust;
+			adjustedSample = std::clamp<float>(adjustedSample, SHRT_MIN, SHRT_MAX);
+			samplesBase[i] = static_cast<int16>(adjustedSample);
+		}
+	}
+}
 
-			//Mix in adsrVolume
-			int32 inputSample = (readSample * static_cast<int32>(channel.adsrVolume >> 16)) / static_cast<int32>(MAX_ADSR_VOLUME >> 16);
+void CSpuBase::RenderBlock(int16* samples, unsigned int ticks, bool updateReverb, bool irqEnabled)
+{
+	assert(ticks <= RENDER_BLOCK_TICKS);
 
-			if(inputSample == 0) continue;
+	//Channels are rendered one after the other over the whole block. Each channel's output is
+	//added with saturation in the same order as if we were rendering sample per sample,
+	//which gives exactly the same result.
+	alignas(16) int16 channelSamples[RENDER_BLOCK_TICKS * 2];
+	alignas(16) int16 reverbSamples[RENDER_BLOCK_TICKS * 2] = {};
+	int16* blockSamples = samples;
 
-			int32 volumeLeft = channel.volumeLeftAbs >> 16;
-			int32 volumeRight = channel.volumeRightAbs >> 16;
+	for(unsigned int i = 0; i < MAX_CHANNEL; i++)
+	{
+		if(!RenderChannel(i, channelSamples, ticks)) continue;
 
-			MixSamples(inputSample, volumeLeft, samples + 0);
-			MixSamples(inputSample, volumeRight, samples + 1);
+		MixSamplesSaturate(samples, channelSamples, ticks * 2);
 
-			//Mix in reverb if enabled for this channel
-			if(updateReverb && (m_channelReverb.f & (1 << i)))
-			{
-				MixSamples(inputSample, volumeLeft, reverbSample + 0);
-				MixSamples(inputSample, volumeRight, reverbSample + 1);
-			}
+		//Mix in reverb if enabled for this channel
+		if(updateReverb && (m_channelReverb.f & (1 << i)))
+		{
+			MixSamplesSaturate(reverbSamples, channelSamples, ticks * 2);
 		}
+	}
 
+	for(unsigned int j = 0; j < ticks; j++)
+	{
 		if(!m_blockReader.CanReadSamples() && (m_blockWritePtr == SOUND_INPUT_DATA_SIZE))
 		{
 			//We're ready to consume some data
@@ -800,71 +870,154 @@ void CSpuBase::Render(int16* samples, unsigned int sampleCount)
 			m_core0OutputOffset &= (CORE0_OUTPUT_SIZE - 1);
 		}
 
-		//Update reverb
-		if(updateReverb)
-		{
-			UpdateReverb(reverbSample, samples);
-		}
-
 		samples += 2;
 	}
 
-	if(irqEnabled && m_irqWatcher->HasPendingIrq(m_spuNumber))
+	//Reverb doesn't depend on the output, it can be added once the block is complete
+	if(updateReverb)
 	{
-		m_irqPending = true;
+		REVERB_CONTEXT reverbContext;
+		reverbContext.ram = m_ram;
+		reverbContext.registers = m_reverb;
+		reverbContext.workAddrStart = m_reverbWorkAddrStart;
+		reverbContext.workAddrEnd = m_reverbWorkAddrEnd;
+		reverbContext.currAddr = m_reverbCurrAddr;
+		reverbContext.ticks = m_reverbTicks;
+		ProcessReverb(reverbContext, reverbSamples, blockSamples, ticks);
+		m_reverbCurrAddr = reverbContext.currAddr;
+		m_reverbTicks = reverbContext.ticks;
 	}
-	m_irqWatcher->ClearIrqPending(m_spuNumber);
+}
 
-	if(m_volumeAdjust != 1.0f)
+bool CSpuBase::CanChannelsReadReverbWorkArea() const
+{
+	//Upper bound of what a voice reads in a block: pitch goes up to 4x (a bit more when the destination
+	//sampling rate is lower), ADPCM blocks are 16 bytes for 28 samples and 2 of them are buffered ahead.
+	//Core input areas aren't written while rendering, voices reading them don't need to be checked.
+	static const uint32 maxReadSize = (((RENDER_BLOCK_TICKS * 5) / 28) + 3) * 0x10;
+	auto overlapsWorkArea = [&](uint32 address) {
+		return (address < m_reverbWorkAddrEnd) && ((address + maxReadSize) > m_reverbWorkAddrStart);
+	};
+	for(unsigned int i = 0; i < MAX_CHANNEL; i++)
 	{
-		for(int i = 0; i < sampleCount; i++)
+		const auto& channel(m_channel[i]);
+		const auto& reader(m_reader[i]);
+		//Voices can also jump to their start address (key on) or to their repeat address
+		if(overlapsWorkArea(reader.GetCurrent()) || overlapsWorkArea(reader.GetRepeat()) ||
+		   overlapsWorkArea(channel.address) || overlapsWorkArea(channel.repeat))
 		{
-			float adjustedSample = static_cast<float>(samplesBase[i]) * m_volumeAdjust;
-			adjustedSample = std::clamp<float>(adjustedSample, SHRT_MIN, SHRT_MAX);
-			samplesBase[i] = static_cast<int16>(adjustedSample);
+			return true;
 		}
 	}
+	return false;
 }
 
-uint32 CSpuBase::GetAdsrDelta(unsigned int index) const
+bool CSpuBase::RenderChannel(unsigned int channelIndex, int16* output, unsigned int ticks)
 {
-	return m_adsrLogTable[index + 32];
-}
+	auto& channel(m_channel[channelIndex]);
+	auto& reader(m_reader[channelIndex]);
 
-float CSpuBase::GetReverbSample(uint32 address) const
-{
-	uint32 absoluteAddress = m_reverbCurrAddr + address;
-	while(absoluteAddress >= m_reverbWorkAddrEnd)
+	//A stopped channel stays silent until the next key on, but its reader needs to keep going
+	bool isSilent = (channel.status == STOPPED) && (channel.adsrVolume == 0);
+
+	//Fixed volumes don't depend on the previous value, no need to compute them on every sample
+	bool isVolumeLeftFixed = (channel.volumeLeft.mode.mode == 0);
+	bool isVolumeRightFixed = (channel.volumeRight.mode.mode == 0);
+	if(isVolumeLeftFixed)
 	{
-		absoluteAddress -= m_reverbWorkAddrEnd;
-		absoluteAddress += m_reverbWorkAddrStart;
+		channel.volumeLeftAbs = ComputeChannelVolume(channel.volumeLeft, channel.volumeLeftAbs);
+	}
+	if(isVolumeRightFixed)
+	{
+		channel.volumeRightAbs = ComputeChannelVolume(channel.volumeRight, channel.volumeRightAbs);
 	}
-	return static_cast<float>(*reinterpret_cast<int16*>(m_ram + absoluteAddress));
-}
 
-void CSpuBase::SetReverbSample(uint32 address, float value)
-{
-	uint32 absoluteAddress = m_reverbCurrAddr + address;
-	while(absoluteAddress >= m_reverbWorkAddrEnd)
+	bool hasOutput = false;
+	for(unsigned int j = 0; j < ticks; j++)
 	{
-		absoluteAddress -= m_reverbWorkAddrEnd;
-		absoluteAddress += m_reverbWorkAddrStart;
+		if(channel.status == KEY_ON)
+		{
+			reader.SetParamsRead(channel.address, channel.repeat);
+			reader.ClearEndFlag();
+			channel.status = ATTACK;
+			channel.adsrVolume = 0;
+		}
+		else
+		{
+			if(reader.IsDone())
+			{
+				channel.status = STOPPED;
+				channel.adsrVolume = 0;
+				reader.ClearIsDone();
+			}
+			if(reader.DidChangeRepeat() && !channel.repeatSet)
+			{
+				channel.repeat = reader.GetRepeat();
+				reader.ClearDidChangeRepeat();
+			}
+			//Update repeat in case it has been changed externally (needed for FFX)
+			reader.SetRepeat(channel.repeat);
+		}
+
+		int32 readSample = reader.GetSample();
+		channel.current = reader.GetCurrent();
+
+		if(!isSilent)
+		{
+			UpdateAdsr(channel);
+		}
+		if(!isVolumeLeftFixed)
+		{
+			channel.volumeLeftAbs = ComputeChannelVolume(channel.volumeLeft, channel.volumeLeftAbs);
+		}
+		if(!isVolumeRightFixed)
+		{
+			channel.volumeRightAbs = ComputeChannelVolume(channel.volumeRight, channel.volumeRightAbs);
+		}
+
+		//Mix in adsrVolume
+		int32 inputSample = (readSample * static_cast<int32>(channel.adsrVolume >> 16)) / static_cast<int32>(MAX_ADSR_VOLUME >> 16);
+
+		//Results always fit in 16 bits: input sample and volume are both within 16 bits
+		int32 volumeLeft = channel.volumeLeftAbs >> 16;
+		int32 volumeRight = channel.volumeRightAbs >> 16;
+		output[(j * 2) + 0] = static_cast<int16>((inputSample * volumeLeft) / 0x7FFF);
+		output[(j * 2) + 1] = static_cast<int16>((inputSample * volumeRight) / 0x7FFF);
+		hasOutput |= (inputSample != 0);
 	}
-	value = std::max<float>(value, SHRT_MIN);
-	value = std::min<float>(value, SHRT_MAX);
-	int16 intValue = static_cast<int16>(value);
-	*reinterpret_cast<int16*>(m_ram + absoluteAddress) = intValue;
+
+	return hasOutput;
 }
 
-uint32 CSpuBase::GetReverbOffset(unsigned int registerId) const
+void CSpuBase::MixSamplesSaturate(int16* output, const int16* input, unsigned int sampleCount)
 {
-	return m_reverb[registerId];
+	unsigned int i = 0;
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+	for(; (i + 8) <= sampleCount; i += 8)
+	{
+		__m128i outputValue = _mm_loadu_si128(reinterpret_cast<const __m128i*>(output + i));
+		__m128i inputValue = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_adds_epi16(outputValue, inputValue));
+	}
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+	for(; (i + 8) <= sampleCount; i += 8)
+	{
+		int16x8_t outputValue = vld1q_s16(output + i);
+		int16x8_t inputValue = vld1q_s16(input + i);
+		vst1q_s16(output + i, vqaddq_s16(outputValue, inputValue));
+	}
+#endif
+	for(; i < sampleCount; i++)
+	{
+		int32 resultSample = static_cast<int32>(output[i]) + static_cast<int32>(input[i]);
+		resultSample = std::clamp<int32>(resultSample, SHRT_MIN, SHRT_MAX);
+		output[i] = static_cast<int16>(resultSample);
+	}
 }
 
-float CSpuBase::GetReverbCoef(unsigned int registerId) const
+uint32 CSpuBase::GetAdsrDelta(unsigned int index) const
 {
-	int16 value = static_cast<int16>(m_reverb[registerId]);
-	return static_cast<float>(value) / static_cast<float>(0x8000);
+	return m_adsrLogTable[index + 32];
 }
 
 void CSpuBase::UpdateAdsr(CHANNEL& channel)
@@ -974,141 +1127,227 @@ void CSpuBase::UpdateAdsr(CHANNEL& channel)
 	channel.adsrVolume = static_cast<uint32>(currentAdsrLevel);
 }
 
-void CSpuBase::UpdateReverb(int16 reverbSample[2], int16* samples)
-{
-	//Feed samples to FIR filter
-	if(m_reverbTicks & 1)
-	{
-		//IIR_INPUT_A0 = buffer[IIR_SRC_A0] * IIR_COEF + INPUT_SAMPLE_L * IN_COEF_L;
-		//IIR_INPUT_A1 = buffer[IIR_SRC_A1] * IIR_COEF + INPUT_SAMPLE_R * IN_COEF_R;
-		//IIR_INPUT_B0 = buffer[IIR_SRC_B1] * IIR_COEF + INPUT_SAMPLE_L * IN_COEF_L;
-		//IIR_INPUT_B1 = buffer[IIR_SRC_B0] * IIR_COEF + INPUT_SAMPLE_R * IN_COEF_R;
-
-		float input_sample_l = static_cast<float>(reverbSample[0]) * 0.5f;
-		float input_sample_r = static_cast<float>(reverbSample[1]) * 0.5f;
-
-		float irr_coef = GetReverbCoef(IIR_COEF);
-		float in_coef_l = GetReverbCoef(IN_COEF_L);
-		float in_coef_r = GetReverbCoef(IN_COEF_R);
-
-		float iir_input_a0 = GetReverbSample(GetReverbOffset(IIR_SRC_A0)) * irr_coef + input_sample_l * in_coef_l;
-		float iir_input_a1 = GetReverbSample(GetReverbOffset(IIR_SRC_A1)) * irr_coef + input_sample_r * in_coef_r;
-		float iir_input_b0 = GetReverbSample(GetReverbOffset(IIR_SRC_B1)) * irr_coef + input_sample_l * in_coef_l;
-		float iir_input_b1 = GetReverbSample(GetReverbOffset(IIR_SRC_B0)) * irr_coef + input_sample_r * in_coef_r;
-
-		//IIR_A0 = IIR_INPUT_A0 * IIR_ALPHA + buffer[IIR_DEST_A0] * (1.0 - IIR_ALPHA);
-		//IIR_A1 = IIR_INPUT_A1 * IIR_ALPHA + buffer[IIR_DEST_A1] * (1.0 - IIR_ALPHA);
-		//IIR_B0 = IIR_INPUT_B0 * IIR_ALPHA + buffer[IIR_DEST_B0] * (1.0 - IIR_ALPHA);
-		//IIR_B1 = IIR_INPUT_B1 * IIR_ALPHA + buffer[IIR_DEST_B1] * (1.0 - IIR_ALPHA);
-
-		float iir_alpha = GetReverbCoef(IIR_ALPHA);
-
-		float iir_a0 = iir_input_a0 * iir_alpha + GetReverbSample(GetReverbOffset(IIR_DEST_A0)) * (1.0f - iir_alpha);
-		float iir_a1 = iir_input_a1 * iir_alpha + GetReverbSample(GetReverbOffset(IIR_DEST_A1)) * (1.0f - iir_alpha);
-		float iir_b0 = iir_input_b0 * iir_alpha + GetReverbSample(GetReverbOffset(IIR_DEST_B0)) * (1.0f - iir_alpha);
-		float iir_b1 = iir_input_b1 * iir_alpha + GetReverbSample(GetReverbOffset(IIR_DEST_B1)) * (1.0f - iir_alpha);
-
-		//buffer[IIR_DEST_A0 + 1sample] = IIR_A0;
-		//buffer[IIR_DEST_A1 + 1sample] = IIR_A1;
-		//buffer[IIR_DEST_B0 + 1sample] = IIR_B0;
-		//buffer[IIR_DEST_B1 + 1sample] = IIR_B1;
-
-		SetReverbSample(GetReverbOffset(IIR_DEST_A0) + 2, iir_a0);
-		SetReverbSample(GetReverbOffset(IIR_DEST_A1) + 2, iir_a1);
-		SetReverbSample(GetReverbOffset(IIR_DEST_B0) + 2, iir_b0);
-		SetReverbSample(GetReverbOffset(IIR_DEST_B1) + 2, iir_b1);
-
-		//ACC0 = buffer[ACC_SRC_A0] * ACC_COEF_A +
-		//	   buffer[ACC_SRC_B0] * ACC_COEF_B +
-		//	   buffer[ACC_SRC_C0] * ACC_COEF_C +
-		//	   buffer[ACC_SRC_D0] * ACC_COEF_D;
-		//ACC1 = buffer[ACC_SRC_A1] * ACC_COEF_A +
-		//	   buffer[ACC_SRC_B1] * ACC_COEF_B +
-		//	   buffer[ACC_SRC_C1] * ACC_COEF_C +
-		//	   buffer[ACC_SRC_D1] * ACC_COEF_D;
-
-		float acc_coef_a = GetReverbCoef(ACC_COEF_A);
-		float acc_coef_b = GetReverbCoef(ACC_COEF_B);
-		float acc_coef_c = GetReverbCoef(ACC_COEF_C);
-		float acc_coef_d = GetReverbCoef(ACC_COEF_D);
-
-		float acc0 =
-		    GetReverbSample(GetReverbOffset(ACC_SRC_A0)) * acc_coef_a +
-		    GetReverbSample(GetReverbOffset(ACC_SRC_B0)) * acc_coef_b +
-		    GetReverbSample(GetReverbOffset(ACC_SRC_C0)) * acc_coef_c +
-		    GetReverbSample(GetReverbOffset(ACC_SRC_D0)) * acc_coef_d;
-
-		float acc1 =
-		    GetReverbSample(GetReverbOffset(ACC_SRC_A1)) * acc_coef_a +
-		    GetReverbSample(GetReverbOffset(ACC_SRC_B1)) * acc_coef_b +
-		    GetReverbSample(GetReverbOffset(ACC_SRC_C1)) * acc_coef_c +
-		    GetReverbSample(GetReverbOffset(ACC_SRC_D1)) * acc_coef_d;
-
-		//FB_A0 = buffer[MIX_DEST_A0 - FB_SRC_A];
-		//FB_A1 = buffer[MIX_DEST_A1 - FB_SRC_A];
-		//FB_B0 = buffer[MIX_DEST_B0 - FB_SRC_B];
-		//FB_B1 = buffer[MIX_DEST_B1 - FB_SRC_B];
-
-		float fb_a0 = GetReverbSample(GetReverbOffset(MIX_DEST_A0) - GetReverbOffset(FB_SRC_A));
-		float fb_a1 = GetReverbSample(GetReverbOffset(MIX_DEST_A1) - GetReverbOffset(FB_SRC_A));
-		float fb_b0 = GetReverbSample(GetReverbOffset(MIX_DEST_B0) - GetReverbOffset(FB_SRC_B));
-		float fb_b1 = GetReverbSample(GetReverbOffset(MIX_DEST_B1) - GetReverbOffset(FB_SRC_B));
-
-		//buffer[MIX_DEST_A0] = ACC0 - FB_A0 * FB_ALPHA;
-		//buffer[MIX_DEST_A1] = ACC1 - FB_A1 * FB_ALPHA;
-		//buffer[MIX_DEST_B0] = (FB_ALPHA * ACC0) - FB_A0 * (FB_ALPHA^0x8000) - FB_B0 * FB_X;
-		//buffer[MIX_DEST_B1] = (FB_ALPHA * ACC1) - FB_A1 * (FB_ALPHA^0x8000) - FB_B1 * FB_X;
-
-		float fb_alpha = GetReverbCoef(FB_ALPHA);
-		float fb_x = GetReverbCoef(FB_X);
-
-		SetReverbSample(GetReverbOffset(MIX_DEST_A0), acc0 - fb_a0 * fb_alpha);
-		SetReverbSample(GetReverbOffset(MIX_DEST_A1), acc1 - fb_a1 * fb_alpha);
-		SetReverbSample(GetReverbOffset(MIX_DEST_B0), (fb_alpha * acc0) - fb_a0 * -fb_alpha - fb_b0 * fb_x);
-		SetReverbSample(GetReverbOffset(MIX_DEST_B1), (fb_alpha * acc1) - fb_a1 * -fb_alpha - fb_b1 * fb_x);
-
-		m_reverbCurrAddr += 2;
-		if(m_reverbCurrAddr >= m_reverbWorkAddrEnd)
-		{
-			m_reverbCurrAddr = m_reverbWorkAddrStart;
-		}
+//Computes Saturate(base + (((a0 * b0) + (a1 * b1)) >> 15)) on 4 lanes, like a 16-bit DSP multiply-accumulate.
+//Sum of products wraps around like it does with SIMD multiply-adds.
+static void ReverbMultiplyAccumulate(int16 result[4], const int16 base[4], const int16 a0[4], const int16 b0[4], const int16 a1[4], const int16 b1[4])
+{
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+	__m128i a = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a0)), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a1)));
+	__m128i b = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(b0)), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b1)));
+	__m128i baseValue = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(base));
+	__m128i sum = _mm_srai_epi32(_mm_madd_epi16(a, b), 15);
+	sum = _mm_add_epi32(sum, _mm_srai_epi32(_mm_unpacklo_epi16(baseValue, baseValue), 16));
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(result), _mm_packs_epi32(sum, sum));
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+	int32x4_t sum = vmull_s16(vld1_s16(a0), vld1_s16(b0));
+	sum = vmlaq_s32(sum, vmovl_s16(vld1_s16(a1)), vmovl_s16(vld1_s16(b1)));
+	sum = vaddw_s16(vshrq_n_s32(sum, 15), vld1_s16(base));
+	vst1_s16(result, vqmovn_s32(sum));
+#else
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		uint32 products = static_cast<uint32>(a0[i] * b0[i]) + static_cast<uint32>(a1[i] * b1[i]);
+		int32 sum = base[i] + (static_cast<int32>(products) >> 15);
+		result[i] = static_cast<int16>(std::clamp<int32>(sum, SHRT_MIN, SHRT_MAX));
 	}
+#endif
+}
 
-	if(m_reverbWorkAddrStart != 0)
+void CSpuBase::ProcessReverb(REVERB_CONTEXT& context, const int16* input, int16* output, unsigned int ticks)
+{
+	assert(context.workAddrStart < context.workAddrEnd);
+
+	uint8* ram = context.ram;
+	const uint32* registers = context.registers;
+	uint32 workAddrStart = context.workAddrStart;
+	uint32 workAddrEnd = context.workAddrEnd;
+	uint32 workSize = workAddrEnd - workAddrStart;
+
+	//Registers don't change during a block: wrap all offsets inside the work area once,
+	//accesses only need a single check afterwards
+	auto wrapOffset = [workSize](int64 offset) {
+		offset %= static_cast<int64>(workSize);
+		return static_cast<uint32>((offset < 0) ? (offset + workSize) : offset);
+	};
+	auto getOffset = [&](unsigned int registerId) { return wrapOffset(registers[registerId]); };
+	auto getCoef = [&](unsigned int registerId) { return static_cast<int16>(registers[registerId]); };
+	auto negateCoef = [](int16 coef) { return static_cast<int16>((coef == SHRT_MIN) ? SHRT_MAX : -coef); };
+
+	//Lanes are A0, A1, B0, B1. IIR inputs for B lanes come from the opposite side.
+	const uint32 iirSrcOffsets[4] = {getOffset(IIR_SRC_A0), getOffset(IIR_SRC_A1), getOffset(IIR_SRC_B1), getOffset(IIR_SRC_B0)};
+	const uint32 iirDestOffsets[4] = {getOffset(IIR_DEST_A0), getOffset(IIR_DEST_A1), getOffset(IIR_DEST_B0), getOffset(IIR_DEST_B1)};
+	const uint32 iirNextOffsets[4] =
+	    {
+	        wrapOffset(static_cast<int64>(registers[IIR_DEST_A0]) + 2),
+	        wrapOffset(static_cast<int64>(registers[IIR_DEST_A1]) + 2),
+	        wrapOffset(static_cast<int64>(registers[IIR_DEST_B0]) + 2),
+	        wrapOffset(static_cast<int64>(registers[IIR_DEST_B1]) + 2),
+	    };
+	//Left and right for A/B taps, then left and right for C/D taps
+	const uint32 accSrcOffsets[2][4] =
+	    {
+	        {getOffset(ACC_SRC_A0), getOffset(ACC_SRC_A1), getOffset(ACC_SRC_C0), getOffset(ACC_SRC_C1)},
+	        {getOffset(ACC_SRC_B0), getOffset(ACC_SRC_B1), getOffset(ACC_SRC_D0), getOffset(ACC_SRC_D1)},
+	    };
+	const uint32 mixDestOffsets[4] = {getOffset(MIX_DEST_A0), getOffset(MIX_DEST_A1), getOffset(MIX_DEST_B0), getOffset(MIX_DEST_B1)};
+	const uint32 fbSrcOffsets[4] =
+	    {
+	        wrapOffset(static_cast<int64>(registers[MIX_DEST_A0]) - static_cast<int64>(registers[FB_SRC_A])),
+	        wrapOffset(static_cast<int64>(registers[MIX_DEST_A1]) - static_cast<int64>(registers[FB_SRC_A])),
+	        wrapOffset(static_cast<int64>(registers[MIX_DEST_B0]) - static_cast<int64>(registers[FB_SRC_B])),
+	        wrapOffset(static_cast<int64>(registers[MIX_DEST_B1]) - static_cast<int64>(registers[FB_SRC_B])),
+	    };
+
+	int16 iirCoef = getCoef(IIR_COEF);
+	int16 iirAlpha = getCoef(IIR_ALPHA);
+	int16 fbAlpha = getCoef(FB_ALPHA);
+	int16 fbX = getCoef(FB_X);
+	int16 inCoefL = getCoef(IN_COEF_L);
+	int16 inCoefR = getCoef(IN_COEF_R);
+	int16 accCoefA = getCoef(ACC_COEF_A);
+	int16 accCoefB = getCoef(ACC_COEF_B);
+	int16 accCoefC = getCoef(ACC_COEF_C);
+	int16 accCoefD = getCoef(ACC_COEF_D);
+
+	alignas(8) const int16 zero[4] = {};
+	alignas(8) const int16 iirCoefs[4] = {iirCoef, iirCoef, iirCoef, iirCoef};
+	alignas(8) const int16 inCoefs[4] = {inCoefL, inCoefR, inCoefL, inCoefR};
+	alignas(8) const int16 iirAlphas[4] = {iirAlpha, iirAlpha, iirAlpha, iirAlpha};
+	alignas(8) const int16 iirNegAlphas[4] = {negateCoef(iirAlpha), negateCoef(iirAlpha), negateCoef(iirAlpha), negateCoef(iirAlpha)};
+	alignas(8) const int16 accCoefs[2][4] = {{accCoefA, accCoefA, accCoefC, accCoefC}, {accCoefB, accCoefB, accCoefD, accCoefD}};
+	alignas(8) const int16 fbCoefs0[4] = {negateCoef(fbAlpha), negateCoef(fbAlpha), fbAlpha, fbAlpha};
+	alignas(8) const int16 fbCoefs1[4] = {0, 0, fbAlpha, fbAlpha};
+	alignas(8) const int16 fbCoefs2[4] = {0, 0, negateCoef(fbX), negateCoef(fbX)};
+	alignas(8) const int16 outputCoefs[4] = {0x2AA0, 0x2AA0, 0, 0};
+
+	//Current address can be moved outside of the work area by the registers
+	uint32 currAddr = context.currAddr;
+	if((currAddr < workAddrStart) || (currAddr >= workAddrEnd))
 	{
-		float sampleL = 0.333f * (GetReverbSample(GetReverbOffset(MIX_DEST_A0)) + GetReverbSample(GetReverbOffset(MIX_DEST_B0)));
-		float sampleR = 0.333f * (GetReverbSample(GetReverbOffset(MIX_DEST_A1)) + GetReverbSample(GetReverbOffset(MIX_DEST_B1)));
+		currAddr = workAddrStart;
+	}
+
+	auto getSample = [&](uint32 offset) -> int16& {
+		uint32 address = currAddr + offset;
+		if(address >= workAddrEnd) address -= workSize;
+		return *reinterpret_cast<int16*>(ram + address);
+	};
 
+	for(unsigned int tick = 0; tick < ticks; tick++)
+	{
+		//Reverb runs at half the sampling rate
+		if(context.ticks & 1)
 		{
-			int16* output = samples + 0;
-			int32 resultSample = static_cast<int32>(sampleL) + static_cast<int32>(*output);
-			resultSample = std::max<int32>(resultSample, SHRT_MIN);
-			resultSample = std::min<int32>(resultSample, SHRT_MAX);
-			*output = static_cast<int16>(resultSample);
+			//IIR_INPUT = buffer[IIR_SRC] * IIR_COEF + INPUT_SAMPLE * IN_COEF
+			//IIR = IIR_INPUT * IIR_ALPHA + buffer[IIR_DEST] * (1.0 - IIR_ALPHA)
+			//buffer[IIR_DEST + 1sample] = IIR
+			alignas(8) int16 inputSamples[4];
+			alignas(8) int16 iirSrc[4];
+			alignas(8) int16 iirDest[4];
+			for(unsigned int i = 0; i < 4; i++)
+			{
+				inputSamples[i] = input[(tick * 2) + (i & 1)] >> 1;
+				iirSrc[i] = getSample(iirSrcOffsets[i]);
+				iirDest[i] = getSample(iirDestOffsets[i]);
+			}
+			alignas(8) int16 iirInput[4];
+			alignas(8) int16 iir[4];
+			ReverbMultiplyAccumulate(iirInput, zero, iirSrc, iirCoefs, inputSamples, inCoefs);
+			ReverbMultiplyAccumulate(iir, iirDest, iirInput, iirAlphas, iirDest, iirNegAlphas);
+			for(unsigned int i = 0; i < 4; i++)
+			{
+				getSample(iirNextOffsets[i]) = iir[i];
+			}
+
+			//ACC = buffer[ACC_SRC_A] * ACC_COEF_A + buffer[ACC_SRC_B] * ACC_COEF_B +
+			//      buffer[ACC_SRC_C] * ACC_COEF_C + buffer[ACC_SRC_D] * ACC_COEF_D
+			alignas(8) int16 accSrc[2][4];
+			for(unsigned int i = 0; i < 4; i++)
+			{
+				accSrc[0][i] = getSample(accSrcOffsets[0][i]);
+				accSrc[1][i] = getSample(accSrcOffsets[1][i]);
+			}
+			alignas(8) int16 accParts[4];
+			ReverbMultiplyAccumulate(accParts, zero, accSrc[0], accCoefs[0], accSrc[1], accCoefs[1]);
+			int16 acc[2] =
+			    {
+			        static_cast<int16>(std::clamp<int32>(accParts[0] + accParts[2], SHRT_MIN, SHRT_MAX)),
+			        static_cast<int16>(std::clamp<int32>(accParts[1] + accParts[3], SHRT_MIN, SHRT_MAX)),
+			    };
+
+			//buffer[MIX_DEST_A] = ACC - FB_A * FB_ALPHA
+			//buffer[MIX_DEST_B] = (FB_ALPHA * ACC) + FB_A * FB_ALPHA - FB_B * FB_X
+			//with FB_A = buffer[MIX_DEST_A - FB_SRC_A] and FB_B = buffer[MIX_DEST_B - FB_SRC_B]
+			alignas(8) int16 fb[4];
+			for(unsigned int i = 0; i < 4; i++)
+			{
+				fb[i] = getSample(fbSrcOffsets[i]);
+			}
+			alignas(8) const int16 mixBase[4] = {acc[0], acc[1], 0, 0};
+			alignas(8) const int16 mixSrc0[4] = {fb[0], fb[1], acc[0], acc[1]};
+			alignas(8) const int16 mixSrc1[4] = {0, 0, fb[0], fb[1]};
+			alignas(8) const int16 mixSrc2[4] = {0, 0, fb[2], fb[3]};
+			alignas(8) int16 mix[4];
+			ReverbMultiplyAccumulate(mix, mixBase, mixSrc0, fbCoefs0, mixSrc1, fbCoefs1);
+			ReverbMultiplyAccumulate(mix, mix, mixSrc2, fbCoefs2, zero, zero);
+			for(unsigned int i = 0; i < 4; i++)
+			{
+				getSample(mixDestOffsets[i]) = mix[i];
+			}
+
+			currAddr += 2;
+			if(currAddr >= workAddrEnd)
+			{
+				currAddr = workAddrStart;
+			}
 		}
 
+		if(workAddrStart != 0)
 		{
-			int16* output = samples + 1;
-			int32 resultSample = static_cast<int32>(sampleR) + static_cast<int32>(*output);
-			resultSample = std::max<int32>(resultSample, SHRT_MIN);
-			resultSample = std::min<int32>(resultSample, SHRT_MAX);
-			*output = static_cast<int16>(resultSample);
+			//OUTPUT = (buffer[MIX_DEST_A] + buffer[MIX_DEST_B]) / 3
+			alignas(8) int16 outputSamples[4] = {output[(tick * 2) + 0], output[(tick * 2) + 1], 0, 0};
+			alignas(8) const int16 mixA[4] = {getSample(mixDestOffsets[0]), getSample(mixDestOffsets[1]), 0, 0};
+			alignas(8) const int16 mixB[4] = {getSample(mixDestOffsets[2]), getSample(mixDestOffsets[3]), 0, 0};
+			ReverbMultiplyAccumulate(outputSamples, outputSamples, mixA, outputCoefs, mixB, outputCoefs);
+			output[(tick * 2) + 0] = outputSamples[0];
+			output[(tick * 2) + 1] = outputSamples[1];
 		}
+
+		context.ticks++;
 	}
 
-	m_reverbTicks++;
+	context.currAddr = currAddr;
 }
 
 ///////////////////////////////////////////////////////
 // CSpuSampleCache
 ///////////////////////////////////////////////////////
 
-const CSpuSampleCache::ITEM* CSpuSampleCache::GetItem(const KEY& key) const
+CSpuSampleCache::CSpuSampleCache()
+    : m_sets(std::make_unique<SET[]>(SET_COUNT))
 {
-	auto range = m_cache.equal_range(key.address);
-	for(auto itemIterator = range.first; itemIterator != range.second; itemIterator++)
+	Clear();
+}
+
+const CSpuSampleCache::ITEM* CSpuSampleCache::GetItem(const KEY& key)
+{
+	//Blocks might not be aligned, check both RAM blocks covered by this one
+	uint32 firstBlock = key.address >> BLOCK_SIZE_BITS;
+	uint32 lastBlock = (key.address + (1 << BLOCK_SIZE_BITS) - 1) >> BLOCK_SIZE_BITS;
+	assert(lastBlock <= BLOCK_COUNT);
+	for(uint32 block = firstBlock; (block <= lastBlock) && (block < BLOCK_COUNT); block++)
 	{
-		const auto& item = itemIterator->second;
+		if(m_dirtyBlocks[block / 64] & (1ULL << (block % 64)))
+		{
+			FlushDirtyBlock(block);
+		}
+	}
+
+	const auto& set = m_sets[GetSetIndex(firstBlock)];
+	for(unsigned int way = 0; way < WAY_COUNT; way++)
+	{
+		if(set.addresses[way] != key.address) continue;
+		const auto& item = set.items[way];
 		if((item.inS1 == key.s1) && (item.inS2 == key.s2))
 		{
 			return &item;
@@ -1119,8 +1358,19 @@ const CSpuSampleCache::ITEM* CSpuSampleCache::GetItem(const KEY& key) const
 
 CSpuSampleCache::ITEM& CSpuSampleCache::RegisterItem(const KEY& key)
 {
-	auto result = m_cache.emplace(std::make_pair(key.address, ITEM()));
-	auto& item = result->second;
+	auto& set = m_sets[GetSetIndex(key.address >> BLOCK_SIZE_BITS)];
+	unsigned int way = 0;
+	for(; way < WAY_COUNT; way++)
+	{
+		if(set.addresses[way] == INVALID_ADDRESS) break;
+	}
+	if(way == WAY_COUNT)
+	{
+		way = set.nextWay;
+		set.nextWay = (set.nextWay + 1) % WAY_COUNT;
+	}
+	set.addresses[way] = key.address;
+	auto& item = set.items[way];
 	item.inS1 = key.s1;
 	item.inS2 = key.s2;
 	return item;
@@ -1128,14 +1378,68 @@ CSpuSampleCache::ITEM& CSpuSampleCache::RegisterItem(const KEY& key)
 
 void CSpuSampleCache::Clear()
 {
-	m_cache.clear();
+	for(unsigned int i = 0; i < SET_COUNT; i++)
+	{
+		auto& set = m_sets[i];
+		for(unsigned int way = 0; way < WAY_COUNT; way++)
+		{
+			set.addresses[way] = INVALID_ADDRESS;
+		}
+		set.nextWay = 0;
+	}
+	memset(m_dirtyBlocks, 0, sizeof(m_dirtyBlocks));
 }
 
 void CSpuSampleCache::ClearRange(uint32 address, uint32 size)
 {
-	auto lowerBound = m_cache.lower_bound(address);
-	auto upperBound = m_cache.upper_bound(address + size);
-	m_cache.erase(lowerBound, upperBound);
+	//Only mark blocks here, entries are flushed when they're looked up
+	if(size == 0) return;
+	uint32 firstBlock = address >> BLOCK_SIZE_BITS;
+	uint32 lastBlock = std::min<uint32>((address + size - 1) >> BLOCK_SIZE_BITS, BLOCK_COUNT - 1);
+	uint32 block = firstBlock;
+	while(block <= lastBlock)
+	{
+		uint32 bitIndex = block % 64;
+		uint32 bitCount = std::min<uint32>(64 - bitIndex, lastBlock - block + 1);
+		uint64 mask = (bitCount == 64) ? ~0ULL : (((1ULL << bitCount) - 1) << bitIndex);
+		m_dirtyBlocks[block / 64] |= mask;
+		block += bitCount;
+	}
+}
+
+unsigned int CSpuSampleCache::GetSetIndex(uint32 block)
+{
+	return block & (SET_COUNT - 1);
+}
+
+void CSpuSampleCache::FlushDirtyBlock(uint32 block)
+{
+	//Remove entries starting in this block and unaligned ones from the previous block that overlap it
+	uint32 blockAddress = block << BLOCK_SIZE_BITS;
+	{
+		auto& set = m_sets[GetSetIndex(block)];
+		for(unsigned int way = 0; way < WAY_COUNT; way++)
+		{
+			if((set.addresses[way] >> BLOCK_SIZE_BITS) == block)
+			{
+				set.addresses[way] = INVALID_ADDRESS;
+			}
+		}
+	}
+	if(block != 0)
+	{
+		auto& set = m_sets[GetSetIndex(block - 1)];
+		for(unsigned int way = 0; way < WAY_COUNT; way++)
+		{
+			uint32 address = set.addresses[way];
+			if(address == INVALID_ADDRESS) continue;
+			if(((address >> BLOCK_SIZE_BITS) == (block - 1)) && ((address + (1 << BLOCK_SIZE_BITS)) > blockAddress))
+			{
+				set.addresses[way] = INVALID_ADDRESS;
+			}
+		}
+	}
+	m_dirtyBlocks[block / 64] &= ~(1ULL << (block % 64));
 }
 
 ///////////////////////////////////////////////////////
@@ -1210,6 +1514,7 @@ void CSpuBase::CSampleReader::Reset()
 	m_nextSampleAddr = 0;
 	m_repeatAddr = 0;
 	memset(m_buffer, 0, sizeof(m_buffer));
+	memset(m_history, 0, sizeof(m_history));
 	m_pitch = 0;
 	m_srcSampleIdx = 0;
 	m_srcSamplingRate = 0;
@@ -1246,6 +1551,11 @@ void CSpuBase::CSampleReader::SetDestinationSamplingRate(uint32 samplingRate)
 	UpdateSampleStep();
 }
 
+void CSpuBase::CSampleReader::SetInterpolationMode(INTERPOLATION_MODE interpolationMode)
+{
+	m_interpolationMode = interpolationMode;
+}
+
 void CSpuBase::CSampleReader::LoadState(const CRegisterState& channelState)
 {
 	m_srcSampleIdx = channelState.GetRegister32(STATE_SAMPLEREADER_REGS_SRCSAMPLEIDX);
@@ -1302,6 +1612,7 @@ void CSpuBase::CSampleReader::SetParamsNoRead(uint32 address, uint32 repeat)
 {
 	SetParams(address, repeat);
 	memset(m_buffer, 0, sizeof(m_buffer));
+	memset(m_history, 0, sizeof(m_history));
 }
 
 void CSpuBase::CSampleReader::SetPitch(uint32 baseSamplingRate, uint16 pitch)
@@ -1314,10 +1625,18 @@ int32 CSpuBase::CSampleReader::GetSample()
 {
 	uint32 srcSampleIdx = m_srcSampleIdx / PITCH_BASE;
 	int32 srcSampleAlpha = m_srcSampleIdx % PITCH_BASE;
-	int32 currentSample = m_buffer[srcSampleIdx];
-	int32 nextSample = m_buffer[srcSampleIdx + 1];
-	int32 resultSample = (currentSample * (PITCH_BASE - srcSampleAlpha) / PITCH_BASE) +
-	                     (nextSample * srcSampleAlpha / PITCH_BASE);
+	int32 resultSample = 0;
+	if(m_interpolationMode == INTERPOLATION_SINC)
+	{
+		resultSample = GetSincSample(srcSampleIdx, srcSampleAlpha);
+	}
+	else
+	{
+		int32 currentSample = m_buffer[srcSampleIdx];
+		int32 nextSample = m_buffer[srcSampleIdx + 1];
+		resultSample = (currentSample * (PITCH_BASE - srcSampleAlpha) / PITCH_BASE) +
+		               (nextSample * srcSampleAlpha / PITCH_BASE);
+	}
 	m_srcSampleIdx += m_sampleStep;
 	if(srcSampleIdx >= BUFFER_SAMPLES)
 	{
@@ -1331,17 +1650,38 @@ void CSpuBase::CSampleReader::AdvanceBuffer()
 {
 	if(m_nextValid)
 	{
+		memcpy(m_history, m_buffer + BUFFER_SAMPLES - CSpuResampler::HISTORY_SAMPLES, sizeof(m_history));
 		memmove(m_buffer, m_buffer + BUFFER_SAMPLES, sizeof(int16) * BUFFER_SAMPLES);
 		UnpackSamples(m_buffer + BUFFER_SAMPLES);
 	}
 	else
 	{
+		memset(m_history, 0, sizeof(m_history));
 		UnpackSamples(m_buffer);
 		UnpackSamples(m_buffer + BUFFER_SAMPLES);
 		m_nextValid = true;
 	}
 }
 
+int32 CSpuBase::CSampleReader::GetSincSample(uint32 srcSampleIdx, uint32 srcSampleAlpha) const
+{
+	static_assert(PITCH_BASE_BITS >= CSpuResampler::PHASE_BITS, "Pitch precision is too low for the resampler's phase count.");
+	assert((srcSampleIdx + CSpuResampler::TAP_COUNT - CSpuResampler::HISTORY_SAMPLES) <= (BUFFER_SAMPLES * 2));
+	unsigned int phase = srcSampleAlpha >> (PITCH_BASE_BITS - CSpuResampler::PHASE_BITS);
+	if(srcSampleIdx >= CSpuResampler::HISTORY_SAMPLES)
+	{
+		return CSpuResampler::Interpolate(m_buffer + srcSampleIdx - CSpuResampler::HISTORY_SAMPLES, phase);
+	}
+	//Window starts in the previous block
+	int16 samples[CSpuResampler::TAP_COUNT];
+	for(unsigned int i = 0; i < CSpuResampler::TAP_COUNT; i++)
+	{
+		int32 sampleIdx = static_cast<int32>(srcSampleIdx + i) - CSpuResampler::HISTORY_SAMPLES;
+		samples[i] = (sampleIdx < 0) ? m_history[CSpuResampler::HISTORY_SAMPLES + sampleIdx] : m_buffer[sampleIdx];
+	}
+	return CSpuResampler::Interpolate(samples, phase);
+}
+
 void CSpuBase::CSampleReader::UpdateSampleStep()
 {
 	m_sampleStep = m_srcSamplingRate / m_dstSamplingRate;
@@ -1349,14 +1689,11 @@ void CSpuBase::CSampleReader::UpdateSampleStep()
 
 void CSpuBase::CSampleReader::UnpackSamples(int16* dst)
 {
-	int32 workBuffer[BUFFER_SAMPLES];
-
 	const uint8* nextSample = m_ram + m_nextSampleAddr;
 
 	m_irqWatcher->CheckIrq(m_nextSampleAddr);
 
 	//Read header
-	uint8 shiftFactor = nextSample[0] & 0xF;
 	uint8 predictNumber = nextSample[0] >> 4;
 	uint8 flags = nextSample[1];
 	assert(predictNumber < 5);
@@ -1376,55 +1713,12 @@ void CSpuBase::CSampleReader::UnpackSamples(int16* dst)
 	}
 	else
 	{
-		//Get intermediate values
-		{
-			unsigned int workBufferPtr = 0;
-			for(unsigned int i = 2; i < 16; i++)
-			{
-				uint8 sampleByte = nextSample[i];
-				int16 firstSample = ((sampleByte & 0x0F) << 12);
-				int16 secondSample = ((sampleByte & 0xF0) << 8);
-				firstSample >>= shiftFactor;
-				secondSample >>= shiftFactor;
-				workBuffer[workBufferPtr++] = firstSample;
-				workBuffer[workBufferPtr++] = secondSample;
-			}
-		}
+		DecodeSamples(dst, nextSample, m_s1, m_s2);
 
-		//Generate PCM samples
-		{
-			// clang-format off
-			//Table is 16 entries long to prevent reading indeterminate
-			//values if predictNumber is greater or equal to 5.
-			//According to some sources, entries at 5 and beyond contain 0 on real hardware
-			static const int32 predictorTable[16][2] =
-			{
-				{0, 0},
-				{60, 0},
-				{115, -52},
-				{98, -55},
-				{122, -60},
-			};
-			// clang-format on
-
-			for(unsigned int i = 0; i < BUFFER_SAMPLES; i++)
-			{
-				int32 currentValue = workBuffer[i] * 64;
-				currentValue += (m_s1 * predictorTable[predictNumber][0]) / 64;
-				currentValue += (m_s2 * predictorTable[predictNumber][1]) / 64;
-				m_s2 = m_s1;
-				m_s1 = currentValue;
-				int32 result = (currentValue + 32) / 64;
-				result = std::max<int32>(result, SHRT_MIN);
-				result = std::min<int32>(result, SHRT_MAX);
-				dst[i] = static_cast<int16>(result);
-			}
-
-			auto& cacheItem = m_sampleCache->RegisterItem(cacheKey);
-			memcpy(&cacheItem.samples, dst, sizeof(int16) * BUFFER_SAMPLES);
-			cacheItem.outS1 = m_s1;
-			cacheItem.outS2 = m_s2;
-		}
+		auto& newCacheItem = m_sampleCache->RegisterItem(cacheKey);
+		memcpy(&newCacheItem.samples, dst, sizeof(int16) * BUFFER_SAMPLES);
+		newCacheItem.outS1 = m_s1;
+		newCacheItem.outS2 = m_s2;
 	}
 
 	if(flags & 0x04)
@@ -1450,6 +1744,137 @@ void CSpuBase::CSampleReader::UnpackSamples(int16* dst)
 	}
 }
 
+void CSpuBase::CSampleReader::DecodeSamples(int16* dst, const uint8* block, int32& s1, int32& s2)
+{
+	uint8 shiftFactor = block[0] & 0xF;
+	uint8 predictNumber = block[0] >> 4;
+
+	//Get intermediate values
+	alignas(16) int16 workBuffer[32];
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+	{
+		//Skip header and split every byte in two nibbles, low nibble first
+		__m128i data = _mm_srli_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), 2);
+		__m128i nibbleMask = _mm_set1_epi8(0x0F);
+		__m128i lo = _mm_and_si128(data, nibbleMask);
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(data, 4), nibbleMask);
+		__m128i nibbles0 = _mm_unpacklo_epi8(lo, hi);
+		__m128i nibbles1 = _mm_unpackhi_epi8(lo, hi);
+		//Move nibbles to the top of 16-bit lanes and shift them back with sign extension
+		__m128i shift = _mm_cvtsi32_si128(shiftFactor);
+		__m128i zero = _mm_setzero_si128();
+		for(unsigned int i = 0; i < 2; i++)
+		{
+			__m128i nibbles = (i == 0) ? nibbles0 : nibbles1;
+			__m128i values0 = _mm_slli_epi16(_mm_unpacklo_epi8(zero, nibbles), 4);
+			__m128i values1 = _mm_slli_epi16(_mm_unpackhi_epi8(zero, nibbles), 4);
+			_mm_store_si128(reinterpret_cast<__m128i*>(workBuffer + (i * 16) + 0), _mm_sra_epi16(values0, shift));
+			_mm_store_si128(reinterpret_cast<__m128i*>(workBuffer + (i * 16) + 8), _mm_sra_epi16(values1, shift));
+		}
+	}
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+	{
+		//Skip header and split every byte in two nibbles, low nibble first
+		uint8x16_t data = vextq_u8(vld1q_u8(block), vdupq_n_u8(0), 2);
+		uint8x16_t lo = vandq_u8(data, vdupq_n_u8(0x0F));
+		uint8x16_t hi = vshrq_n_u8(data, 4);
+		uint8x16x2_t nibbles = vzipq_u8(lo, hi);
+		//Move nibbles to the top of 16-bit lanes and shift them back with sign extension
+		int16x8_t shift = vdupq_n_s16(-static_cast<int16>(shiftFactor));
+		for(unsigned int i = 0; i < 2; i++)
+		{
+			int16x8_t values0 = vreinterpretq_s16_u16(vshlq_n_u16(vmovl_u8(vget_low_u8(nibbles.val[i])), 12));
+			int16x8_t values1 = vreinterpretq_s16_u16(vshlq_n_u16(vmovl_u8(vget_high_u8(nibbles.val[i])), 12));
+			vst1q_s16(workBuffer + (i * 16) + 0, vshlq_s16(values0, shift));
+			vst1q_s16(workBuffer + (i * 16) + 8, vshlq_s16(values1, shift));
+		}
+	}
+#else
+	{
+		unsigned int workBufferPtr = 0;
+		for(unsigned int i = 2; i < 16; i++)
+		{
+			uint8 sampleByte = block[i];
+			int16 firstSample = ((sampleByte & 0x0F) << 12);
+			int16 secondSample = ((sampleByte & 0xF0) << 8);
+			firstSample >>= shiftFactor;
+			secondSample >>= shiftFactor;
+			workBuffer[workBufferPtr++] = firstSample;
+			workBuffer[workBufferPtr++] = secondSample;
+		}
+	}
+#endif
+
+	//Generate PCM samples
+	{
+		// clang-format off
+		//Table is 16 entries long to prevent reading indeterminate
+		//values if predictNumber is greater or equal to 5.
+		//According to some sources, entries at 5 and beyond contain 0 on real hardware
+		static const int32 predictorTable[16][2] =
+		{
+			{0, 0},
+			{60, 0},
+			{115, -52},
+			{98, -55},
+			{122, -60},
+		};
+		// clang-format on
+
+		//Filter is recursive, only the final scaling can be done in parallel
+		alignas(16) int32 filtered[32];
+		int32 predictor0 = predictorTable[predictNumber][0];
+		int32 predictor1 = predictorTable[predictNumber][1];
+		for(unsigned int i = 0; i < BUFFER_SAMPLES; i++)
+		{
+			int32 currentValue = static_cast<int32>(workBuffer[i]) * 64;
+			currentValue += (s1 * predictor0) / 64;
+			currentValue += (s2 * predictor1) / 64;
+			s2 = s1;
+			s1 = currentValue;
+			filtered[i] = currentValue;
+		}
+
+		unsigned int i = 0;
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+		{
+			//(value + 32) / 64, rounding towards zero, then saturate to 16 bits
+			__m128i roundBias = _mm_set1_epi32(32);
+			__m128i divideBias = _mm_set1_epi32(63);
+			for(; (i + 8) <= BUFFER_SAMPLES; i += 8)
+			{
+				__m128i values0 = _mm_add_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(filtered + i + 0)), roundBias);
+				__m128i values1 = _mm_add_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(filtered + i + 4)), roundBias);
+				values0 = _mm_srai_epi32(_mm_add_epi32(values0, _mm_and_si128(_mm_srai_epi32(values0, 31), divideBias)), 6);
+				values1 = _mm_srai_epi32(_mm_add_epi32(values1, _mm_and_si128(_mm_srai_epi32(values1, 31), divideBias)), 6);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(values0, values1));
+			}
+		}
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+		{
+			//(value + 32) / 64, rounding towards zero, then saturate to 16 bits
+			int32x4_t roundBias = vdupq_n_s32(32);
+			int32x4_t divideBias = vdupq_n_s32(63);
+			for(; (i + 8) <= BUFFER_SAMPLES; i += 8)
+			{
+				int32x4_t values0 = vaddq_s32(vld1q_s32(filtered + i + 0), roundBias);
+				int32x4_t values1 = vaddq_s32(vld1q_s32(filtered + i + 4), roundBias);
+				values0 = vshrq_n_s32(vaddq_s32(values0, vandq_s32(vshrq_n_s32(values0, 31), divideBias)), 6);
+				values1 = vshrq_n_s32(vaddq_s32(values1, vandq_s32(vshrq_n_s32(values1, 31), divideBias)), 6);
+				vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(values0), vqmovn_s32(values1)));
+			}
+		}
+#endif
+		for(; i < BUFFER_SAMPLES; i++)
+		{
+			int32 result = (filtered[i] + 32) / 64;
+			result = std::max<int32>(result, SHRT_MIN);
+			result = std::min<int32>(result, SHRT_MAX);
+			dst[i] = static_cast<int16>(result);
+		}
+	}
+}
+
 uint32 CSpuBase::CSampleReader::GetRepeat() const
 {
 	return m_repeatAddr;
@@ -1,16 +1,21 @@
 #pragma once
 
-#include <map>
+#include <memory>
 #include "Types.h"
 #include "BasicUnion.h"
 #include "Convertible.h"
 #include "zip/ZipArchiveWriter.h"
 #include "zip/ZipArchiveReader.h"
+#include "Iop_SpuResampler.h"
 
 class CRegisterState;
 
 namespace Iop
 {
+	class CSpuCapture;
+
+	//Keeps decoded ADPCM blocks around, indexed by SPU RAM block number.
+	//Blocks map to a set with a few ways, lookups and invalidations are O(1).
 	class CSpuSampleCache
 	{
 	public:
@@ -32,13 +37,40 @@ namespace Iop
 			int32 outS2;
 		};
 
-		const ITEM* GetItem(const KEY&) const;
+		CSpuSampleCache();
+
+		const ITEM* GetItem(const KEY&);
 		ITEM& RegisterItem(const KEY&);
 		void Clear();
 		void ClearRange(uint32 address, uint32 size);
 
 	private:
-		std::multimap<uint32, ITEM> m_cache;
+		enum
+		{
+			//PSP has 4MB of sound RAM
+			MAX_RAM_SIZE = 0x400000,
+			BLOCK_SIZE_BITS = 4,
+			BLOCK_COUNT = (MAX_RAM_SIZE >> BLOCK_SIZE_BITS),
+			SET_COUNT_BITS = 12,
+			SET_COUNT = (1 << SET_COUNT_BITS),
+			WAY_COUNT = 4,
+			INVALID_ADDRESS = ~0U,
+		};
+
+		struct alignas(64) SET
+		{
+			uint32 addresses[WAY_COUNT];
+			ITEM items[WAY_COUNT];
+			uint32 nextWay;
+		};
+
+		static unsigned int GetSetIndex(uint32);
+		void FlushDirtyBlock(uint32);
+
+		std::unique_ptr<SET[]> m_sets;
+
+		//Blocks written to since their entries were last flushed
+		uint64 m_dirtyBlocks[BLOCK_COUNT / 64];
 	};
 
 	class CSpuIrqWatcher
@@ -189,6 +221,22 @@ namespace Iop
 			RELEASE,
 		};
 
+		enum INTERPOLATION_MODE
+		{
+			INTERPOLATION_LINEAR,
+			INTERPOLATION_SINC,
+		};
+
+		struct REVERB_CONTEXT
+		{
+			uint8* ram = nullptr;
+			const uint32* registers = nullptr;
+			uint32 workAddrStart = 0;
+			uint32 workAddrEnd = 0;
+			uint32 currAddr = 0;
+			uint32 ticks = 0;
+		};
+
 		struct CHANNEL
 		{
 			CHANNEL_VOLUME volumeLeft;
@@ -221,6 +269,10 @@ namespace Iop
 
 		void SetBaseSamplingRate(uint32);
 		void SetDestinationSamplingRate(uint32);
+		void SetInterpolationMode(INTERPOLATION_MODE);
+
+		//Records render calls, DMA transfers and setting changes, current settings are recorded right away
+		void SetCapture(CSpuCapture*);
 
 		bool GetIrqPending() const;
 		void ClearIrqPending();
@@ -272,6 +324,10 @@ namespace Iop
 
 		void Render(int16*, unsigned int);
 
+		//Runs reverb over a block of ticks. Input and output are interleaved stereo samples,
+		//reverb output is added to the output samples.
+		static void ProcessReverb(REVERB_CONTEXT&, const int16*, int16*, unsigned int);
+
 		static bool g_reverbParamIsAddress[REVERB_PARAM_COUNT];
 
 	private:
@@ -299,6 +355,7 @@ namespace Iop
 			void SetSampleCache(CSpuSampleCache*);
 			void SetIrqWatcher(CSpuIrqWatcher*);
 			void SetDestinationSamplingRate(uint32);
+			void SetInterpolationMode(INTERPOLATION_MODE);
 
 			void LoadState(const CRegisterState&);
 			void SaveState(CRegisterState&) const;
@@ -323,8 +380,10 @@ namespace Iop
 
 			void SetParams(uint32, uint32);
 			void UnpackSamples(int16*);
+			static void DecodeSamples(int16*, const uint8*, int32&, int32&);
 			void AdvanceBuffer();
 			void UpdateSampleStep();
+			int32 GetSincSample(uint32, uint32) const;
 
 			uint8* m_ram = nullptr;
 			uint32 m_ramSize = 0;
@@ -338,6 +397,9 @@ namespace Iop
 			uint32 m_nextSampleAddr = 0;
 			uint32 m_repeatAddr = 0;
 			int16 m_buffer[BUFFER_SAMPLES * 2];
+			//Last samples of the previous block, only used by sinc interpolation
+			int16 m_history[CSpuResampler::HISTORY_SAMPLES];
+			INTERPOLATION_MODE m_interpolationMode = INTERPOLATION_LINEAR;
 			uint16 m_pitch;
 			int32 m_s1;
 			int32 m_s2;
@@ -377,15 +439,20 @@ namespace Iop
 			MAX_ADSR_VOLUME = 0x7FFFFFFF,
 		};
 
+		enum
+		{
+			RENDER_BLOCK_TICKS = 64,
+		};
+
+		uint32 ReceiveDmaImpl(uint8*, uint32, uint32, uint32);
+		void RenderBlock(int16*, unsigned int, bool, bool);
+		bool CanChannelsReadReverbWorkArea() const;
+		bool RenderChannel(unsigned int, int16*, unsigned int);
 		void UpdateAdsr(CHANNEL&);
-		void UpdateReverb(int16[2], int16*);
 		uint32 GetAdsrDelta(unsigned int) const;
-		float GetReverbSample(uint32) const;
-		void SetReverbSample(uint32, float);
-		uint32 GetReverbOffset(unsigned int) const;
-		float GetReverbCoef(unsigned int) const;
 
 		static void MixSamples(int32, int32, int16*);
+		static void MixSamplesSaturate(int16*, const int16*, unsigned int);
 		int32 ComputeChannelVolume(const CHANNEL_VOLUME&, int32);
 
 		static const uint32 g_linearIncreaseSweepDeltas[0x80];
@@ -395,6 +462,8 @@ namespace Iop
 		uint32 m_ramSize;
 		unsigned int m_spuNumber;
 		uint32 m_baseSamplingRate;
+		uint32 m_destinationSamplingRate = 0;
+		INTERPOLATION_MODE m_interpolationMode = INTERPOLATION_LINEAR;
 
 		uint32 m_irqAddr = 0;
 		bool m_irqPending = false;
@@ -411,6 +480,7 @@ namespace Iop
 		uint32 m_reverb[REVERB_REG_COUNT];
 		CSpuSampleCache* m_sampleCache = nullptr;
 		CSpuIrqWatcher* m_irqWatcher = nullptr;
+		CSpuCapture* m_capture = nullptr;
 		CHANNEL m_channel[MAX_CHANNEL];
 		CSampleReader m_reader[MAX_CHANNEL];
 		uint32 m_adsrLogTable[160];
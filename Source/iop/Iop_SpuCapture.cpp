@@ -0,0 +1,297 @@
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include "Iop_SpuCapture.h"
+#include "Iop_SpuBase.h"
+#include "MemStream.h"
+#include "PtrStream.h"
+#include "zip/ZipArchiveWriter.h"
+#include "zip/ZipArchiveReader.h"
+#include "../states/MemoryStateFile.h"
+#include "../states/RegisterStateFile.h"
+
+#define STATE_INFO "info"
+#define STATE_INITIAL_SPURAM "init/spuram"
+#define STATE_INITIAL_SPUSTATE "init/spustate"
+#define STATE_EVENTS "events"
+
+#define STATE_INFO_VERSION "version"
+
+using namespace Iop;
+
+static constexpr uint32 g_captureVersion = 1;
+
+void CSpuCapture::Reset()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_initialState.clear();
+	m_initialRam.clear();
+	m_events.clear();
+	m_currentTime = 0;
+	m_lastEventTime = 0;
+}
+
+void CSpuCapture::Read(Framework::CStream& input)
+{
+	Reset();
+
+	Framework::CZipArchiveReader archive(input);
+
+	{
+		CRegisterStateFile registerFile(*archive.BeginReadFile(STATE_INFO));
+		uint32 version = registerFile.GetRegister32(STATE_INFO_VERSION);
+		if(version != g_captureVersion)
+		{
+			throw std::runtime_error("Unsupported SPU capture version.");
+		}
+	}
+
+	auto readFile =
+	    [&archive](const char* fileName, std::vector<uint8>& contents) {
+		    auto fileHeader = archive.GetFileHeader(fileName);
+		    if(!fileHeader)
+		    {
+			    throw std::runtime_error("SPU capture is missing a file.");
+		    }
+		    contents.resize(fileHeader->uncompressedSize);
+		    archive.BeginReadFile(fileName)->Read(contents.data(), contents.size());
+	    };
+
+	readFile(STATE_INITIAL_SPURAM, m_initialRam);
+	readFile(STATE_INITIAL_SPUSTATE, m_initialState);
+	readFile(STATE_EVENTS, m_events);
+}
+
+void CSpuCapture::Write(Framework::CStream& output) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Framework::CZipArchiveWriter archive;
+
+	{
+		auto infoFile = std::make_unique<CRegisterStateFile>(STATE_INFO);
+		infoFile->SetRegister32(STATE_INFO_VERSION, g_captureVersion);
+		archive.InsertFile(std::move(infoFile));
+	}
+
+	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_INITIAL_SPURAM, m_initialRam.data(), m_initialRam.size()));
+	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_INITIAL_SPUSTATE, m_initialState.data(), m_initialState.size()));
+	//Terminate the event stream so readers don't need to rely on the file size
+	std::vector<uint8> events(m_events);
+	events.push_back(EVENT_END);
+	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_EVENTS, events.data(), events.size()));
+
+	archive.Write(output);
+}
+
+void CSpuCapture::SaveInitialState(const uint8* ram, uint32 ramSize, CSpuBase& core0, CSpuBase& core1, CSpuIrqWatcher& irqWatcher)
+{
+	Reset();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_initialRam.assign(ram, ram + ramSize);
+
+	//Cores and IRQ watcher already know how to serialize themselves in a save state, keep that in a nested archive
+	Framework::CZipArchiveWriter archive;
+	irqWatcher.SaveState(archive);
+	core0.SaveState(archive);
+	core1.SaveState(archive);
+
+	Framework::CMemStream stateStream;
+	archive.Write(stateStream);
+	m_initialState.assign(stateStream.GetBuffer(), stateStream.GetBuffer() + stateStream.GetSize());
+}
+
+void CSpuCapture::LoadInitialState(uint8* ram, uint32 ramSize, CSpuBase& core0, CSpuBase& core1, CSpuIrqWatcher& irqWatcher) const
+{
+	if(ramSize != m_initialRam.size())
+	{
+		throw std::runtime_error("SPU capture RAM size doesn't match.");
+	}
+
+	memcpy(ram, m_initialRam.data(), ramSize);
+
+	//Settings recorded when the capture started come first, readers need a destination sampling rate before loading their state
+	{
+		size_t position = 0;
+		EVENT event;
+		while(ReadEvent(position, event) && (event.type == EVENT_SETTING))
+		{
+			ApplySetting((event.coreId == 0) ? core0 : core1, static_cast<SETTING>(event.address), event.value);
+		}
+	}
+
+	Framework::CPtrStream stateStream(m_initialState.data(), m_initialState.size());
+	Framework::CZipArchiveReader archive(stateStream);
+	irqWatcher.LoadState(archive);
+	core0.LoadState(archive);
+	core1.LoadState(archive);
+}
+
+uint32 CSpuCapture::GetRamSize() const
+{
+	return static_cast<uint32>(m_initialRam.size());
+}
+
+void CSpuCapture::AddTicks(uint32 ticks)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_currentTime += ticks;
+}
+
+void CSpuCapture::RecordRegisterRead(uint32 address)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	BeginEvent(EVENT_REGISTER_READ);
+	WriteVarInt(address);
+}
+
+void CSpuCapture::RecordRegisterWrite(uint32 address, uint32 value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	BeginEvent(EVENT_REGISTER_WRITE);
+	WriteVarInt(address);
+	WriteVarInt(value);
+}
+
+void CSpuCapture::RecordDma(unsigned int coreId, const uint8* buffer, uint32 blockSize, uint32 blockCount)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	BeginEvent(EVENT_DMA);
+	WriteVarInt(coreId);
+	WriteVarInt(blockSize);
+	WriteVarInt(blockCount);
+	m_events.insert(m_events.end(), buffer, buffer + (blockSize * blockCount));
+}
+
+void CSpuCapture::RecordRender(unsigned int coreId, unsigned int sampleCount)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	BeginEvent(EVENT_RENDER);
+	WriteVarInt(coreId);
+	WriteVarInt(sampleCount);
+}
+
+void CSpuCapture::RecordSetting(unsigned int coreId, SETTING setting, uint32 value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	BeginEvent(EVENT_SETTING);
+	WriteVarInt(coreId);
+	WriteVarInt(setting);
+	WriteVarInt(value);
+}
+
+bool CSpuCapture::ReadEvent(size_t& position, EVENT& event) const
+{
+	if(position >= m_events.size()) return false;
+	auto type = static_cast<EVENT_TYPE>(m_events[position++]);
+	if(type == EVENT_END) return false;
+
+	uint64 timestamp = event.timestamp + ReadVarInt(m_events, position);
+	event = EVENT();
+	event.type = type;
+	event.timestamp = timestamp;
+	switch(type)
+	{
+	case EVENT_REGISTER_READ:
+		event.address = static_cast<uint32>(ReadVarInt(m_events, position));
+		break;
+	case EVENT_REGISTER_WRITE:
+		event.address = static_cast<uint32>(ReadVarInt(m_events, position));
+		event.value = static_cast<uint32>(ReadVarInt(m_events, position));
+		break;
+	case EVENT_DMA:
+	{
+		event.coreId = static_cast<uint32>(ReadVarInt(m_events, position));
+		event.blockSize = static_cast<uint32>(ReadVarInt(m_events, position));
+		event.blockCount = static_cast<uint32>(ReadVarInt(m_events, position));
+		size_t dataSize = static_cast<size_t>(event.blockSize) * event.blockCount;
+		if((m_events.size() - position) < dataSize)
+		{
+			throw std::runtime_error("SPU capture DMA event is truncated.");
+		}
+		event.data = m_events.data() + position;
+		position += dataSize;
+	}
+	break;
+	case EVENT_RENDER:
+		event.coreId = static_cast<uint32>(ReadVarInt(m_events, position));
+		event.value = static_cast<uint32>(ReadVarInt(m_events, position));
+		break;
+	case EVENT_SETTING:
+		event.coreId = static_cast<uint32>(ReadVarInt(m_events, position));
+		event.address = static_cast<uint32>(ReadVarInt(m_events, position));
+		event.value = static_cast<uint32>(ReadVarInt(m_events, position));
+		break;
+	default:
+		throw std::runtime_error("Unknown SPU capture event type.");
+	}
+	return true;
+}
+
+void CSpuCapture::ApplySetting(CSpuBase& core, SETTING setting, uint32 value)
+{
+	switch(setting)
+	{
+	case SETTING_BASE_SAMPLING_RATE:
+		core.SetBaseSamplingRate(value);
+		break;
+	case SETTING_DESTINATION_SAMPLING_RATE:
+		core.SetDestinationSamplingRate(value);
+		break;
+	case SETTING_INTERPOLATION_MODE:
+		core.SetInterpolationMode(static_cast<CSpuBase::INTERPOLATION_MODE>(value));
+		break;
+	case SETTING_VOLUME_ADJUST:
+	{
+		float volumeAdjust = 0;
+		static_assert(sizeof(volumeAdjust) == sizeof(value), "float must be 32 bits wide.");
+		memcpy(&volumeAdjust, &value, sizeof(value));
+		core.SetVolumeAdjust(volumeAdjust);
+	}
+	break;
+	case SETTING_REVERB_ENABLED:
+		core.SetReverbEnabled(value != 0);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+void CSpuCapture::BeginEvent(EVENT_TYPE type)
+{
+	m_events.push_back(static_cast<uint8>(type));
+	WriteVarInt(m_currentTime - m_lastEventTime);
+	m_lastEventTime = m_currentTime;
+}
+
+void CSpuCapture::WriteVarInt(uint64 value)
+{
+	//LEB128, most values (addresses, deltas, sample counts) fit in 1 to 3 bytes
+	while(value >= 0x80)
+	{
+		m_events.push_back(static_cast<uint8>(value | 0x80));
+		value >>= 7;
+	}
+	m_events.push_back(static_cast<uint8>(value));
+}
+
+uint64 CSpuCapture::ReadVarInt(const std::vector<uint8>& buffer, size_t& position)
+{
+	uint64 value = 0;
+	unsigned int shift = 0;
+	while(true)
+	{
+		if((position >= buffer.size()) || (shift >= 64))
+		{
+			throw std::runtime_error("SPU capture event stream is truncated.");
+		}
+		uint8 byte = buffer[position++];
+		value |= static_cast<uint64>(byte & 0x7F) << shift;
+		if((byte & 0x80) == 0) break;
+		shift += 7;
+	}
+	return value;
+}
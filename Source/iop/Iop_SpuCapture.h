@@ -0,0 +1,90 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include "Types.h"
+#include "Stream.h"
+
+namespace Iop
+{
+	class CSpuBase;
+	class CSpuIrqWatcher;
+
+	//Records everything that affects SPU output (register accesses, DMA transfers, render calls and settings)
+	//along with the SPU's state when recording started. This allows rendering the same audio again without
+	//running the emulated program. Events are kept in memory until the capture is written.
+	class CSpuCapture
+	{
+	public:
+		enum EVENT_TYPE
+		{
+			EVENT_END = 0,
+			EVENT_REGISTER_READ,
+			EVENT_REGISTER_WRITE,
+			EVENT_DMA,
+			EVENT_RENDER,
+			EVENT_SETTING,
+		};
+
+		enum SETTING
+		{
+			SETTING_BASE_SAMPLING_RATE,
+			SETTING_DESTINATION_SAMPLING_RATE,
+			SETTING_INTERPOLATION_MODE,
+			SETTING_VOLUME_ADJUST,
+			SETTING_REVERB_ENABLED,
+		};
+
+		struct EVENT
+		{
+			EVENT_TYPE type = EVENT_END;
+			//IOP cycles since the start of the capture
+			uint64 timestamp = 0;
+			uint32 coreId = 0;
+			//Register address or setting id
+			uint32 address = 0;
+			//Register or setting value, sample count for render events
+			uint32 value = 0;
+			uint32 blockSize = 0;
+			uint32 blockCount = 0;
+			const uint8* data = nullptr;
+		};
+
+		void Reset();
+
+		void Read(Framework::CStream&);
+		void Write(Framework::CStream&) const;
+
+		void SaveInitialState(const uint8*, uint32, CSpuBase&, CSpuBase&, CSpuIrqWatcher&);
+		void LoadInitialState(uint8*, uint32, CSpuBase&, CSpuBase&, CSpuIrqWatcher&) const;
+		uint32 GetRamSize() const;
+
+		void AddTicks(uint32);
+
+		void RecordRegisterRead(uint32);
+		void RecordRegisterWrite(uint32, uint32);
+		void RecordDma(unsigned int, const uint8*, uint32, uint32);
+		void RecordRender(unsigned int, unsigned int);
+		void RecordSetting(unsigned int, SETTING, uint32);
+
+		//Goes through events one after the other, position starts at 0 and the same event needs to be
+		//passed on every call since timestamps are stored as deltas. Returns false when all events were read.
+		//DMA event data points inside the capture and remains valid until it is modified.
+		bool ReadEvent(size_t&, EVENT&) const;
+
+		static void ApplySetting(CSpuBase&, SETTING, uint32);
+
+	private:
+		void BeginEvent(EVENT_TYPE);
+		void WriteVarInt(uint64);
+		static uint64 ReadVarInt(const std::vector<uint8>&, size_t&);
+
+		std::vector<uint8> m_initialState;
+		std::vector<uint8> m_initialRam;
+		std::vector<uint8> m_events;
+		uint64 m_currentTime = 0;
+		uint64 m_lastEventTime = 0;
+		//Render events come from the SPU render thread while ticks and accesses come from the IOP
+		mutable std::mutex m_mutex;
+	};
+}
@@ -0,0 +1,142 @@
+#include <cassert>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+#include "SimdDefs.h"
+#include "Iop_SpuResampler.h"
+
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+#include <emmintrin.h>
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace Iop;
+
+const CSpuResampler::COEF_TABLE CSpuResampler::g_coefTable;
+
+CSpuResampler::COEF_TABLE::COEF_TABLE()
+{
+	static const double pi = 3.14159265358979323846;
+	static const double halfWidth = TAP_COUNT / 2;
+	for(unsigned int phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		double fraction = static_cast<double>(phase) / static_cast<double>(PHASE_COUNT);
+		double taps[TAP_COUNT];
+		double tapSum = 0;
+		for(unsigned int tap = 0; tap < TAP_COUNT; tap++)
+		{
+			//Distance between the tap's sample and the interpolated position
+			double x = static_cast<double>(tap) - (HISTORY_SAMPLES + fraction);
+			double sinc = (x == 0) ? 1.0 : sin(pi * x) / (pi * x);
+			double window = 0.42 + (0.5 * cos(pi * x / halfWidth)) + (0.08 * cos(2 * pi * x / halfWidth));
+			taps[tap] = sinc * window;
+			tapSum += taps[tap];
+		}
+
+		//Normalize so that each phase has unity gain, rounding errors go in the largest tap
+		int32 coefSum = 0;
+		unsigned int largestTap = 0;
+		for(unsigned int tap = 0; tap < TAP_COUNT; tap++)
+		{
+			int32 coef = static_cast<int32>(lround(taps[tap] * (1 << COEF_SHIFT) / tapSum));
+			coefs[phase][tap] = static_cast<int16>(coef);
+			coefSum += coef;
+			if(std::abs(taps[tap]) > std::abs(taps[largestTap]))
+			{
+				largestTap = tap;
+			}
+		}
+		coefs[phase][largestTap] += static_cast<int16>((1 << COEF_SHIFT) - coefSum);
+	}
+}
+
+int32 CSpuResampler::Interpolate(const int16* samples, unsigned int phase)
+{
+	assert(phase < PHASE_COUNT);
+	const int16* coefs = g_coefTable.coefs[phase];
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+	static_assert(TAP_COUNT == 8, "SIMD implementation expects 8 taps.");
+	__m128i sampleValues = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+	__m128i coefValues = _mm_load_si128(reinterpret_cast<const __m128i*>(coefs));
+	__m128i products = _mm_madd_epi16(sampleValues, coefValues);
+	products = _mm_add_epi32(products, _mm_shuffle_epi32(products, _MM_SHUFFLE(1, 0, 3, 2)));
+	products = _mm_add_epi32(products, _mm_shuffle_epi32(products, _MM_SHUFFLE(2, 3, 0, 1)));
+	int32 result = _mm_cvtsi128_si32(products);
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+	static_assert(TAP_COUNT == 8, "SIMD implementation expects 8 taps.");
+	int16x8_t sampleValues = vld1q_s16(samples);
+	int16x8_t coefValues = vld1q_s16(coefs);
+	int32x4_t products = vmull_s16(vget_low_s16(sampleValues), vget_low_s16(coefValues));
+	products = vmlal_s16(products, vget_high_s16(sampleValues), vget_high_s16(coefValues));
+	int32x2_t sums = vadd_s32(vget_low_s32(products), vget_high_s32(products));
+	int32 result = vget_lane_s32(vpadd_s32(sums, sums), 0);
+#else
+	int32 result = 0;
+	for(unsigned int tap = 0; tap < TAP_COUNT; tap++)
+	{
+		result += static_cast<int32>(samples[tap]) * static_cast<int32>(coefs[tap]);
+	}
+#endif
+	result = (result + (1 << (COEF_SHIFT - 1))) >> COEF_SHIFT;
+	return std::clamp<int32>(result, SHRT_MIN, SHRT_MAX);
+}
+
+void CSpuResampler::Reset()
+{
+	//Start with silence in the history, output is delayed by a few samples
+	for(auto& input : m_input)
+	{
+		input.assign(HISTORY_SAMPLES, 0);
+	}
+	m_position = 0;
+}
+
+void CSpuResampler::SetSamplingRates(uint32 srcSamplingRate, uint32 dstSamplingRate)
+{
+	assert(dstSamplingRate != 0);
+	m_step = (static_cast<uint64>(srcSamplingRate) << POSITION_BITS) / dstSamplingRate;
+}
+
+void CSpuResampler::Process(std::vector<int16>& output, const int16* samples, unsigned int sampleCount)
+{
+	assert(m_step != 0);
+	assert((sampleCount % CHANNEL_COUNT) == 0);
+	if(m_input[0].empty())
+	{
+		Reset();
+	}
+
+	unsigned int frameCount = sampleCount / CHANNEL_COUNT;
+	for(unsigned int channel = 0; channel < CHANNEL_COUNT; channel++)
+	{
+		auto& input = m_input[channel];
+		size_t inputOffset = input.size();
+		input.resize(inputOffset + frameCount);
+		for(unsigned int i = 0; i < frameCount; i++)
+		{
+			input[inputOffset + i] = samples[(i * CHANNEL_COUNT) + channel];
+		}
+	}
+
+	size_t inputFrameCount = m_input[0].size();
+	while(1)
+	{
+		size_t inputIndex = static_cast<size_t>(m_position >> POSITION_BITS);
+		if((inputIndex + TAP_COUNT) > inputFrameCount) break;
+		unsigned int phase = static_cast<unsigned int>(m_position >> (POSITION_BITS - PHASE_BITS)) & (PHASE_COUNT - 1);
+		for(unsigned int channel = 0; channel < CHANNEL_COUNT; channel++)
+		{
+			output.push_back(static_cast<int16>(Interpolate(m_input[channel].data() + inputIndex, phase)));
+		}
+		m_position += m_step;
+	}
+
+	//Drop frames that won't be used anymore
+	size_t consumedFrameCount = std::min<size_t>(static_cast<size_t>(m_position >> POSITION_BITS), inputFrameCount);
+	for(auto& input : m_input)
+	{
+		input.erase(input.begin(), input.begin() + consumedFrameCount);
+	}
+	m_position -= (static_cast<uint64>(consumedFrameCount) << POSITION_BITS);
+}
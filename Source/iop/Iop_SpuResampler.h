@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include "Types.h"
+
+namespace Iop
+{
+	//Windowed-sinc polyphase filter, used to interpolate SPU voices and to convert
+	//the final mix to the host's output rate.
+	class CSpuResampler
+	{
+	public:
+		enum
+		{
+			TAP_COUNT = 8,
+			//Number of taps before the interpolated position
+			HISTORY_SAMPLES = (TAP_COUNT / 2) - 1,
+			PHASE_BITS = 8,
+			PHASE_COUNT = (1 << PHASE_BITS),
+			COEF_SHIFT = 14,
+		};
+
+		//Interpolates in between samples[HISTORY_SAMPLES] and samples[HISTORY_SAMPLES + 1],
+		//phase goes from 0 to PHASE_COUNT - 1. Reads TAP_COUNT samples.
+		static int32 Interpolate(const int16*, unsigned int);
+
+		void Reset();
+		void SetSamplingRates(uint32, uint32);
+
+		//Converts interleaved stereo samples and appends the results to the output
+		void Process(std::vector<int16>&, const int16*, unsigned int);
+
+	private:
+		struct COEF_TABLE
+		{
+			COEF_TABLE();
+
+			alignas(16) int16 coefs[PHASE_COUNT][TAP_COUNT];
+		};
+
+		enum
+		{
+			CHANNEL_COUNT = 2,
+			POSITION_BITS = 32,
+		};
+
+		static const COEF_TABLE g_coefTable;
+
+		std::vector<int16> m_input[CHANNEL_COUNT];
+		uint64 m_position = 0;
+		uint64 m_step = 0;
+	};
+}
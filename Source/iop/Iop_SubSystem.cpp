@@ -80,8 +80,16 @@ CSubSystem::CSubSystem(bool ps2Mode)
 	m_cpu.m_pCOP[0] = &m_copScu;
 	m_cpu.m_pAddrTranslator = &CMIPS::TranslateAddress64;
 
-	m_dmac.SetReceiveFunction(CDmac::CHANNEL_SPU0, std::bind(&CSpuBase::ReceiveDma, &m_spuCore0, PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
-	m_dmac.SetReceiveFunction(CDmac::CHANNEL_SPU1, std::bind(&CSpuBase::ReceiveDma, &m_spuCore1, PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
+	m_dmac.SetReceiveFunction(CDmac::CHANNEL_SPU0,
+	                          [this](uint8* buffer, uint32 blockSize, uint32 blockAmount, uint32 direction) {
+		                          SyncSpu();
+		                          return m_spuCore0.ReceiveDma(buffer, blockSize, blockAmount, direction);
+	                          });
+	m_dmac.SetReceiveFunction(CDmac::CHANNEL_SPU1,
+	                          [this](uint8* buffer, uint32 blockSize, uint32 blockAmount, uint32 direction) {
+		                          SyncSpu();
+		                          return m_spuCore1.ReceiveDma(buffer, blockSize, blockAmount, direction);
+	                          });
 	m_dmac.SetReceiveFunction(CDmac::CHANNEL_DEV9, std::bind(&CSpeed::ReceiveDma, &m_speed, PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
 	m_dmac.SetReceiveFunction(CDmac::CHANNEL_SIO2in, std::bind(&CSio2::ReceiveDmaIn, &m_sio2, PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
 	m_dmac.SetReceiveFunction(CDmac::CHANNEL_SIO2out, std::bind(&CSio2::ReceiveDmaOut, &m_sio2, PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
@@ -109,8 +117,50 @@ void CSubSystem::NotifyVBlankEnd()
 	m_intc.AssertLine(Iop::CIntc::LINE_EVBLANK);
 }
 
+void CSubSystem::SetSpuRenderThread(CSpuRenderThread* spuRenderThread)
+{
+	m_spuRenderThread = spuRenderThread;
+}
+
+void CSubSystem::SyncSpu()
+{
+	if(m_spuRenderThread)
+	{
+		m_spuRenderThread->Sync();
+	}
+}
+
+void CSubSystem::StartSpuCapture()
+{
+	SyncSpu();
+	DetachSpuCapture();
+	m_spuCapture = std::make_unique<CSpuCapture>();
+	m_spuCapture->SaveInitialState(m_spuRam, SPU_RAM_SIZE, m_spuCore0, m_spuCore1, m_spuIrqWatcher);
+	m_spuCore0.SetCapture(m_spuCapture.get());
+	m_spuCore1.SetCapture(m_spuCapture.get());
+	m_spu2.SetCapture(m_spuCapture.get());
+	m_spuCaptureActive = true;
+}
+
+std::unique_ptr<CSpuCapture> CSubSystem::StopSpuCapture()
+{
+	SyncSpu();
+	DetachSpuCapture();
+	return std::move(m_spuCapture);
+}
+
+void CSubSystem::DetachSpuCapture()
+{
+	//Keeps what was recorded until now, replaying past this point wouldn't make sense
+	m_spuCore0.SetCapture(nullptr);
+	m_spuCore1.SetCapture(nullptr);
+	m_spu2.SetCapture(nullptr);
+	m_spuCaptureActive = false;
+}
+
 void CSubSystem::SaveState(Framework::CZipArchiveWriter& archive)
 {
+	SyncSpu();
 	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_CPU, &m_cpu.m_State, sizeof(MIPSSTATE)));
 	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_RAM, m_ram, IOP_RAM_SIZE));
 	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_SCRATCH, m_scratchPad, IOP_SCRATCH_SIZE));
@@ -138,6 +188,8 @@ void CSubSystem::SaveState(Framework::CZipArchiveWriter& archive)
 
 void CSubSystem::LoadState(Framework::CZipArchiveReader& archive)
 {
+	SyncSpu();
+	DetachSpuCapture();
 	m_bios->PreLoadState();
 
 	//Read and check differences in memory to invalidate executor blocks only if necessary
@@ -182,6 +234,8 @@ void CSubSystem::LoadState(Framework::CZipArchiveReader& archive)
 
 void CSubSystem::Reset()
 {
+	SyncSpu();
+	DetachSpuCapture();
 	memset(m_ram, 0, IOP_RAM_SIZE);
 	memset(m_scratchPad, 0, IOP_SCRATCH_SIZE);
 	memset(m_spuRam, 0, SPU_RAM_SIZE);
@@ -233,6 +287,7 @@ uint32 CSubSystem::ReadIoRegister(uint32 address)
 	}
 	else if(address >= CSpu::SPU_BEGIN && address <= CSpu::SPU_END)
 	{
+		SyncSpu();
 		return m_spu.ReadRegister(address);
 	}
 	else if(
@@ -260,6 +315,7 @@ uint32 CSubSystem::ReadIoRegister(uint32 address)
 #endif
 	else if(address >= CSpu2::REGS_BEGIN && address <= CSpu2::REGS_END)
 	{
+		SyncSpu();
 		return m_spu2.ReadRegister(address);
 	}
 	else if((address >= 0x1F801000 && address <= 0x1F801020) || (address >= 0x1F801400 && address <= 0x1F801420))
@@ -289,6 +345,7 @@ uint32 CSubSystem::WriteIoRegister(uint32 address, uint32 value)
 {
 	if(address >= CSpu::SPU_BEGIN && address <= CSpu::SPU_END)
 	{
+		SyncSpu();
 		m_spu.WriteRegister(address, static_cast<uint16>(value));
 	}
 	else if(
@@ -316,6 +373,7 @@ uint32 CSubSystem::WriteIoRegister(uint32 address, uint32 value)
 #endif
 	else if(address >= CSpu2::REGS_BEGIN && address <= CSpu2::REGS_END)
 	{
+		SyncSpu();
 		return m_spu2.WriteRegister(address, value);
 	}
 	else if((address >= 0x1F801000 && address <= 0x1F801020) || (address >= 0x1F801400 && address <= 0x1F801420))
@@ -373,6 +431,10 @@ void CSubSystem::CountTicks(int ticks)
 	m_counters.Update(ticks);
 	m_speed.CountTicks(ticks);
 	m_bios->CountTicks(ticks);
+	if(m_spuCaptureActive)
+	{
+		m_spuCapture->AddTicks(ticks);
+	}
 	m_dmaUpdateTicks += ticks;
 	if(m_dmaUpdateTicks >= g_dmaUpdateDelay)
 	{
@@ -383,6 +445,11 @@ void CSubSystem::CountTicks(int ticks)
 	m_spuIrqUpdateTicks += ticks;
 	if(m_spuIrqUpdateTicks >= g_spuIrqCheckDelay)
 	{
+		//Rendering only raises IRQs when they're enabled, no need to wait for it otherwise
+		if((m_spuCore0.GetControl() | m_spuCore1.GetControl()) & CSpuBase::CONTROL_IRQ)
+		{
+			SyncSpu();
+		}
 		bool irqPending = false;
 		irqPending |= m_spuCore0.GetIrqPending();
 		irqPending |= m_spuCore1.GetIrqPending();
@@ -13,6 +13,8 @@
 #include "Iop_SpuBase.h"
 #include "Iop_Spu.h"
 #include "Iop_Spu2.h"
+#include "Iop_SpuCapture.h"
+#include "../SpuRenderThread.h"
 #include "Iop_Sio2.h"
 #include "zip/ZipArchiveWriter.h"
 #include "zip/ZipArchiveReader.h"
@@ -36,6 +38,13 @@ namespace Iop
 		void SaveState(Framework::CZipArchiveWriter&);
 		void LoadState(Framework::CZipArchiveReader&);
 
+		void SetSpuRenderThread(CSpuRenderThread*);
+		void SyncSpu();
+
+		//Records SPU2 activity until stopped, reset or a state is loaded. Stopping returns what was recorded.
+		void StartSpuCapture();
+		std::unique_ptr<CSpuCapture> StopSpuCapture();
+
 		CMIPS m_cpu;
 		CMA_MIPSIV m_cpuArch;
 		CCOP_SCU m_copScu;
@@ -74,8 +83,13 @@ namespace Iop
 		uint32 WriteIoRegister(uint32, uint32);
 
 		void CheckPendingInterrupts();
+		void DetachSpuCapture();
 
 		int m_dmaUpdateTicks = 0;
 		int m_spuIrqUpdateTicks = 0;
+
+		CSpuRenderThread* m_spuRenderThread = nullptr;
+		std::unique_ptr<CSpuCapture> m_spuCapture;
+		bool m_spuCaptureActive = false;
 	};
 }
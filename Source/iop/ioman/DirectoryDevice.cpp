@@ -1,8 +1,11 @@
 #include <cassert>
+#include <cstring>
+#include <vector>
 #include "DirectoryDevice.h"
 #include "../Iop_PathUtils.h"
 #include "PathDirectoryIterator.h"
 #include "StdStream.h"
+#include "MemStream.h"
 #include "string_cast.h"
 
 using namespace Iop::Ioman;
@@ -23,6 +26,30 @@ Framework::CStdStream* CreateStdStream(const std::wstring& path, const char* mod
 	return new Framework::CStdStream(path.c_str(), cvtMode.c_str());
 }
 
+static Framework::CStream* CreateBulkReadStream(const fs::path& path, uint64 size)
+{
+	try
+	{
+		std::unique_ptr<Framework::CStdStream> inputStream(CreateStdStream(path.native(), "rb"));
+		std::vector<uint8> contents(size);
+		if(inputStream->Read(contents.data(), size) != size)
+		{
+			return nullptr;
+		}
+		auto stream = new Framework::CMemStream();
+		if(size != 0)
+		{
+			stream->Write(contents.data(), size);
+			stream->Seek(0, Framework::STREAM_SEEK_SET);
+		}
+		return stream;
+	}
+	catch(...)
+	{
+		return nullptr;
+	}
+}
+
 Framework::CStream* CDirectoryDevice::GetFile(uint32 accessType, const char* devicePath)
 {
 	auto basePath = GetBasePath();
@@ -56,6 +83,23 @@ Framework::CStream* CDirectoryDevice::GetFile(uint32 accessType, const char* dev
 		break;
 	}
 
+	if(!strcmp(mode, "rb"))
+	{
+		auto entry = m_cache.GetEntry(path);
+		if(!entry.exists)
+		{
+			return nullptr;
+		}
+		//Small files are served from memory, saves a few host calls per IOP read
+		if(!entry.isDirectory && (entry.size <= BULK_READ_MAX_SIZE))
+		{
+			if(auto stream = CreateBulkReadStream(path, entry.size))
+			{
+				return stream;
+			}
+		}
+	}
+
 	try
 	{
 		return CreateStdStream(path.native(), mode);
@@ -70,11 +114,11 @@ DirectoryIteratorPtr CDirectoryDevice::GetDirectory(const char* devicePath)
 {
 	auto basePath = GetBasePath();
 	auto path = Iop::PathUtils::MakeHostPath(basePath, devicePath);
-	if(!fs::is_directory(path))
+	if(!m_cache.GetEntry(path).isDirectory)
 	{
 		throw std::runtime_error("Not a directory.");
 	}
-	return std::make_unique<CPathDirectoryIterator>(path);
+	return std::make_unique<CPathDirectoryIterator>(m_cache.GetListing(path));
 }
 
 void CDirectoryDevice::MakeDirectory(const char* devicePath)
@@ -94,3 +138,26 @@ void CDirectoryDevice::Rename(const char* srcDevicePath, const char* dstDevicePa
 	auto dstPath = Iop::PathUtils::MakeHostPath(basePath, dstDevicePath);
 	fs::rename(srcPath, dstPath);
 }
+
+bool CDirectoryDevice::TryGetStat(const char* devicePath, bool& succeeded, STAT& stat)
+{
+	auto basePath = GetBasePath();
+	auto path = Iop::PathUtils::MakeHostPath(basePath, devicePath);
+	auto entry = m_cache.GetEntry(path);
+	succeeded = entry.exists;
+	if(!succeeded)
+	{
+		return true;
+	}
+	stat = {};
+	if(entry.isDirectory)
+	{
+		stat.mode = STAT_MODE_DIR;
+	}
+	else
+	{
+		stat.mode = STAT_MODE_FILE;
+		stat.loSize = static_cast<uint32>(entry.size);
+	}
+	return true;
+}
@@ -2,6 +2,7 @@
 
 #include <string>
 #include "../Ioman_Device.h"
+#include "HostFileSystemCache.h"
 
 namespace Iop
 {
@@ -16,9 +17,19 @@ namespace Iop
 			DirectoryIteratorPtr GetDirectory(const char*) override;
 			void MakeDirectory(const char*) override;
 			void Rename(const char*, const char*) override;
+			bool TryGetStat(const char*, bool&, STAT&) override;
 
 		protected:
 			virtual fs::path GetBasePath() = 0;
+
+		private:
+			enum
+			{
+				//Files opened for reading that are at most this size are read in one go
+				BULK_READ_MAX_SIZE = 0x100000,
+			};
+
+			CHostFileSystemCache m_cache;
 		};
 	}
 }
@@ -0,0 +1,305 @@
+#include "HostFileSystemCache.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace Iop::Ioman;
+
+#ifdef __linux__
+static const uint32 g_watchMask = IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MODIFY | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+#endif
+
+static CHostFileSystemCache::ListingPtr ReadListingInternal(const fs::path& path, bool& hasSymlinks)
+{
+	hasSymlinks = false;
+	auto listing = std::make_shared<CHostFileSystemCache::LISTING>();
+	for(const auto& dirEntry : fs::directory_iterator(path))
+	{
+		std::error_code errorCode;
+		CHostFileSystemCache::LISTING_ITEM item;
+		item.name = dirEntry.path().filename().string();
+		item.isDirectory = dirEntry.is_directory(errorCode);
+		if(!item.isDirectory)
+		{
+			item.size = dirEntry.file_size(errorCode);
+			if(errorCode) item.size = 0;
+		}
+		if(dirEntry.is_symlink(errorCode))
+		{
+			hasSymlinks = true;
+		}
+		listing->push_back(std::move(item));
+	}
+	return listing;
+}
+
+template <typename MapType, typename EraseCallback>
+static void ErasePathTree(MapType& map, const fs::path::string_type& key, const EraseCallback& eraseCallback)
+{
+	auto itemIterator = map.find(key);
+	if(itemIterator != std::end(map))
+	{
+		eraseCallback(itemIterator->second);
+		map.erase(itemIterator);
+	}
+	auto prefix = key;
+	prefix += fs::path::preferred_separator;
+	for(itemIterator = map.lower_bound(prefix);
+	    (itemIterator != std::end(map)) && (itemIterator->first.compare(0, prefix.size(), prefix) == 0);)
+	{
+		eraseCallback(itemIterator->second);
+		itemIterator = map.erase(itemIterator);
+	}
+}
+
+CHostFileSystemCache::CHostFileSystemCache()
+{
+#ifdef __linux__
+	m_notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+CHostFileSystemCache::~CHostFileSystemCache()
+{
+#ifdef __linux__
+	if(m_notifyFd != -1)
+	{
+		close(m_notifyFd);
+	}
+#endif
+}
+
+bool CHostFileSystemCache::IsEnabled() const
+{
+	return m_notifyFd != -1;
+}
+
+CHostFileSystemCache::ENTRY CHostFileSystemCache::GetEntry(const fs::path& path)
+{
+	if(!IsEnabled())
+	{
+		return ReadEntry(path);
+	}
+
+	ProcessEvents();
+
+	auto key = MakeKey(path);
+	auto entryIterator = m_entries.find(key);
+	if(entryIterator != std::end(m_entries))
+	{
+		return entryIterator->second;
+	}
+
+	//Changes to an entry are reported through its parent's watch
+	auto parentKey = MakeKey(fs::path(key).parent_path());
+	if((parentKey == key) || !WatchDirectory(parentKey))
+	{
+		return ReadEntry(path);
+	}
+
+	//Changes to the target of a symlink wouldn't be reported, don't cache those
+	std::error_code errorCode;
+	if(fs::is_symlink(fs::symlink_status(key, errorCode)))
+	{
+		return ReadEntry(path);
+	}
+
+	auto entry = ReadEntry(key);
+	if(m_entries.size() >= MAX_ENTRY_COUNT)
+	{
+		Clear();
+	}
+	m_entries[key] = entry;
+	return entry;
+}
+
+CHostFileSystemCache::ListingPtr CHostFileSystemCache::GetListing(const fs::path& path)
+{
+	if(!IsEnabled())
+	{
+		return ReadListing(path);
+	}
+
+	ProcessEvents();
+
+	auto key = MakeKey(path);
+	auto listingIterator = m_listings.find(key);
+	if(listingIterator != std::end(m_listings))
+	{
+		return listingIterator->second;
+	}
+
+	if(!WatchDirectory(key))
+	{
+		return ReadListing(path);
+	}
+
+	bool hasSymlinks = false;
+	auto listing = ReadListingInternal(key, hasSymlinks);
+	if(hasSymlinks)
+	{
+		return listing;
+	}
+
+	if((m_entries.size() + listing->size()) >= MAX_ENTRY_COUNT)
+	{
+		Clear();
+	}
+	m_listings[key] = listing;
+
+	//We got metadata for every item of the directory, use it for stats too
+	for(const auto& item : *listing)
+	{
+		ENTRY entry;
+		entry.exists = true;
+		entry.isDirectory = item.isDirectory;
+		entry.size = item.size;
+		m_entries[MakeKey(fs::path(key) / item.name)] = entry;
+	}
+
+	return listing;
+}
+
+CHostFileSystemCache::ENTRY CHostFileSystemCache::ReadEntry(const fs::path& path)
+{
+	ENTRY entry;
+	std::error_code errorCode;
+	auto status = fs::status(path, errorCode);
+	entry.exists = fs::exists(status);
+	entry.isDirectory = fs::is_directory(status);
+	if(fs::is_regular_file(status))
+	{
+		entry.size = fs::file_size(path, errorCode);
+		if(errorCode) entry.size = 0;
+	}
+	return entry;
+}
+
+CHostFileSystemCache::ListingPtr CHostFileSystemCache::ReadListing(const fs::path& path)
+{
+	bool hasSymlinks = false;
+	return ReadListingInternal(path, hasSymlinks);
+}
+
+CHostFileSystemCache::PathKey CHostFileSystemCache::MakeKey(const fs::path& path)
+{
+	//Guest paths can contain redundant separators or a trailing one. Normalizing is costly,
+	//only do it if we see a separator that is followed by another one or by a dot.
+	const auto& native = path.native();
+	bool needsNormalization = native.empty() || (native.back() == '/');
+	for(size_t i = 0; !needsNormalization && (i + 1) < native.size(); i++)
+	{
+		needsNormalization = (native[i] == '/') && ((native[i + 1] == '/') || (native[i + 1] == '.'));
+	}
+	if(!needsNormalization)
+	{
+		return native;
+	}
+	auto result = path.lexically_normal();
+	if(result.has_relative_path() && !result.has_filename())
+	{
+		result = result.parent_path();
+	}
+	return result.native();
+}
+
+bool CHostFileSystemCache::WatchDirectory(const PathKey& key)
+{
+#ifdef __linux__
+	if(m_watchedDirectories.find(key) != std::end(m_watchedDirectories))
+	{
+		return true;
+	}
+	int wd = inotify_add_watch(m_notifyFd, key.c_str(), g_watchMask);
+	if(wd == -1)
+	{
+		//Directory doesn't exist or we're out of watches
+		return false;
+	}
+	if(m_watches.find(wd) != std::end(m_watches))
+	{
+		//Same directory reached through another path, we would only be able to invalidate one of them
+		return false;
+	}
+	m_watches[wd] = key;
+	m_watchedDirectories[key] = wd;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void CHostFileSystemCache::ProcessEvents()
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[0x1000];
+	while(1)
+	{
+		auto size = read(m_notifyFd, buffer, sizeof(buffer));
+		if(size <= 0)
+		{
+			//EAGAIN, no more events
+			break;
+		}
+		for(ssize_t offset = 0; offset < size;)
+		{
+			auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			if(event->mask & IN_Q_OVERFLOW)
+			{
+				//We lost events, nothing we know can be trusted anymore
+				for(const auto& watchPair : m_watches)
+				{
+					inotify_rm_watch(m_notifyFd, watchPair.first);
+				}
+				m_watches.clear();
+				m_watchedDirectories.clear();
+				Clear();
+				continue;
+			}
+
+			auto watchIterator = m_watches.find(event->wd);
+			if(watchIterator == std::end(m_watches)) continue;
+			auto directoryKey = watchIterator->second;
+
+			if(event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+			{
+				InvalidatePath(directoryKey);
+			}
+			else
+			{
+				m_listings.erase(directoryKey);
+				if(event->len != 0)
+				{
+					InvalidatePath(MakeKey(fs::path(directoryKey) / event->name));
+				}
+			}
+		}
+	}
+#endif
+}
+
+void CHostFileSystemCache::InvalidatePath(const PathKey& key)
+{
+	//Drops everything we know about the path and what's below it (if it's a directory)
+	ErasePathTree(m_entries, key, [](const ENTRY&) {});
+	ErasePathTree(m_listings, key, [](const ListingPtr&) {});
+	//Watches of directories that were moved away now refer to something else, remove them
+	ErasePathTree(m_watchedDirectories, key, [this](int wd) { RemoveWatch(wd); });
+}
+
+void CHostFileSystemCache::RemoveWatch(int wd)
+{
+#ifdef __linux__
+	inotify_rm_watch(m_notifyFd, wd);
+#endif
+	m_watches.erase(wd);
+}
+
+void CHostFileSystemCache::Clear()
+{
+	m_entries.clear();
+	m_listings.clear();
+}
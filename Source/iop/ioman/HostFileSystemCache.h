@@ -0,0 +1,76 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Types.h"
+#include "filesystem_def.h"
+
+namespace Iop
+{
+	namespace Ioman
+	{
+		//Keeps metadata and directory listings of host paths so that repeated stats and
+		//directory iterations don't go to the host file system. Entries are invalidated
+		//using inotify, cache is disabled (everything goes to the host) on other platforms.
+		class CHostFileSystemCache
+		{
+		public:
+			struct ENTRY
+			{
+				bool exists = false;
+				bool isDirectory = false;
+				uint64 size = 0;
+			};
+
+			struct LISTING_ITEM
+			{
+				std::string name;
+				bool isDirectory = false;
+				uint64 size = 0;
+			};
+
+			typedef std::vector<LISTING_ITEM> LISTING;
+			typedef std::shared_ptr<const LISTING> ListingPtr;
+
+			CHostFileSystemCache();
+			virtual ~CHostFileSystemCache();
+
+			CHostFileSystemCache(const CHostFileSystemCache&) = delete;
+			CHostFileSystemCache& operator=(const CHostFileSystemCache&) = delete;
+
+			bool IsEnabled() const;
+
+			ENTRY GetEntry(const fs::path&);
+			//Path must be a directory, throws otherwise
+			ListingPtr GetListing(const fs::path&);
+
+			static ENTRY ReadEntry(const fs::path&);
+			static ListingPtr ReadListing(const fs::path&);
+
+		private:
+			typedef fs::path::string_type PathKey;
+
+			enum
+			{
+				//Everything is dropped when we go over this, watches are kept
+				MAX_ENTRY_COUNT = 0x10000,
+			};
+
+			static PathKey MakeKey(const fs::path&);
+
+			bool WatchDirectory(const PathKey&);
+			void RemoveWatch(int);
+			void ProcessEvents();
+			void InvalidatePath(const PathKey&);
+			void Clear();
+
+			int m_notifyFd = -1;
+			std::map<int, PathKey> m_watches;
+			std::map<PathKey, int> m_watchedDirectories;
+			std::map<PathKey, ENTRY> m_entries;
+			std::map<PathKey, ListingPtr> m_listings;
+		};
+	}
+}
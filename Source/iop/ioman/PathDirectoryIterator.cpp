@@ -5,20 +5,24 @@ using namespace Iop;
 using namespace Iop::Ioman;
 
 CPathDirectoryIterator::CPathDirectoryIterator(const fs::path& path)
-    : m_iterator(path)
+    : m_listing(CHostFileSystemCache::ReadListing(path))
+{
+}
+
+CPathDirectoryIterator::CPathDirectoryIterator(CHostFileSystemCache::ListingPtr listing)
+    : m_listing(std::move(listing))
 {
 }
 
 void CPathDirectoryIterator::ReadEntry(DIRENTRY* dirEntry)
 {
-	auto itemPath = m_iterator->path();
-	auto name = itemPath.filename().string();
-	strncpy(dirEntry->name, name.c_str(), Ioman::DIRENTRY::NAME_SIZE);
+	const auto& item = (*m_listing)[m_index];
+	strncpy(dirEntry->name, item.name.c_str(), Ioman::DIRENTRY::NAME_SIZE);
 	dirEntry->name[Ioman::DIRENTRY::NAME_SIZE - 1] = 0;
 
 	auto& stat = dirEntry->stat;
 	memset(&stat, 0, sizeof(Ioman::STAT));
-	if(fs::is_directory(itemPath))
+	if(item.isDirectory)
 	{
 		stat.mode = STAT_MODE_DIR;
 		stat.attr = 0x8427;
@@ -26,14 +30,14 @@ void CPathDirectoryIterator::ReadEntry(DIRENTRY* dirEntry)
 	else
 	{
 		stat.mode = STAT_MODE_FILE;
-		stat.loSize = fs::file_size(itemPath);
+		stat.loSize = item.size;
 		stat.attr = 0x8497;
 	}
 
-	m_iterator++;
+	m_index++;
 }
 
 bool CPathDirectoryIterator::IsDone()
 {
-	return m_iterator == fs::directory_iterator();
+	return m_index == m_listing->size();
 }
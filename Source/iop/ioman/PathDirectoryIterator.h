@@ -1,6 +1,7 @@
 #pragma once
 
 #include "filesystem_def.h"
+#include "HostFileSystemCache.h"
 #include "../Ioman_DirectoryIterator.h"
 
 namespace Iop
@@ -11,12 +12,14 @@ namespace Iop
 		{
 		public:
 			CPathDirectoryIterator(const fs::path&);
+			CPathDirectoryIterator(CHostFileSystemCache::ListingPtr);
 
 			void ReadEntry(DIRENTRY*) override;
 			bool IsDone() override;
 
 		private:
-			fs::directory_iterator m_iterator;
+			CHostFileSystemCache::ListingPtr m_listing;
+			size_t m_index = 0;
 		};
 	}
 }
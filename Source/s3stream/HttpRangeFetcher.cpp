@@ -0,0 +1,77 @@
+#include <cstdlib>
+#include <stdexcept>
+#include "HttpRangeFetcher.h"
+#include "http/HttpClientFactory.h"
+#include "string_format.h"
+#include "stricmp.h"
+
+#define HTTP_STATUS_PARTIAL_CONTENT 206
+
+CHttpRangeFetcher::CHttpRangeFetcher(std::string url)
+    : m_url(std::move(url))
+{
+}
+
+static std::string FindHeader(const Framework::Http::HeaderMap& headers, const char* name)
+{
+	//Servers don't all use the same case for header names
+	for(const auto& headerPair : headers)
+	{
+		if(!stricmp(headerPair.first.c_str(), name))
+		{
+			return headerPair.second;
+		}
+	}
+	return std::string();
+}
+
+static std::vector<uint8> SendRangeRequest(const std::string& url, uint64 position, uint64 size, Framework::Http::HeaderMap* responseHeaders = nullptr)
+{
+	Framework::Http::HeaderMap headers;
+	headers.insert(std::make_pair("Range", string_format("bytes=%llu-%llu", position, position + size - 1)));
+
+	auto client = Framework::Http::CreateHttpClient();
+	client->SetUrl(url);
+	client->SetHeaders(headers);
+	auto requestResult = client->SendRequest();
+
+	//Servers that ignore the range would send the whole object
+	if(static_cast<int>(requestResult.statusCode) != HTTP_STATUS_PARTIAL_CONTENT)
+	{
+		throw std::runtime_error(string_format("Range request failed (status: %d).", static_cast<int>(requestResult.statusCode)));
+	}
+	if(requestResult.data.GetSize() != size)
+	{
+		throw std::runtime_error("Range request returned an unexpected amount of data.");
+	}
+	if(responseHeaders)
+	{
+		(*responseHeaders) = requestResult.headers;
+	}
+	auto data = reinterpret_cast<const uint8*>(requestResult.data.GetBuffer());
+	return std::vector<uint8>(data, data + size);
+}
+
+CRangeFetcher::OBJECT_INFO CHttpRangeFetcher::GetObjectInfo()
+{
+	//Content-Range of any range gives us the object's size, ex.: 'bytes 0-0/1234'
+	Framework::Http::HeaderMap headers;
+	SendRangeRequest(m_url, 0, 1, &headers);
+
+	auto contentRange = FindHeader(headers, "Content-Range");
+	auto sizePosition = contentRange.find('/');
+	if(sizePosition == std::string::npos)
+	{
+		throw std::runtime_error("Server didn't report the object's size.");
+	}
+
+	OBJECT_INFO result;
+	result.size = strtoull(contentRange.c_str() + sizePosition + 1, nullptr, 10);
+	result.etag = FindHeader(headers, "ETag");
+	return result;
+}
+
+std::vector<uint8> CHttpRangeFetcher::GetRange(uint64 position, uint64 size)
+{
+	return SendRangeRequest(m_url, position, size);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "RangeFetcher.h"
+
+//Fetches ranges from a plain HTTP server, mostly useful to stand in for S3 (ex.: local server for testing)
+class CHttpRangeFetcher : public CRangeFetcher
+{
+public:
+	CHttpRangeFetcher(std::string);
+
+	OBJECT_INFO GetObjectInfo() override;
+	std::vector<uint8> GetRange(uint64, uint64) override;
+
+private:
+	std::string m_url;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Types.h"
+
+//Fetches byte ranges of a remote object. Ranges are fetched from multiple threads
+//at once, implementations must support concurrent calls to GetRange.
+class CRangeFetcher
+{
+public:
+	struct OBJECT_INFO
+	{
+		uint64 size = 0;
+		//Changes along with the object's contents, empty if the server doesn't provide one
+		std::string etag;
+	};
+
+	virtual ~CRangeFetcher() = default;
+
+	virtual OBJECT_INFO GetObjectInfo() = 0;
+	virtual std::vector<uint8> GetRange(uint64 position, uint64 size) = 0;
+};
@@ -1,21 +1,26 @@
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <regex>
 #include "S3ObjectStream.h"
-#include "amazon/AmazonS3Client.h"
+#include "S3RangeFetcher.h"
 #include "Singleton.h"
 #include "AppConfig.h"
 #include "PathUtils.h"
 #include "string_format.h"
+#include "StdStream.h"
 #include "StdStreamUtils.h"
 #include "Log.h"
+#include "xxhash.h"
 
 #define PREF_S3_OBJECTSTREAM_ACCESSKEYID "s3.objectstream.accesskeyid"
 #define PREF_S3_OBJECTSTREAM_SECRETACCESSKEY "s3.objectstream.secretaccesskey"
 #define CACHE_PATH "Play Data Files/s3objectstream_cache"
 
-#define LOG_NAME "s3objectstream"
+#define CACHE_MAGIC 0x434F3353 //'S3OC'
+#define CACHE_VERSION 1
 
-#define BUFFERSIZE 0x40000
+#define LOG_NAME "s3objectstream"
 
 CS3ObjectStream::CConfig::CConfig()
 {
@@ -32,12 +37,50 @@ CAmazonCredentials CS3ObjectStream::CConfig::GetCredentials()
 }
 
 CS3ObjectStream::CS3ObjectStream(const char* bucketName, const char* objectKey)
-    : m_bucketName(bucketName)
-    , m_objectKey(objectKey)
+    : CS3ObjectStream(std::make_unique<CS3RangeFetcher>(CConfig::GetInstance().GetCredentials(), bucketName, objectKey), GetCachePath())
+{
+}
+
+static CReadAheadCache::PARAMS MakeReadAheadCacheParams(uint32 slotCount, uint32 threadCount, uint32 readAheadCount)
+{
+	CReadAheadCache::PARAMS params;
+	params.unitsPerBlock = 1;
+	params.slotCount = slotCount;
+	params.threadCount = threadCount;
+	params.readAheadCount = readAheadCount;
+	params.threadName = "S3 Object Stream Fetch Thread";
+	return params;
+}
+
+CS3ObjectStream::CS3ObjectStream(RangeFetcherPtr fetcher, const fs::path& cachePath)
+    : m_fetcher(std::move(fetcher))
+    , m_readAheadCache(MakeReadAheadCacheParams(SLOT_COUNT, FETCH_THREAD_COUNT, READ_AHEAD_BLOCK_COUNT),
+                       [this](uint32 blockIndex, CReadAheadCache::Block& data) { FetchReadAheadBlock(blockIndex, data); },
+                       [this](uint32 blockIndex) { return (blockIndex < m_blockCount) && !IsBlockCached(blockIndex); })
+{
+	m_buffer.resize(BLOCK_SIZE);
+
+	auto objectInfo = m_fetcher->GetObjectInfo();
+	m_objectSize = objectInfo.size;
+	m_blockCount = static_cast<uint32>((m_objectSize + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+	if(!cachePath.empty() && !objectInfo.etag.empty())
+	{
+		try
+		{
+			OpenCache(cachePath, objectInfo.etag);
+		}
+		catch(const std::exception& exception)
+		{
+			//Not a problem if we failed to open cache, everything will be fetched
+			CLog::GetInstance().Print(LOG_NAME, "Failed to open cache: '%s'.\r\n", exception.what());
+			m_cacheStream.reset();
+		}
+	}
+}
+
+CS3ObjectStream::~CS3ObjectStream()
 {
-	m_buffer.resize(BUFFERSIZE);
-	Framework::PathUtils::EnsurePathExists(GetCachePath());
-	GetObjectInfo();
 }
 
 uint64 CS3ObjectStream::Read(void* buffer, uint64 size)
@@ -50,11 +93,11 @@ uint64 CS3ObjectStream::Read(void* buffer, uint64 size)
 	while(adjSize != 0)
 	{
 		//Read if we're inside buffer size
-		if((m_bufferPosition / BUFFERSIZE) == (m_objectPosition / BUFFERSIZE))
+		if(m_bufferBlockIndex == (m_objectPosition / BLOCK_SIZE))
 		{
-			uint64 bufferOffset = m_objectPosition % BUFFERSIZE;
-			uint64 remainSize = BUFFERSIZE - bufferOffset;
-			assert(remainSize <= BUFFERSIZE);
+			uint64 bufferOffset = m_objectPosition % BLOCK_SIZE;
+			uint64 remainSize = BLOCK_SIZE - bufferOffset;
+			assert(remainSize <= BLOCK_SIZE);
 			auto copySize = std::min(remainSize, adjSize);
 			assert(copySize <= adjSize);
 			memcpy(outBuffer, m_buffer.data() + bufferOffset, copySize);
@@ -104,113 +147,208 @@ bool CS3ObjectStream::IsEOF()
 	return (m_objectPosition == m_objectSize);
 }
 
-fs::path CS3ObjectStream::GetCachePath()
+uint64 CS3ObjectStream::GetFetchedBlockCount()
 {
-	return Framework::PathUtils::GetCachePath() / CACHE_PATH;
+	return m_fetchedBlockCount;
 }
 
-std::string CS3ObjectStream::GenerateReadCacheKey(const std::pair<uint64, uint64>& range) const
+fs::path CS3ObjectStream::GetCachePath()
 {
-	return string_format("%s-%llu-%llu", m_objectEtag.c_str(), range.first, range.second);
+	return Framework::PathUtils::GetCachePath() / CACHE_PATH;
 }
 
-static std::string TrimQuotes(std::string input)
+void CS3ObjectStream::OpenCache(const fs::path& cachePath, const std::string& etag)
 {
-	if(input.empty()) return input;
-	if(input[0] == '"')
+	Framework::PathUtils::EnsurePathExists(cachePath);
+	RemoveObsoleteCacheFiles(cachePath);
+
+	//Etags can contain characters that aren't allowed in file names
+	uint64 cacheKey = XXH3_64bits_withSeed(etag.data(), etag.size(), m_objectSize);
+	auto cacheFilePath = cachePath / string_format("%016llx.cache", static_cast<unsigned long long>(cacheKey));
+
+	CACHE_HEADER expectedHeader;
+	expectedHeader.magic = CACHE_MAGIC;
+	expectedHeader.version = CACHE_VERSION;
+	expectedHeader.objectSize = m_objectSize;
+	expectedHeader.blockSize = BLOCK_SIZE;
+	expectedHeader.blockCount = m_blockCount;
+
+	m_cacheBitmap.resize((m_blockCount + 7) / 8);
+	//Keep blocks aligned in the file
+	m_cacheDataOffset = ((sizeof(CACHE_HEADER) + m_cacheBitmap.size() + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_SIZE;
+
+	if(fs::exists(cacheFilePath))
 	{
-		input = std::string(input.begin() + 1, input.end());
+		auto cacheStream = std::make_unique<Framework::CStdStream>(Framework::CreateUpdateExistingStdStream(cacheFilePath.native()));
+		CACHE_HEADER header;
+		bool headerValid =
+		    (cacheStream->Read(&header, sizeof(CACHE_HEADER)) == sizeof(CACHE_HEADER)) &&
+		    !memcmp(&header, &expectedHeader, sizeof(CACHE_HEADER)) &&
+		    (cacheStream->Read(m_cacheBitmap.data(), m_cacheBitmap.size()) == m_cacheBitmap.size());
+		if(headerValid)
+		{
+			m_cacheStream = std::move(cacheStream);
+			return;
+		}
+		std::fill(m_cacheBitmap.begin(), m_cacheBitmap.end(), 0);
 	}
-	if(input.empty()) return input;
-	if(input[input.size() - 1] == '"')
+
+	//Blocks are written as they're fetched, file systems that support it will leave holes for the others
 	{
-		input = std::string(input.begin(), input.end() - 1);
+		auto cacheStream = Framework::CreateOutputStdStream(cacheFilePath.native());
+		cacheStream.Write(&expectedHeader, sizeof(CACHE_HEADER));
+		cacheStream.Write(m_cacheBitmap.data(), m_cacheBitmap.size());
 	}
-	return input;
+	m_cacheStream = std::make_unique<Framework::CStdStream>(Framework::CreateUpdateExistingStdStream(cacheFilePath.native()));
 }
 
-void CS3ObjectStream::GetObjectInfo()
+void CS3ObjectStream::RemoveObsoleteCacheFiles(const fs::path& cachePath)
 {
-	//Obtain bucket region
-	{
-		CAmazonS3Client client(CConfig::GetInstance().GetCredentials());
+	//Older versions kept each fetched range in its own file ('<etag>-<first>-<last>'), those are never read anymore
+	static const std::regex rangeFileNameRegex(R"(.+-\d+-\d+)");
 
-		GetBucketLocationRequest request;
-		request.bucket = m_bucketName;
+	std::vector<fs::path> obsoletePaths;
+	std::error_code errorCode;
+	for(fs::directory_iterator iterator(cachePath, errorCode), endIterator;
+	    !errorCode && (iterator != endIterator); iterator.increment(errorCode))
+	{
+		const auto& path = iterator->path();
+		if(!iterator->is_regular_file(errorCode) || errorCode) continue;
+		if(!std::regex_match(path.filename().string(), rangeFileNameRegex)) continue;
+		obsoletePaths.push_back(path);
+	}
 
-		auto result = client.GetBucketLocation(request);
-		m_bucketRegion = result.locationConstraint;
+	for(const auto& path : obsoletePaths)
+	{
+		//Not a problem if we can't remove it
+		fs::remove(path, errorCode);
 	}
+}
 
-	//Obtain object info
+bool CS3ObjectStream::IsBlockCached(uint32 blockIndex)
+{
+	std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+	return m_cacheStream && (m_cacheBitmap[blockIndex / 8] & (1 << (blockIndex % 8)));
+}
+
+bool CS3ObjectStream::ReadCachedBlock(uint32 blockIndex, uint8* block)
+{
+	std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+	if(!m_cacheStream || !(m_cacheBitmap[blockIndex / 8] & (1 << (blockIndex % 8))))
 	{
-		CAmazonS3Client client(CConfig::GetInstance().GetCredentials(), m_bucketRegion);
+		return false;
+	}
+	try
+	{
+		uint64 size = GetBlockSize(blockIndex);
+		m_cacheStream->Seek(m_cacheDataOffset + (static_cast<uint64>(blockIndex) * BLOCK_SIZE), Framework::STREAM_SEEK_SET);
+		return (m_cacheStream->Read(block, size) == size);
+	}
+	catch(const std::exception& exception)
+	{
+		//Not a problem if we failed to read cache
+		CLog::GetInstance().Print(LOG_NAME, "Failed to read cache: '%s'.\r\n", exception.what());
+		return false;
+	}
+}
 
-		HeadObjectRequest request;
-		request.bucket = m_bucketName;
-		request.key = m_objectKey;
+void CS3ObjectStream::WriteCachedBlock(uint32 blockIndex, const uint8* block)
+{
+	std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+	if(!m_cacheStream) return;
+	try
+	{
+		uint64 size = GetBlockSize(blockIndex);
+		m_cacheStream->Seek(m_cacheDataOffset + (static_cast<uint64>(blockIndex) * BLOCK_SIZE), Framework::STREAM_SEEK_SET);
+		if(m_cacheStream->Write(block, size) != size)
+		{
+			throw std::runtime_error("Failed to write block.");
+		}
 
-		auto objectHeader = client.HeadObject(request);
-		m_objectSize = objectHeader.contentLength;
-		m_objectEtag = TrimQuotes(objectHeader.etag);
+		//Block is only marked as cached once its data was written
+		uint32 bitmapIndex = blockIndex / 8;
+		m_cacheBitmap[bitmapIndex] |= (1 << (blockIndex % 8));
+		m_cacheStream->Seek(sizeof(CACHE_HEADER) + bitmapIndex, Framework::STREAM_SEEK_SET);
+		if(m_cacheStream->Write(&m_cacheBitmap[bitmapIndex], 1) != 1)
+		{
+			throw std::runtime_error("Failed to write bitmap.");
+		}
+	}
+	catch(const std::exception& exception)
+	{
+		//Not a problem if we failed to write cache, but don't try again (ex.: disk is full)
+		CLog::GetInstance().Print(LOG_NAME, "Failed to write cache: '%s'.\r\n", exception.what());
+		m_cacheStream.reset();
 	}
 }
 
-void CS3ObjectStream::SyncBuffer()
+uint64 CS3ObjectStream::GetBlockSize(uint32 blockIndex) const
 {
-	m_bufferPosition = (m_objectPosition / BUFFERSIZE) * BUFFERSIZE;
+	return std::min<uint64>(BLOCK_SIZE, m_objectSize - (static_cast<uint64>(blockIndex) * BLOCK_SIZE));
+}
 
-	uint64 size = std::min<uint64>(BUFFERSIZE, m_objectSize - m_bufferPosition);
-	auto range = std::make_pair(m_bufferPosition, m_bufferPosition + size - 1);
-	auto readCacheFilePath = GetCachePath() / GenerateReadCacheKey(range);
+std::vector<uint8> CS3ObjectStream::FetchBlock(uint32 blockIndex)
+{
+	uint64 position = static_cast<uint64>(blockIndex) * BLOCK_SIZE;
+	uint64 size = GetBlockSize(blockIndex);
+	assert(size > 0);
 
 #ifdef _TRACEGET
 	static FILE* output = fopen("getobject.log", "wb");
-	fprintf(output, "%ld,%ld,%ld\r\n", range.first, range.second, size);
+	fprintf(output, "%llu,%llu,%llu\r\n", position, position + size - 1, size);
 	fflush(output);
 #endif
 
-	bool cachedReadSucceeded =
-	    [&]() {
-		    try
-		    {
-			    if(fs::exists(readCacheFilePath))
-			    {
-				    auto readCacheFileStream = Framework::CreateInputStdStream(readCacheFilePath.native());
-				    FRAMEWORK_MAYBE_UNUSED auto cacheRead = readCacheFileStream.Read(m_buffer.data(), size);
-				    assert(cacheRead == size);
-				    return true;
-			    }
-		    }
-		    catch(const std::exception& exception)
-		    {
-			    //Not a problem if we failed to read cache
-			    CLog::GetInstance().Print(LOG_NAME, "Failed to read cache: '%s'.\r\n", exception.what());
-		    }
-		    return false;
-	    }();
-
-	if(!cachedReadSucceeded)
-	{
-		assert(size > 0);
-		CAmazonS3Client client(CConfig::GetInstance().GetCredentials(), m_bucketRegion);
-		GetObjectRequest request;
-		request.key = m_objectKey;
-		request.bucket = m_bucketName;
-		request.range = range;
-		auto objectContent = client.GetObject(request);
-		assert(objectContent.data.size() == size);
-		memcpy(m_buffer.data(), objectContent.data.data(), size);
+	auto data = m_fetcher->GetRange(position, size);
+	if(data.size() != size)
+	{
+		throw std::runtime_error("Fetched range doesn't have the requested size.");
+	}
+	WriteCachedBlock(blockIndex, data.data());
+	m_fetchedBlockCount++;
 
-		try
-		{
-			auto readCacheFileStream = Framework::CreateOutputStdStream(readCacheFilePath.native());
-			readCacheFileStream.Write(objectContent.data.data(), size);
-		}
-		catch(const std::exception& exception)
-		{
-			//Not a problem if we failed to write cache
-			CLog::GetInstance().Print(LOG_NAME, "Failed to write cache: '%s'.\r\n", exception.what());
-		}
+	return data;
+}
+
+void CS3ObjectStream::FetchReadAheadBlock(uint32 blockIndex, CReadAheadCache::Block& data)
+{
+	try
+	{
+		data = FetchBlock(blockIndex);
+	}
+	catch(const std::exception& exception)
+	{
+		CLog::GetInstance().Print(LOG_NAME, "Failed to fetch block %d: '%s'.\r\n", blockIndex, exception.what());
+		throw;
+	}
+}
+
+void CS3ObjectStream::SyncBuffer()
+{
+	uint32 blockIndex = static_cast<uint32>(m_objectPosition / BLOCK_SIZE);
+	m_bufferBlockIndex = ~0U;
+
+	bool fetched = m_readAheadCache.Read(
+	    blockIndex, [&](CReadAheadCache::Block& data) {
+		    //Block won't be needed again while it's in our buffer, take its data and let the slot go
+		    std::swap(m_buffer, data);
+		    m_buffer.resize(BLOCK_SIZE);
+	    },
+	    true);
+	if(fetched)
+	{
+		m_bufferBlockIndex = blockIndex;
+		return;
 	}
+
+	if(ReadCachedBlock(blockIndex, m_buffer.data()))
+	{
+		m_bufferBlockIndex = blockIndex;
+		return;
+	}
+
+	//Not cached, random access or fetch failed, fetch it directly to let errors reach the caller
+	auto data = FetchBlock(blockIndex);
+	memcpy(m_buffer.data(), data.data(), data.size());
+	m_bufferBlockIndex = blockIndex;
 }
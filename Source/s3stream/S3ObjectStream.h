@@ -1,11 +1,19 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include "Singleton.h"
 #include "Stream.h"
 #include "filesystem_def.h"
 #include "amazon/AmazonS3Client.h"
+#include "RangeFetcher.h"
+#include "../ReadAheadCache.h"
 
+//Object is fetched in blocks by a few threads at once, blocks ahead of sequential reads are
+//fetched before they're needed. Fetched blocks are kept in a single sparse cache file per
+//object, along with a bitmap of blocks it contains.
 class CS3ObjectStream : public Framework::CStream
 {
 public:
@@ -16,7 +24,12 @@ public:
 		CAmazonCredentials GetCredentials();
 	};
 
+	typedef std::unique_ptr<CRangeFetcher> RangeFetcherPtr;
+
 	CS3ObjectStream(const char*, const char*);
+	//Cache is disabled if cache path is empty or if the fetcher doesn't provide an etag
+	CS3ObjectStream(RangeFetcherPtr, const fs::path&);
+	virtual ~CS3ObjectStream();
 
 	uint64 Read(void*, uint64) override;
 	uint64 Write(const void*, uint64) override;
@@ -24,22 +37,60 @@ public:
 	uint64 Tell() override;
 	bool IsEOF() override;
 
-private:
+	//Number of blocks fetched from the remote object, includes read ahead
+	uint64 GetFetchedBlockCount();
+
 	static fs::path GetCachePath();
-	std::string GenerateReadCacheKey(const std::pair<uint64, uint64>&) const;
-	void GetObjectInfo();
+
+private:
+	enum
+	{
+		BLOCK_SIZE = 0x40000,
+		FETCH_THREAD_COUNT = 4,
+		READ_AHEAD_BLOCK_COUNT = 8,
+		SLOT_COUNT = FETCH_THREAD_COUNT + READ_AHEAD_BLOCK_COUNT + 2,
+	};
+
+	struct CACHE_HEADER
+	{
+		uint32 magic = 0;
+		uint32 version = 0;
+		uint64 objectSize = 0;
+		uint32 blockSize = 0;
+		uint32 blockCount = 0;
+	};
+	static_assert(sizeof(CACHE_HEADER) == 0x18, "Cache header size must be 0x18 bytes.");
+
+	void OpenCache(const fs::path&, const std::string&);
+	static void RemoveObsoleteCacheFiles(const fs::path&);
+	bool IsBlockCached(uint32);
+	bool ReadCachedBlock(uint32, uint8*);
+	void WriteCachedBlock(uint32, const uint8*);
+
+	uint64 GetBlockSize(uint32) const;
+	std::vector<uint8> FetchBlock(uint32);
+	void FetchReadAheadBlock(uint32, CReadAheadCache::Block&);
 	void SyncBuffer();
 
-	std::string m_bucketName;
-	std::string m_bucketRegion;
-	std::string m_objectKey;
+	RangeFetcherPtr m_fetcher;
 
 	//Object Metadata
 	uint64 m_objectSize = 0;
-	std::string m_objectEtag;
+	uint32 m_blockCount = 0;
 
 	uint64 m_objectPosition = 0;
 
 	std::vector<uint8> m_buffer;
-	uint64 m_bufferPosition = ~0ULL;
+	uint32 m_bufferBlockIndex = ~0U;
+
+	//Cache file, data blocks start at m_cacheDataOffset
+	std::mutex m_cacheMutex;
+	std::unique_ptr<Framework::CStream> m_cacheStream;
+	std::vector<uint8> m_cacheBitmap;
+	uint64 m_cacheDataOffset = 0;
+
+	std::atomic<uint64> m_fetchedBlockCount = {0};
+
+	//Declared last, its threads use the fetcher and the cache file until it's destroyed
+	CReadAheadCache m_readAheadCache;
 };
@@ -0,0 +1,70 @@
+#include <stdexcept>
+#include "S3RangeFetcher.h"
+
+CS3RangeFetcher::CS3RangeFetcher(const CAmazonCredentials& credentials, const char* bucketName, const char* objectKey)
+    : m_credentials(credentials)
+    , m_bucketName(bucketName)
+    , m_objectKey(objectKey)
+{
+}
+
+static std::string TrimQuotes(std::string input)
+{
+	if(input.empty()) return input;
+	if(input[0] == '"')
+	{
+		input = std::string(input.begin() + 1, input.end());
+	}
+	if(input.empty()) return input;
+	if(input[input.size() - 1] == '"')
+	{
+		input = std::string(input.begin(), input.end() - 1);
+	}
+	return input;
+}
+
+CRangeFetcher::OBJECT_INFO CS3RangeFetcher::GetObjectInfo()
+{
+	//Obtain bucket region
+	{
+		CAmazonS3Client client(m_credentials);
+
+		GetBucketLocationRequest request;
+		request.bucket = m_bucketName;
+
+		auto result = client.GetBucketLocation(request);
+		m_bucketRegion = result.locationConstraint;
+	}
+
+	//Obtain object info
+	{
+		CAmazonS3Client client(m_credentials, m_bucketRegion);
+
+		HeadObjectRequest request;
+		request.bucket = m_bucketName;
+		request.key = m_objectKey;
+
+		auto objectHeader = client.HeadObject(request);
+
+		OBJECT_INFO result;
+		result.size = objectHeader.contentLength;
+		result.etag = TrimQuotes(objectHeader.etag);
+		return result;
+	}
+}
+
+std::vector<uint8> CS3RangeFetcher::GetRange(uint64 position, uint64 size)
+{
+	//Clients aren't shared, ranges are fetched from multiple threads
+	CAmazonS3Client client(m_credentials, m_bucketRegion);
+	GetObjectRequest request;
+	request.key = m_objectKey;
+	request.bucket = m_bucketName;
+	request.range = std::make_pair(position, position + size - 1);
+	auto objectContent = client.GetObject(request);
+	if(objectContent.data.size() != size)
+	{
+		throw std::runtime_error("Failed to get object range.");
+	}
+	return std::vector<uint8>(objectContent.data.begin(), objectContent.data.end());
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "RangeFetcher.h"
+#include "amazon/AmazonS3Client.h"
+
+class CS3RangeFetcher : public CRangeFetcher
+{
+public:
+	CS3RangeFetcher(const CAmazonCredentials&, const char*, const char*);
+
+	OBJECT_INFO GetObjectInfo() override;
+	std::vector<uint8> GetRange(uint64, uint64) override;
+
+private:
+	CAmazonCredentials m_credentials;
+	std::string m_bucketName;
+	std::string m_bucketRegion;
+	std::string m_objectKey;
+};
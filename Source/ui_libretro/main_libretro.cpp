@@ -174,7 +174,7 @@ void retro_get_system_info(struct retro_system_info* info)
 	info->library_name = "Play!";
 	info->library_version = PLAY_VERSION;
 	info->need_fullpath = true;
-	info->valid_extensions = "elf|iso|cso|isz|cue|chd";
+	info->valid_extensions = "elf|iso|cso|isz|cue|chd|zci";
 }
 
 void retro_get_system_av_info(struct retro_system_av_info* info)
@@ -48,11 +48,20 @@ int main(int argc, char* argv[])
 	QCommandLineOption load_state_option("state", "Load state at index", "state_index");
 	parser.addOption(load_state_option);
 
+	QCommandLineOption record_audio_option("record-audio", "Record audio output to a WAVE or FLAC file (picked from the extension)", "audio_file");
+	parser.addOption(record_audio_option);
+
 	parser.process(a);
 
 	MainWindow w;
 	w.show();
 
+	if(parser.isSet(record_audio_option))
+	{
+		QString audioFile = parser.value(record_audio_option);
+		w.SetAudioRecordPath(QStringToPath(audioFile));
+	}
+
 	if(parser.isSet(cdrom_image_option))
 	{
 		try
@@ -38,6 +38,7 @@
 #else
 #include "tools/PsfPlayer/Source/SH_OpenAL.h"
 #endif
+#include "audio/SH_Capture.h"
 #ifdef DEBUGGER_INCLUDED
 #include "DebugSupport/DebugSupportSettings.h"
 #include "DebugSupport/QtDebugger.h"
@@ -282,25 +283,40 @@ void MainWindow::SetupSoundHandler()
 {
 	assert(m_virtualMachine);
 	bool audioEnabled = CAppConfig::GetInstance().GetPreferenceBoolean(PREFERENCE_AUDIO_ENABLEOUTPUT);
+	CSoundHandler::FactoryFunction factory;
 	if(audioEnabled)
 	{
-		try
-		{
 #ifdef _WIN32
-			m_virtualMachine->CreateSoundHandler(&CSH_WaveOut::HandlerFactory);
+		factory = &CSH_WaveOut::HandlerFactory;
 #else
-			m_virtualMachine->CreateSoundHandler(&CSH_OpenAL::HandlerFactory);
+		factory = &CSH_OpenAL::HandlerFactory;
 #endif
+	}
+	if(!m_audioRecordPath.empty())
+	{
+		//Recording works with audio output disabled, the capture handler has no inner handler then.
+		//Recreating the handler (ie.: when settings change) starts the file over.
+		factory = CSH_Capture::GetFactoryFunction(factory, m_audioRecordPath);
+	}
+	//CreateSoundHandler keeps any existing handler, get rid of it for the new factory to be used
+	m_virtualMachine->DestroySoundHandler();
+	if(factory)
+	{
+		try
+		{
+			m_virtualMachine->CreateSoundHandler(factory);
 		}
 		catch(const std::exception& ex)
 		{
 			m_msgLabel->setText(QString("Failed to create sound handler: %0").arg(QString::fromUtf8(ex.what())));
 		}
 	}
-	else
-	{
-		m_virtualMachine->DestroySoundHandler();
-	}
+}
+
+void MainWindow::SetAudioRecordPath(fs::path audioRecordPath)
+{
+	m_audioRecordPath = std::move(audioRecordPath);
+	SetupSoundHandler();
 }
 
 void MainWindow::outputWindow_resized()
@@ -611,7 +627,7 @@ void MainWindow::CreateStatusBar()
 
 void MainWindow::updateStats()
 {
-	auto unlockedFps = !CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_LIMIT_FRAMERATE);
+	auto unlockedFps = !CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_LIMIT_FRAMERATE) || (m_virtualMachine && m_virtualMachine->IsTurboModeEnabled());
 	uint32 frames = CStatsManager::GetInstance().GetFrames();
 	uint32 drawCalls = CStatsManager::GetInstance().GetDrawCalls();
 	auto cpuUtilisation = CStatsManager::GetInstance().GetCpuUtilisationInfo();
@@ -777,6 +793,15 @@ void MainWindow::on_actionPause_Resume_triggered()
 	}
 }
 
+void MainWindow::on_actionTurbo_Mode_triggered(bool checked)
+{
+	if(m_virtualMachine != nullptr)
+	{
+		m_virtualMachine->SetTurboModeEnabled(checked);
+		m_msgLabel->setText(checked ? "Turbo mode enabled." : "Turbo mode disabled.");
+	}
+}
+
 void MainWindow::closeEvent(QCloseEvent* event)
 {
 	//btnRes is the answer to the "Are you sure you want to exit?" question.
@@ -1114,6 +1139,53 @@ void MainWindow::DumpNextFrame()
 	    });
 }
 
+fs::path MainWindow::GetSpuCaptureDirectoryPath()
+{
+	return CAppConfig::GetInstance().GetBasePath() / fs::path("spucaptures/");
+}
+
+void MainWindow::ToggleSpuCapture()
+{
+	if(debugMenuUi->actionCaptureSpu->isChecked())
+	{
+		m_virtualMachine->StartSpuCapture();
+		m_msgLabel->setText(QString("Started SPU capture."));
+		return;
+	}
+
+	fs::path capturePath;
+	std::string captureFileName;
+	try
+	{
+		auto captureDirectoryPath = GetSpuCaptureDirectoryPath();
+		Framework::PathUtils::EnsurePathExists(captureDirectoryPath);
+		for(unsigned int i = 0; i < UINT_MAX; i++)
+		{
+			captureFileName = string_format("spucapture_%08d.spucap.zip", i);
+			capturePath = captureDirectoryPath / fs::path(captureFileName);
+			if(!fs::exists(capturePath)) break;
+		}
+	}
+	catch(...)
+	{
+		m_msgLabel->setText(QString("Failed to save SPU capture."));
+		return;
+	}
+
+	auto future = m_virtualMachine->StopSpuCapture(capturePath);
+	m_continuationChecker->GetContinuationManager().Register(std::move(future),
+	                                                         [this, captureFileName](const bool& succeeded) {
+		                                                         if(succeeded)
+		                                                         {
+			                                                         m_msgLabel->setText(QString("Saved SPU capture to '%1'.").arg(captureFileName.c_str()));
+		                                                         }
+		                                                         else
+		                                                         {
+			                                                         m_msgLabel->setText(QString("Failed to save SPU capture."));
+		                                                         }
+	                                                         });
+}
+
 void MainWindow::ToggleGsDraw()
 {
 	auto gs = m_virtualMachine->GetGSHandler();
@@ -1275,6 +1347,7 @@ void MainWindow::SetupDebugger()
 		connect(debugMenuUi->actionShowDebugger, &QAction::triggered, this, std::bind(&MainWindow::ShowDebugger, this));
 		connect(debugMenuUi->actionShowFrameDebugger, &QAction::triggered, this, std::bind(&MainWindow::ShowFrameDebugger, this));
 		connect(debugMenuUi->actionDumpNextFrame, &QAction::triggered, this, std::bind(&MainWindow::DumpNextFrame, this));
+		connect(debugMenuUi->actionCaptureSpu, &QAction::triggered, this, std::bind(&MainWindow::ToggleSpuCapture, this));
 		connect(debugMenuUi->actionGsDrawEnabled, &QAction::triggered, this, std::bind(&MainWindow::ToggleGsDraw, this));
 	}
 
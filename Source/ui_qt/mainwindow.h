@@ -46,6 +46,7 @@ public:
 	void LoadCDROM(fs::path filePath);
 	void BootArcadeMachine(fs::path);
 	void loadState(int);
+	void SetAudioRecordPath(fs::path);
 
 #ifdef DEBUGGER_INCLUDED
 	void ShowMainWindow();
@@ -53,6 +54,8 @@ public:
 	void ShowFrameDebugger();
 	fs::path GetFrameDumpDirectoryPath();
 	void DumpNextFrame();
+	fs::path GetSpuCaptureDirectoryPath();
+	void ToggleSpuCapture();
 	void ToggleGsDraw();
 #endif
 
@@ -115,6 +118,7 @@ private:
 	std::shared_ptr<CInputProviderQtMouse> m_qtMouseInputProvider;
 	LastOpenCommand m_lastOpenCommand;
 	fs::path m_lastPath;
+	fs::path m_audioRecordPath;
 
 	Framework::CSignal<void()>::Connection m_OnExecutableChangeConnection;
 	CPS2VM::NewFrameEvent::Connection m_OnNewFrameConnection;
@@ -150,6 +154,7 @@ private slots:
 	void keyReleaseEvent(QKeyEvent*) Q_DECL_OVERRIDE;
 	void on_actionSettings_triggered();
 	void on_actionPause_Resume_triggered();
+	void on_actionTurbo_Mode_triggered(bool checked);
 	void on_actionAbout_triggered();
 	void focusOutEvent(QFocusEvent*) Q_DECL_OVERRIDE;
 	void focusInEvent(QFocusEvent*) Q_DECL_OVERRIDE;
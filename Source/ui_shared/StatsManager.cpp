@@ -27,6 +27,7 @@ void CStatsManager::OnNewFrame(CPS2VM* virtualMachine)
 			zoneInfo.minValue = std::min<uint64>(zoneInfo.minValue, zone.totalTime);
 		}
 		zoneInfo.maxValue = std::max<uint64>(zoneInfo.maxValue, zone.totalTime);
+		zoneInfo.hitCount += zone.hitCount;
 	}
 #endif
 }
@@ -85,6 +86,7 @@ std::string CStatsManager::GetProfilingInfo()
 	for(const auto& zonePair : m_profilerZones)
 	{
 		const auto& zoneInfo = zonePair.second;
+		if(zoneInfo.hitCount != 0) continue;
 		float avgRatioSpent = (totalTime != 0) ? static_cast<double>(zoneInfo.currentValue) / static_cast<double>(totalTime) : 0;
 		float avgMsSpent = (m_frames != 0) ? static_cast<double>(zoneInfo.currentValue) / static_cast<double>(m_frames * timeScale) : 0;
 		float minMsSpent = (zoneInfo.minValue != ~0ULL) ? static_cast<double>(zoneInfo.minValue) / static_cast<double>(timeScale) : 0;
@@ -99,6 +101,14 @@ std::string CStatsManager::GetProfilingInfo()
 		result += string_format("                   %6.2fms\r\n\r\n", totalAvgMsSpent);
 	}
 
+	for(const auto& zonePair : m_profilerZones)
+	{
+		const auto& zoneInfo = zonePair.second;
+		if(zoneInfo.hitCount == 0) continue;
+		float avgHits = (m_frames != 0) ? static_cast<double>(zoneInfo.hitCount) / static_cast<double>(m_frames) : 0;
+		result += string_format("%s: %6.2f hits/frame\r\n", zonePair.first.c_str(), avgHits);
+	}
+
 	{
 		float eeUsageRatio = ComputeCpuUsageRatio(m_cpuUtilisation.eeIdleTicks, m_cpuUtilisation.eeTotalTicks);
 		float iopUsageRatio = ComputeCpuUsageRatio(m_cpuUtilisation.iopIdleTicks, m_cpuUtilisation.iopTotalTicks);
@@ -122,6 +132,7 @@ void CStatsManager::ClearStats()
 	for(auto& zonePair : m_profilerZones)
 	{
 		zonePair.second.currentValue = 0;
+		zonePair.second.hitCount = 0;
 	}
 #endif
 }
@@ -38,6 +38,7 @@ private:
 		uint64 currentValue = 0;
 		uint64 minValue = ~0ULL;
 		uint64 maxValue = 0;
+		uint64 hitCount = 0;
 	};
 
 	typedef std::map<std::string, ZONEINFO> ZoneMap;
@@ -0,0 +1,505 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+#include "filesystem_def.h"
+#include "StdStreamUtils.h"
+#include "stricmp.h"
+#include "DiskUtils.h"
+#include "ISO9660/BlockProvider.h"
+#include "discimages/CsoImageWriter.h"
+#include "discimages/ZciImageWriter.h"
+#include "xxhash.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define MAX_UNRECOGNIZED_LINE_WARNINGS 10
+
+struct OPTIONS
+{
+	bool sequential = false;
+	bool random = false;
+	fs::path tracePath;
+	uint32 sectorsPerRead = 16;
+	uint32 randomReadCount = 10000;
+	//Maximum number of sectors read by the sequential pass, 0 reads the whole track
+	uint32 sequentialSectorCount = 0;
+	uint32 seed = 0x1234;
+	//Converts the image to CSO and ZCI and runs the same passes on the converted images
+	bool compare = false;
+	uint32 csoFrameSize = 0x800;
+	uint32 zciChunkSize = CZciImageWriter::DEFAULT_CHUNK_SIZE;
+};
+
+struct READ
+{
+	uint32 address = 0;
+	uint32 count = 0;
+};
+typedef std::vector<READ> ReadList;
+
+struct PASS_RESULT
+{
+	uint64 byteCount = 0;
+	double time = 0;
+	double cpuTime = 0;
+	double latencyP50 = 0;
+	double latencyP99 = 0;
+	double latencyMax = 0;
+	uint64 hash = 0;
+};
+
+static void PrintUsage()
+{
+	printf("Usage: DiscBench [options] <image path>\r\n");
+	printf("Measures sector read performance of any disc image supported by Play! (including '//s3/' and '//http/' paths).\r\n");
+	printf("Runs the sequential and random passes if no pass is specified.\r\n");
+	printf("Options: \r\n");
+	printf("\t --sequential\t\t Read the data track from start to end.\r\n");
+	printf("\t --random\t\t Read from random positions.\r\n");
+	printf("\t --trace <path>\t\t Replay reads listed in a file ('<sector> <count>', Cdvdman's CdRead or Cdvdfsv's Read/ReadIopMem log lines).\r\n");
+	printf("\t --sectors <count>\t Number of sectors per read for sequential and random passes (default: 16).\r\n");
+	printf("\t --reads <count>\t Number of reads in the random pass (default: 10000).\r\n");
+	printf("\t --limit <count>\t Maximum number of sectors to read in the sequential pass (default: whole track).\r\n");
+	printf("\t --seed <seed>\t\t Seed used to generate random pass positions.\r\n");
+	printf("\t --compare\t\t Also run the passes on CSO and ZCI conversions of the image (must be an ISO file).\r\n");
+	printf("\t --frame-size <size>\t Frame size of the CSO image, power of two, at least 2048 (default: 2048).\r\n");
+	printf("\t --chunk-size <size>\t Chunk size of the ZCI image, multiple of 2048 (default: %d).\r\n", CZciImageWriter::DEFAULT_CHUNK_SIZE);
+}
+
+//Decompression happens on the reading thread and on worker threads, we count all of them
+static double GetProcessCpuTime()
+{
+#ifdef _WIN32
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if(!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+	{
+		return 0;
+	}
+	auto toSeconds =
+	    [](const FILETIME& fileTime) {
+		    uint64 ticks = (static_cast<uint64>(fileTime.dwHighDateTime) << 32) | fileTime.dwLowDateTime;
+		    return static_cast<double>(ticks) / 10000000.0;
+	    };
+	return toSeconds(kernelTime) + toSeconds(userTime);
+#else
+	return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+static ReadList MakeSequentialReads(uint32 blockCount, const OPTIONS& options)
+{
+	ReadList reads;
+	uint32 endAddress = (options.sequentialSectorCount != 0) ? std::min(options.sequentialSectorCount, blockCount) : blockCount;
+	for(uint32 address = 0; address < endAddress; address += options.sectorsPerRead)
+	{
+		READ read;
+		read.address = address;
+		read.count = std::min(options.sectorsPerRead, endAddress - address);
+		reads.push_back(read);
+	}
+	return reads;
+}
+
+static ReadList MakeRandomReads(uint32 blockCount, const OPTIONS& options)
+{
+	ReadList reads;
+	uint32 sectorsPerRead = std::min(options.sectorsPerRead, blockCount);
+	uint32 positionCount = blockCount - sectorsPerRead + 1;
+	uint32 randomState = options.seed;
+	for(uint32 i = 0; i < options.randomReadCount; i++)
+	{
+		randomState = (randomState * 1103515245) + 12345;
+		READ read;
+		read.address = static_cast<uint32>((static_cast<uint64>(randomState >> 8) * 4099) % positionCount);
+		read.count = sectorsPerRead;
+		reads.push_back(read);
+	}
+	return reads;
+}
+
+static bool ParseTraceLine(const char* line, READ& read)
+{
+	struct LOG_FORMAT
+	{
+		const char* function;
+		const char* countField;
+	};
+
+	//Cdvdman: CdRead(startSector = 0x..., sectorCount = 0x..., ...)
+	//Cdvdfsv: Read(sector = 0x..., count = 0x..., ...) and ReadIopMem(sector = 0x..., count = 0x..., ...)
+	static const LOG_FORMAT logFormats[] =
+	    {
+	        {"CdRead(startSector = ", ", sectorCount = "},
+	        {"Read(sector = ", ", count = "},
+	        {"ReadIopMem(sector = ", ", count = "},
+	    };
+
+	for(const auto& logFormat : logFormats)
+	{
+		const char* sector = strstr(line, logFormat.function);
+		if(!sector) continue;
+		//Function name must not be the end of a longer one
+		if((sector != line) && isalnum(static_cast<unsigned char>(sector[-1]))) continue;
+		const char* count = strstr(sector, logFormat.countField);
+		if(!count) return false;
+		read.address = strtoul(sector + strlen(logFormat.function), nullptr, 0);
+		read.count = strtoul(count + strlen(logFormat.countField), nullptr, 0);
+		return true;
+	}
+
+	char* end = nullptr;
+	read.address = strtoul(line, &end, 0);
+	if(end == line) return false;
+	const char* countStart = end;
+	read.count = strtoul(countStart, &end, 0);
+	return (end != countStart);
+}
+
+static ReadList LoadTraceReads(const fs::path& tracePath, uint32 blockCount)
+{
+	auto stream = Framework::CreateInputStdStream(tracePath.native());
+	std::string contents(stream.GetLength(), 0);
+	if(stream.Read(&contents[0], contents.size()) != contents.size())
+	{
+		throw std::runtime_error("Failed to read trace file.");
+	}
+
+	ReadList reads;
+	uint32 skippedCount = 0;
+	uint32 unrecognizedCount = 0;
+	uint32 lineNumber = 0;
+	size_t lineStart = 0;
+	while(lineStart < contents.size())
+	{
+		size_t lineEnd = contents.find('\n', lineStart);
+		if(lineEnd == std::string::npos) lineEnd = contents.size();
+		auto line = contents.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+		lineNumber++;
+
+		if(!line.empty() && (line.back() == '\r')) line.pop_back();
+		if(line.empty() || (line[0] == '#')) continue;
+
+		READ read;
+		if(!ParseTraceLine(line.c_str(), read))
+		{
+			//Only show the first few, a full log has a lot of unrelated lines
+			if(unrecognizedCount < MAX_UNRECOGNIZED_LINE_WARNINGS)
+			{
+				printf("Warning: Line %d of trace isn't a read: '%s'.\r\n", lineNumber, line.c_str());
+			}
+			unrecognizedCount++;
+			continue;
+		}
+		if((read.count == 0) || (read.address >= blockCount) || (read.count > (blockCount - read.address)))
+		{
+			skippedCount++;
+			continue;
+		}
+		reads.push_back(read);
+	}
+
+	if(unrecognizedCount != 0)
+	{
+		printf("Warning: Skipped %d lines from trace that weren't reads.\r\n", unrecognizedCount);
+	}
+	if(skippedCount != 0)
+	{
+		printf("Warning: Skipped %d reads from trace that were outside of the data track.\r\n", skippedCount);
+	}
+	if(reads.empty())
+	{
+		throw std::runtime_error("Trace file doesn't contain any valid read.");
+	}
+	return reads;
+}
+
+static PASS_RESULT RunPass(const fs::path& imagePath, const ReadList& reads)
+{
+	//Media is opened again for every pass for caches and read ahead to start from scratch
+	auto opticalMedia = DiskUtils::CreateOpticalMediaFromPath(imagePath, COpticalMedia::CREATE_AUTO_DISABLE_DL_DETECT);
+	auto blockProvider = opticalMedia->GetTrackBlockProvider(0);
+
+	uint32 maxCount = 0;
+	for(const auto& read : reads)
+	{
+		maxCount = std::max(maxCount, read.count);
+	}
+	std::vector<uint8> buffer(static_cast<size_t>(maxCount) * ISO9660::CBlockProvider::BLOCKSIZE);
+	std::vector<double> latencies;
+	latencies.reserve(reads.size());
+
+	XXH3_state_t* hashState = XXH3_createState();
+	XXH3_64bits_reset(hashState);
+
+	PASS_RESULT result;
+	double cpuStartTime = GetProcessCpuTime();
+	auto startTime = std::chrono::steady_clock::now();
+	for(const auto& read : reads)
+	{
+		auto readStartTime = std::chrono::steady_clock::now();
+		blockProvider->ReadBlocks(read.address, read.count, buffer.data());
+		auto readEndTime = std::chrono::steady_clock::now();
+		latencies.push_back(std::chrono::duration<double, std::milli>(readEndTime - readStartTime).count());
+
+		uint64 readSize = static_cast<uint64>(read.count) * ISO9660::CBlockProvider::BLOCKSIZE;
+		XXH3_64bits_update(hashState, buffer.data(), readSize);
+		result.byteCount += readSize;
+	}
+	result.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	result.cpuTime = GetProcessCpuTime() - cpuStartTime;
+	result.hash = XXH3_64bits_digest(hashState);
+	XXH3_freeState(hashState);
+
+	std::sort(latencies.begin(), latencies.end());
+	result.latencyP50 = latencies[latencies.size() / 2];
+	result.latencyP99 = latencies[std::min(latencies.size() - 1, (latencies.size() * 99) / 100)];
+	result.latencyMax = latencies.back();
+	return result;
+}
+
+static void PrintPassResult(const char* name, const ReadList& reads, const PASS_RESULT& result)
+{
+	double time = std::max(result.time, 1e-9);
+	printf("%-12s %8d %10.1f %10.0f %10.3f %10.3f %10.3f %8.2f\r\n", name, static_cast<int>(reads.size()),
+	       static_cast<double>(result.byteCount) / (time * 1024 * 1024), static_cast<double>(reads.size()) / time,
+	       result.latencyP50, result.latencyP99, result.latencyMax, result.cpuTime);
+}
+
+//Returns true and sets the data track hash if the whole track was read
+static bool RunBenchmark(const fs::path& imagePath, const OPTIONS& options, uint64& dataTrackHash)
+{
+	auto openStartTime = std::chrono::steady_clock::now();
+	uint32 blockCount = 0;
+	{
+		auto opticalMedia = DiskUtils::CreateOpticalMediaFromPath(imagePath, COpticalMedia::CREATE_AUTO_DISABLE_DL_DETECT);
+		blockCount = opticalMedia->GetTrackBlockProvider(0)->GetBlockCount();
+	}
+	double openTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - openStartTime).count();
+	if(blockCount == 0)
+	{
+		throw std::runtime_error("Data track is empty.");
+	}
+	printf("Opened '%s' in %0.1fms (%d sectors).\r\n\r\n", imagePath.string().c_str(), openTime, blockCount);
+
+	ReadList traceReads;
+	if(!options.tracePath.empty())
+	{
+		traceReads = LoadTraceReads(options.tracePath, blockCount);
+	}
+
+	printf("%-12s %8s %10s %10s %10s %10s %10s %8s\r\n", "Pass", "Reads", "MB/s", "IOPS", "p50 (ms)", "p99 (ms)", "max (ms)", "CPU (s)");
+
+	bool runAll = !options.sequential && !options.random && options.tracePath.empty();
+	uint64 sequentialHash = 0;
+	bool sequentialComplete = false;
+	if(runAll || options.sequential)
+	{
+		auto reads = MakeSequentialReads(blockCount, options);
+		auto result = RunPass(imagePath, reads);
+		PrintPassResult("Sequential", reads, result);
+		sequentialHash = result.hash;
+		sequentialComplete = (result.byteCount == (static_cast<uint64>(blockCount) * ISO9660::CBlockProvider::BLOCKSIZE));
+	}
+	if(runAll || options.random)
+	{
+		auto reads = MakeRandomReads(blockCount, options);
+		PrintPassResult("Random", reads, RunPass(imagePath, reads));
+	}
+	if(!traceReads.empty())
+	{
+		PrintPassResult("Trace", traceReads, RunPass(imagePath, traceReads));
+	}
+
+	//Images holding the same data have the same hash, regardless of their format
+	if(sequentialComplete)
+	{
+		printf("\r\nData track hash (XXH3): %016llx\r\n", static_cast<unsigned long long>(sequentialHash));
+	}
+	dataTrackHash = sequentialHash;
+	return sequentialComplete;
+}
+
+static fs::path ConvertImage(const fs::path& isoPath, const char* extension, const std::function<void(Framework::CStream&, Framework::CStream&)>& convertFunction)
+{
+	auto outputPath = fs::temp_directory_path() / isoPath.filename();
+	outputPath.replace_extension(std::string(".discbench") + extension);
+
+	auto startTime = std::chrono::steady_clock::now();
+	try
+	{
+		auto inputStream = Framework::CreateInputStdStream(isoPath.native());
+		auto outputStream = Framework::CreateOutputStdStream(outputPath.native());
+		convertFunction(outputStream, inputStream);
+	}
+	catch(...)
+	{
+		fs::remove(outputPath);
+		throw;
+	}
+	double conversionTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	printf("Converted to '%s' in %0.2fs, %0.1f%% of the original size.\r\n\r\n", outputPath.string().c_str(), conversionTime,
+	       100.0 * static_cast<double>(fs::file_size(outputPath)) / static_cast<double>(std::max<uint64>(fs::file_size(isoPath), 1)));
+	return outputPath;
+}
+
+static fs::path ConvertToCso(const fs::path& isoPath, const OPTIONS& options)
+{
+	return ConvertImage(isoPath, ".cso",
+	                    [&](Framework::CStream& output, Framework::CStream& input) {
+		                    WriteCsoImage(output, input, options.csoFrameSize);
+	                    });
+}
+
+static fs::path ConvertToZci(const fs::path& isoPath, const OPTIONS& options)
+{
+	return ConvertImage(isoPath, ".zci",
+	                    [&](Framework::CStream& output, Framework::CStream& input) {
+		                    CZciImageWriter::OPTIONS writerOptions;
+		                    writerOptions.chunkSize = options.zciChunkSize;
+		                    CZciImageWriter writer(output, writerOptions);
+		                    std::vector<uint8> buffer(0x100000);
+		                    while(uint64 readSize = input.Read(buffer.data(), buffer.size()))
+		                    {
+			                    writer.Write(buffer.data(), readSize);
+		                    }
+		                    writer.Finish();
+	                    });
+}
+
+static bool RunComparison(const fs::path& isoPath, const OPTIONS& options)
+{
+	//Converters take the raw image data, other formats would need to be decoded first
+	if(stricmp(isoPath.extension().string().c_str(), ".iso"))
+	{
+		throw std::runtime_error("Only ISO images can be compared with their CSO and ZCI conversions.");
+	}
+
+	uint64 isoHash = 0;
+	bool hasIsoHash = RunBenchmark(isoPath, options, isoHash);
+
+	bool hashesMatch = true;
+	for(auto convertFunction : {ConvertToCso, ConvertToZci})
+	{
+		printf("\r\n");
+		auto convertedPath = convertFunction(isoPath, options);
+		try
+		{
+			uint64 hash = 0;
+			if(RunBenchmark(convertedPath, options, hash) && hasIsoHash && (hash != isoHash))
+			{
+				printf("Error: Data track of '%s' doesn't match the original image.\r\n", convertedPath.string().c_str());
+				hashesMatch = false;
+			}
+		}
+		catch(...)
+		{
+			fs::remove(convertedPath);
+			throw;
+		}
+		fs::remove(convertedPath);
+	}
+	return hashesMatch;
+}
+
+int main(int argc, const char** argv)
+{
+	OPTIONS options;
+	fs::path imagePath;
+	for(int i = 1; i < argc; i++)
+	{
+		bool hasValue = (i + 1) < argc;
+		if(!strcmp(argv[i], "--sequential"))
+		{
+			options.sequential = true;
+		}
+		else if(!strcmp(argv[i], "--random"))
+		{
+			options.random = true;
+		}
+		else if(!strcmp(argv[i], "--trace") && hasValue)
+		{
+			options.tracePath = fs::path(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "--sectors") && hasValue)
+		{
+			options.sectorsPerRead = std::max<uint32>(strtoul(argv[++i], nullptr, 0), 1);
+		}
+		else if(!strcmp(argv[i], "--reads") && hasValue)
+		{
+			options.randomReadCount = std::max<uint32>(strtoul(argv[++i], nullptr, 0), 1);
+		}
+		else if(!strcmp(argv[i], "--limit") && hasValue)
+		{
+			options.sequentialSectorCount = strtoul(argv[++i], nullptr, 0);
+		}
+		else if(!strcmp(argv[i], "--seed") && hasValue)
+		{
+			options.seed = strtoul(argv[++i], nullptr, 0);
+		}
+		else if(!strcmp(argv[i], "--compare"))
+		{
+			options.compare = true;
+		}
+		else if(!strcmp(argv[i], "--frame-size") && hasValue)
+		{
+			options.csoFrameSize = strtoul(argv[++i], nullptr, 0);
+		}
+		else if(!strcmp(argv[i], "--chunk-size") && hasValue)
+		{
+			options.zciChunkSize = strtoul(argv[++i], nullptr, 0);
+		}
+		else if(!strncmp(argv[i], "--", 2) || !imagePath.empty())
+		{
+			PrintUsage();
+			return -1;
+		}
+		else
+		{
+			imagePath = fs::path(argv[i]);
+		}
+	}
+
+	if(imagePath.empty())
+	{
+		PrintUsage();
+		return -1;
+	}
+
+	if((options.csoFrameSize < 0x800) || (options.csoFrameSize & (options.csoFrameSize - 1)))
+	{
+		printf("Error: Frame size must be a power of two, at least 2048.\r\n");
+		return -1;
+	}
+
+	try
+	{
+		if(options.compare)
+		{
+			if(!RunComparison(imagePath, options))
+			{
+				return -1;
+			}
+		}
+		else
+		{
+			uint64 dataTrackHash = 0;
+			RunBenchmark(imagePath, options, dataTrackHash);
+		}
+	}
+	catch(const std::exception& exception)
+	{
+		printf("Error: %s\r\n", exception.what());
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "filesystem_def.h"
+#include "StdStreamUtils.h"
+#include "DiskUtils.h"
+#include "ISO9660/BlockProvider.h"
+#include "discimages/ZciImageWriter.h"
+
+#define BATCH_BLOCK_COUNT (0x100)
+#define CDROMXA_BLOCK_SIZE (0x930)
+
+static void PrintUsage()
+{
+	printf("Usage: DiscImageConverter [options] <input image> <output.zci>\r\n");
+	printf("Converts any disc image supported by Play! to a ZCI image.\r\n");
+	printf("Options: \r\n");
+	printf("\t --level <level>\t zstd compression level (default: %d).\r\n", CZciImageWriter::DEFAULT_COMPRESSION_LEVEL);
+	printf("\t --chunk-size <size>\t Size of independently compressed chunks, multiple of 2048 (default: %d).\r\n", CZciImageWriter::DEFAULT_CHUNK_SIZE);
+	printf("\t --dictionary <path>\t zstd dictionary to embed and compress chunks with (made with 'zstd --train').\r\n");
+	printf("\t --threads <count>\t Number of compression threads (default: number of cores).\r\n");
+}
+
+static std::vector<uint8> ReadDictionary(const fs::path& dictionaryPath)
+{
+	auto stream = Framework::CreateInputStdStream(dictionaryPath.native());
+	std::vector<uint8> result(stream.GetLength());
+	if(stream.Read(result.data(), result.size()) != result.size())
+	{
+		throw std::runtime_error("Failed to read dictionary.");
+	}
+	return result;
+}
+
+static void ConvertImage(const fs::path& inputPath, const fs::path& outputPath, const CZciImageWriter::OPTIONS& options)
+{
+	auto opticalMedia = DiskUtils::CreateOpticalMediaFromPath(inputPath, COpticalMedia::CREATE_AUTO_DISABLE_DL_DETECT);
+	auto blockProvider = opticalMedia->GetTrackBlockProvider(0);
+	uint32 blockCount = blockProvider->GetBlockCount();
+	uint32 rawBlockSize = blockProvider->GetRawBlockSize();
+
+	//CD-ROM XA images keep their raw sectors (minus subchannel data, if any) to be detected as such when opened.
+	//Everything else only keeps user data.
+	bool keepRawBlocks = (opticalMedia->GetTrackDataType(0) == COpticalMedia::TRACK_DATA_TYPE_MODE2_2352) && (rawBlockSize >= CDROMXA_BLOCK_SIZE);
+	uint32 outputBlockSize = keepRawBlocks ? CDROMXA_BLOCK_SIZE : ISO9660::CBlockProvider::BLOCKSIZE;
+
+	printf("Converting '%s' (%d blocks of %d bytes)...\r\n", inputPath.string().c_str(), blockCount, outputBlockSize);
+
+	auto startTime = std::chrono::steady_clock::now();
+	auto outputStream = Framework::CreateOutputStdStream(outputPath.native());
+	CZciImageWriter writer(outputStream, options);
+
+	std::vector<uint8> batch(BATCH_BLOCK_COUNT * outputBlockSize);
+	std::vector<uint8> rawBlock(rawBlockSize);
+	int lastProgress = -1;
+	for(uint32 blockIndex = 0; blockIndex < blockCount; blockIndex += BATCH_BLOCK_COUNT)
+	{
+		uint32 batchBlockCount = std::min<uint32>(BATCH_BLOCK_COUNT, blockCount - blockIndex);
+		if(keepRawBlocks)
+		{
+			for(uint32 i = 0; i < batchBlockCount; i++)
+			{
+				blockProvider->ReadRawBlock(blockIndex + i, rawBlock.data());
+				memcpy(batch.data() + (i * outputBlockSize), rawBlock.data(), outputBlockSize);
+			}
+		}
+		else
+		{
+			blockProvider->ReadBlocks(blockIndex, batchBlockCount, batch.data());
+		}
+		writer.Write(batch.data(), static_cast<uint64>(batchBlockCount) * outputBlockSize);
+
+		int progress = static_cast<int>((static_cast<uint64>(blockIndex + batchBlockCount) * 100) / blockCount);
+		if(progress != lastProgress)
+		{
+			printf("\r%d%%", progress);
+			fflush(stdout);
+			lastProgress = progress;
+		}
+	}
+	writer.Finish();
+
+	double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	uint64 inputSize = static_cast<uint64>(blockCount) * outputBlockSize;
+	printf("\rConverted in %0.2fs, ZCI image is %0.1f%% of the original size.\r\n", time,
+	       (inputSize != 0) ? (100.0 * static_cast<double>(writer.GetCompressedSize()) / static_cast<double>(inputSize)) : 0.0);
+}
+
+int main(int argc, const char** argv)
+{
+	CZciImageWriter::OPTIONS options;
+	std::vector<fs::path> paths;
+	for(int i = 1; i < argc; i++)
+	{
+		bool hasValue = (i + 1) < argc;
+		if(!strcmp(argv[i], "--level") && hasValue)
+		{
+			options.compressionLevel = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "--chunk-size") && hasValue)
+		{
+			options.chunkSize = strtoul(argv[++i], nullptr, 0);
+		}
+		else if(!strcmp(argv[i], "--threads") && hasValue)
+		{
+			options.threadCount = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "--dictionary") && hasValue)
+		{
+			try
+			{
+				options.dictionary = ReadDictionary(fs::path(argv[++i]));
+			}
+			catch(const std::exception& exception)
+			{
+				printf("Error: Failed to load dictionary: %s\r\n", exception.what());
+				return -1;
+			}
+		}
+		else if(!strncmp(argv[i], "--", 2))
+		{
+			PrintUsage();
+			return -1;
+		}
+		else
+		{
+			paths.push_back(fs::path(argv[i]));
+		}
+	}
+
+	if(paths.size() != 2)
+	{
+		PrintUsage();
+		return -1;
+	}
+
+	try
+	{
+		ConvertImage(paths[0], paths[1], options);
+	}
+	catch(const std::exception& exception)
+	{
+		printf("\r\nError: %s\r\n", exception.what());
+		std::error_code removeError;
+		fs::remove(paths[1], removeError);
+		return -1;
+	}
+
+	return 0;
+}
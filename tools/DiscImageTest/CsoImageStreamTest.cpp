@@ -0,0 +1,81 @@
+#include "CsoImageStreamTest.h"
+#include <cstring>
+#include "MemStream.h"
+#include "PtrStream.h"
+#include "discimages/CsoImageStream.h"
+#include "discimages/CsoImageWriter.h"
+
+void CCsoImageStreamTest::Execute()
+{
+	TestImage(0x800, 0);
+	TestImage(0x800, 2);
+	TestImage(0x4000, 4);
+}
+
+std::vector<uint8> CCsoImageStreamTest::CreateImageData(uint64 size)
+{
+	//Mix of runs that compress well and noise that ends up stored uncompressed
+	std::vector<uint8> result(size);
+	for(uint64 i = 0; i < size; i++)
+	{
+		uint64 sector = i / 0x800;
+		bool noise = (sector % 7) == 3;
+		result[i] = noise ? static_cast<uint8>(NextRandom()) : static_cast<uint8>(sector + (i % 0x800) / 0x40);
+	}
+	return result;
+}
+
+void CCsoImageStreamTest::TestImage(uint32 frameSize, uint8 indexShift)
+{
+	//Not a multiple of the frame size to make sure the last frame is handled properly
+	static const uint64 imageSize = (0x800 * 1500) + 0x123;
+
+	auto imageData = CreateImageData(imageSize);
+	Framework::CPtrStream inputStream(imageData.data(), imageData.size());
+	auto csoStream = std::make_unique<Framework::CMemStream>();
+	WriteCsoImage(*csoStream, inputStream, frameSize, indexShift);
+
+	CCsoImageStream stream(std::move(csoStream));
+
+	auto checkRange = [&](uint64 position, uint64 size) {
+		std::vector<uint8> buffer(size);
+		stream.Seek(position, Framework::STREAM_SEEK_SET);
+		uint64 expectedSize = (position < imageSize) ? std::min<uint64>(size, imageSize - position) : 0;
+		TEST_VERIFY(stream.Read(buffer.data(), size) == expectedSize);
+		TEST_VERIFY(!memcmp(buffer.data(), imageData.data() + position, expectedSize));
+	};
+
+	//Sector by sector, read ahead kicks in
+	for(uint64 position = 0; position < imageSize; position += 0x800)
+	{
+		checkRange(position, 0x800);
+	}
+
+	//Large reads spanning many frames
+	checkRange(0x10, 0x40000);
+	checkRange(imageSize - 0x1000, 0x2000);
+
+	//Random reads mixed with short sequential runs
+	for(unsigned int i = 0; i < 500; i++)
+	{
+		uint64 position = NextRandom() % imageSize;
+		uint64 size = (NextRandom() % 0x1800) + 1;
+		checkRange(position, size);
+		checkRange(position + size, 0x800);
+	}
+
+	//Smallest cache possible, frames get evicted while reading ahead
+	stream.SetReadAheadFrameCount(4);
+	stream.SetFrameCacheSize(0);
+	for(uint64 position = 0; position < imageSize; position += 0x800)
+	{
+		checkRange(position, 0x800);
+	}
+
+	//Read ahead disabled
+	stream.SetReadAheadFrameCount(0);
+	for(unsigned int i = 0; i < 200; i++)
+	{
+		checkRange(NextRandom() % imageSize, 0x800);
+	}
+}
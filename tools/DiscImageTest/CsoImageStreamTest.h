@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+
+class CCsoImageStreamTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	std::vector<uint8> CreateImageData(uint64);
+	void TestImage(uint32, uint8);
+};
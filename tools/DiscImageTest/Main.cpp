@@ -0,0 +1,29 @@
+#include <functional>
+#include "CsoImageStreamTest.h"
+#include "PathIndexTest.h"
+#include "S3ObjectStreamTest.h"
+#include "ZciImageStreamTest.h"
+
+typedef std::function<CTest*()> TestFactoryFunction;
+
+// clang-format off
+static const TestFactoryFunction s_factories[] =
+{
+	[]() { return new CCsoImageStreamTest(); },
+	[]() { return new CPathIndexTest(); },
+	[]() { return new CS3ObjectStreamTest(); },
+	[]() { return new CZciImageStreamTest(); },
+};
+// clang-format on
+
+int main(int argc, const char** argv)
+{
+	for(const auto& factory : s_factories)
+	{
+		auto test = factory();
+		test->Execute();
+		delete test;
+	}
+
+	return 0;
+}
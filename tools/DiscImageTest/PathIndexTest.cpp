@@ -0,0 +1,270 @@
+#include "PathIndexTest.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include "MemStream.h"
+#include "string_format.h"
+#include "ISO9660/BlockProvider.h"
+#include "ISO9660/PathIndex.h"
+
+#define BLOCKSIZE 0x800
+#define VOLUME_DESCRIPTOR_LBA 16
+#define PATH_TABLE_LBA 18
+#define FIRST_DIRECTORY_LBA 20
+
+static void WriteBoth16(uint8* output, uint16 value)
+{
+	output[0] = static_cast<uint8>(value);
+	output[1] = static_cast<uint8>(value >> 8);
+	output[2] = output[1];
+	output[3] = output[0];
+}
+
+static void WriteBoth32(uint8* output, uint32 value)
+{
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		output[i] = static_cast<uint8>(value >> (i * 8));
+		output[7 - i] = output[i];
+	}
+}
+
+static uint32 GetRecordLength(size_t nameLength)
+{
+	//Records are padded to an even size
+	return static_cast<uint32>(33 + nameLength + ((nameLength + 1) % 2));
+}
+
+static uint32 WriteRecord(uint8* output, const std::string& name, uint32 position, uint32 size, bool isDirectory)
+{
+	uint32 length = GetRecordLength(name.size());
+	memset(output, 0, length);
+	output[0] = static_cast<uint8>(length);
+	WriteBoth32(output + 2, position);
+	WriteBoth32(output + 10, size);
+	output[25] = isDirectory ? 2 : 0;
+	WriteBoth16(output + 28, 1);
+	output[32] = static_cast<uint8>(name.size());
+	memcpy(output + 33, name.data(), name.size());
+	return length;
+}
+
+void CPathIndexTest::Execute()
+{
+	auto tree = CreateTree();
+	auto blockProvider = std::make_shared<ISO9660::CBlockProvider2048>(CreateImage(tree));
+
+	//Index isn't enabled, lookups go through the directory walk
+	CISO9660 iso(blockProvider);
+
+	std::atomic<bool> cancelled = {false};
+	auto index = ISO9660::CPathIndex::Build(blockProvider.get(), tree[0].position, cancelled);
+	TEST_VERIFY(index);
+
+	static const uint64 contentHash = 0x0123456789ABCDEFULL;
+	Framework::CMemStream indexStream;
+	index->Save(indexStream, contentHash);
+	indexStream.Seek(0, Framework::STREAM_SEEK_SET);
+	auto loadedIndex = ISO9660::CPathIndex::Load(indexStream, contentHash);
+	TEST_VERIFY(loadedIndex);
+	indexStream.Seek(0, Framework::STREAM_SEEK_SET);
+	TEST_VERIFY(!ISO9660::CPathIndex::Load(indexStream, contentHash + 1));
+
+	std::vector<std::string> queries =
+	    {
+	        "", "/", "\\", "SYSTEM.CNF;1", "/SYSTEM.CNF", "\\system.cnf;1", "SYSTEM.CNF;10", "SYSTEM", "S",
+	        "DATA", "data", "DATA/", "DATA/FILE14", "DATA/FILE1", "DATA/SUB", "DATA/SUB/", "DATA/SUB/A",
+	        "DATA/SUB/A.TXT", "DATA/SUB/A.TXT;1", "DATA/SUB/A.TXT;10", "DATA/SUB/AB", "DATA/SUB/C.TXT",
+	        "DATA/NOPE", "NOPE/FILE", "EMPTY", "EMPTY/", "EMPTY/X", "SYSTEM.CNF;1/X"};
+
+	//Every file of the image, with and without version suffix, in upper and lower case
+	std::vector<std::string> directoryPaths(tree.size());
+	for(uint32 directoryIndex = 1; directoryIndex < tree.size(); directoryIndex++)
+	{
+		const auto& directory = tree[directoryIndex];
+		const auto& parentPath = directoryPaths[directory.parentIndex];
+		directoryPaths[directoryIndex] = parentPath.empty() ? directory.name : (parentPath + "/" + directory.name);
+	}
+	for(uint32 directoryIndex = 0; directoryIndex < tree.size(); directoryIndex++)
+	{
+		const auto& directoryPath = directoryPaths[directoryIndex];
+		for(const auto& entry : tree[directoryIndex].entries)
+		{
+			auto path = directoryPath.empty() ? entry.name : (directoryPath + "/" + entry.name);
+			auto lowerPath = path;
+			std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+			queries.push_back(path);
+			queries.push_back(lowerPath);
+			auto versionPosition = path.find(';');
+			if(versionPosition != std::string::npos)
+			{
+				queries.push_back(path.substr(0, versionPosition));
+				queries.push_back(lowerPath.substr(0, versionPosition));
+			}
+		}
+	}
+
+	for(const auto& query : queries)
+	{
+		ISO9660::CDirectoryRecord record;
+		bool found = iso.GetFileRecord(&record, query.c_str());
+		auto expected = DescribeRecord(found, record);
+
+		ISO9660::CDirectoryRecord indexRecord;
+		found = index->GetFileRecord(&indexRecord, query.c_str());
+		TEST_VERIFY(DescribeRecord(found, indexRecord) == expected);
+
+		ISO9660::CDirectoryRecord loadedIndexRecord;
+		found = loadedIndex->GetFileRecord(&loadedIndexRecord, query.c_str());
+		TEST_VERIFY(DescribeRecord(found, loadedIndexRecord) == expected);
+	}
+
+	cancelled = true;
+	TEST_VERIFY(!ISO9660::CPathIndex::Build(blockProvider.get(), tree[0].position, cancelled));
+}
+
+CPathIndexTest::DirectoryArray CPathIndexTest::CreateTree()
+{
+	//Directories are in path table order (parents before their children)
+	DirectoryArray tree(4);
+
+	auto& root = tree[0];
+	root.entries.push_back({"DATA", 1});
+	root.entries.push_back({"EMPTY", 2});
+	root.entries.push_back({"SYSTEM.CNF;1", ~0U, 30});
+
+	//Spans multiple blocks
+	auto& data = tree[1];
+	data.name = "DATA";
+	data.parentIndex = 0;
+	for(uint32 i = 0; i < 150; i++)
+	{
+		data.entries.push_back({string_format("FILE%03d.BIN;1", i), ~0U, 100 + (i * 37)});
+	}
+	data.entries.push_back({"SUB", 3});
+
+	auto& empty = tree[2];
+	empty.name = "EMPTY";
+	empty.parentIndex = 0;
+
+	//Not sorted, a lookup must return the first record that starts with the name
+	auto& sub = tree[3];
+	sub.name = "SUB";
+	sub.parentIndex = 1;
+	sub.entries.push_back({"A.TXT;10", ~0U, 10});
+	sub.entries.push_back({"A.TXT;1", ~0U, 5});
+	sub.entries.push_back({"AB.TXT;1", ~0U, 6});
+
+	return tree;
+}
+
+std::shared_ptr<Framework::CStream> CPathIndexTest::CreateImage(DirectoryArray& tree)
+{
+	//Lay out directories, then files
+	uint32 position = FIRST_DIRECTORY_LBA;
+	for(auto& directory : tree)
+	{
+		//Records can't cross block boundaries, '.' and '..' records are 34 bytes long
+		uint32 blockCount = 1;
+		uint32 blockOffset = GetRecordLength(1) * 2;
+		for(const auto& entry : directory.entries)
+		{
+			uint32 recordLength = GetRecordLength(entry.name.size());
+			if((blockOffset + recordLength) > BLOCKSIZE)
+			{
+				blockCount++;
+				blockOffset = 0;
+			}
+			blockOffset += recordLength;
+		}
+		directory.position = position;
+		directory.size = blockCount * BLOCKSIZE;
+		position += blockCount;
+	}
+	for(auto& directory : tree)
+	{
+		for(auto& entry : directory.entries)
+		{
+			if(entry.directoryIndex != ~0U)
+			{
+				entry.position = tree[entry.directoryIndex].position;
+				entry.size = tree[entry.directoryIndex].size;
+			}
+			else
+			{
+				entry.position = position;
+				position += std::max<uint32>((entry.size + BLOCKSIZE - 1) / BLOCKSIZE, 1);
+			}
+		}
+	}
+
+	std::vector<uint8> image(position * BLOCKSIZE);
+
+	for(const auto& directory : tree)
+	{
+		const auto& parent = tree[directory.parentIndex];
+		uint32 offset = directory.position * BLOCKSIZE;
+		offset += WriteRecord(image.data() + offset, std::string(1, '\0'), directory.position, directory.size, true);
+		offset += WriteRecord(image.data() + offset, std::string(1, '\1'), parent.position, parent.size, true);
+		for(const auto& entry : directory.entries)
+		{
+			uint32 recordLength = GetRecordLength(entry.name.size());
+			if(((offset % BLOCKSIZE) + recordLength) > BLOCKSIZE)
+			{
+				offset = ((offset / BLOCKSIZE) + 1) * BLOCKSIZE;
+			}
+			offset += WriteRecord(image.data() + offset, entry.name, entry.position, entry.size, entry.directoryIndex != ~0U);
+		}
+	}
+
+	//Little endian path table
+	uint32 pathTableSize = 0;
+	{
+		uint8* pathTable = image.data() + (PATH_TABLE_LBA * BLOCKSIZE);
+		for(const auto& directory : tree)
+		{
+			auto name = directory.name.empty() ? std::string(1, '\0') : directory.name;
+			uint8* record = pathTable + pathTableSize;
+			record[0] = static_cast<uint8>(name.size());
+			record[1] = 0;
+			memcpy(record + 2, &directory.position, 4);
+			uint16 parentNumber = static_cast<uint16>(directory.parentIndex + 1);
+			memcpy(record + 6, &parentNumber, 2);
+			memcpy(record + 8, name.data(), name.size());
+			pathTableSize += 8 + static_cast<uint32>(name.size()) + (name.size() % 2);
+		}
+	}
+
+	{
+		uint8* volumeDescriptor = image.data() + (VOLUME_DESCRIPTOR_LBA * BLOCKSIZE);
+		volumeDescriptor[0] = 1;
+		memcpy(volumeDescriptor + 1, "CD001", 5);
+		volumeDescriptor[6] = 1;
+		memset(volumeDescriptor + 40, ' ', 32);
+		memcpy(volumeDescriptor + 40, "PATHINDEXTEST", 13);
+		WriteBoth32(volumeDescriptor + 80, position);
+		WriteBoth32(volumeDescriptor + 132, pathTableSize);
+		uint32 pathTablePosition = PATH_TABLE_LBA;
+		memcpy(volumeDescriptor + 140, &pathTablePosition, 4);
+		WriteRecord(volumeDescriptor + 156, std::string(1, '\0'), tree[0].position, tree[0].size, true);
+
+		uint8* terminator = volumeDescriptor + BLOCKSIZE;
+		terminator[0] = 0xFF;
+		memcpy(terminator + 1, "CD001", 5);
+	}
+
+	auto stream = std::make_shared<Framework::CMemStream>();
+	stream->Write(image.data(), image.size());
+	stream->Seek(0, Framework::STREAM_SEEK_SET);
+	return stream;
+}
+
+std::string CPathIndexTest::DescribeRecord(bool found, const ISO9660::CDirectoryRecord& record)
+{
+	if(!found)
+	{
+		return "<none>";
+	}
+	return string_format("%s@%u+%u:%u", record.GetName(), record.GetPosition(), record.GetDataLength(), record.GetFlags());
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Test.h"
+#include "ISO9660/ISO9660.h"
+
+class CPathIndexTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	struct IMAGE_ENTRY
+	{
+		std::string name;
+		uint32 directoryIndex = ~0U;
+		uint32 size = 0;
+		uint32 position = 0;
+	};
+
+	struct IMAGE_DIRECTORY
+	{
+		std::string name;
+		uint32 parentIndex = 0;
+		std::vector<IMAGE_ENTRY> entries;
+		uint32 position = 0;
+		uint32 size = 0;
+	};
+
+	typedef std::vector<IMAGE_DIRECTORY> DirectoryArray;
+
+	static DirectoryArray CreateTree();
+	static std::shared_ptr<Framework::CStream> CreateImage(DirectoryArray&);
+	static std::string DescribeRecord(bool, const ISO9660::CDirectoryRecord&);
+};
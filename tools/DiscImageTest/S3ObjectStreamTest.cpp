@@ -0,0 +1,170 @@
+#include "S3ObjectStreamTest.h"
+#ifdef HAS_AMAZON_S3
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include "StdStreamUtils.h"
+#include "s3stream/S3ObjectStream.h"
+
+#define OBJECT_SIZE ((0x40000 * 10) + 0x123)
+
+//Serves ranges of an object kept in memory
+class CMemoryRangeFetcher : public CRangeFetcher
+{
+public:
+	CMemoryRangeFetcher(const std::vector<uint8>& data, std::string etag, uint64 failingPosition = ~0ULL)
+	    : m_data(data)
+	    , m_etag(std::move(etag))
+	    , m_failingPosition(failingPosition)
+	{
+	}
+
+	OBJECT_INFO GetObjectInfo() override
+	{
+		OBJECT_INFO result;
+		result.size = m_data.size();
+		result.etag = m_etag;
+		return result;
+	}
+
+	std::vector<uint8> GetRange(uint64 position, uint64 size) override
+	{
+		TEST_VERIFY(size != 0);
+		TEST_VERIFY((position + size) <= m_data.size());
+		if((m_failingPosition >= position) && (m_failingPosition < (position + size)))
+		{
+			throw std::runtime_error("Failed to get range.");
+		}
+		return std::vector<uint8>(m_data.begin() + position, m_data.begin() + position + size);
+	}
+
+private:
+	const std::vector<uint8>& m_data;
+	std::string m_etag;
+	uint64 m_failingPosition = ~0ULL;
+};
+
+static bool CheckRange(CS3ObjectStream& stream, const std::vector<uint8>& objectData, uint64 position, uint64 size)
+{
+	std::vector<uint8> buffer(size);
+	stream.Seek(position, Framework::STREAM_SEEK_SET);
+	stream.Read(buffer.data(), size);
+	return !memcmp(buffer.data(), objectData.data() + position, size);
+}
+
+static bool CheckSequentialRead(CS3ObjectStream& stream, const std::vector<uint8>& objectData)
+{
+	stream.Seek(0, Framework::STREAM_SEEK_SET);
+	for(uint64 position = 0; position < objectData.size(); position += 0x800)
+	{
+		uint64 size = std::min<uint64>(0x800, objectData.size() - position);
+		if(!CheckRange(stream, objectData, position, size)) return false;
+	}
+	return stream.IsEOF();
+}
+#endif
+
+void CS3ObjectStreamTest::Execute()
+{
+#ifdef HAS_AMAZON_S3
+	TestReads();
+	TestCache();
+	TestFetchFailure();
+#endif
+}
+
+std::vector<uint8> CS3ObjectStreamTest::CreateObjectData(uint64 size)
+{
+	std::vector<uint8> result(size);
+	for(auto& value : result)
+	{
+		value = static_cast<uint8>(NextRandom());
+	}
+	return result;
+}
+
+void CS3ObjectStreamTest::TestReads()
+{
+#ifdef HAS_AMAZON_S3
+	auto objectData = CreateObjectData(OBJECT_SIZE);
+	CS3ObjectStream stream(std::make_unique<CMemoryRangeFetcher>(objectData, "etag"), fs::path());
+	TEST_VERIFY(stream.GetLength() == OBJECT_SIZE);
+
+	for(unsigned int i = 0; i < 200; i++)
+	{
+		uint64 position = NextRandom() % OBJECT_SIZE;
+		uint64 size = std::min<uint64>((NextRandom() % 0x50000) + 1, OBJECT_SIZE - position);
+		TEST_VERIFY(CheckRange(stream, objectData, position, size));
+	}
+
+	TEST_VERIFY(CheckSequentialRead(stream, objectData));
+	TEST_VERIFY(CheckRange(stream, objectData, 0, OBJECT_SIZE));
+#endif
+}
+
+void CS3ObjectStreamTest::TestCache()
+{
+#ifdef HAS_AMAZON_S3
+	auto cachePath = fs::temp_directory_path() / "S3ObjectStreamTest";
+	fs::remove_all(cachePath);
+
+	//Range files left by older versions must be removed, our cache file must be kept
+	auto obsoleteCacheFilePath = cachePath / "\"etag\"-0-262143";
+	fs::create_directories(cachePath);
+	Framework::CreateOutputStdStream(obsoleteCacheFilePath.native());
+
+	auto objectData = CreateObjectData(OBJECT_SIZE);
+	uint64 blockCount = 0;
+	{
+		CS3ObjectStream stream(std::make_unique<CMemoryRangeFetcher>(objectData, "\"etag/1\""), cachePath);
+		//Only read part of the object, the rest should be fetched by the next stream
+		TEST_VERIFY(CheckRange(stream, objectData, 0x50000, 0x1000));
+		TEST_VERIFY(CheckRange(stream, objectData, OBJECT_SIZE - 0x10, 0x10));
+		TEST_VERIFY(stream.GetFetchedBlockCount() == 2);
+		TEST_VERIFY(!fs::exists(obsoleteCacheFilePath));
+	}
+	{
+		CS3ObjectStream stream(std::make_unique<CMemoryRangeFetcher>(objectData, "\"etag/1\""), cachePath);
+		TEST_VERIFY(CheckSequentialRead(stream, objectData));
+		blockCount = stream.GetFetchedBlockCount() + 2;
+	}
+	{
+		//Everything is cached now
+		CS3ObjectStream stream(std::make_unique<CMemoryRangeFetcher>(objectData, "\"etag/1\""), cachePath);
+		TEST_VERIFY(CheckSequentialRead(stream, objectData));
+		TEST_VERIFY(CheckRange(stream, objectData, 0x3FFF0, 0x20));
+		TEST_VERIFY(stream.GetFetchedBlockCount() == 0);
+	}
+	{
+		//Object changed, cache must not be used
+		auto newObjectData = CreateObjectData(OBJECT_SIZE);
+		CS3ObjectStream stream(std::make_unique<CMemoryRangeFetcher>(newObjectData, "\"etag/2\""), cachePath);
+		TEST_VERIFY(CheckSequentialRead(stream, newObjectData));
+		TEST_VERIFY(stream.GetFetchedBlockCount() == blockCount);
+	}
+
+	fs::remove_all(cachePath);
+#endif
+}
+
+void CS3ObjectStreamTest::TestFetchFailure()
+{
+#ifdef HAS_AMAZON_S3
+	auto objectData = CreateObjectData(OBJECT_SIZE);
+	CS3ObjectStream stream(std::make_unique<CMemoryRangeFetcher>(objectData, "etag", 0x40000 * 5), fs::path());
+
+	//Blocks before the failing one are still readable, even if read ahead failed
+	TEST_VERIFY(CheckRange(stream, objectData, 0, 0x40000 * 5));
+
+	bool failed = false;
+	try
+	{
+		CheckSequentialRead(stream, objectData);
+	}
+	catch(const std::exception&)
+	{
+		failed = true;
+	}
+	TEST_VERIFY(failed);
+#endif
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+
+class CS3ObjectStreamTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	std::vector<uint8> CreateObjectData(uint64);
+	void TestReads();
+	void TestCache();
+	void TestFetchFailure();
+};
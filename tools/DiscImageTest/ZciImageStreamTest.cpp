@@ -0,0 +1,135 @@
+#include "ZciImageStreamTest.h"
+#include <cstring>
+#include <functional>
+#include "MemStream.h"
+#include "discimages/ZciImageStream.h"
+#include "discimages/ZciImageWriter.h"
+
+void CZciImageStreamTest::Execute()
+{
+	TestImage(0x800, 1, false);
+	TestImage(0x10000, 3, false);
+	TestImage(0x4000, 2, true);
+	TestCorruptedImage();
+}
+
+std::vector<uint8> CZciImageStreamTest::CreateImageData(uint64 size)
+{
+	//Mix of runs that compress well and noise that ends up stored uncompressed
+	std::vector<uint8> result(size);
+	for(uint64 i = 0; i < size; i++)
+	{
+		uint64 sector = i / 0x800;
+		bool noise = (sector % 61) < 40;
+		result[i] = noise ? static_cast<uint8>(NextRandom()) : static_cast<uint8>(sector + (i % 0x800) / 0x40);
+	}
+	return result;
+}
+
+void CZciImageStreamTest::TestImage(uint32 chunkSize, unsigned int threadCount, bool useDictionary)
+{
+	//Not a multiple of the chunk size to make sure the last chunk is handled properly
+	static const uint64 imageSize = (0x800 * 1500) + 0x123;
+
+	auto imageData = CreateImageData(imageSize);
+	auto zciStream = std::make_unique<Framework::CMemStream>();
+	{
+		CZciImageWriter::OPTIONS options;
+		options.chunkSize = chunkSize;
+		options.compressionLevel = 3;
+		options.threadCount = threadCount;
+		if(useDictionary)
+		{
+			//Raw content dictionary
+			options.dictionary = std::vector<uint8>(imageData.begin() + (0x800 * 40), imageData.begin() + (0x800 * 61));
+		}
+		CZciImageWriter writer(*zciStream, options);
+		//Odd sized writes, spanning chunks and batches
+		uint64 position = 0;
+		while(position < imageSize)
+		{
+			uint64 size = std::min<uint64>((NextRandom() % 0x30000) + 1, imageSize - position);
+			writer.Write(imageData.data() + position, size);
+			position += size;
+		}
+		writer.Finish();
+		TEST_VERIFY(writer.GetCompressedSize() == zciStream->GetSize());
+		TEST_VERIFY(writer.GetCompressedSize() < imageSize);
+	}
+
+	CZciImageStream stream(std::move(zciStream));
+	TEST_VERIFY(stream.GetChunkSize() == chunkSize);
+	TEST_VERIFY(stream.GetLength() == imageSize);
+
+	auto checkRange = [&](uint64 position, uint64 size) {
+		std::vector<uint8> buffer(size);
+		stream.Seek(position, Framework::STREAM_SEEK_SET);
+		uint64 expectedSize = (position < imageSize) ? std::min<uint64>(size, imageSize - position) : 0;
+		TEST_VERIFY(stream.Read(buffer.data(), size) == expectedSize);
+		TEST_VERIFY(!memcmp(buffer.data(), imageData.data() + position, expectedSize));
+	};
+
+	for(uint64 position = 0; position < imageSize; position += 0x800)
+	{
+		checkRange(position, 0x800);
+	}
+
+	checkRange(0x10, 0x40000);
+	checkRange(imageSize - 0x1000, 0x2000);
+	checkRange(imageSize, 0x800);
+
+	for(unsigned int i = 0; i < 500; i++)
+	{
+		uint64 position = NextRandom() % imageSize;
+		uint64 size = (NextRandom() % 0x1800) + 1;
+		checkRange(position, size);
+	}
+}
+
+void CZciImageStreamTest::TestCorruptedImage()
+{
+	//Compresses well, every chunk ends up compressed
+	std::vector<uint8> imageData(0x800 * 16);
+	for(size_t i = 0; i < imageData.size(); i++)
+	{
+		imageData[i] = static_cast<uint8>(i / 0x40);
+	}
+	Framework::CMemStream zciStream;
+	{
+		CZciImageWriter::OPTIONS options;
+		options.chunkSize = 0x800;
+		options.compressionLevel = 1;
+		CZciImageWriter writer(zciStream, options);
+		writer.Write(imageData.data(), imageData.size());
+		writer.Finish();
+	}
+
+	auto openImage = [&](uint64 size, const std::function<void(uint8*)>& corrupt) {
+		std::vector<uint8> data(zciStream.GetBuffer(), zciStream.GetBuffer() + size);
+		corrupt(data.data());
+		auto stream = std::make_unique<Framework::CMemStream>();
+		stream->Write(data.data(), data.size());
+		try
+		{
+			CZciImageStream imageStream(std::move(stream));
+			std::vector<uint8> buffer(imageData.size());
+			imageStream.Read(buffer.data(), buffer.size());
+			return true;
+		}
+		catch(const std::exception&)
+		{
+			return false;
+		}
+	};
+
+	uint64 size = zciStream.GetSize();
+	TEST_VERIFY(openImage(size, [](uint8*) {}));
+	//Truncated
+	TEST_VERIFY(!openImage(size - 1, [](uint8*) {}));
+	//Bad header magic
+	TEST_VERIFY(!openImage(size, [](uint8* data) { data[0] ^= 0xFF; }));
+	//Chunk offsets out of order
+	TEST_VERIFY(!openImage(size, [&](uint8* data) { data[size - 0x28 - 0x10] ^= 0x40; }));
+	//Compressed data corrupted
+	TEST_VERIFY(!openImage(size, [](uint8* data) { memset(data + 0x18, 0xFF, 4); }));
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+
+class CZciImageStreamTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	std::vector<uint8> CreateImageData(uint64);
+	void TestImage(uint32, unsigned int, bool);
+	void TestCorruptedImage();
+};
@@ -0,0 +1,208 @@
+#include "DctCoefficientTest.h"
+#include <cstring>
+#include "BitStream.h"
+#include "mpeg2/DcSizeLuminanceTable.h"
+#include "mpeg2/DctCoefficientTable0.h"
+#include "mpeg2/DctCoefficientTable1.h"
+
+//Plain bit reader, doesn't share anything with the IPU's input FIFO
+class CTestBitStream : public Framework::CBitStream
+{
+public:
+	CTestBitStream(const std::vector<uint8>& data)
+	    : m_data(data)
+	{
+	}
+
+	void Advance(uint8 bits) override
+	{
+		if((m_position + bits) > GetSize())
+		{
+			throw CBitStreamException();
+		}
+		m_position += bits;
+	}
+
+	uint8 GetBitIndex() const override
+	{
+		return static_cast<uint8>(m_position % 8);
+	}
+
+	bool TryPeekBits_LSBF(uint8, uint32&) override
+	{
+		return false;
+	}
+
+	bool TryPeekBits_MSBF(uint8 size, uint32& result) override
+	{
+		if((m_position + size) > GetSize())
+		{
+			return false;
+		}
+		result = 0;
+		for(unsigned int i = 0; i < size; i++)
+		{
+			result = (result << 1) | GetBit(m_position + i);
+		}
+		return true;
+	}
+
+	uint32 GetPosition() const
+	{
+		return m_position;
+	}
+
+private:
+	uint32 GetSize() const
+	{
+		return static_cast<uint32>(m_data.size() * 8);
+	}
+
+	uint32 GetBit(uint32 position) const
+	{
+		return (m_data[position / 8] >> (7 - (position % 8))) & 1;
+	}
+
+	const std::vector<uint8>& m_data;
+	uint32 m_position = 0;
+};
+
+static MPEG2::CDctCoefficientTable& GetCoeffTable(bool useTable1)
+{
+	if(useTable1)
+	{
+		return MPEG2::CDctCoefficientTable1::GetInstance();
+	}
+	else
+	{
+		return MPEG2::CDctCoefficientTable0::GetInstance();
+	}
+}
+
+void CDctCoefficientTest::Execute()
+{
+	//Non intra blocks always use table 0
+	TestTable(false, false, false);
+	TestTable(false, false, true);
+	TestTable(true, false, false);
+	TestTable(true, false, true);
+	TestTable(true, true, false);
+	TestTable(true, true, true);
+}
+
+void CDctCoefficientTest::TestTable(bool mbi, bool isMpeg1CoeffVLCTable, bool isMpeg2)
+{
+	//Random bits make a valid coefficient stream most of the time, including escape codes
+	std::vector<uint8> data(0x20);
+	for(unsigned int iteration = 0; iteration < 0x4000; iteration++)
+	{
+		for(auto& value : data)
+		{
+			value = static_cast<uint8>(NextRandom());
+		}
+
+		auto referenceResult = DecodeReference(data, mbi, isMpeg1CoeffVLCTable, isMpeg2);
+
+		//Data written all at once, and in two parts to make the decoder stop and resume
+		uint32 splitSize = NextRandom() % data.size();
+		for(auto writeSize : {static_cast<uint32>(data.size()), splitSize})
+		{
+			auto result = DecodeBlock(data, writeSize, mbi, isMpeg1CoeffVLCTable, isMpeg2);
+			TEST_VERIFY(result.status == referenceResult.status);
+			TEST_VERIFY(memcmp(result.block, referenceResult.block, sizeof(result.block)) == 0);
+			if(result.status == CIPU::DCT_DECODE_STATUS_DONE)
+			{
+				TEST_VERIFY(result.position == referenceResult.position);
+			}
+		}
+	}
+}
+
+//Symbol by symbol decoding, same steps as the IPU's BDEC ReadDct subcommand without the lookup table
+CDctCoefficientTest::DECODE_RESULT CDctCoefficientTest::DecodeReference(const std::vector<uint8>& data, bool mbi, bool isMpeg1CoeffVLCTable, bool isMpeg2)
+{
+	DECODE_RESULT result;
+	CTestBitStream stream(data);
+	auto& coeffTable = GetCoeffTable(mbi && !isMpeg1CoeffVLCTable);
+	unsigned int blockIndex = 0;
+	try
+	{
+		result.status = CIPU::DCT_DECODE_STATUS_NEEDMOREDATA;
+		if(mbi)
+		{
+			//Luminance DC difference, no predictor
+			uint32 dcSize = 0;
+			if(MPEG2::CDcSizeLuminanceTable::GetInstance()->TryGetSymbol(&stream, dcSize) != MPEG2::CVLCTable::DECODE_STATUS_SUCCESS)
+			{
+				return result;
+			}
+			int16 dcDiff = 0;
+			if(dcSize != 0)
+			{
+				uint32 diffValue = 0;
+				if(!stream.TryGetBits_MSBF(dcSize, diffValue))
+				{
+					return result;
+				}
+				int16 halfRange = (1 << (dcSize - 1));
+				dcDiff = static_cast<int16>(diffValue);
+				if(dcDiff < halfRange)
+				{
+					dcDiff = (dcDiff + 1) - (2 * halfRange);
+				}
+			}
+			result.block[0] = dcDiff;
+			blockIndex = 1;
+		}
+		while(1)
+		{
+			bool isEob = false;
+			if(coeffTable.TryIsEndOfBlock(&stream, isEob) != MPEG2::CVLCTable::DECODE_STATUS_SUCCESS)
+			{
+				break;
+			}
+			if((blockIndex != 0) && isEob)
+			{
+				if(coeffTable.TrySkipEndOfBlock(&stream) == MPEG2::CVLCTable::DECODE_STATUS_SUCCESS)
+				{
+					result.status = CIPU::DCT_DECODE_STATUS_DONE;
+				}
+				break;
+			}
+			MPEG2::RUNLEVELPAIR runLevelPair;
+			auto decodeStatus = (blockIndex == 0) ? coeffTable.TryGetRunLevelPairDc(&stream, &runLevelPair, isMpeg2) : coeffTable.TryGetRunLevelPair(&stream, &runLevelPair, isMpeg2);
+			if(decodeStatus == MPEG2::CVLCTable::DECODE_STATUS_SYMBOLNOTFOUND)
+			{
+				result.status = CIPU::DCT_DECODE_STATUS_ERROR;
+				break;
+			}
+			if(decodeStatus != MPEG2::CVLCTable::DECODE_STATUS_SUCCESS)
+			{
+				break;
+			}
+			blockIndex += runLevelPair.run;
+			if(blockIndex >= 0x40)
+			{
+				result.status = CIPU::DCT_DECODE_STATUS_ERROR;
+				break;
+			}
+			result.block[blockIndex] = static_cast<int16>(runLevelPair.level);
+			blockIndex++;
+		}
+	}
+	catch(...)
+	{
+		result.status = CIPU::DCT_DECODE_STATUS_ERROR;
+	}
+	result.position = stream.GetPosition();
+	return result;
+}
+
+//Goes through the IPU's BDEC ReadDct subcommand, which uses the multi-symbol lookup table on the input FIFO
+CDctCoefficientTest::DECODE_RESULT CDctCoefficientTest::DecodeBlock(const std::vector<uint8>& data, uint32 firstWriteSize, bool mbi, bool isMpeg1CoeffVLCTable, bool isMpeg2)
+{
+	DECODE_RESULT result;
+	result.status = CIPU::DecodeDctBlock(result.block, result.position, data.data(), static_cast<uint32>(data.size()), firstWriteSize,
+	                                     mbi, isMpeg1CoeffVLCTable, isMpeg2);
+	return result;
+}
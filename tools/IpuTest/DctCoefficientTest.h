@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+#include "ee/IPU.h"
+
+class CDctCoefficientTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	struct DECODE_RESULT
+	{
+		int16 block[0x40] = {};
+		uint32 position = 0;
+		CIPU::DCT_DECODE_STATUS status = CIPU::DCT_DECODE_STATUS_DONE;
+	};
+
+	void TestTable(bool, bool, bool);
+
+	static DECODE_RESULT DecodeReference(const std::vector<uint8>&, bool, bool, bool);
+	static DECODE_RESULT DecodeBlock(const std::vector<uint8>&, uint32, bool, bool, bool);
+};
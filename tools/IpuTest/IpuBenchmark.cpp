@@ -0,0 +1,346 @@
+#include "IpuBenchmark.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "StdStreamUtils.h"
+
+//Bits from the IPU_CTRL register
+#define IPU_CTRL_BIT_ECD (0x00004000)
+#define IPU_CTRL_BIT_RST (0x40000000)
+
+//IDEC waits for some time before starting, make sure we go through it immediately
+#define IDEC_DELAY_TICKS (1000)
+
+// clang-format off
+static const uint8 g_zigZagTable[0x40] =
+{
+	0,  1,  8,  16, 9,  2,  3,  10,
+	17, 24, 32, 25, 18, 11, 4,  5,
+	12, 19, 26, 33, 40, 48, 41, 34,
+	27, 20, 13, 6,  7,  14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36,
+	29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46,
+	53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+static const uint8 g_defaultIntraIq[0x40] =
+{
+	8,  16, 19, 22, 26, 27, 29, 34,
+	16, 16, 22, 24, 27, 29, 34, 37,
+	19, 22, 26, 27, 29, 34, 34, 38,
+	22, 22, 26, 27, 29, 34, 37, 40,
+	22, 26, 27, 29, 32, 35, 40, 48,
+	26, 27, 29, 32, 35, 40, 48, 58,
+	26, 27, 29, 34, 38, 46, 56, 69,
+	27, 29, 35, 38, 46, 56, 69, 83,
+};
+// clang-format on
+
+static const uint8 g_sequenceEndCode[4] = {0x00, 0x00, 0x01, 0xB7};
+
+class CHeaderBitReader
+{
+public:
+	CHeaderBitReader(const uint8* data, uint32 size)
+	    : m_data(data)
+	    , m_size(size)
+	{
+	}
+
+	uint32 Read(unsigned int bitCount)
+	{
+		uint32 result = 0;
+		for(unsigned int i = 0; i < bitCount; i++)
+		{
+			uint32 byteIndex = m_position / 8;
+			uint32 bit = (byteIndex < m_size) ? ((m_data[byteIndex] >> (7 - (m_position % 8))) & 1) : 0;
+			result = (result << 1) | bit;
+			m_position++;
+		}
+		return result;
+	}
+
+	uint32 GetPosition() const
+	{
+		return m_position;
+	}
+
+private:
+	const uint8* m_data = nullptr;
+	uint32 m_size = 0;
+	uint32 m_position = 0;
+};
+
+CIpuBenchmark::CIpuBenchmark()
+    : m_ipu(m_intc)
+{
+	m_ipu.SetDMA3ReceiveHandler(
+	    [this](const void*, uint32 qwc) {
+		    m_stats.outputSize += qwc * 0x10;
+		    return qwc;
+	    });
+}
+
+bool CIpuBenchmark::Run(const fs::path& streamPath, const OPTIONS& options)
+{
+	std::vector<uint8> streamData;
+	{
+		auto stream = Framework::CreateInputStdStream(streamPath.native());
+		streamData.resize(stream.GetLength());
+		stream.Read(streamData.data(), streamData.size());
+	}
+
+	m_options = options;
+	m_stats = STATS();
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < m_options.repeatCount; i++)
+	{
+		m_intc.Reset();
+		m_ipu.Reset();
+		m_streamState = STREAM_STATE();
+		ProcessStream(streamData);
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	double elapsed = std::chrono::duration<double>(endTime - startTime).count();
+	uint32 macroblockSize = m_options.rgb16 ? (0x100 * sizeof(uint16)) : (0x100 * sizeof(uint32));
+	uint64 macroblockCount = m_stats.outputSize / macroblockSize;
+
+	printf("Decoded %d pictures (%d slices, %d skipped, %d failed) in %.3fs.\r\n",
+	       m_stats.pictureCount, m_stats.sliceCount, m_stats.skippedSliceCount, m_stats.failedSliceCount, elapsed);
+	printf("%.1f pictures/s, %.1f macroblocks/s, %.2f MB/s of input.\r\n",
+	       m_stats.pictureCount / elapsed, macroblockCount / elapsed,
+	       (static_cast<double>(streamData.size()) * m_options.repeatCount) / (elapsed * 1024 * 1024));
+
+	return m_stats.failedSliceCount == 0;
+}
+
+void CIpuBenchmark::ProcessStream(const std::vector<uint8>& streamData)
+{
+	uint32 streamSize = static_cast<uint32>(streamData.size());
+	uint32 currentCodePosition = ~0U;
+	for(uint32 i = 0; i <= streamSize; i++)
+	{
+		bool isStartCode = ((i + 4) <= streamSize) && (streamData[i + 0] == 0) && (streamData[i + 1] == 0) && (streamData[i + 2] == 1);
+		if(!isStartCode && (i != streamSize)) continue;
+
+		if(currentCodePosition != ~0U)
+		{
+			uint8 code = streamData[currentCodePosition + 3];
+			const uint8* payload = streamData.data() + currentCodePosition + 4;
+			uint32 payloadSize = i - (currentCodePosition + 4);
+			if(code == 0xB3)
+			{
+				ProcessSequenceHeader(payload, payloadSize);
+			}
+			else if(code == 0xB5)
+			{
+				ProcessExtension(payload, payloadSize);
+			}
+			else if(code == 0x00)
+			{
+				ProcessPictureHeader(payload, payloadSize);
+			}
+			else if((code >= 0x01) && (code <= 0xAF))
+			{
+				ProcessSlice(payload, payloadSize);
+			}
+		}
+
+		currentCodePosition = i;
+		if(isStartCode) i += 3;
+	}
+}
+
+void CIpuBenchmark::ProcessSequenceHeader(const uint8* data, uint32 size)
+{
+	CHeaderBitReader reader(data, size);
+	reader.Read(12); //horizontal_size_value
+	reader.Read(12); //vertical_size_value
+	reader.Read(4);  //aspect_ratio_information
+	reader.Read(4);  //frame_rate_code
+	reader.Read(18); //bit_rate_value
+	reader.Read(1);  //marker_bit
+	reader.Read(10); //vbv_buffer_size_value
+	reader.Read(1);  //constrained_parameters_flag
+
+	uint8 intraIq[0x40];
+	uint8 nonIntraIq[0x40];
+
+	if(reader.Read(1))
+	{
+		for(unsigned int i = 0; i < 0x40; i++)
+		{
+			intraIq[i] = static_cast<uint8>(reader.Read(8));
+		}
+	}
+	else
+	{
+		for(unsigned int i = 0; i < 0x40; i++)
+		{
+			intraIq[i] = g_defaultIntraIq[g_zigZagTable[i]];
+		}
+	}
+
+	if(reader.Read(1))
+	{
+		for(unsigned int i = 0; i < 0x40; i++)
+		{
+			nonIntraIq[i] = static_cast<uint8>(reader.Read(8));
+		}
+	}
+	else
+	{
+		memset(nonIntraIq, 16, sizeof(nonIntraIq));
+	}
+
+	SetIq(intraIq, false);
+	SetIq(nonIntraIq, true);
+
+	//Will be cleared if a sequence extension follows
+	m_streamState.isMpeg1 = true;
+}
+
+void CIpuBenchmark::ProcessExtension(const uint8* data, uint32 size)
+{
+	CHeaderBitReader reader(data, size);
+	uint32 extensionId = reader.Read(4);
+	switch(extensionId)
+	{
+	case 1:
+		//Sequence extension
+		m_streamState.isMpeg1 = false;
+		break;
+	case 8:
+		//Picture coding extension
+		reader.Read(16); //f_code[2][2]
+		m_streamState.dcPrecision = reader.Read(2);
+		m_streamState.pictureStructure = reader.Read(2);
+		reader.Read(1); //top_field_first
+		m_streamState.framePredFrameDct = (reader.Read(1) != 0);
+		reader.Read(1); //concealment_motion_vectors
+		m_streamState.qScaleType = (reader.Read(1) != 0);
+		m_streamState.intraVlcFormat = (reader.Read(1) != 0);
+		m_streamState.alternateScan = (reader.Read(1) != 0);
+		break;
+	}
+}
+
+void CIpuBenchmark::ProcessPictureHeader(const uint8* data, uint32 size)
+{
+	CHeaderBitReader reader(data, size);
+	reader.Read(10); //temporal_reference
+	m_streamState.pictureType = reader.Read(3);
+	m_streamState.dcPrecision = 0;
+	m_streamState.pictureStructure = 3;
+	m_streamState.framePredFrameDct = true;
+	m_streamState.qScaleType = false;
+	m_streamState.intraVlcFormat = false;
+	m_streamState.alternateScan = false;
+	if(m_streamState.pictureType == 1)
+	{
+		m_stats.pictureCount++;
+	}
+}
+
+void CIpuBenchmark::ProcessSlice(const uint8* data, uint32 size)
+{
+	//IDEC only handles intra pictures
+	if(m_streamState.pictureType != 1) return;
+
+	CHeaderBitReader reader(data, size);
+	uint32 qsc = reader.Read(5);
+	while(reader.Read(1))
+	{
+		reader.Read(8); //extra_information_slice
+	}
+
+	//IDEC starts decoding at the macroblock type, skip over the first address increment
+	if(reader.Read(1) != 1)
+	{
+		m_stats.skippedSliceCount++;
+		return;
+	}
+
+	uint32 fb = reader.GetPosition();
+	assert(fb < 0x40);
+
+	//dct_type is only present in frame pictures
+	bool dtd = !m_streamState.isMpeg1 && (m_streamState.pictureStructure == 3) && !m_streamState.framePredFrameDct;
+
+	uint32 command = (1 << 28); //IDEC
+	command |= (m_options.rgb16 ? 1 : 0) << 27;
+	command |= (m_options.dither ? 1 : 0) << 26;
+	command |= (dtd ? 1 : 0) << 24;
+	command |= qsc << 16;
+	command |= fb;
+
+	//Terminate the slice with a start code, like the rest of the stream would
+	std::vector<uint8> sliceData(data, data + size);
+	sliceData.insert(sliceData.end(), std::begin(g_sequenceEndCode), std::end(g_sequenceEndCode));
+
+	m_ipu.SetRegister(CIPU::IPU_CTRL, GetControlValue() | IPU_CTRL_BIT_RST);
+	if(!ExecuteCommand(command, sliceData.data(), static_cast<uint32>(sliceData.size())))
+	{
+		m_stats.failedSliceCount++;
+	}
+	m_stats.sliceCount++;
+}
+
+void CIpuBenchmark::SetIq(const uint8* matrix, bool isNonIntra)
+{
+	uint32 command = (5 << 28); //SETIQ
+	command |= (isNonIntra ? 1 : 0) << 27;
+	m_ipu.SetRegister(CIPU::IPU_CTRL, GetControlValue() | IPU_CTRL_BIT_RST);
+	ExecuteCommand(command, matrix, 0x40);
+}
+
+uint32 CIpuBenchmark::GetControlValue() const
+{
+	uint32 result = 0;
+	result |= (m_streamState.pictureType & 0x7) << 24;
+	result |= (m_streamState.isMpeg1 ? 1 : 0) << 23;
+	result |= (m_streamState.qScaleType ? 1 : 0) << 22;
+	result |= (m_streamState.intraVlcFormat ? 1 : 0) << 21;
+	result |= (m_streamState.alternateScan ? 1 : 0) << 20;
+	result |= (m_streamState.dcPrecision & 0x3) << 16;
+	return result;
+}
+
+bool CIpuBenchmark::ExecuteCommand(uint32 command, const uint8* data, uint32 size)
+{
+	//Data goes through a fake EE RAM and is fed in quadwords, like DMA channel 4 would
+	uint32 paddedSize = (size + 0xF) & ~0xF;
+	if(m_ram.size() < paddedSize)
+	{
+		m_ram.resize(paddedSize);
+	}
+	memcpy(m_ram.data(), data, size);
+	memset(m_ram.data() + size, 0, paddedSize - size);
+
+	m_ipu.SetRegister(CIPU::IPU_CMD, command);
+
+	uint32 address = 0;
+	uint32 qwc = paddedSize / 0x10;
+	while(m_ipu.WillExecuteCommand())
+	{
+		uint32 transferred = m_ipu.ReceiveDMA4(address, qwc, false, m_ram.data(), nullptr);
+		address += transferred * 0x10;
+		qwc -= transferred;
+		if(m_ipu.IsCommandDelayed())
+		{
+			m_ipu.CountTicks(IDEC_DELAY_TICKS);
+		}
+		m_ipu.ExecuteCommand();
+		if((transferred == 0) && (qwc == 0) && m_ipu.WillExecuteCommand() && !m_ipu.IsCommandDelayed())
+		{
+			//Command is starving, stream must be truncated
+			return false;
+		}
+	}
+
+	return (m_ipu.GetRegister(CIPU::IPU_CTRL) & IPU_CTRL_BIT_ECD) == 0;
+}
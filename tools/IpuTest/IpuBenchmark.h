@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include "Types.h"
+#include "filesystem_def.h"
+#include "ee/INTC.h"
+#include "ee/IPU.h"
+
+//Feeds an MPEG-1/MPEG-2 video elementary stream through the IPU, the same way games do:
+//headers are parsed on the "EE" side and every slice of intra pictures is decoded with IDEC.
+class CIpuBenchmark
+{
+public:
+	struct OPTIONS
+	{
+		bool rgb16 = false;
+		bool dither = false;
+		unsigned int repeatCount = 1;
+	};
+
+	CIpuBenchmark();
+
+	bool Run(const fs::path&, const OPTIONS&);
+
+private:
+	struct STREAM_STATE
+	{
+		bool isMpeg1 = true;
+		uint32 pictureType = 0;
+		uint32 dcPrecision = 0;
+		uint32 pictureStructure = 3;
+		bool framePredFrameDct = true;
+		bool qScaleType = false;
+		bool intraVlcFormat = false;
+		bool alternateScan = false;
+	};
+
+	struct STATS
+	{
+		uint32 pictureCount = 0;
+		uint32 sliceCount = 0;
+		uint32 skippedSliceCount = 0;
+		uint32 failedSliceCount = 0;
+		uint64 outputSize = 0;
+	};
+
+	void ProcessStream(const std::vector<uint8>&);
+	void ProcessSequenceHeader(const uint8*, uint32);
+	void ProcessExtension(const uint8*, uint32);
+	void ProcessPictureHeader(const uint8*, uint32);
+	void ProcessSlice(const uint8*, uint32);
+
+	void SetIq(const uint8*, bool);
+	uint32 GetControlValue() const;
+	bool ExecuteCommand(uint32, const uint8*, uint32);
+
+	CINTC m_intc;
+	CIPU m_ipu;
+	std::vector<uint8> m_ram;
+	OPTIONS m_options;
+	STREAM_STATE m_streamState;
+	STATS m_stats;
+};
@@ -0,0 +1,94 @@
+#include "KernelsTest.h"
+#include <cstring>
+#include "ee/IPU_Kernels.h"
+
+void CKernelsTest::Execute()
+{
+	TestDequantiseInverseScan();
+	TestYCbCrToRgb32();
+	TestRgb32ToRgb16();
+}
+
+void CKernelsTest::TestDequantiseInverseScan()
+{
+	uint8 intraIq[0x40];
+	uint8 nonIntraIq[0x40];
+
+	for(unsigned int iteration = 0; iteration < 0x1000; iteration++)
+	{
+		for(unsigned int i = 0; i < 0x40; i++)
+		{
+			intraIq[i] = static_cast<uint8>(NextRandom() | 1);
+			nonIntraIq[i] = static_cast<uint8>(NextRandom() | 1);
+		}
+
+		int16 block[0x40];
+		for(unsigned int i = 0; i < 0x40; i++)
+		{
+			//Keep a good amount of zero coefficients, like real streams
+			block[i] = ((NextRandom() & 3) == 0) ? static_cast<int16>((NextRandom() & 0xFFF) - 0x800) : 0;
+		}
+
+		bool isIntra = (iteration & 1) != 0;
+		bool isLinearQScale = (iteration & 2) != 0;
+		bool isZigZag = (iteration & 4) != 0;
+		uint32 dcPrecision = (iteration >> 3) % 3;
+		uint8 qsc = static_cast<uint8>(NextRandom() & 0x1F);
+
+		int16 referenceBlock[0x40];
+		memcpy(referenceBlock, block, sizeof(block));
+
+		IPU::Kernels::DequantiseInverseScan_Generic(referenceBlock, isIntra, qsc, isLinearQScale, dcPrecision, intraIq, nonIntraIq, isZigZag);
+		IPU::Kernels::DequantiseInverseScan(block, isIntra, qsc, isLinearQScale, dcPrecision, intraIq, nonIntraIq, isZigZag);
+
+		TEST_VERIFY(memcmp(block, referenceBlock, sizeof(block)) == 0);
+	}
+}
+
+void CKernelsTest::TestYCbCrToRgb32()
+{
+	uint8 block[0x180];
+
+	for(unsigned int iteration = 0; iteration < 0x400; iteration++)
+	{
+		for(unsigned int i = 0; i < sizeof(block); i++)
+		{
+			block[i] = static_cast<uint8>(NextRandom());
+		}
+
+		uint16 th0 = static_cast<uint16>(NextRandom() & 0x1FF);
+		uint16 th1 = static_cast<uint16>(NextRandom() & 0x1FF);
+
+		uint32 referencePixels[IPU::Kernels::MACROBLOCK_PIXELS];
+		uint32 pixels[IPU::Kernels::MACROBLOCK_PIXELS];
+
+		IPU::Kernels::ConvertYCbCrToRgb32_Generic(referencePixels, block, th0, th1);
+		IPU::Kernels::ConvertYCbCrToRgb32(pixels, block, th0, th1);
+
+		TEST_VERIFY(memcmp(pixels, referencePixels, sizeof(pixels)) == 0);
+	}
+}
+
+void CKernelsTest::TestRgb32ToRgb16()
+{
+	static const uint32 alphaValues[3] = {0x00, 0x40, 0x80};
+
+	for(unsigned int iteration = 0; iteration < 0x400; iteration++)
+	{
+		uint32 pixels[IPU::Kernels::MACROBLOCK_PIXELS];
+		for(unsigned int i = 0; i < IPU::Kernels::MACROBLOCK_PIXELS; i++)
+		{
+			pixels[i] = (NextRandom() & 0xFFFFFF) | (alphaValues[NextRandom() % 3] << 24);
+		}
+
+		bool dither = (iteration & 1) != 0;
+
+		uint16 referencePixels[IPU::Kernels::MACROBLOCK_PIXELS];
+		uint16 cvtPixels[IPU::Kernels::MACROBLOCK_PIXELS];
+
+		IPU::Kernels::ConvertRgb32ToRgb16_Generic(referencePixels, pixels, dither);
+		IPU::Kernels::ConvertRgb32ToRgb16(cvtPixels, pixels, dither);
+
+		TEST_VERIFY(memcmp(cvtPixels, referencePixels, sizeof(cvtPixels)) == 0);
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Test.h"
+
+class CKernelsTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	void TestDequantiseInverseScan();
+	void TestYCbCrToRgb32();
+	void TestRgb32ToRgb16();
+};
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include "DctCoefficientTest.h"
+#include "KernelsTest.h"
+#include "IpuBenchmark.h"
+#include "TimerTest.h"
+
+typedef std::function<CTest*()> TestFactoryFunction;
+
+// clang-format off
+static const TestFactoryFunction s_factories[] =
+{
+	[]() { return new CDctCoefficientTest(); },
+	[]() { return new CKernelsTest(); },
+	[]() { return new CTimerTest(); },
+};
+// clang-format on
+
+int main(int argc, const char** argv)
+{
+	for(const auto& factory : s_factories)
+	{
+		auto test = factory();
+		test->Execute();
+		delete test;
+	}
+
+	if(argc < 2)
+	{
+		return 0;
+	}
+
+	fs::path streamPath;
+	CIpuBenchmark::OPTIONS options;
+	for(int i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "--rgb16"))
+		{
+			options.rgb16 = true;
+		}
+		else if(!strcmp(argv[i], "--dither"))
+		{
+			options.dither = true;
+		}
+		else if(!strcmp(argv[i], "--repeat"))
+		{
+			if((i + 1) >= argc)
+			{
+				printf("Error: Count must be specified for --repeat option.\r\n");
+				return -1;
+			}
+			options.repeatCount = std::max(atoi(argv[i + 1]), 1);
+			i++;
+		}
+		else
+		{
+			streamPath = fs::path(argv[i]);
+		}
+	}
+
+	if(streamPath.empty())
+	{
+		printf("Usage: IpuTest [options] stream.m2v\r\n");
+		printf("Options: \r\n");
+		printf("\t --rgb16\t Outputs RGBA16 pixels instead of RGBA32.\r\n");
+		printf("\t --dither\t Enables dithering for RGBA16 output.\r\n");
+		printf("\t --repeat <count>\t Decodes the stream <count> times.\r\n");
+		return -1;
+	}
+
+	CIpuBenchmark benchmark;
+	return benchmark.Run(streamPath, options) ? 0 : -1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Types.h"
+
+#define TEST_VERIFY(a) \
+	if(!(a))           \
+	{                  \
+		int* p = 0;    \
+		(*p) = 0;      \
+	}
+
+class CTest
+{
+public:
+	virtual ~CTest() = default;
+	virtual void Execute() = 0;
+
+protected:
+	//Simple deterministic generator to get reproducible inputs
+	uint32 NextRandom()
+	{
+		m_randomState = (m_randomState * 1103515245) + 12345;
+		return m_randomState >> 8;
+	}
+
+private:
+	uint32 m_randomState = 0x1234;
+};
@@ -0,0 +1,97 @@
+#include "TimerTest.h"
+#include "ee/Timer.h"
+
+void CTimerTest::Execute()
+{
+	static const uint32 registerOffsets[] = {0x00, 0x10, 0x20, 0x30};
+
+	//External clock needs a GS handler, leave it out
+	static const uint32 clockSelects[] =
+	    {
+	        CTimer::MODE_CLOCK_SELECT_BUSCLOCK,
+	        CTimer::MODE_CLOCK_SELECT_BUSCLOCK16,
+	        CTimer::MODE_CLOCK_SELECT_BUSCLOCK256,
+	    };
+
+	CGSHandler* gs = nullptr;
+	CINTC eagerIntc;
+	CINTC lazyIntc;
+	CTimer eagerTimer(eagerIntc, gs);
+	CTimer lazyTimer(lazyIntc, gs);
+	uint32 pendingTicks = 0;
+
+	//Same as CSubSystem::SyncTimers, counting 0 ticks isn't a no-op when the divider changed
+	auto syncLazyTimer =
+	    [&]() {
+		    if(pendingTicks == 0) return;
+		    lazyTimer.Count(pendingTicks);
+		    pendingTicks = 0;
+	    };
+
+	for(unsigned int step = 0; step < 0x40000; step++)
+	{
+		switch(NextRandom() % 16)
+		{
+		case 0:
+		{
+			uint32 address = 0x10000000 + ((NextRandom() % 4) << 11);
+			uint32 mode = CTimer::MODE_COUNT_ENABLE | clockSelects[NextRandom() % 3];
+			mode |= NextRandom() & (CTimer::MODE_ZERO_RETURN | CTimer::MODE_EQUAL_INT_ENABLE | CTimer::MODE_OVERFLOW_INT_ENABLE);
+			//Writing the flags clears them
+			mode |= NextRandom() & (CTimer::MODE_EQUAL_FLAG | CTimer::MODE_OVERFLOW_FLAG);
+			if((NextRandom() % 8) == 0)
+			{
+				mode &= ~CTimer::MODE_COUNT_ENABLE;
+			}
+			syncLazyTimer();
+			eagerTimer.SetRegister(address + 0x10, mode);
+			lazyTimer.SetRegister(address + 0x10, mode);
+		}
+		break;
+		case 1:
+		{
+			uint32 address = 0x10000000 + ((NextRandom() % 4) << 11) + (((NextRandom() % 2) == 0) ? 0x00 : 0x20);
+			uint32 value = ((NextRandom() % 4) == 0) ? 0 : (NextRandom() & 0xFFFF);
+			syncLazyTimer();
+			eagerTimer.SetRegister(address, value);
+			lazyTimer.SetRegister(address, value);
+		}
+		break;
+		case 2:
+		case 3:
+		{
+			syncLazyTimer();
+			for(unsigned int timer = 0; timer < 4; timer++)
+			{
+				for(auto offset : registerOffsets)
+				{
+					uint32 address = 0x10000000 + (timer << 11) + offset;
+					TEST_VERIFY(eagerTimer.GetRegister(address) == lazyTimer.GetRegister(address));
+				}
+			}
+		}
+		break;
+		default:
+		{
+			//Execution chunk, from a single instruction to a full time slice
+			uint32 ticks = ((NextRandom() % 4) == 0) ? (NextRandom() % 4800) : (NextRandom() % 64);
+			eagerTimer.Count(ticks);
+			pendingTicks += ticks;
+			if(pendingTicks >= lazyTimer.GetTicksUntilNextFlag())
+			{
+				syncLazyTimer();
+			}
+		}
+		break;
+		}
+
+		//Interrupts must be raised after the same chunk
+		TEST_VERIFY(eagerIntc.GetRegister(CINTC::INTC_STAT) == lazyIntc.GetRegister(CINTC::INTC_STAT));
+		if((NextRandom() % 64) == 0)
+		{
+			uint32 stat = eagerIntc.GetRegister(CINTC::INTC_STAT);
+			eagerIntc.SetRegister(CINTC::INTC_STAT, stat);
+			lazyIntc.SetRegister(CINTC::INTC_STAT, stat);
+		}
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Test.h"
+
+//Checks that counting EE timers lazily (only when accessed or about to set a flag)
+//gives the same results as counting them after every execution chunk
+class CTimerTest : public CTest
+{
+public:
+	void Execute() override;
+};
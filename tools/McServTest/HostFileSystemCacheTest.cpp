@@ -0,0 +1,343 @@
+#include "HostFileSystemCacheTest.h"
+#include <fstream>
+#include <vector>
+#include "MemStream.h"
+#include "StdStream.h"
+
+using namespace Iop::Ioman;
+
+CHostFileSystemCacheTest::CHostFileSystemCacheTest()
+    : m_rootPath(fs::temp_directory_path() / "McServTest_HostFileSystemCache")
+{
+	fs::remove_all(m_rootPath);
+	fs::create_directories(m_rootPath);
+	m_device = std::make_unique<CPathDirectoryDevice>(m_rootPath);
+}
+
+CHostFileSystemCacheTest::~CHostFileSystemCacheTest()
+{
+	m_device.reset();
+	std::error_code errorCode;
+	fs::remove_all(m_rootPath, errorCode);
+}
+
+void CHostFileSystemCacheTest::Execute()
+{
+	TestStats();
+	TestListings();
+	TestDirectoryMoves();
+	TestSymlinks();
+	TestQueueOverflow();
+	TestFileReads();
+	TestRandomChanges();
+}
+
+void CHostFileSystemCacheTest::TestStats()
+{
+	fs::create_directories(m_rootPath / "a/b");
+	WriteFile("a/f1", 10);
+	WriteFile("a/b/f2", 20);
+
+	CheckStat("a/f1");
+	CheckStat("a//f1");
+	CheckStat("a/./f1");
+	CheckStat("a/b/");
+	CheckStat("a/none");
+	CheckStat("");
+
+	//Changes to entries we've already seen
+	WriteFile("a/f1", 30);
+	CheckStat("a/f1");
+	CheckStat("a//f1");
+	WriteFile("a/none", 5);
+	CheckStat("a/none");
+	fs::remove(m_rootPath / "a/none");
+	CheckStat("a/none");
+}
+
+void CHostFileSystemCacheTest::TestListings()
+{
+	CheckListing("a");
+
+	//Listing of the parent must be dropped when one of its items changes
+	WriteFile("a/f3", 7);
+	CheckListing("a/");
+	CheckStat("a/f3");
+	WriteFile("a/f3", 8);
+	CheckListing("a");
+	fs::remove(m_rootPath / "a/f3");
+	CheckListing("a");
+	CheckStat("a/f3");
+
+	//Stats that come from a listing
+	CheckListing("a/b");
+	WriteFile("a/b/f2", 25);
+	CheckStat("a/b/f2");
+}
+
+void CHostFileSystemCacheTest::TestDirectoryMoves()
+{
+	CheckStat("a/b/f2");
+	CheckListing("a/b");
+
+	//Everything we knew below the old path must be gone
+	fs::rename(m_rootPath / "a/b", m_rootPath / "a/c");
+	CheckStat("a/b");
+	CheckStat("a/b/f2");
+	CheckStat("a/c/f2");
+
+	//Watch of the directory we've moved away must not be used for the new one, and the other way around
+	fs::create_directories(m_rootPath / "a/b");
+	WriteFile("a/b/f2", 99);
+	CheckStat("a/b/f2");
+	CheckListing("a/b");
+	WriteFile("a/b/f4", 3);
+	CheckListing("a/b");
+	CheckListing("a/c");
+	WriteFile("a/c/f5", 3);
+	CheckStat("a/c/f5");
+	CheckListing("a/c");
+
+	//Moving the parent of a watched directory
+	CheckStat("a/c/f5");
+	fs::rename(m_rootPath / "a", m_rootPath / "z");
+	CheckStat("a/c/f5");
+	CheckStat("z/c/f5");
+	WriteFile("z/c/f5", 12);
+	CheckStat("z/c/f5");
+	CheckListing("z/c");
+	fs::rename(m_rootPath / "z", m_rootPath / "a");
+	CheckStat("z/c/f5");
+	CheckStat("a/c/f5");
+	CheckListing("a/c");
+}
+
+void CHostFileSystemCacheTest::TestSymlinks()
+{
+#ifdef __linux__
+	fs::create_directories(m_rootPath / "target");
+	WriteFile("target/t1", 5);
+	fs::create_directory_symlink(m_rootPath / "target", m_rootPath / "link");
+	fs::create_symlink(m_rootPath / "a/f1", m_rootPath / "a/flink");
+
+	//Changes to the target of a symlink are not reported through the link's parent
+	CheckStat("a/flink");
+	CheckListing("a");
+	WriteFile("a/f1", 40);
+	CheckStat("a/flink");
+	CheckListing("a");
+
+	//Same directory reached through two paths
+	CheckStat("link/t1");
+	CheckStat("target/t1");
+	CheckListing("link");
+	CheckListing("target");
+	WriteFile("target/t1", 15);
+	CheckStat("link/t1");
+	CheckStat("target/t1");
+	CheckListing("link");
+	CheckListing("target");
+
+	//Link pointing somewhere else
+	fs::remove(m_rootPath / "link");
+	fs::create_directory_symlink(m_rootPath / "a/c", m_rootPath / "link");
+	CheckStat("link/t1");
+	CheckStat("link/f5");
+	CheckListing("link");
+
+	fs::remove(m_rootPath / "link");
+	fs::remove(m_rootPath / "a/flink");
+	fs::remove_all(m_rootPath / "target");
+#endif
+}
+
+void CHostFileSystemCacheTest::TestQueueOverflow()
+{
+#ifdef __linux__
+	//Queue more events than inotify can hold, events coming after the overflow are lost
+	uint32 maxQueuedEvents = 0x4000;
+	{
+		std::ifstream maxQueuedEventsFile("/proc/sys/fs/inotify/max_queued_events");
+		maxQueuedEventsFile >> maxQueuedEvents;
+	}
+
+	CheckStat("a/f1");
+	CheckListing("a/b");
+	for(uint32 i = 0; i < maxQueuedEvents; i++)
+	{
+		WriteFile("a/b/tmp", 0);
+		fs::remove(m_rootPath / "a/b/tmp");
+	}
+	WriteFile("a/f1", 50);
+	WriteFile("a/b/f6", 6);
+	CheckStat("a/f1");
+	CheckListing("a/b");
+
+	//Directories must be watched again
+	WriteFile("a/f1", 60);
+	CheckStat("a/f1");
+	fs::remove(m_rootPath / "a/b/f6");
+	CheckListing("a/b");
+#endif
+}
+
+void CHostFileSystemCacheTest::TestFileReads()
+{
+	//Small files are read in one go, large ones are streamed from the host
+	WriteFile("small", 100, 's');
+	WriteFile("large", 0x200000, 'l');
+	WriteFile("empty", 0, 'e');
+
+	char buffer[200] = {};
+	{
+		std::unique_ptr<Framework::CStream> stream(m_device->GetFile(CDevice::OPEN_FLAG_RDONLY, "small"));
+		TEST_VERIFY(dynamic_cast<Framework::CMemStream*>(stream.get()));
+		TEST_VERIFY(stream->Read(buffer, sizeof(buffer)) == 100);
+		TEST_VERIFY(buffer[0] == 's');
+		TEST_VERIFY(buffer[99] == 's');
+	}
+	{
+		std::unique_ptr<Framework::CStream> stream(m_device->GetFile(CDevice::OPEN_FLAG_RDONLY, "large"));
+		TEST_VERIFY(dynamic_cast<Framework::CStdStream*>(stream.get()));
+	}
+	{
+		std::unique_ptr<Framework::CStream> stream(m_device->GetFile(CDevice::OPEN_FLAG_RDONLY, "empty"));
+		TEST_VERIFY(stream);
+		TEST_VERIFY(stream->Read(buffer, sizeof(buffer)) == 0);
+	}
+	TEST_VERIFY(m_device->GetFile(CDevice::OPEN_FLAG_RDONLY, "none") == nullptr);
+
+	//Written through the device, then read back
+	{
+		std::unique_ptr<Framework::CStream> stream(m_device->GetFile(CDevice::OPEN_FLAG_WRONLY | CDevice::OPEN_FLAG_CREAT, "small"));
+		stream->Write("zz", 2);
+	}
+	CheckStat("small");
+	{
+		std::unique_ptr<Framework::CStream> stream(m_device->GetFile(CDevice::OPEN_FLAG_RDONLY, "small"));
+		TEST_VERIFY(stream->Read(buffer, sizeof(buffer)) == 2);
+		TEST_VERIFY(buffer[0] == 'z');
+	}
+}
+
+void CHostFileSystemCacheTest::TestRandomChanges()
+{
+	static const std::vector<std::string> directoryNames =
+	    {
+	        "d0", "d1", "d0/d2", "d1/d3", "d0/d2/d4"};
+	static const std::vector<std::string> fileNames =
+	    {
+	        "f0", "d0/f1", "d1/f2", "d0/d2/f3", "d1/d3/f4", "d0/d2/d4/f5"};
+
+	std::vector<std::string> names;
+	names.insert(names.end(), directoryNames.begin(), directoryNames.end());
+	names.insert(names.end(), fileNames.begin(), fileNames.end());
+
+	for(uint32 i = 0; i < 1000; i++)
+	{
+		auto nameIndex = NextRandom() % names.size();
+		const auto& name = names[nameIndex];
+		auto hostPath = m_rootPath / name;
+		std::error_code errorCode;
+		switch(NextRandom() % 5)
+		{
+		case 0:
+			if(nameIndex < directoryNames.size())
+			{
+				fs::create_directory(hostPath, errorCode);
+			}
+			else if(fs::is_directory(hostPath.parent_path()))
+			{
+				WriteFile(name, NextRandom() % 50);
+			}
+			break;
+		case 1:
+			fs::remove_all(hostPath, errorCode);
+			break;
+		case 2:
+			//Can move files over directories and the other way around, those fail
+			fs::rename(hostPath, m_rootPath / names[NextRandom() % names.size()], errorCode);
+			break;
+		case 3:
+			if(fs::is_regular_file(hostPath))
+			{
+				WriteFile(name, NextRandom() % 50);
+			}
+			break;
+		default:
+			break;
+		}
+		for(const auto& checkName : names)
+		{
+			CheckStat(checkName);
+			if(fs::is_directory(m_rootPath / checkName))
+			{
+				CheckListing(checkName);
+			}
+		}
+	}
+}
+
+void CHostFileSystemCacheTest::WriteFile(const std::string& path, uint64 size, char value)
+{
+	std::ofstream output(m_rootPath / path, std::ios::binary | std::ios::trunc);
+	std::string content(size, value);
+	output.write(content.data(), content.size());
+	TEST_VERIFY(output.good());
+}
+
+void CHostFileSystemCacheTest::CheckStat(const std::string& path)
+{
+	bool succeeded = false;
+	STAT stat = {};
+	TEST_VERIFY(m_device->TryGetStat(path.c_str(), succeeded, stat));
+
+	auto hostPath = m_rootPath / path;
+	std::error_code errorCode;
+	auto status = fs::status(hostPath, errorCode);
+	if(!fs::exists(status))
+	{
+		TEST_VERIFY(!succeeded);
+		return;
+	}
+	TEST_VERIFY(succeeded);
+	if(fs::is_directory(status))
+	{
+		TEST_VERIFY(stat.mode == STAT_MODE_DIR);
+	}
+	else
+	{
+		TEST_VERIFY(stat.mode == STAT_MODE_FILE);
+		TEST_VERIFY(stat.loSize == fs::file_size(hostPath));
+	}
+}
+
+void CHostFileSystemCacheTest::CheckListing(const std::string& path)
+{
+	TEST_VERIFY(ListDevice(path) == ListHost(path));
+}
+
+CHostFileSystemCacheTest::Listing CHostFileSystemCacheTest::ListDevice(const std::string& path)
+{
+	Listing result;
+	auto iterator = m_device->GetDirectory(path.c_str());
+	while(!iterator->IsDone())
+	{
+		DIRENTRY entry = {};
+		iterator->ReadEntry(&entry);
+		bool isDirectory = (entry.stat.mode == STAT_MODE_DIR);
+		result.insert(std::make_pair(std::string(entry.name), isDirectory ? ~0ULL : entry.stat.loSize));
+	}
+	return result;
+}
+
+CHostFileSystemCacheTest::Listing CHostFileSystemCacheTest::ListHost(const std::string& path)
+{
+	Listing result;
+	for(const auto& entry : fs::directory_iterator(m_rootPath / path))
+	{
+		bool isDirectory = entry.is_directory();
+		result.insert(std::make_pair(entry.path().filename().string(), isDirectory ? ~0ULL : entry.file_size()));
+	}
+	return result;
+}
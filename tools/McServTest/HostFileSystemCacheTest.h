@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include "Test.h"
+#include "filesystem_def.h"
+#include "iop/ioman/PathDirectoryDevice.h"
+
+//Checks that what CDirectoryDevice reports through its host file system cache
+//stays in sync with the host while the host directory is being modified
+class CHostFileSystemCacheTest : public CTest
+{
+public:
+	CHostFileSystemCacheTest();
+	virtual ~CHostFileSystemCacheTest();
+
+	void Execute() override;
+
+private:
+	typedef std::set<std::pair<std::string, uint64>> Listing;
+
+	void TestStats();
+	void TestListings();
+	void TestDirectoryMoves();
+	void TestSymlinks();
+	void TestQueueOverflow();
+	void TestFileReads();
+	void TestRandomChanges();
+
+	void WriteFile(const std::string&, uint64, char = 'a');
+	void CheckStat(const std::string&);
+	void CheckListing(const std::string&);
+	Listing ListDevice(const std::string&);
+	Listing ListHost(const std::string&);
+
+	fs::path m_rootPath;
+	std::unique_ptr<Iop::Ioman::CPathDirectoryDevice> m_device;
+};
@@ -10,6 +10,7 @@
 #include "PathUtils.h"
 #include "StdStreamUtils.h"
 #include "GameTestSheet.h"
+#include "HostFileSystemCacheTest.h"
 
 #define MCSERV_CMD(a) (Iop::CMcServ::a | Iop::CMcServ::CMD_FLAG_DIRECT)
 
@@ -120,5 +121,10 @@ int main(int argc, const char** argv)
 		}
 	}
 
+	{
+		CHostFileSystemCacheTest test;
+		test.Execute();
+	}
+
 	return 0;
 }
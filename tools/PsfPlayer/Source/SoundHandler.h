@@ -17,5 +17,11 @@ public:
 	virtual bool HasFreeBuffers() = 0;
 	virtual void RecycleBuffers() = 0;
 
+	//Pull based handlers buffer audio on their own, writers don't need to batch samples
+	virtual bool IsPullBased() const
+	{
+		return false;
+	}
+
 private:
 };
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <vector>
+#include "filesystem_def.h"
+#include "PsfVm.h"
+#include "PsfLoader.h"
+#include "PsfArchive.h"
+#include "PsfStreamProvider.h"
+#include "PsfTags.h"
+#include "PlaybackController.h"
+#include "Playlist.h"
+#include "StdStream.h"
+#include "StdStreamUtils.h"
+#include "ThreadPool.h"
+#include "stricmp.h"
+#include "audio/WaveFileWriter.h"
+
+struct RENDER_JOB
+{
+	CPsfPathToken path;
+	fs::path archivePath;
+	fs::path outputPath;
+	std::string name;
+};
+
+struct RENDER_RESULT
+{
+	bool succeeded = false;
+	double audioTime = 0;
+	double renderTime = 0;
+};
+
+//Writes everything to a WAVE file and never reports being full, which lets the VM run as fast as it can.
+class CSH_WaveRender : public CSoundHandler
+{
+public:
+	CSH_WaveRender(CWaveFileWriter::StreamPtr stream)
+	    : m_stream(std::move(stream))
+	{
+	}
+
+	void Reset() override
+	{
+	}
+
+	void Write(int16* samples, unsigned int sampleCount, unsigned int sampleRate) override
+	{
+		if(m_completed) return;
+		if(!m_writer)
+		{
+			m_writer = std::make_unique<CWaveFileWriter>(std::move(m_stream), sampleRate, 2);
+		}
+		m_writer->Write(samples, sampleCount);
+	}
+
+	bool HasFreeBuffers() override
+	{
+		return true;
+	}
+
+	void RecycleBuffers() override
+	{
+	}
+
+	//Drops whatever is rendered after the track is over
+	void SetCompleted()
+	{
+		m_completed = true;
+	}
+
+	double GetWrittenTime() const
+	{
+		return m_writer ? static_cast<double>(m_writer->GetFrameCount()) / static_cast<double>(m_writer->GetSampleRate()) : 0;
+	}
+
+private:
+	CWaveFileWriter::StreamPtr m_stream;
+	std::unique_ptr<CWaveFileWriter> m_writer;
+	bool m_completed = false;
+};
+
+static bool IsArchivePath(const fs::path& path)
+{
+	auto extension = path.extension().string();
+	return !stricmp(extension.c_str(), ".zip") || !stricmp(extension.c_str(), ".rar");
+}
+
+static void AddJobs(std::vector<RENDER_JOB>& jobs, const fs::path& inputPath, const fs::path& outputDirPath)
+{
+	if(fs::is_directory(inputPath))
+	{
+		for(const auto& entry : fs::recursive_directory_iterator(inputPath))
+		{
+			if(!entry.is_regular_file()) continue;
+			const auto& filePath = entry.path();
+			auto pathToken = CPhysicalPsfStreamProvider::GetPathTokenFromFilePath(filePath);
+			if(!CPlaylist::IsLoadableExtension(pathToken.GetExtension())) continue;
+			RENDER_JOB job;
+			job.path = pathToken;
+			job.outputPath = (outputDirPath / fs::relative(filePath, inputPath)).replace_extension(".wav");
+			job.name = filePath.string();
+			jobs.push_back(std::move(job));
+		}
+	}
+	else if(IsArchivePath(inputPath))
+	{
+		auto archive = CPsfArchive::CreateFromPath(inputPath);
+		for(const auto& fileInfo : archive->GetFiles())
+		{
+			auto pathToken = CArchivePsfStreamProvider::GetPathTokenFromFilePath(fileInfo.name);
+			if(!CPlaylist::IsLoadableExtension(pathToken.GetExtension())) continue;
+			RENDER_JOB job;
+			job.path = pathToken;
+			job.archivePath = inputPath;
+			job.outputPath = (outputDirPath / inputPath.stem() / fs::path(fileInfo.name)).replace_extension(".wav");
+			job.name = inputPath.string() + ":" + fileInfo.name;
+			jobs.push_back(std::move(job));
+		}
+	}
+	else
+	{
+		RENDER_JOB job;
+		job.path = CPhysicalPsfStreamProvider::GetPathTokenFromFilePath(inputPath);
+		job.outputPath = (outputDirPath / inputPath.filename()).replace_extension(".wav");
+		job.name = inputPath.string();
+		jobs.push_back(std::move(job));
+	}
+}
+
+static RENDER_RESULT Render(const RENDER_JOB& job)
+{
+	RENDER_RESULT result;
+	try
+	{
+		CPsfVm virtualMachine;
+		CPsfBase::TagMap tags;
+		CPsfLoader::LoadPsf(virtualMachine, job.path, job.archivePath, &tags);
+
+		auto stream = std::make_unique<Framework::CStdStream>(Framework::CreateOutputStdStream(job.outputPath.native()));
+		auto soundHandler = new CSH_WaveRender(std::move(stream));
+		virtualMachine.SetSpuHandler([soundHandler]() { return soundHandler; });
+
+		//Same track length and fade out as the player, frames are counted in emulated time
+		std::promise<void> completedPromise;
+		auto completedFuture = completedPromise.get_future();
+		CPlaybackController playbackController;
+		auto volumeChangedConnection = playbackController.VolumeChanged.Connect(
+		    [&](float volume) { virtualMachine.SetVolumeAdjust(volume); });
+		auto playbackCompletedConnection = playbackController.PlaybackCompleted.Connect(
+		    [&]() {
+			    soundHandler->SetCompleted();
+			    completedPromise.set_value();
+		    });
+		auto newFrameConnection = virtualMachine.OnNewFrame.Connect(
+		    [&]() { playbackController.Tick(); });
+
+		playbackController.Play(CPsfTags(tags));
+
+		auto startTime = std::chrono::steady_clock::now();
+		virtualMachine.Resume();
+		completedFuture.wait();
+		virtualMachine.Pause();
+		result.renderTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		result.audioTime = soundHandler->GetWrittenTime();
+		result.succeeded = true;
+
+		//Sound handler is deleted, which completes the file, along with the VM
+	}
+	catch(const std::exception& exception)
+	{
+		printf("Failed to render '%s', reason: '%s'.\r\n", job.name.c_str(), exception.what());
+		fflush(stdout);
+		return result;
+	}
+
+	printf("Rendered '%s', %.1fs of audio in %.2fs (%.1fx).\r\n",
+	       job.name.c_str(), result.audioTime, result.renderTime, result.audioTime / std::max(result.renderTime, 1e-6));
+	fflush(stdout);
+	return result;
+}
+
+static void PrintUsage()
+{
+	printf("Usage: psfrender [--jobs count] [--output directory] <file/directory/archive>...\r\n");
+	printf("Renders (mini)PSF, PSF2 and PSFP files to WAVE files as fast as possible.\r\n");
+}
+
+int main(int argc, const char** argv)
+{
+	unsigned int jobCount = std::max(std::thread::hardware_concurrency(), 1U);
+	fs::path outputDirPath = fs::current_path();
+	std::vector<fs::path> inputPaths;
+	for(int i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "--jobs"))
+		{
+			if((i + 1) >= argc)
+			{
+				printf("Error: Count must be specified for --jobs option.\r\n");
+				return -1;
+			}
+			jobCount = std::max(atoi(argv[++i]), 1);
+		}
+		else if(!strcmp(argv[i], "--output"))
+		{
+			if((i + 1) >= argc)
+			{
+				printf("Error: Directory must be specified for --output option.\r\n");
+				return -1;
+			}
+			outputDirPath = fs::path(argv[++i]);
+		}
+		else
+		{
+			inputPaths.push_back(fs::path(argv[i]));
+		}
+	}
+
+	if(inputPaths.empty())
+	{
+		PrintUsage();
+		return -1;
+	}
+
+	std::vector<RENDER_JOB> jobs;
+	try
+	{
+		for(const auto& inputPath : inputPaths)
+		{
+			AddJobs(jobs, inputPath, outputDirPath);
+		}
+		for(const auto& job : jobs)
+		{
+			fs::create_directories(job.outputPath.parent_path());
+		}
+	}
+	catch(const std::exception& exception)
+	{
+		printf("Error: %s\r\n", exception.what());
+		return -1;
+	}
+
+	printf("Rendering %d tracks with %d jobs.\r\n", static_cast<int>(jobs.size()), jobCount);
+	fflush(stdout);
+
+	//Each job runs its own VM, VMs don't share any state
+	std::vector<RENDER_RESULT> results(jobs.size());
+	auto startTime = std::chrono::steady_clock::now();
+	{
+		Framework::CThreadPool threadPool(jobCount);
+		for(size_t i = 0; i < jobs.size(); i++)
+		{
+			threadPool.Enqueue([&jobs, &results, i]() { results[i] = Render(jobs[i]); });
+		}
+	}
+	double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	unsigned int failedCount = 0;
+	double totalAudioTime = 0;
+	for(const auto& result : results)
+	{
+		if(!result.succeeded) failedCount++;
+		totalAudioTime += result.audioTime;
+	}
+
+	printf("Rendered %d tracks (%d failed), %.1fs of audio in %.2fs, %.1f seconds of audio per second.\r\n",
+	       static_cast<int>(jobs.size() - failedCount), failedCount, totalAudioTime, totalTime, totalAudioTime / std::max(totalTime, 1e-6));
+	return (failedCount == 0) ? 0 : 1;
+}
@@ -0,0 +1,481 @@
+#include "AudioCaptureTest.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <thread>
+#include "StdStream.h"
+#include "StdStreamUtils.h"
+#include "audio/FlacFileWriter.h"
+#include "audio/SH_Capture.h"
+#include "audio/SH_WaveFile.h"
+
+namespace
+{
+	class CRecordingSoundHandler : public CSoundHandler
+	{
+	public:
+		void Reset() override
+		{
+			resetCount++;
+		}
+
+		void Write(int16* samples, unsigned int sampleCount, unsigned int) override
+		{
+			writtenSamples.insert(writtenSamples.end(), samples, samples + sampleCount);
+		}
+
+		bool HasFreeBuffers() override
+		{
+			return false;
+		}
+
+		void RecycleBuffers() override
+		{
+		}
+
+		std::vector<int16> writtenSamples;
+		unsigned int resetCount = 0;
+	};
+
+	class CBitReader
+	{
+	public:
+		CBitReader(const std::vector<uint8>& data, size_t position)
+		    : m_data(data)
+		    , m_bitPosition(position * 8)
+		{
+		}
+
+		uint32 ReadBits(unsigned int bitCount)
+		{
+			uint32 value = 0;
+			for(unsigned int i = 0; i < bitCount; i++)
+			{
+				size_t bytePosition = m_bitPosition / 8;
+				uint32 bit = (bytePosition < m_data.size()) ? ((m_data[bytePosition] >> (7 - (m_bitPosition % 8))) & 1) : 0;
+				value = (value << 1) | bit;
+				m_bitPosition++;
+			}
+			return value;
+		}
+
+		int32 ReadSigned(unsigned int bitCount)
+		{
+			uint32 value = ReadBits(bitCount);
+			uint32 signBit = 1U << (bitCount - 1);
+			return static_cast<int32>((value ^ signBit) - signBit);
+		}
+
+		void AlignToByte()
+		{
+			m_bitPosition = (m_bitPosition + 7) & ~7;
+		}
+
+		size_t GetBytePosition() const
+		{
+			return m_bitPosition / 8;
+		}
+
+	private:
+		const std::vector<uint8>& m_data;
+		size_t m_bitPosition = 0;
+	};
+
+	uint16 ComputeCrc16(const uint8* data, size_t size)
+	{
+		uint16 crc = 0;
+		for(size_t i = 0; i < size; i++)
+		{
+			crc ^= static_cast<uint16>(data[i] << 8);
+			for(unsigned int bit = 0; bit < 8; bit++)
+			{
+				crc = (crc & 0x8000) ? static_cast<uint16>((crc << 1) ^ 0x8005) : static_cast<uint16>(crc << 1);
+			}
+		}
+		return crc;
+	}
+}
+
+void CAudioCaptureTest::Execute()
+{
+	TestWaveCapture();
+	TestFlacRoundtrip();
+	TestWaveFileHandler();
+}
+
+std::vector<int16> CAudioCaptureTest::GenerateSamples(unsigned int frameCount)
+{
+	//Each block long section has a different kind of signal to go through all channel assignments and subframe types
+	std::mt19937 rng(0xCAFE);
+	auto noise = [&](int32 amplitude) { return static_cast<int32>(rng() % (amplitude * 2 + 1)) - amplitude; };
+	std::vector<int16> samples(frameCount * 2);
+	int32 walk[2] = {};
+	for(unsigned int i = 0; i < frameCount; i++)
+	{
+		int32 tone = static_cast<int32>(sin(static_cast<double>(i) * 2 * M_PI * 440 / 48000) * 12000);
+		int32 left = 0;
+		int32 right = 0;
+		switch((i / CFlacFileWriter::BLOCK_SIZE) % 7)
+		{
+		case 0:
+			//Unrelated channels
+			left = tone;
+			right = static_cast<int32>(cos(static_cast<double>(i) * 2 * M_PI * 660 / 48000) * 8000);
+			break;
+		case 1:
+			//Silence
+			break;
+		case 2:
+		{
+			//Smooth mid, noisy side
+			int32 difference = noise(2000);
+			left = tone + difference;
+			right = tone - difference;
+		}
+		break;
+		case 3:
+		{
+			//Right is left plus noise
+			int32 common = noise(4000);
+			left = common;
+			right = common + noise(4000);
+		}
+		break;
+		case 4:
+		{
+			//Left is right plus noise
+			int32 common = noise(4000);
+			left = common + noise(4000);
+			right = common;
+		}
+		break;
+		case 5:
+			//Full scale noise
+			left = noise(INT16_MAX);
+			right = noise(INT16_MAX);
+			break;
+		case 6:
+			walk[0] = std::clamp<int32>(walk[0] + noise(300), INT16_MIN, INT16_MAX);
+			walk[1] = std::clamp<int32>(walk[1] + noise(300), INT16_MIN, INT16_MAX);
+			left = walk[0];
+			right = walk[1];
+			break;
+		}
+		samples[(i * 2) + 0] = static_cast<int16>(left);
+		samples[(i * 2) + 1] = static_cast<int16>(right);
+	}
+	return samples;
+}
+
+std::vector<uint8> CAudioCaptureTest::ReadFile(const fs::path& path)
+{
+	auto stream = Framework::CreateInputStdStream(path.native());
+	auto size = stream.GetLength();
+	std::vector<uint8> data(size);
+	stream.Read(data.data(), size);
+	return data;
+}
+
+void CAudioCaptureTest::TestWaveCapture()
+{
+	static const unsigned int frameCount = 30000;
+	static const unsigned int blockFrameCount = 735;
+	auto outputPath = fs::temp_directory_path() / "spucapturetest.wav";
+	auto samples = GenerateSamples(frameCount);
+
+	{
+		auto inner = new CRecordingSoundHandler();
+		CSH_Capture handler(inner, outputPath);
+
+		//Everything else goes straight through
+		handler.Reset();
+		TEST_VERIFY(inner->resetCount == 1);
+		TEST_VERIFY(!handler.HasFreeBuffers());
+		TEST_VERIFY(!handler.IsPullBased());
+
+		for(unsigned int frame = 0; frame < frameCount; frame += blockFrameCount)
+		{
+			unsigned int writeFrameCount = std::min(blockFrameCount, frameCount - frame);
+			handler.Write(samples.data() + (frame * 2), writeFrameCount * 2, 48000);
+		}
+		TEST_VERIFY(inner->writtenSamples == samples);
+		TEST_VERIFY(handler.GetDroppedFrameCount() == 0);
+	}
+
+	auto data = ReadFile(outputPath);
+	fs::remove(outputPath);
+	TEST_VERIFY(data.size() == 44 + (samples.size() * sizeof(int16)));
+	TEST_VERIFY(!memcmp(data.data(), "RIFF", 4));
+	uint32 sampleRate = 0;
+	memcpy(&sampleRate, data.data() + 24, sizeof(uint32));
+	TEST_VERIFY(sampleRate == 48000);
+	TEST_VERIFY(!memcmp(data.data() + 44, samples.data(), samples.size() * sizeof(int16)));
+}
+
+void CAudioCaptureTest::TestFlacRoundtrip()
+{
+	//Frame count isn't a multiple of the block size to get a short final frame
+	static const unsigned int frameCount = (CFlacFileWriter::BLOCK_SIZE * 7) + 123;
+	auto outputPath = fs::temp_directory_path() / "spucapturetest.flac";
+	auto samples = GenerateSamples(frameCount);
+
+	TEST_VERIFY(CSH_Capture::GetFormatFromPath(outputPath) == CSH_Capture::FORMAT_FLAC);
+	TEST_VERIFY(CSH_Capture::GetFormatFromPath("capture.FLAC") == CSH_Capture::FORMAT_FLAC);
+	TEST_VERIFY(CSH_Capture::GetFormatFromPath("capture.wav") == CSH_Capture::FORMAT_WAVE);
+
+	{
+		//Headless capture
+		CSH_Capture handler(nullptr, outputPath);
+		TEST_VERIFY(handler.HasFreeBuffers());
+		for(unsigned int frame = 0; frame < frameCount; frame += 1000)
+		{
+			unsigned int writeFrameCount = std::min(1000U, frameCount - frame);
+			handler.Write(samples.data() + (frame * 2), writeFrameCount * 2, 44100);
+		}
+	}
+
+	auto data = ReadFile(outputPath);
+	fs::remove(outputPath);
+	TEST_VERIFY(data.size() < (samples.size() * sizeof(int16)));
+
+	std::vector<int16> decodedSamples;
+	uint32 sampleRate = 0;
+	TEST_VERIFY(DecodeFlac(data, decodedSamples, sampleRate));
+	TEST_VERIFY(sampleRate == 44100);
+	TEST_VERIFY(decodedSamples == samples);
+}
+
+void CAudioCaptureTest::TestWaveFileHandler()
+{
+	//Frames are never silent, silence added by the handler while it waits for audio can be told apart
+	static const unsigned int frameCount = 24000;
+	static const unsigned int blockFrameCount = 480;
+	static const unsigned int trailingSilenceBlockCount = 40;
+	auto outputPath = fs::temp_directory_path() / "spuwavefiletest.wav";
+
+	std::vector<int16> samples(frameCount * 2);
+	for(unsigned int i = 0; i < frameCount; i++)
+	{
+		int16 value = static_cast<int16>(1 + (i % 0x7000));
+		samples[(i * 2) + 0] = value;
+		samples[(i * 2) + 1] = -value;
+	}
+
+	{
+		CSH_WaveFile handler(outputPath);
+		handler.SetLatencyLimits(960, 4800);
+		TEST_VERIFY(handler.IsPullBased());
+
+		//Write blocks like the SPU does, pacing on free buffers, then follow with silence to push
+		//the last frames through the ring
+		std::vector<int16> silence(blockFrameCount * 2, 0);
+		unsigned int frame = 0;
+		unsigned int silenceBlockCount = 0;
+		auto timeoutTime = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while(silenceBlockCount < trailingSilenceBlockCount)
+		{
+			TEST_VERIFY(std::chrono::steady_clock::now() < timeoutTime);
+			if(!handler.HasFreeBuffers())
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+			if(frame < frameCount)
+			{
+				handler.Write(samples.data() + (frame * 2), blockFrameCount * 2, 48000);
+				frame += blockFrameCount;
+			}
+			else
+			{
+				handler.Write(silence.data(), blockFrameCount * 2, 48000);
+				silenceBlockCount++;
+			}
+		}
+		TEST_VERIFY(handler.GetDroppedFrameCount() == 0);
+	}
+
+	auto data = ReadFile(outputPath);
+	fs::remove(outputPath);
+	TEST_VERIFY(data.size() >= 44);
+	TEST_VERIFY(!memcmp(data.data(), "RIFF", 4));
+	uint32 sampleRate = 0;
+	memcpy(&sampleRate, data.data() + 24, sizeof(uint32));
+	TEST_VERIFY(sampleRate == 48000);
+	uint32 dataSize = 0;
+	memcpy(&dataSize, data.data() + 40, sizeof(uint32));
+	TEST_VERIFY(dataSize == (data.size() - 44));
+
+	//Underruns can insert silence anywhere, everything else must be what was written, in order
+	std::vector<int16> writtenSamples((data.size() - 44) / sizeof(int16));
+	memcpy(writtenSamples.data(), data.data() + 44, writtenSamples.size() * sizeof(int16));
+	std::vector<int16> audibleSamples;
+	for(size_t i = 0; (i + 1) < writtenSamples.size(); i += 2)
+	{
+		if((writtenSamples[i] == 0) && (writtenSamples[i + 1] == 0)) continue;
+		audibleSamples.push_back(writtenSamples[i]);
+		audibleSamples.push_back(writtenSamples[i + 1]);
+	}
+	TEST_VERIFY(audibleSamples == samples);
+}
+
+//Minimal decoder for what CFlacFileWriter produces, checks CRCs and the stream info
+bool CAudioCaptureTest::DecodeFlac(const std::vector<uint8>& data, std::vector<int16>& samples, uint32& sampleRate)
+{
+	if((data.size() < 42) || memcmp(data.data(), "fLaC", 4)) return false;
+
+	CBitReader infoReader(data, 8);
+	uint32 minBlockSize = infoReader.ReadBits(16);
+	uint32 maxBlockSize = infoReader.ReadBits(16);
+	uint32 minFrameSize = infoReader.ReadBits(24);
+	uint32 maxFrameSize = infoReader.ReadBits(24);
+	sampleRate = infoReader.ReadBits(20);
+	uint32 channelCount = infoReader.ReadBits(3) + 1;
+	uint32 bitsPerSample = infoReader.ReadBits(5) + 1;
+	uint64 totalFrameCount = static_cast<uint64>(infoReader.ReadBits(4)) << 32;
+	totalFrameCount |= infoReader.ReadBits(32);
+	if((minBlockSize != CFlacFileWriter::BLOCK_SIZE) || (maxBlockSize != CFlacFileWriter::BLOCK_SIZE)) return false;
+	if((channelCount != 2) || (bitsPerSample != 16)) return false;
+
+	samples.clear();
+	size_t position = 42;
+	uint32 expectedFrameNumber = 0;
+	while(position < data.size())
+	{
+		CBitReader reader(data, position);
+		if(reader.ReadBits(14) != 0x3FFE) return false;
+		reader.ReadBits(2);
+		if(reader.ReadBits(4) != 7) return false;
+		if(reader.ReadBits(4) != 0) return false;
+		uint32 channelAssignment = reader.ReadBits(4);
+		if(reader.ReadBits(3) != 4) return false;
+		reader.ReadBits(1);
+
+		uint32 frameNumber = reader.ReadBits(8);
+		if(frameNumber >= 0x80)
+		{
+			unsigned int extraByteCount = 0;
+			while(frameNumber & (0x40 >> extraByteCount))
+			{
+				extraByteCount++;
+			}
+			frameNumber &= (0x3F >> extraByteCount);
+			for(unsigned int i = 0; i < extraByteCount; i++)
+			{
+				frameNumber = (frameNumber << 6) | (reader.ReadBits(8) & 0x3F);
+			}
+		}
+		if(frameNumber != expectedFrameNumber++) return false;
+		uint32 blockSize = reader.ReadBits(16) + 1;
+		reader.ReadBits(8); //CRC-8, header is covered by the CRC-16 as well
+
+		std::vector<int32> channels[2];
+		for(unsigned int channel = 0; channel < 2; channel++)
+		{
+			bool isSide = ((channelAssignment == 8) && (channel == 1)) || ((channelAssignment == 9) && (channel == 0)) || ((channelAssignment == 10) && (channel == 1));
+			unsigned int subframeBitsPerSample = isSide ? 17 : 16;
+			auto& output = channels[channel];
+			output.resize(blockSize);
+			if(reader.ReadBits(1) != 0) return false;
+			uint32 type = reader.ReadBits(6);
+			if(reader.ReadBits(1) != 0) return false;
+			if(type == 0)
+			{
+				std::fill(output.begin(), output.end(), reader.ReadSigned(subframeBitsPerSample));
+			}
+			else if(type == 1)
+			{
+				for(auto& sample : output)
+				{
+					sample = reader.ReadSigned(subframeBitsPerSample);
+				}
+			}
+			else if((type & 0x38) == 0x08)
+			{
+				unsigned int order = type & 7;
+				if(order > 4) return false;
+				for(unsigned int i = 0; i < order; i++)
+				{
+					output[i] = reader.ReadSigned(subframeBitsPerSample);
+				}
+				if(reader.ReadBits(2) != 0) return false;
+				unsigned int partitionOrder = reader.ReadBits(4);
+				unsigned int partitionSize = blockSize >> partitionOrder;
+				unsigned int sampleIndex = order;
+				for(unsigned int partition = 0; partition < (1U << partitionOrder); partition++)
+				{
+					unsigned int k = reader.ReadBits(4);
+					unsigned int count = (partition == 0) ? (partitionSize - order) : partitionSize;
+					for(unsigned int i = 0; i < count; i++)
+					{
+						uint32 quotient = 0;
+						while(reader.ReadBits(1) == 0)
+						{
+							quotient++;
+						}
+						uint32 value = (quotient << k) | reader.ReadBits(k);
+						int32 residual = static_cast<int32>(value >> 1) ^ -static_cast<int32>(value & 1);
+						const int32* s = output.data() + sampleIndex;
+						int32 prediction = 0;
+						switch(order)
+						{
+						case 1:
+							prediction = s[-1];
+							break;
+						case 2:
+							prediction = (2 * s[-1]) - s[-2];
+							break;
+						case 3:
+							prediction = (3 * s[-1]) - (3 * s[-2]) + s[-3];
+							break;
+						case 4:
+							prediction = (4 * s[-1]) - (6 * s[-2]) + (4 * s[-3]) - s[-4];
+							break;
+						}
+						output[sampleIndex++] = prediction + residual;
+					}
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		reader.AlignToByte();
+		size_t frameEnd = reader.GetBytePosition();
+		uint16 crc = static_cast<uint16>(reader.ReadBits(16));
+		if(ComputeCrc16(data.data() + position, frameEnd - position) != crc) return false;
+		uint32 frameSize = static_cast<uint32>(frameEnd + 2 - position);
+		if((frameSize < minFrameSize) || (frameSize > maxFrameSize)) return false;
+		position = frameEnd + 2;
+
+		for(unsigned int i = 0; i < blockSize; i++)
+		{
+			int32 left = channels[0][i];
+			int32 right = channels[1][i];
+			switch(channelAssignment)
+			{
+			case 8:
+				right = left - right;
+				break;
+			case 9:
+				left = left + right;
+				break;
+			case 10:
+			{
+				int32 mid = (channels[0][i] * 2) | (channels[1][i] & 1);
+				left = (mid + channels[1][i]) >> 1;
+				right = (mid - channels[1][i]) >> 1;
+			}
+			break;
+			}
+			samples.push_back(static_cast<int16>(left));
+			samples.push_back(static_cast<int16>(right));
+		}
+	}
+
+	return (samples.size() / 2) == totalFrameCount;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+#include "filesystem_def.h"
+#include "Test.h"
+
+class CAudioCaptureTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	void TestWaveCapture();
+	void TestFlacRoundtrip();
+	void TestWaveFileHandler();
+
+	static std::vector<int16> GenerateSamples(unsigned int);
+	static std::vector<uint8> ReadFile(const fs::path&);
+	static bool DecodeFlac(const std::vector<uint8>&, std::vector<int16>&, uint32&);
+};
@@ -0,0 +1,152 @@
+#include "AudioStreamTest.h"
+#include <cmath>
+#include <vector>
+#include "audio/AudioLatencyController.h"
+#include "audio/AudioRingBuffer.h"
+#include "audio/PullSoundHandler.h"
+#include "audio/TimeStretcher.h"
+
+void CAudioStreamTest::Execute()
+{
+	TestRingBuffer();
+	TestLatencyController();
+	TestPullUnderrun();
+	TestTimeStretch();
+}
+
+void CAudioStreamTest::TestRingBuffer()
+{
+	CAudioRingBuffer ring(100);
+	TEST_VERIFY(ring.GetCapacity() == 128);
+
+	//Go around the ring a few times with sizes that don't divide its capacity
+	int16 nextWriteValue = 0;
+	int16 nextReadValue = 0;
+	for(unsigned int i = 0; i < 50; i++)
+	{
+		int16 samples[45 * 2];
+		for(auto& sample : samples)
+		{
+			sample = nextWriteValue++;
+		}
+		TEST_VERIFY(ring.Write(samples, 45) == 45);
+		TEST_VERIFY(ring.GetReadableFrameCount() == 45);
+
+		int16 readSamples[45 * 2];
+		TEST_VERIFY(ring.Read(readSamples, 45) == 45);
+		for(auto sample : readSamples)
+		{
+			TEST_VERIFY(sample == nextReadValue++);
+		}
+	}
+
+	//Writes stop when the ring is full, reads stop when it's empty
+	std::vector<int16> samples(200 * 2);
+	TEST_VERIFY(ring.Write(samples.data(), 200) == 128);
+	TEST_VERIFY(ring.GetWritableFrameCount() == 0);
+	TEST_VERIFY(ring.Read(samples.data(), 200) == 128);
+	TEST_VERIFY(ring.Read(samples.data(), 1) == 0);
+}
+
+void CAudioStreamTest::TestLatencyController()
+{
+	CAudioLatencyController controller;
+	controller.SetSampleRate(48000);
+	controller.SetLimits(480, 9600);
+	uint32 initialTarget = controller.GetTargetFrameCount();
+	TEST_VERIFY((initialTarget >= 480) && (initialTarget <= 9600));
+
+	//Underruns raise the target up to the limit
+	controller.Update(480, 1);
+	TEST_VERIFY(controller.GetTargetFrameCount() > initialTarget);
+	controller.Update(480, 100);
+	TEST_VERIFY(controller.GetTargetFrameCount() == 9600);
+
+	//Long stable playback brings it back down, never below the limit
+	for(unsigned int i = 0; i < 48000; i++)
+	{
+		controller.Update(480, 0);
+	}
+	TEST_VERIFY(controller.GetTargetFrameCount() == 480);
+}
+
+void CAudioStreamTest::TestPullUnderrun()
+{
+	static const uint32 sampleRate = 48000;
+	CPullSoundHandler handler;
+	handler.SetLatencyLimits(960, 960);
+
+	std::vector<int16> block(480 * 2, 0x100);
+	std::vector<int16> output(480 * 2);
+
+	//Nothing comes out before the target is reached
+	handler.Write(block.data(), static_cast<unsigned int>(block.size()), sampleRate);
+	handler.Pull(output.data(), 480);
+	TEST_VERIFY(output[0] == 0);
+	TEST_VERIFY(handler.HasFreeBuffers());
+
+	handler.Write(block.data(), static_cast<unsigned int>(block.size()), sampleRate);
+	TEST_VERIFY(!handler.HasFreeBuffers());
+	handler.Pull(output.data(), 480);
+	TEST_VERIFY(output[0] == 0x100);
+	TEST_VERIFY(output[(480 * 2) - 1] == 0x100);
+	TEST_VERIFY(handler.GetUnderrunCount() == 0);
+
+	//Partial pull is padded with silence and counted
+	std::vector<int16> largeOutput(960 * 2);
+	handler.Pull(largeOutput.data(), 960);
+	TEST_VERIFY(largeOutput[(480 * 2) - 1] == 0x100);
+	TEST_VERIFY(largeOutput[480 * 2] == 0);
+	TEST_VERIFY(handler.GetUnderrunCount() == 1);
+
+	//Reset drops what's buffered
+	handler.Write(block.data(), static_cast<unsigned int>(block.size()), sampleRate);
+	handler.Write(block.data(), static_cast<unsigned int>(block.size()), sampleRate);
+	handler.Reset();
+	handler.Pull(output.data(), 480);
+	TEST_VERIFY(output[0] == 0);
+	TEST_VERIFY(handler.GetBufferedFrameCount() == 0);
+}
+
+void CAudioStreamTest::TestTimeStretch()
+{
+	//440Hz tone played 5% faster must keep its pitch and be 5% shorter
+	static const double pi = 3.14159265358979323846;
+	static const uint32 sampleRate = 48000;
+	static const unsigned int inputFrameCount = sampleRate * 2;
+	static const float tempo = 1.05f;
+
+	std::vector<int16> input(inputFrameCount * 2);
+	for(unsigned int i = 0; i < inputFrameCount; i++)
+	{
+		int16 value = static_cast<int16>(std::lround(sin(2 * pi * 440 * i / sampleRate) * 16000));
+		input[(i * 2) + 0] = value;
+		input[(i * 2) + 1] = value;
+	}
+
+	CTimeStretcher stretcher;
+	stretcher.SetSampleRate(sampleRate);
+	stretcher.SetTempo(tempo);
+	std::vector<int16> output;
+	for(unsigned int i = 0; i < inputFrameCount; i += 480)
+	{
+		stretcher.Process(output, input.data() + (i * 2), 480);
+	}
+
+	unsigned int outputFrameCount = static_cast<unsigned int>(output.size() / 2);
+	unsigned int consumedFrameCount = inputFrameCount - stretcher.GetBufferedFrameCount();
+	double ratio = static_cast<double>(consumedFrameCount) / static_cast<double>(outputFrameCount);
+	TEST_VERIFY(std::abs(ratio - tempo) < 0.01);
+
+	//Count rising zero crossings to estimate the frequency
+	unsigned int crossingCount = 0;
+	for(unsigned int i = 1; i < outputFrameCount; i++)
+	{
+		if((output[(i - 1) * 2] < 0) && (output[i * 2] >= 0))
+		{
+			crossingCount++;
+		}
+	}
+	double frequency = static_cast<double>(crossingCount) * sampleRate / outputFrameCount;
+	TEST_VERIFY(std::abs(frequency - 440) < 5);
+}
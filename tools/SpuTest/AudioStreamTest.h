@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Test.h"
+
+class CAudioStreamTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	void TestRingBuffer();
+	void TestLatencyController();
+	void TestPullUnderrun();
+	void TestTimeStretch();
+};
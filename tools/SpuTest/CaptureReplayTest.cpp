@@ -0,0 +1,147 @@
+#include "CaptureReplayTest.h"
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <random>
+#include "MemStream.h"
+#include "Ps2Const.h"
+#include "SpuReplay.h"
+#include "iop/Iop_SpuCapture.h"
+
+typedef Iop::Spu2::CCore CORE;
+
+void CCaptureReplayTest::Execute()
+{
+	static const uint32 sampleAddress = 0x5000;
+	static const uint32 sampleSize = 0x800;
+	static const uint32 dmaSampleAddress = 0x8000;
+	static const uint32 reverbWorkAddrStart = 0x20000;
+	static const uint32 reverbWorkAddrEnd = 0x3FFFF;
+
+	std::mt19937 rng(0x5EED);
+
+	//Fill some ADPCM blocks with noise, loop over all of them
+	for(uint32 i = 0; i < sampleSize; i++)
+	{
+		m_ram[sampleAddress + i] = static_cast<uint8>(rng());
+	}
+	for(uint32 i = 0; i < sampleSize; i += 0x10)
+	{
+		//Stick to stable filters and moderate shifts
+		m_ram[sampleAddress + i + 0] = static_cast<uint8>(((rng() % 2) << 4) | (4 + (rng() % 8)));
+		m_ram[sampleAddress + i + 1] = (i == 0) ? 0x04 : ((i + 0x10) == sampleSize) ? 0x03 : 0x00;
+	}
+
+	Iop::CSpuCapture capture;
+	capture.SaveInitialState(m_ram, PS2::SPU_RAM_SIZE, m_spuCore0, m_spuCore1, m_irqWatcher);
+	m_spuCore0.SetCapture(&capture);
+	m_spuCore1.SetCapture(&capture);
+	m_spu.SetCapture(&capture);
+
+	std::vector<int16> expectedSamples;
+
+	//Copy samples with a DMA transfer for CORE1 to play
+	{
+		std::vector<uint8> dmaData(m_ram + sampleAddress, m_ram + sampleAddress + sampleSize);
+		SetCoreAddress(1, CORE::A_TSA_HI, dmaSampleAddress);
+		SetCoreRegister(1, CORE::A_TS_MODE, Iop::CSpuBase::TRANSFER_MODE_VOICE);
+		SetCoreRegister(1, CORE::CORE_ATTR, Iop::CSpuBase::CONTROL_DMA_WRITE);
+		uint32 blocksReceived = m_spuCore1.ReceiveDma(dmaData.data(), 0x40, sampleSize / 0x40, 0);
+		TEST_VERIFY(blocksReceived == (sampleSize / 0x40));
+	}
+
+	for(unsigned int coreIndex = 0; coreIndex < CORE_COUNT; coreIndex++)
+	{
+		uint32 voiceSampleAddress = (coreIndex == 0) ? sampleAddress : dmaSampleAddress;
+		for(unsigned int i = 0; i < VOICE_COUNT; i++)
+		{
+			SetVoiceRegister(coreIndex, i, CORE::VP_VOLL, 0x1000);
+			SetVoiceRegister(coreIndex, i, CORE::VP_VOLR, 0x0800);
+			SetVoiceRegister(coreIndex, i, CORE::VP_PITCH, 0x800 + (rng() % 0x1000));
+			SetVoiceRegister(coreIndex, i, CORE::VP_ADSR1, 0x00FF);
+			SetVoiceRegister(coreIndex, i, CORE::VP_ADSR2, 0x1FC0);
+			SetVoiceAddress(coreIndex, i, CORE::VA_SSA_HI, voiceSampleAddress);
+		}
+		SetCoreRegister(coreIndex, CORE::A_KON_HI, 0xFFFF);
+		SetCoreRegister(coreIndex, CORE::A_KON_LO, 0xFF);
+	}
+
+	Render(expectedSamples, 1024);
+
+	//Enable reverb on CORE0 with random coefficients
+	SetCoreAddress(0, CORE::A_ESA_HI, reverbWorkAddrStart);
+	SetCoreRegister(0, CORE::A_EEA_HI, reverbWorkAddrEnd >> 17);
+	for(uint32 address = CORE::RVB_C_REG_BASE; address < CORE::RVB_C_REG_END; address += 2)
+	{
+		SetCoreRegister(0, address, rng() & 0x3FFF);
+	}
+	SetCoreRegister(0, CORE::P_EVOLL, 0x3000);
+	SetCoreRegister(0, CORE::P_EVOLR, 0x3000);
+	SetCoreRegister(0, CORE::S_VMIXEL_HI, 0xFFFF);
+	SetCoreRegister(0, CORE::S_VMIXER_HI, 0xFFFF);
+	SetCoreRegister(0, CORE::CORE_ATTR, Iop::CSpuBase::CONTROL_REVERB);
+
+	//Settings changed while capturing are part of the capture too
+	m_spuCore0.SetVolumeAdjust(1.5f);
+	m_spuCore1.SetInterpolationMode(Iop::CSpuBase::INTERPOLATION_SINC);
+
+	for(unsigned int i = 0; i < 16; i++)
+	{
+		Render(expectedSamples, 128 + (rng() % 512));
+		SetVoiceRegister(i & 1, rng() % VOICE_COUNT, CORE::VP_PITCH, rng() % 0x3FFF);
+		if((i % 4) == 3)
+		{
+			SetCoreRegister(i & 1, CORE::A_KOFF_HI, rng() & 0xFFFF);
+			m_spu.ReadRegister(Iop::CSpu2::C_IRQINFO);
+		}
+	}
+
+	m_spuCore0.SetCapture(nullptr);
+	m_spuCore1.SetCapture(nullptr);
+	m_spu.SetCapture(nullptr);
+
+	TEST_VERIFY(std::any_of(expectedSamples.begin(), expectedSamples.end(), [](int16 sample) { return sample != 0; }));
+
+	//Go through serialization to make sure everything survives it
+	Iop::CSpuCapture loadedCapture;
+	{
+		Framework::CMemStream captureStream;
+		capture.Write(captureStream);
+		captureStream.Seek(0, Framework::STREAM_SEEK_SET);
+		loadedCapture.Read(captureStream);
+	}
+
+	auto replay = std::make_unique<CSpuReplay>();
+	CSpuReplay::RESULT result;
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		//Replaying twice shouldn't be affected by state left behind by the first run
+		replay->Replay(loadedCapture, result);
+		TEST_VERIFY(result.dmaMismatchCount == 0);
+		TEST_VERIFY(result.samplingRate == 44100);
+		TEST_VERIFY(result.samples == expectedSamples);
+		TEST_VERIFY(CSpuReplay::ComputeHash(result.samples) == CSpuReplay::ComputeHash(expectedSamples));
+	}
+
+	//Slightly different output must not compare as equal
+	result.samples[result.samples.size() / 2] ^= 1;
+	TEST_VERIFY(CSpuReplay::ComputeHash(result.samples) != CSpuReplay::ComputeHash(expectedSamples));
+	double psnr = CSpuReplay::ComputePsnr(result.samples, expectedSamples);
+	TEST_VERIFY((psnr > 90) && (psnr < INFINITY));
+}
+
+void CCaptureReplayTest::Render(std::vector<int16>& output, unsigned int ticks)
+{
+	//Same as the emulator: render both cores and mix them
+	unsigned int sampleCount = ticks * 2;
+	std::vector<int16> core1Samples(sampleCount);
+	size_t offset = output.size();
+	output.resize(offset + sampleCount);
+	m_spuCore0.Render(output.data() + offset, sampleCount);
+	m_spuCore1.Render(core1Samples.data(), sampleCount);
+	for(unsigned int i = 0; i < sampleCount; i++)
+	{
+		int32 resultSample = static_cast<int32>(output[offset + i]) + static_cast<int32>(core1Samples[i]);
+		output[offset + i] = static_cast<int16>(std::clamp<int32>(resultSample, SHRT_MIN, SHRT_MAX));
+	}
+}
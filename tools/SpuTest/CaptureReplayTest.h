@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+
+class CCaptureReplayTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	void Render(std::vector<int16>&, unsigned int);
+};
@@ -1,9 +1,20 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
+#include "AudioCaptureTest.h"
+#include "AudioStreamTest.h"
+#include "CaptureReplayTest.h"
 #include "KeyOnOffTest.h"
 #include "MultiCoreIrqTest.h"
+#include "RenderBlockTest.h"
+#include "ResamplerTest.h"
+#include "ReverbTest.h"
 #include "SetRepeatTest.h"
 #include "SetRepeatTest2.h"
 #include "SimpleIrqTest.h"
+#include "SpuReplay.h"
 #include "SweepTest.h"
 
 typedef std::function<CTest*()> TestFactoryFunction;
@@ -11,8 +22,14 @@ typedef std::function<CTest*()> TestFactoryFunction;
 // clang-format off
 static const TestFactoryFunction s_factories[] =
 {
+	[]() { return new CAudioCaptureTest(); },
+	[]() { return new CAudioStreamTest(); },
+	[]() { return new CCaptureReplayTest(); },
 	[]() { return new CKeyOnOffTest(); },
 	[]() { return new CMultiCoreIrqTest(); },
+	[]() { return new CRenderBlockTest(); },
+	[]() { return new CResamplerTest(); },
+	[]() { return new CReverbTest(); },
 	[]() { return new CSetRepeatTest(); },
 	[]() { return new CSetRepeatTest2(); },
 	[]() { return new CSimpleIrqTest(); },
@@ -28,5 +45,53 @@ int main(int argc, const char** argv)
 		test->Execute();
 		delete test;
 	}
-	return 0;
+
+	if(argc < 2)
+	{
+		return 0;
+	}
+
+	fs::path capturePath;
+	CSpuReplay::OPTIONS options;
+	for(int i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "--repeat"))
+		{
+			if((i + 1) >= argc)
+			{
+				printf("Error: Count must be specified for --repeat option.\r\n");
+				return -1;
+			}
+			options.repeatCount = std::max(atoi(argv[i + 1]), 1);
+			i++;
+		}
+		else if(!strcmp(argv[i], "--golden") || !strcmp(argv[i], "--write-golden"))
+		{
+			if((i + 1) >= argc)
+			{
+				printf("Error: Path must be specified for %s option.\r\n", argv[i]);
+				return -1;
+			}
+			auto& path = !strcmp(argv[i], "--golden") ? options.goldenPath : options.writeGoldenPath;
+			path = fs::path(argv[i + 1]);
+			i++;
+		}
+		else
+		{
+			capturePath = fs::path(argv[i]);
+		}
+	}
+
+	if(capturePath.empty())
+	{
+		printf("Usage: SpuTest [options] capture.spucap.zip\r\n");
+		printf("Options: \r\n");
+		printf("\t --repeat <count>\t Renders the capture <count> times.\r\n");
+		printf("\t --golden <path>\t Compares output with raw 16-bit stereo samples from <path>.\r\n");
+		printf("\t --write-golden <path>\t Writes output as raw 16-bit stereo samples to <path>.\r\n");
+		return -1;
+	}
+
+	CSpuReplay replay;
+	return replay.Run(capturePath, options) ? 0 : -1;
 }
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Test.h"
+
+class CRenderBlockTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	struct SPU_STATE
+	{
+		std::vector<uint8> ram;
+		Iop::CSpuSampleCache sampleCache;
+		Iop::CSpuIrqWatcher irqWatcher;
+		std::unique_ptr<Iop::CSpuBase> core;
+	};
+
+	static void SetupSpu(SPU_STATE&, uint32);
+	void TestCompareTickByTick(uint32);
+};
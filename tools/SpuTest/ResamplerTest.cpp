@@ -0,0 +1,74 @@
+#include "ResamplerTest.h"
+#include <cmath>
+#include <vector>
+#include "iop/Iop_SpuResampler.h"
+
+void CResamplerTest::Execute()
+{
+	TestInterpolate();
+	TestUpsample();
+}
+
+void CResamplerTest::TestInterpolate()
+{
+	static const int16 samples[Iop::CSpuResampler::TAP_COUNT] = {100, -2000, 3000, 1234, -5, 6000, -7000, 800};
+
+	//First phase falls exactly on a sample
+	TEST_VERIFY(Iop::CSpuResampler::Interpolate(samples, 0) == 1234);
+
+	//Constant input stays constant on every phase
+	int16 constantSamples[Iop::CSpuResampler::TAP_COUNT];
+	for(auto& sample : constantSamples)
+	{
+		sample = 0x4000;
+	}
+	for(unsigned int phase = 0; phase < Iop::CSpuResampler::PHASE_COUNT; phase++)
+	{
+		TEST_VERIFY(Iop::CSpuResampler::Interpolate(constantSamples, phase) == 0x4000);
+	}
+
+	//Full scale input must saturate instead of wrapping around
+	static const int16 extremeSamples[Iop::CSpuResampler::TAP_COUNT] = {-32768, 32767, -32768, 32767, 32767, -32768, 32767, -32768};
+	int32 result = Iop::CSpuResampler::Interpolate(extremeSamples, Iop::CSpuResampler::PHASE_COUNT / 2);
+	TEST_VERIFY(result == 32767);
+}
+
+void CResamplerTest::TestUpsample()
+{
+	//1kHz sine wave going from 48kHz to 96kHz, fed in small blocks
+	static const double pi = 3.14159265358979323846;
+	static const unsigned int srcFrameCount = 4800;
+	static const unsigned int blockFrameCount = 40;
+	static const double amplitude = 16000;
+
+	std::vector<int16> input;
+	for(unsigned int i = 0; i < srcFrameCount; i++)
+	{
+		auto sample = static_cast<int16>(lround(amplitude * sin(2 * pi * 1000 * i / 48000.0)));
+		input.push_back(sample);
+		input.push_back(-sample);
+	}
+
+	Iop::CSpuResampler resampler;
+	resampler.Reset();
+	resampler.SetSamplingRates(48000, 96000);
+
+	std::vector<int16> output;
+	for(unsigned int i = 0; i < srcFrameCount; i += blockFrameCount)
+	{
+		resampler.Process(output, input.data() + (i * 2), blockFrameCount * 2);
+	}
+
+	//Last few source frames stay in the resampler until more data comes in
+	unsigned int dstFrameCount = static_cast<unsigned int>(output.size() / 2);
+	TEST_VERIFY(dstFrameCount <= (srcFrameCount * 2));
+	TEST_VERIFY(dstFrameCount >= ((srcFrameCount - Iop::CSpuResampler::TAP_COUNT) * 2));
+
+	//Skip the start, history is filled with silence there
+	for(unsigned int i = Iop::CSpuResampler::TAP_COUNT * 2; i < dstFrameCount; i++)
+	{
+		double expected = amplitude * sin(2 * pi * 1000 * i / 96000.0);
+		TEST_VERIFY(std::abs(output[(i * 2) + 0] - expected) < 8);
+		TEST_VERIFY(std::abs(output[(i * 2) + 0] + output[(i * 2) + 1]) <= 1);
+	}
+}
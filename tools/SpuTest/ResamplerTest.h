@@ -0,0 +1,13 @@
+#pragma once
+
+#include "Test.h"
+
+class CResamplerTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	void TestInterpolate();
+	void TestUpsample();
+};
@@ -0,0 +1,173 @@
+#include "ReverbTest.h"
+#include <algorithm>
+#include <climits>
+#include <random>
+
+typedef Iop::CSpuBase SPU;
+
+static const uint32 g_ramSize = 0x10000;
+static const uint32 g_workAddrStart = 0x4000;
+static const uint32 g_workAddrEnd = 0xC000;
+
+//Straightforward model of the reverb unit: 64-bit math, addresses wrapped with a modulo on every access
+static int16 Saturate(int64 value)
+{
+	return static_cast<int16>(std::clamp<int64>(value, SHRT_MIN, SHRT_MAX));
+}
+
+static int16 Multiply(int64 base, int64 a0, int64 b0, int64 a1 = 0, int64 b1 = 0)
+{
+	//Sum of products is a 32-bit value on the hardware
+	int32 products = static_cast<int32>(static_cast<uint32>((a0 * b0) + (a1 * b1)));
+	return Saturate(base + (products >> 15));
+}
+
+static int64 Negate(int64 coef)
+{
+	return (coef == SHRT_MIN) ? SHRT_MAX : -coef;
+}
+
+void CReverbTest::Execute()
+{
+	for(uint32 seed = 0; seed < 32; seed++)
+	{
+		TestCompareReference(seed);
+	}
+}
+
+int16* CReverbTest::GetReferenceSample(REFERENCE_STATE& state, int64 offset)
+{
+	int64 workSize = g_workAddrEnd - g_workAddrStart;
+	int64 position = (static_cast<int64>(state.currAddr - g_workAddrStart) + offset) % workSize;
+	if(position < 0) position += workSize;
+	return reinterpret_cast<int16*>(state.ram.data() + g_workAddrStart + position);
+}
+
+void CReverbTest::ProcessReference(REFERENCE_STATE& state, const uint32* registers, const int16* input, int16* output, unsigned int ticks)
+{
+	auto reg = [&](unsigned int registerId) { return static_cast<int64>(registers[registerId]); };
+	auto coef = [&](unsigned int registerId) { return static_cast<int64>(static_cast<int16>(registers[registerId])); };
+	auto get = [&](int64 offset) { return static_cast<int64>(*GetReferenceSample(state, offset)); };
+	auto set = [&](int64 offset, int16 value) { *GetReferenceSample(state, offset) = value; };
+
+	for(unsigned int tick = 0; tick < ticks; tick++)
+	{
+		if(state.ticks & 1)
+		{
+			int64 inputL = input[(tick * 2) + 0] >> 1;
+			int64 inputR = input[(tick * 2) + 1] >> 1;
+
+			int64 iirInputA0 = Multiply(0, get(reg(SPU::IIR_SRC_A0)), coef(SPU::IIR_COEF), inputL, coef(SPU::IN_COEF_L));
+			int64 iirInputA1 = Multiply(0, get(reg(SPU::IIR_SRC_A1)), coef(SPU::IIR_COEF), inputR, coef(SPU::IN_COEF_R));
+			int64 iirInputB0 = Multiply(0, get(reg(SPU::IIR_SRC_B1)), coef(SPU::IIR_COEF), inputL, coef(SPU::IN_COEF_L));
+			int64 iirInputB1 = Multiply(0, get(reg(SPU::IIR_SRC_B0)), coef(SPU::IIR_COEF), inputR, coef(SPU::IN_COEF_R));
+
+			int64 iirAlpha = coef(SPU::IIR_ALPHA);
+			int16 iirA0 = Multiply(get(reg(SPU::IIR_DEST_A0)), iirInputA0, iirAlpha, get(reg(SPU::IIR_DEST_A0)), Negate(iirAlpha));
+			int16 iirA1 = Multiply(get(reg(SPU::IIR_DEST_A1)), iirInputA1, iirAlpha, get(reg(SPU::IIR_DEST_A1)), Negate(iirAlpha));
+			int16 iirB0 = Multiply(get(reg(SPU::IIR_DEST_B0)), iirInputB0, iirAlpha, get(reg(SPU::IIR_DEST_B0)), Negate(iirAlpha));
+			int16 iirB1 = Multiply(get(reg(SPU::IIR_DEST_B1)), iirInputB1, iirAlpha, get(reg(SPU::IIR_DEST_B1)), Negate(iirAlpha));
+
+			set(reg(SPU::IIR_DEST_A0) + 2, iirA0);
+			set(reg(SPU::IIR_DEST_A1) + 2, iirA1);
+			set(reg(SPU::IIR_DEST_B0) + 2, iirB0);
+			set(reg(SPU::IIR_DEST_B1) + 2, iirB1);
+
+			int64 acc0 = Saturate(
+			    Multiply(0, get(reg(SPU::ACC_SRC_A0)), coef(SPU::ACC_COEF_A), get(reg(SPU::ACC_SRC_B0)), coef(SPU::ACC_COEF_B)) +
+			    Multiply(0, get(reg(SPU::ACC_SRC_C0)), coef(SPU::ACC_COEF_C), get(reg(SPU::ACC_SRC_D0)), coef(SPU::ACC_COEF_D)));
+			int64 acc1 = Saturate(
+			    Multiply(0, get(reg(SPU::ACC_SRC_A1)), coef(SPU::ACC_COEF_A), get(reg(SPU::ACC_SRC_B1)), coef(SPU::ACC_COEF_B)) +
+			    Multiply(0, get(reg(SPU::ACC_SRC_C1)), coef(SPU::ACC_COEF_C), get(reg(SPU::ACC_SRC_D1)), coef(SPU::ACC_COEF_D)));
+
+			int64 fbA0 = get(reg(SPU::MIX_DEST_A0) - reg(SPU::FB_SRC_A));
+			int64 fbA1 = get(reg(SPU::MIX_DEST_A1) - reg(SPU::FB_SRC_A));
+			int64 fbB0 = get(reg(SPU::MIX_DEST_B0) - reg(SPU::FB_SRC_B));
+			int64 fbB1 = get(reg(SPU::MIX_DEST_B1) - reg(SPU::FB_SRC_B));
+
+			int64 fbAlpha = coef(SPU::FB_ALPHA);
+			int64 fbX = coef(SPU::FB_X);
+			set(reg(SPU::MIX_DEST_A0), Multiply(acc0, fbA0, Negate(fbAlpha)));
+			set(reg(SPU::MIX_DEST_A1), Multiply(acc1, fbA1, Negate(fbAlpha)));
+			set(reg(SPU::MIX_DEST_B0), Multiply(Multiply(0, acc0, fbAlpha, fbA0, fbAlpha), fbB0, Negate(fbX)));
+			set(reg(SPU::MIX_DEST_B1), Multiply(Multiply(0, acc1, fbAlpha, fbA1, fbAlpha), fbB1, Negate(fbX)));
+
+			state.currAddr += 2;
+			if(state.currAddr >= g_workAddrEnd)
+			{
+				state.currAddr = g_workAddrStart;
+			}
+		}
+
+		static const int64 outputCoef = 0x2AA0;
+		output[(tick * 2) + 0] = Multiply(output[(tick * 2) + 0], get(reg(SPU::MIX_DEST_A0)), outputCoef, get(reg(SPU::MIX_DEST_B0)), outputCoef);
+		output[(tick * 2) + 1] = Multiply(output[(tick * 2) + 1], get(reg(SPU::MIX_DEST_A1)), outputCoef, get(reg(SPU::MIX_DEST_B1)), outputCoef);
+
+		state.ticks++;
+	}
+}
+
+void CReverbTest::TestCompareReference(uint32 seed)
+{
+	std::mt19937 random(seed);
+	uint32 workSize = g_workAddrEnd - g_workAddrStart;
+
+	//Address registers go past the end of the work area to check wrapping
+	uint32 registers[SPU::REVERB_REG_COUNT];
+	for(unsigned int i = 0; i < SPU::REVERB_REG_COUNT; i++)
+	{
+		registers[i] = SPU::g_reverbParamIsAddress[i] ? ((random() % workSize) * 2) : (random() & 0xFFFF);
+	}
+	//Extreme coefficients
+	if(seed & 1)
+	{
+		registers[SPU::IIR_ALPHA] = 0x8000;
+		registers[SPU::FB_X] = 0x8000;
+		registers[SPU::ACC_COEF_A] = 0x8000;
+		registers[SPU::ACC_COEF_B] = 0x8000;
+	}
+
+	std::vector<uint8> ram(g_ramSize);
+	for(auto& value : ram)
+	{
+		value = static_cast<uint8>(random());
+	}
+
+	static const unsigned int tickCount = 0x2000;
+	std::vector<int16> input(tickCount * 2);
+	std::vector<int16> output(tickCount * 2);
+	for(unsigned int i = 0; i < tickCount * 2; i++)
+	{
+		input[i] = static_cast<int16>(random());
+		output[i] = static_cast<int16>(random());
+	}
+
+	REFERENCE_STATE referenceState;
+	referenceState.ram = ram;
+	referenceState.currAddr = g_workAddrEnd - 0x20;
+	referenceState.ticks = seed;
+	std::vector<int16> referenceOutput = output;
+	ProcessReference(referenceState, registers, input.data(), referenceOutput.data(), tickCount);
+
+	SPU::REVERB_CONTEXT context;
+	context.ram = ram.data();
+	context.registers = registers;
+	context.workAddrStart = g_workAddrStart;
+	context.workAddrEnd = g_workAddrEnd;
+	context.currAddr = g_workAddrEnd - 0x20;
+	context.ticks = seed;
+
+	//Process in blocks of varying sizes
+	unsigned int tick = 0;
+	while(tick < tickCount)
+	{
+		unsigned int blockTicks = std::min<unsigned int>((random() % 64) + 1, tickCount - tick);
+		SPU::ProcessReverb(context, input.data() + (tick * 2), output.data() + (tick * 2), blockTicks);
+		tick += blockTicks;
+	}
+
+	TEST_VERIFY(context.currAddr == referenceState.currAddr);
+	TEST_VERIFY(context.ticks == referenceState.ticks);
+	TEST_VERIFY(output == referenceOutput);
+	TEST_VERIFY(ram == referenceState.ram);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+#include "iop/Iop_SpuBase.h"
+
+class CReverbTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	struct REFERENCE_STATE
+	{
+		std::vector<uint8> ram;
+		uint32 currAddr = 0;
+		uint32 ticks = 0;
+	};
+
+	static int16* GetReferenceSample(REFERENCE_STATE&, int64);
+	static void ProcessReference(REFERENCE_STATE&, const uint32*, const int16*, int16*, unsigned int);
+
+	void TestCompareReference(uint32);
+};
@@ -0,0 +1,218 @@
+#include "SpuReplay.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "Ps2Const.h"
+#include "StdStreamUtils.h"
+
+CSpuReplay::CSpuReplay()
+    : m_ram(new uint8[PS2::SPU_RAM_SIZE])
+    , m_spuCore0(m_ram, PS2::SPU_RAM_SIZE, &m_spuSampleCache, &m_irqWatcher, 0)
+    , m_spuCore1(m_ram, PS2::SPU_RAM_SIZE, &m_spuSampleCache, &m_irqWatcher, 1)
+    , m_spu(m_spuCore0, m_spuCore1)
+{
+	memset(m_ram, 0, PS2::SPU_RAM_SIZE);
+}
+
+CSpuReplay::~CSpuReplay()
+{
+	delete[] m_ram;
+}
+
+void CSpuReplay::Replay(const Iop::CSpuCapture& capture, RESULT& result)
+{
+	result = RESULT();
+
+	m_spuSampleCache.Clear();
+	m_irqWatcher.Reset();
+	m_spuCore0.Reset();
+	m_spuCore1.Reset();
+	m_spu.Reset();
+	capture.LoadInitialState(m_ram, PS2::SPU_RAM_SIZE, m_spuCore0, m_spuCore1, m_irqWatcher);
+
+	std::vector<uint8> dmaBuffer;
+	std::vector<int16> core1Samples;
+	//The emulator renders CORE1 right after CORE0 and mixes both, keep track of where the last CORE0 block is
+	bool hasCore0Block = false;
+	size_t core0BlockOffset = 0;
+	unsigned int core0BlockSampleCount = 0;
+
+	size_t position = 0;
+	Iop::CSpuCapture::EVENT event;
+	while(capture.ReadEvent(position, event))
+	{
+		switch(event.type)
+		{
+		case Iop::CSpuCapture::EVENT_REGISTER_READ:
+			m_spu.ReadRegister(event.address);
+			break;
+		case Iop::CSpuCapture::EVENT_REGISTER_WRITE:
+			//CORE_ATTR writes also apply the core's base sampling rate, the capture records it as a setting right after
+			m_spu.WriteRegister(event.address, event.value);
+			break;
+		case Iop::CSpuCapture::EVENT_DMA:
+		{
+			//Transfers reading from SPU RAM write to the buffer, don't let them touch the capture
+			dmaBuffer.assign(event.data, event.data + (event.blockSize * event.blockCount));
+			auto& core = (event.coreId == 0) ? m_spuCore0 : m_spuCore1;
+			uint32 blocksReceived = core.ReceiveDma(dmaBuffer.data(), event.blockSize, event.blockCount, 0);
+			if(blocksReceived != event.blockCount)
+			{
+				result.dmaMismatchCount++;
+			}
+		}
+		break;
+		case Iop::CSpuCapture::EVENT_RENDER:
+		{
+			unsigned int sampleCount = event.value;
+			if(event.coreId == 0)
+			{
+				hasCore0Block = true;
+				core0BlockOffset = result.samples.size();
+				core0BlockSampleCount = sampleCount;
+				result.samples.resize(result.samples.size() + sampleCount);
+				m_spuCore0.Render(result.samples.data() + core0BlockOffset, sampleCount);
+				result.renderedTicks += sampleCount / 2;
+			}
+			else
+			{
+				core1Samples.resize(sampleCount);
+				m_spuCore1.Render(core1Samples.data(), sampleCount);
+				if(hasCore0Block && (core0BlockSampleCount == sampleCount))
+				{
+					int16* output = result.samples.data() + core0BlockOffset;
+					for(unsigned int i = 0; i < sampleCount; i++)
+					{
+						int32 resultSample = static_cast<int32>(output[i]) + static_cast<int32>(core1Samples[i]);
+						output[i] = static_cast<int16>(std::clamp<int32>(resultSample, SHRT_MIN, SHRT_MAX));
+					}
+				}
+				else
+				{
+					result.samples.insert(result.samples.end(), core1Samples.begin(), core1Samples.end());
+					result.renderedTicks += sampleCount / 2;
+				}
+				hasCore0Block = false;
+			}
+		}
+		break;
+		case Iop::CSpuCapture::EVENT_SETTING:
+		{
+			auto setting = static_cast<Iop::CSpuCapture::SETTING>(event.address);
+			auto& core = (event.coreId == 0) ? m_spuCore0 : m_spuCore1;
+			Iop::CSpuCapture::ApplySetting(core, setting, event.value);
+			if((setting == Iop::CSpuCapture::SETTING_DESTINATION_SAMPLING_RATE) && (event.coreId == 0))
+			{
+				result.samplingRate = event.value;
+			}
+		}
+		break;
+		default:
+			break;
+		}
+	}
+}
+
+bool CSpuReplay::Run(const fs::path& capturePath, const OPTIONS& options)
+{
+	Iop::CSpuCapture capture;
+	{
+		auto stream = Framework::CreateInputStdStream(capturePath.native());
+		capture.Read(stream);
+	}
+
+	RESULT result;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < options.repeatCount; i++)
+	{
+		Replay(capture, result);
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	double elapsed = std::chrono::duration<double>(endTime - startTime).count();
+	double renderedTicks = static_cast<double>(result.renderedTicks) * options.repeatCount;
+
+	printf("Rendered %llu stereo samples (x%d) in %.3fs.\r\n",
+	       static_cast<unsigned long long>(result.renderedTicks), options.repeatCount, elapsed);
+	printf("%.1f samples/s", renderedTicks / elapsed);
+	if(result.samplingRate != 0)
+	{
+		printf(", %.1fx realtime at %dHz", (renderedTicks / result.samplingRate) / elapsed, result.samplingRate);
+	}
+	printf(".\r\n");
+	printf("Output hash: %016llX\r\n", static_cast<unsigned long long>(ComputeHash(result.samples)));
+
+	bool succeeded = true;
+	if(result.dmaMismatchCount != 0)
+	{
+		printf("Warning: %d DMA transfers didn't replay like they were recorded.\r\n", result.dmaMismatchCount);
+		succeeded = false;
+	}
+
+	if(!options.writeGoldenPath.empty())
+	{
+		auto stream = Framework::CreateOutputStdStream(options.writeGoldenPath.native());
+		stream.Write(result.samples.data(), result.samples.size() * sizeof(int16));
+	}
+
+	if(!options.goldenPath.empty())
+	{
+		std::vector<int16> goldenSamples;
+		{
+			auto stream = Framework::CreateInputStdStream(options.goldenPath.native());
+			goldenSamples.resize(stream.GetLength() / sizeof(int16));
+			stream.Read(goldenSamples.data(), goldenSamples.size() * sizeof(int16));
+		}
+		if(goldenSamples == result.samples)
+		{
+			printf("Output matches golden output.\r\n");
+		}
+		else
+		{
+			printf("Output differs from golden output (%d vs %d samples), PSNR: %.2fdB.\r\n",
+			       static_cast<int>(result.samples.size()), static_cast<int>(goldenSamples.size()),
+			       ComputePsnr(result.samples, goldenSamples));
+			succeeded = false;
+		}
+	}
+
+	return succeeded;
+}
+
+uint64 CSpuReplay::ComputeHash(const std::vector<int16>& samples)
+{
+	//FNV-1a over the samples' bytes in little endian order
+	uint64 hash = 0xCBF29CE484222325ULL;
+	for(auto sample : samples)
+	{
+		uint16 value = static_cast<uint16>(sample);
+		for(unsigned int i = 0; i < 2; i++)
+		{
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 0x100000001B3ULL;
+		}
+	}
+	return hash;
+}
+
+double CSpuReplay::ComputePsnr(const std::vector<int16>& samples, const std::vector<int16>& referenceSamples)
+{
+	//Missing samples on either side count as silence
+	size_t sampleCount = std::max(samples.size(), referenceSamples.size());
+	if(sampleCount == 0) return INFINITY;
+	double errorSum = 0;
+	for(size_t i = 0; i < sampleCount; i++)
+	{
+		double sample = (i < samples.size()) ? samples[i] : 0;
+		double referenceSample = (i < referenceSamples.size()) ? referenceSamples[i] : 0;
+		double error = sample - referenceSample;
+		errorSum += error * error;
+	}
+	if(errorSum == 0) return INFINITY;
+	double meanError = errorSum / static_cast<double>(sampleCount);
+	double peak = SHRT_MAX;
+	return 10.0 * std::log10((peak * peak) / meanError);
+}
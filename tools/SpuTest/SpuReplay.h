@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include "Types.h"
+#include "filesystem_def.h"
+#include "iop/Iop_Spu2.h"
+#include "iop/Iop_SpuCapture.h"
+
+//Renders SPU captures made by the emulator (see Iop::CSpuCapture) without running the emulated program.
+//Used to measure rendering performance and to check that changes to the SPU don't alter its output.
+class CSpuReplay
+{
+public:
+	struct OPTIONS
+	{
+		unsigned int repeatCount = 1;
+		//Raw 16-bit stereo samples to compare the output with
+		fs::path goldenPath;
+		fs::path writeGoldenPath;
+	};
+
+	struct RESULT
+	{
+		//Stereo pairs of samples, both cores mixed together like the emulator does
+		std::vector<int16> samples;
+		uint64 renderedTicks = 0;
+		uint32 samplingRate = 0;
+		uint32 dmaMismatchCount = 0;
+	};
+
+	CSpuReplay();
+	virtual ~CSpuReplay();
+
+	CSpuReplay(const CSpuReplay&) = delete;
+	CSpuReplay& operator=(const CSpuReplay&) = delete;
+
+	void Replay(const Iop::CSpuCapture&, RESULT&);
+	bool Run(const fs::path&, const OPTIONS&);
+
+	static uint64 ComputeHash(const std::vector<int16>&);
+	static double ComputePsnr(const std::vector<int16>&, const std::vector<int16>&);
+
+private:
+	uint8* m_ram = nullptr;
+	Iop::CSpuSampleCache m_spuSampleCache;
+	Iop::CSpuIrqWatcher m_irqWatcher;
+	Iop::CSpuBase m_spuCore0;
+	Iop::CSpuBase m_spuCore1;
+	Iop::CSpu2 m_spu;
+};